@@ -23,10 +23,11 @@ frontEndFilterFlag = false;
 % Sampling Frequency of EEG data
 fs = 256;           
 
-% calibrationFlag enables calibration of the amps. If disabled, amplifiers
-% will initialize quicker but may contain unusal offsets or scales.
-% (recommended on)
-calibrationFlag = false;
+% calibrationFlag enables calibration of the amps. Calibrations are cached
+% per amplifier serial and only redone once they are a day old, so
+% calibrated sessions start as quickly as uncalibrated ones. If disabled,
+% amplifiers may contain unusal offsets or scales. (recommended on)
+calibrationFlag = true;
 
 % ampBufferLengthSec is the buffer length (in sec) of the data acquisition
 % toolbox. If set to 'Inf' the data acquisition toolbox continually
@@ -0,0 +1,91 @@
+//_____________________________________________________________________________
+//    AcquisitionEngine.h
+//
+//	  Created: Oct 2026
+//
+//_____________________________________________________________________________
+//
+
+#ifndef ACQUISITIONENGINE_H
+#define ACQUISITIONENGINE_H
+
+#include <afxwin.h>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+
+class DAQgUSBamp;
+
+/*
+ * Runs the acquisition of several independent device groups (DAQgUSBamp objects, each with its master and slaves, its
+ * own sync, buffers and stats) on a bounded set of I/O threads instead of one time critical thread per group. A started
+ * group is served by the I/O thread with the fewest devices. Each thread waits on the oldest transfer of every device
+ * of its groups and handles completions as they are signalled, rotating the wait order so that no group starves. A
+ * group that stops takes back its transfers in flight as they complete, without holding up the other groups of its
+ * thread, then ends and leaves its thread; one that fails or has no completion for TIMEOUT_MS is ended at once.
+ */
+class AcquisitionEngine
+{
+public:
+
+	// Handles a thread can wait on (WaitForMultipleObjects), one is its wake-up event
+	static const int MAX_WAIT_HANDLES = 64;
+
+	// Time without completion after which a group is stopped with a timeout error
+	static const int TIMEOUT_MS = 1000;
+
+	// Constructor. Starts numThreads I/O threads at time critical priority
+	AcquisitionEngine(int numThreads);
+
+	// Destructor. Ends the groups still attached and joins the threads
+	~AcquisitionEngine();
+
+	// Engine shared by the groups of the process, created with numThreads threads by the first caller
+	static AcquisitionEngine *AcquireShared(int numThreads);
+
+	// Releases the shared engine, deleted with its last user
+	static void ReleaseShared();
+
+	// Hands a group whose acquisition is starting to the least loaded thread. False if no thread can wait on
+	// numDevices more devices
+	bool Attach(DAQgUSBamp *group, int numDevices);
+
+	// Number of I/O threads
+	int NumThreads();
+
+	// Number of groups attached to an I/O thread
+	int NumGroups(int threadIndex);
+
+	// I/O thread serving a group. -1 if it is not attached
+	int ThreadOfGroup(DAQgUSBamp *group);
+
+private:
+
+	// An I/O thread and the groups it serves (defined in AcquisitionEngine.cpp)
+	struct IoThread;
+
+	// Loop of an I/O thread
+	void Run(IoThread *io);
+
+	// Ends a group and removes it from its thread
+	void Detach(IoThread *io, size_t groupIndex);
+
+	// I/O threads
+	std::vector< std::unique_ptr<IoThread> > _threads;
+
+	// Mutex used to attach and detach groups
+	std::mutex _lock;
+
+	// Flag cleared to end the threads
+	bool _isRunning;
+
+	// Shared engine and number of its users
+	static AcquisitionEngine *_shared;
+	static int _numSharedUsers;
+
+	// Mutex used to create and delete the shared engine
+	static std::mutex _sharedLock;
+};
+
+#endif
@@ -0,0 +1,110 @@
+//_____________________________________________________________________________
+//    AmpDriver.h
+//
+//	  Created: Oct 2026
+//
+//_____________________________________________________________________________
+//
+
+#ifndef AMPDRIVER_H
+#define AMPDRIVER_H
+
+#include <afxwin.h>
+#include "gUSBamp.h"
+
+/*
+ * Device calls used by DAQgUSBamp. Each method has the signature and semantics of the gtec C API function of the
+ * same name (GT_ prefix removed), so the acquisition code does not depend on whether a real amplifier is behind it.
+ */
+class AmpDriver
+{
+public:
+
+	virtual ~AmpDriver() {}
+
+	virtual HANDLE OpenDevice(int usbPort) = 0;
+	virtual HANDLE OpenDeviceEx(LPSTR serial) = 0;
+	virtual BOOL CloseDevice(HANDLE *hDevice) = 0;
+	virtual BOOL GetSerial(HANDLE hDevice, LPSTR serial, UINT size) = 0;
+
+	virtual BOOL SetSlave(HANDLE hDevice, BOOL slave) = 0;
+	virtual BOOL SetReference(HANDLE hDevice, REF reference) = 0;
+	virtual BOOL SetGround(HANDLE hDevice, GND ground) = 0;
+	virtual BOOL SetChannels(HANDLE hDevice, UCHAR *channels, UCHAR numChannels) = 0;
+	virtual BOOL SetSampleRate(HANDLE hDevice, WORD sampleRate) = 0;
+	virtual BOOL EnableTriggerLine(HANDLE hDevice, BOOL enable) = 0;
+	virtual BOOL SetBufferSize(HANDLE hDevice, WORD numScans) = 0;
+	virtual BOOL SetBandPass(HANDLE hDevice, UCHAR channel, int filterIndex) = 0;
+	virtual BOOL SetNotch(HANDLE hDevice, UCHAR channel, int filterIndex) = 0;
+	virtual BOOL EnableSC(HANDLE hDevice, BOOL enable) = 0;
+	virtual BOOL SetBipolar(HANDLE hDevice, CHANNEL bipolar) = 0;
+	virtual BOOL SetMode(HANDLE hDevice, UCHAR mode) = 0;
+
+	virtual BOOL GetScale(HANDLE hDevice, SCALE *scaling) = 0;
+	virtual BOOL Calibrate(HANDLE hDevice, SCALE *scaling) = 0;
+	virtual BOOL SetScale(HANDLE hDevice, SCALE *scaling) = 0;
+
+	virtual BOOL Start(HANDLE hDevice) = 0;
+	virtual BOOL Stop(HANDLE hDevice) = 0;
+	virtual BOOL ResetTransfer(HANDLE hDevice) = 0;
+
+	// Queues an overlapped transfer of sizeBytes bytes (header plus scans); ov->hEvent is signalled when it completes
+	virtual BOOL GetData(HANDLE hDevice, BYTE *buffer, DWORD sizeBytes, OVERLAPPED *ov) = 0;
+
+	// Same as the Windows function for transfers queued with GetData
+	virtual BOOL GetOverlappedResult(HANDLE hDevice, OVERLAPPED *ov, DWORD *numBytes, BOOL wait) = 0;
+
+	virtual BOOL SetDigitalOutEx(HANDLE hDevice, DigitalOUT digitalOut) = 0;
+
+	// Impedance of the electrode of one channel (1 to 16), in ohms. Takes a while and must not run during acquisition
+	virtual BOOL GetImpedance(HANDLE hDevice, UCHAR channel, double *impedance) = 0;
+
+	// Scans dropped by the devices because no transfer was queued. -1 if the driver cannot tell
+	virtual long long LostScans() { return -1; }
+
+	// True once a device has no more data to acquire (a replayed recording has ended)
+	virtual bool Finished() { return false; }
+};
+
+/*
+ * Driver for real amplifiers: forwards every call to the gtec C API.
+ */
+class GtecAmpDriver : public AmpDriver
+{
+public:
+
+	HANDLE OpenDevice(int usbPort) { return GT_OpenDevice(usbPort); }
+	HANDLE OpenDeviceEx(LPSTR serial) { return GT_OpenDeviceEx(serial); }
+	BOOL CloseDevice(HANDLE *hDevice) { return GT_CloseDevice(hDevice); }
+	BOOL GetSerial(HANDLE hDevice, LPSTR serial, UINT size) { return GT_GetSerial(hDevice, serial, size); }
+
+	BOOL SetSlave(HANDLE hDevice, BOOL slave) { return GT_SetSlave(hDevice, slave); }
+	BOOL SetReference(HANDLE hDevice, REF reference) { return GT_SetReference(hDevice, reference); }
+	BOOL SetGround(HANDLE hDevice, GND ground) { return GT_SetGround(hDevice, ground); }
+	BOOL SetChannels(HANDLE hDevice, UCHAR *channels, UCHAR numChannels) { return GT_SetChannels(hDevice, channels, numChannels); }
+	BOOL SetSampleRate(HANDLE hDevice, WORD sampleRate) { return GT_SetSampleRate(hDevice, sampleRate); }
+	BOOL EnableTriggerLine(HANDLE hDevice, BOOL enable) { return GT_EnableTriggerLine(hDevice, enable); }
+	BOOL SetBufferSize(HANDLE hDevice, WORD numScans) { return GT_SetBufferSize(hDevice, numScans); }
+	BOOL SetBandPass(HANDLE hDevice, UCHAR channel, int filterIndex) { return GT_SetBandPass(hDevice, channel, filterIndex); }
+	BOOL SetNotch(HANDLE hDevice, UCHAR channel, int filterIndex) { return GT_SetNotch(hDevice, channel, filterIndex); }
+	BOOL EnableSC(HANDLE hDevice, BOOL enable) { return GT_EnableSC(hDevice, enable); }
+	BOOL SetBipolar(HANDLE hDevice, CHANNEL bipolar) { return GT_SetBipolar(hDevice, bipolar); }
+	BOOL SetMode(HANDLE hDevice, UCHAR mode) { return GT_SetMode(hDevice, mode); }
+
+	BOOL GetScale(HANDLE hDevice, SCALE *scaling) { return GT_GetScale(hDevice, scaling); }
+	BOOL Calibrate(HANDLE hDevice, SCALE *scaling) { return GT_Calibrate(hDevice, scaling); }
+	BOOL SetScale(HANDLE hDevice, SCALE *scaling) { return GT_SetScale(hDevice, scaling); }
+
+	BOOL Start(HANDLE hDevice) { return GT_Start(hDevice); }
+	BOOL Stop(HANDLE hDevice) { return GT_Stop(hDevice); }
+	BOOL ResetTransfer(HANDLE hDevice) { return GT_ResetTransfer(hDevice); }
+
+	BOOL GetData(HANDLE hDevice, BYTE *buffer, DWORD sizeBytes, OVERLAPPED *ov) { return GT_GetData(hDevice, buffer, sizeBytes, ov); }
+	BOOL GetOverlappedResult(HANDLE hDevice, OVERLAPPED *ov, DWORD *numBytes, BOOL wait) { return ::GetOverlappedResult(hDevice, ov, numBytes, wait); }
+
+	BOOL SetDigitalOutEx(HANDLE hDevice, DigitalOUT digitalOut) { return GT_SetDigitalOutEx(hDevice, digitalOut); }
+
+	BOOL GetImpedance(HANDLE hDevice, UCHAR channel, double *impedance) { return GT_GetImpedance(hDevice, channel, impedance); }
+};
+
+#endif
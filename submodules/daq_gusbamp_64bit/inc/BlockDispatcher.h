@@ -0,0 +1,168 @@
+//_____________________________________________________________________________
+//    BlockDispatcher.h
+//
+//	  Created: Oct 2026
+//
+//_____________________________________________________________________________
+//
+
+#ifndef BLOCKDISPATCHER_H
+#define BLOCKDISPATCHER_H
+
+#include <vector>
+#include <deque>
+#include <map>
+#include <memory>
+#include <functional>
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
+#include "WorkStealingPool.h"
+
+// Merged block passed to a subscriber. The values are only valid during the callback
+struct BlockSpan
+{
+	// Interleaved scans (channels, then trigger)
+	const float *data;
+
+	// Number of scans and values per scan
+	int numScans;
+	int scanStride;
+
+	// Index of the block since acquisition started (0 based)
+	long long blockIndex;
+};
+
+// Delivery statistics of one subscriber
+struct SubscriberStats
+{
+	// Blocks passed to the callback and blocks dropped because the subscriber queue was full
+	long long delivered;
+	long long dropped;
+
+	// Blocks waiting for the callback now, and the most that ever waited
+	int queuedBlocks;
+	int maxQueuedBlocks;
+
+	// Time from publishing a block to the start of its callback (lag), and callback duration
+	double meanLagMs;
+	double maxLagMs;
+	double meanCallbackMs;
+	double maxCallbackMs;
+};
+
+/*
+ * Hands every block of the acquisition loop to the registered callbacks on a pool of dispatch threads. The writer
+ * merges each block straight into a dispatcher buffer (AcquireBlock) and publishes it; subscribers receive that same
+ * buffer, which is recycled once every subscriber is done with it, so no block is copied.
+ *
+ * Each subscriber has its own queue, drained by one pool task at a time: callbacks of one subscriber run in block
+ * order and never concurrently, callbacks of different subscribers run in parallel. Publishing never waits. When a
+ * subscriber has maxQueuedBlocks blocks waiting, its oldest one is dropped and counted (backpressure is on the slow
+ * subscriber, never on the writer).
+ */
+class BlockDispatcher
+{
+public:
+
+	// Function called with each block
+	typedef std::function<void(const BlockSpan &)> BlockCallback;
+
+	// Constructor. numThreads dispatch threads (<= 0 for one per core)
+	BlockDispatcher(int numThreads);
+
+	// Destructor. Removes every subscriber, waiting for the callbacks in progress
+	~BlockDispatcher();
+
+	// Registers callback. Returns the subscriber id
+	int Subscribe(BlockCallback callback, int maxQueuedBlocks);
+
+	// Removes a subscriber, dropping its queued blocks and waiting for its callback in progress. Must not be called
+	// from that subscriber's own callback
+	bool Unsubscribe(int subscriberId);
+
+	// Number of subscribers
+	int NumSubscribers();
+
+	// Buffer of numValues floats the writer fills with the next block. The same buffer is returned until it is published
+	float *AcquireBlock(size_t numValues);
+
+	// Queues the acquired block for every subscriber
+	void Publish(int numScans, int scanStride);
+
+	// Restarts block numbering (acquisition start)
+	void ResetBlockIndex();
+
+	// Waits until every queued block has been delivered or dropped
+	void Flush();
+
+	// Copies the statistics of a subscriber. False if it does not exist
+	bool GetStats(int subscriberId, SubscriberStats *stats);
+
+	// Number of block buffers allocated so far
+	int NumBuffers();
+
+	// Dispatch threads
+	WorkStealingPool &Pool() { return _pool; }
+
+private:
+
+	typedef std::chrono::steady_clock::time_point TimePoint;
+
+	// Block buffer shared by the subscribers it is queued for
+	struct Block
+	{
+		std::vector<float> data;
+		int numScans;
+		int scanStride;
+		long long blockIndex;
+		TimePoint published;
+
+		// Subscribers still holding the block
+		int references;
+	};
+
+	// Registered callback and its queue
+	struct Subscriber
+	{
+		BlockCallback callback;
+		int maxQueuedBlocks;
+		std::deque<Block *> queue;
+
+		// Set while a pool task drains the queue, and once unsubscribed
+		bool scheduled;
+		bool removed;
+
+		// Statistics (lag and callback sums for the means)
+		SubscriberStats stats;
+		double sumLagMs;
+		double sumCallbackMs;
+	};
+
+	// Delivers the queued blocks of subscriber in order, run as a pool task
+	void Drain(std::shared_ptr<Subscriber> subscriber);
+
+	// Drops one reference to block and recycles it when unused (called with _lock held)
+	void Release(Block *block);
+
+	// Every buffer allocated, free buffers, and the one being written
+	std::vector< std::unique_ptr<Block> > _blocks;
+	std::vector<Block *> _freeBlocks;
+	Block *_writing;
+
+	// Index of the next block published
+	long long _nextBlockIndex;
+
+	// Subscribers by id
+	std::map<int, std::shared_ptr<Subscriber> > _subscribers;
+	int _nextSubscriberId;
+
+	// Mutex protecting blocks, subscribers and statistics, and condition signalled when a drain task ends
+	std::mutex _lock;
+	std::condition_variable _drained;
+
+	// Dispatch threads (declared last so they stop before the state they use is destroyed)
+	WorkStealingPool _pool;
+};
+
+#endif
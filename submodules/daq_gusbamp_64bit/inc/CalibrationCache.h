@@ -0,0 +1,63 @@
+//_____________________________________________________________________________
+//    CalibrationCache.h
+//
+//	  Created: Oct 2026
+//
+//_____________________________________________________________________________
+//
+
+#ifndef CALIBRATIONCACHE_H
+#define CALIBRATIONCACHE_H
+
+#include <string>
+#include <map>
+#include <time.h>
+
+/*
+ * Calibration results (scale factor and offset of the 16 channels, as returned by GT_Calibrate) of each amplifier,
+ * keyed by serial number and stamped with the time they were measured. The cache is kept in a text file with one line
+ * per amplifier: serial, time (seconds since 1970), 16 factors and 16 offsets.
+ */
+class CalibrationCache
+{
+public:
+
+	// Number of channels of one amplifier
+	static const int NUM_CHANNELS = 16;
+
+	// Constructor
+	CalibrationCache();
+
+	// Reads the entries of fileName, replacing the current ones. A missing file gives an empty cache
+	bool Load(const char *fileName);
+
+	// Writes all entries to fileName (replaced atomically where the platform allows it)
+	bool Save(const char *fileName) const;
+
+	// Stores the calibration of serial measured at time measured
+	void Store(const std::string &serial, time_t measured, const float *factor, const float *offset);
+
+	// Copies the calibration of serial if it is at most maxAgeSeconds old at time now. Sets ageSeconds if not NULL
+	bool Find(const std::string &serial, time_t now, double maxAgeSeconds, float *factor, float *offset, double *ageSeconds) const;
+
+	// Forgets the calibration of serial
+	void Remove(const std::string &serial);
+
+	// Number of amplifiers in the cache
+	int NumEntries() const { return (int) _entries.size(); }
+
+private:
+
+	// Calibration of one amplifier
+	struct Entry
+	{
+		time_t measured;
+		float factor[NUM_CHANNELS];
+		float offset[NUM_CHANNELS];
+	};
+
+	// Entries by serial number
+	std::map<std::string, Entry> _entries;
+};
+
+#endif
@@ -0,0 +1,31 @@
+//_____________________________________________________________________________
+//    ChannelGather.h
+//
+//	  Created: Oct 2026
+//
+//_____________________________________________________________________________
+//
+
+#ifndef CHANNELGATHER_H
+#define CHANNELGATHER_H
+
+/*
+ * Turns interleaved scans (all channels of a sample, then the next sample) into channel-major rows of a subset of the
+ * channels, gathering and transposing in one pass. Scans are walked in blocks of BLOCK_SCANS that stay in the L1 cache
+ * while every selected channel is read from them; groups of 4 channels are transposed 4 scans at a time with SSE
+ * registers so that each channel row is written with full vector stores.
+ */
+class ChannelGather
+{
+public:
+
+	// Scans per cache block (64 scans of 64 channels use 16 kB)
+	static const int BLOCK_SCANS = 64;
+
+	// Copies the channels (indices in a scan) of numScans scans of scanStride values into channelMajor: first
+	// numScans values of channels[0], then those of channels[1]... Rows start rowStride values apart (at least
+	// numScans), so that several calls can fill the columns of one destination
+	static void Gather(const float *scans, int numScans, int scanStride, const int *channels, int numChannels, float *channelMajor, int rowStride);
+};
+
+#endif
@@ -0,0 +1,102 @@
+//_____________________________________________________________________________
+//    ClassifierTrainer.h
+//
+//	  Created: Oct 2026
+//
+//_____________________________________________________________________________
+//
+
+#ifndef CLASSIFIERTRAINER_H
+#define CLASSIFIERTRAINER_H
+
+#include <vector>
+#include <memory>
+#include "SSVEPFeatureEngine.h"
+
+/*
+ * Offline k-fold evaluation of the CCA-KDE classifier over a grid of trial lengths, run on a work stealing pool.
+ * CCA features (one canonical correlation per class) are computed once per trial and trial length and shared by
+ * every fold. Each fold fits one Gaussian product kernel density per class on the training trials (bandwidth by the
+ * multivariate rule of ksdensity: sigma = MAD / 0.6745, h = sigma * (4 / ((d + 2) n)) ^ (1 / (d + 4))) and scores
+ * the held out trials with the class prior. Fold membership is given by the caller so that the folds match the
+ * MATLAB path.
+ */
+class ClassifierTrainer
+{
+public:
+
+	// Constructor. numThreads <= 0 uses one thread per core
+	ClassifierTrainer(int sampleRate, std::vector<double> stimFrequencies, int numHarmonics, std::vector<double> prior, int numThreads);
+
+	// Sets the trials, numChannels x numSamples x numTrials in column-major order (as in MATLAB), and the class
+	// index (0 based) of each trial. The data is not copied and must outlive Run
+	void SetData(const double *data, int numChannels, int numSamples, int numTrials, const int *labels);
+
+	// Evaluates every trial length (in samples) with the given folds (fold index per trial, 0 based)
+	bool Run(std::vector<int> trialLengths, const int *folds, int numFolds);
+
+	// Accuracy per trial length and fold, numTrialLengths x numFolds (column-major)
+	const std::vector<double> &Accuracy() const { return _accuracy; }
+
+	// Held out posteriors, numClasses x numTrials x numTrialLengths (column-major)
+	const std::vector<double> &Posterior() const { return _posterior; }
+
+	// CCA features, numClasses x numTrials x numTrialLengths (column-major)
+	const std::vector<double> &Features() const { return _features; }
+
+	// Seconds spent computing features and evaluating folds in the last Run
+	double FeatureSeconds() const { return _featureSeconds; }
+	double FoldSeconds() const { return _foldSeconds; }
+
+	// Number of worker threads used
+	int NumThreads() const { return _numThreads; }
+
+private:
+
+	// Computes the features of one trial for one trial length
+	void ComputeFeatures(int lengthIndex, int trialIndex);
+
+	// Trains on every fold but one and scores the held out fold
+	void EvaluateFold(int lengthIndex, int fold);
+
+	// Sample rate in Hz
+	int _sampleRate;
+
+	// Stimulus frequencies in Hz, one per class
+	std::vector<double> _stimFrequencies;
+
+	// Number of harmonics in the CCA templates
+	int _numHarmonics;
+
+	// Class prior
+	std::vector<double> _prior;
+
+	// Number of worker threads
+	int _numThreads;
+
+	// Trials (not owned) and their size
+	const double *_data;
+	int _numChannels;
+	int _numSamples;
+	int _numTrials;
+
+	// Class index of each trial
+	std::vector<int> _labels;
+
+	// Grid of the last Run
+	std::vector<int> _trialLengths;
+	std::vector<int> _folds;
+	int _numFolds;
+
+	// CCA templates per trial length and class, built once per Run
+	std::vector< std::unique_ptr<CCAReference> > _references;
+
+	// Results of the last Run
+	std::vector<double> _features;
+	std::vector<double> _posterior;
+	std::vector<double> _accuracy;
+	double _featureSeconds;
+	double _foldSeconds;
+};
+
+#endif
@@ -14,10 +14,60 @@
 #include <string>
 #include <deque>
 #include <vector>
+#include <map>
+#include <set>
 #include "ringbuffer.h"
+#include "SSVEPFeatureEngine.h"
+#include "IncrementalTrialClassifier.h"
+#include "AmpDriver.h"
+#include "TransferMonitor.h"
+#include "CalibrationCache.h"
+#include "ReadNotifier.h"
+#include "BlockDispatcher.h"
+#include "ThreadScheduling.h"
+#include "SampleCodec.h"
+#include "ChannelGather.h"
+#include "ScanInterleaver.h"
+#include "SignalQualityMonitor.h"
+#include "EOGArtifactDetector.h"
+#include "EnvelopePyramid.h"
+#include "TriggerScheduler.h"
+#include "SessionRecorder.h"
+
+class AcquisitionEngine;
+
+/*
+ * Size and pacing of the transfers: small blocks, a deep queue and a wake-up per block give the lowest latency
+ * (closed-loop feedback); large blocks and fewer wake-ups give the lowest overhead (long recordings).
+ */
+struct BlockPolicy
+{
+	// Scans per transfer (GT_SetBufferSize). 0 for SampleRate / 32
+	int blockScans;
+
+	// Transfers queued per device
+	int queueDepth;
+
+	// Merged blocks per wake-up of the thread reading the application buffer
+	int wakeBlocks;
+
+	// Default policy: blocks of about 31 ms, 4 transfers queued, wake-up every block
+	BlockPolicy() : blockScans(0), queueDepth(4), wakeBlocks(1) {}
+
+	BlockPolicy(int scans, int depth, int wake) : blockScans(scans), queueDepth(depth), wakeBlocks(wake) {}
+
+	// Blocks of about 8 ms with the same 125 ms of queued transfers as the default, wake-up every block
+	static BlockPolicy LowLatency(int sampleRate);
+
+	// Blocks of about 250 ms (at most 512 scans), wake-up every second
+	static BlockPolicy HighThroughput(int sampleRate);
+};
 
 class DAQgUSBamp	
 {
+	// Runs the acquisition steps of groups attached to its I/O threads
+	friend class AcquisitionEngine;
+
 private:
 
 	// DAQ version
@@ -26,8 +76,17 @@ private:
 	// The size of the application buffer in seconds
 	static const int BUFFER_SIZE_SECONDS = 1800;		
 	
-	// The number of GT_GetData calls that will be queued during acquisition to avoid loss of data
-    static const int QUEUE_SIZE = 4;
+	// The number of GT_GetData calls per device that will be queued during acquisition to avoid loss of data
+    static const int DEFAULT_QUEUE_SIZE = 4;
+
+	// Upper bound of the queue depth (configured or reached by adaptive deepening)
+	static const int MAX_QUEUE_SIZE = 32;
+
+	// Number of recent completions the transfer latency percentiles are computed on
+	static const int LATENCY_WINDOW = 128;
+
+	// Maximum number of scans per transfer accepted by GT_SetBufferSize
+	static const int MAX_BLOCK_SCANS = 512;
 
 	// Maximum number of channels per amplifier
 	static const int MAX_NUMBER_OF_CHANNELS = 16;
@@ -38,6 +97,42 @@ private:
 	// Maximum number of USB ports to check
 	static const int MAX_NUMBER_USB_PORTS = 31;
 
+	// Number of USB ports probed at the same time during discovery
+	static const int DISCOVERY_THREADS = 8;
+
+	// Number of threads running block subscriber callbacks
+	static const int DISPATCH_THREADS = 2;
+
+	// Blocks the signal quality monitor may lag behind before its oldest one is dropped
+	static const int QUALITY_QUEUED_BLOCKS = 256;
+
+	// Blocks the SSVEP feature engine may lag behind before its oldest one is dropped
+	static const int FEATURE_QUEUED_BLOCKS = 256;
+
+	// Blocks the trial classifier may lag behind before its oldest one is dropped (a dropped block shortens the trial)
+	static const int CLASSIFIER_QUEUED_BLOCKS = 4096;
+
+	// Blocks the EOG artifact detector may lag behind before its oldest one is dropped (a dropped block shifts the spans)
+	static const int EOG_QUEUED_BLOCKS = 4096;
+
+	// Blocks the envelope pyramid may lag behind before its oldest one is dropped (a dropped block shifts the envelope)
+	static const int ENVELOPE_QUEUED_BLOCKS = 4096;
+
+	// Serial and USB port of the devices found by the last port scan, shared by all instances
+	static std::map<std::string, int> _deviceInventory;
+
+	// Mutex used to access the device inventory and the opened serials
+	static CMutex _inventoryLock;
+
+	// Serials of the devices opened by the instances (device groups) of this process
+	static std::set<std::string> _openedSerials;
+
+	// Number of instances acquiring, the process priority is raised by the first and restored by the last
+	static int _numAcquiring;
+
+	// Mutex used to change the process priority
+	static CMutex _priorityLock;
+
 	// Flag that indicates if the thread is currently running
 	bool _isRunning;						
 	
@@ -49,21 +144,46 @@ private:
 	
 	// Mutex used to manage concurrent thread access to the class data buffer
 	CMutex _bufferLock;				
+
+	// Mutex serializing the readers of the application buffer, held from the copy until the compact values are decoded
+	// (the read lanes are shared)
+	CMutex _readLock;
 	
 	// The thread that performs data acquisition
 	CWinThread* _dataAcquisitionThread;		
 	
 	// The application buffer where received data will be stored for each device
 	CRingBuffer<float> _buffer;				
+
+	// The application buffer in compact storage (half precision or int16 lanes), used instead of _buffer
+	CRingBuffer<uint16_t> _compactBuffer;
+
+	// Converts scans between floats and the compact storage of the application buffer
+	SampleCodec _codec;
+
+	// Merges the blocks of the devices into scans, with the kernel selected for the configuration when acquisition starts
+	ScanInterleaver _interleaver;
+
+	// Compact lanes of the block being written and of the samples being read (the latter under _readLock)
+	std::vector<uint16_t> _compactWrite;
+	std::vector<uint16_t> _compactRead;
+
+	// Scans decoded from the compact storage before their channels are gathered (under _readLock)
+	std::vector<float> _decodedRead;
+
+	// Values clipped to the range of the compact storage since acquisition started, updated under _bufferLock
+	long long _numClipped;
 	
 	// Event that signals that data acquisition thread has been stopped
 	CEvent _dataAcquisitionStopped;			
 	
-	// Event to avoid polling the application data buffer for new data
-	CEvent _newDataAvailable;				
+	// Wakes readers waiting for a number of samples or a trigger every wakeBlocks blocks, updated under _bufferLock
+	ReadNotifier _readNotifier;
 	
-	// File where acquisition loop is storing the data
-	CFile outputFile;             
+	// Writes the file where acquisition loop is storing the data from a thread of its own, and the durability it is
+	// written with
+	SessionRecorder _recorder;
+	DurabilityPolicy _durabilityPolicy;
 
 	// Serial number of all devices. Master is last
 	std::deque<std::string> deviceSerialList;   
@@ -86,15 +206,214 @@ private:
 	// Boolean set in StartAcquisition to check if a file will be written
 	bool writeToFile;
 
-	// Function to return a list of the serial number of connected devices
+	// Passes each merged block to the subscribers on its own threads. Blocks are merged into its buffers
+	BlockDispatcher *_dispatcher;
+
+	// Online SSVEP feature engine fed on the dispatch threads. NULL if disabled
+	SSVEPFeatureEngine *_featureEngine;
+
+	// Block subscriber feeding the SSVEP feature engine
+	int _featureSubscriber;
+
+	// Early stopping classifier of block trials fed on the dispatch threads. NULL if disabled
+	IncrementalTrialClassifier *_trialClassifier;
+
+	// Block subscriber feeding the trial classifier
+	int _classifierSubscriber;
+
+	// EOG artifact detector fed on the dispatch threads, trial flags are ready once the block where the trigger falls
+	// is delivered. NULL if disabled
+	EOGArtifactDetector *_eogDetector;
+
+	// Block subscriber feeding the EOG artifact detector
+	int _eogSubscriber;
+
+	// Signal quality monitor fed on the dispatch threads. NULL if disabled
+	SignalQualityMonitor *_qualityMonitor;
+
+	// Block subscriber feeding the signal quality monitor
+	int _qualitySubscriber;
+
+	// Log of the signal quality next to the recording. Empty when not recording
+	std::string _qualityLogName;
+
+	// Min/max envelope pyramid of the scans fed on the dispatch threads. NULL if disabled
+	EnvelopePyramid *_envelope;
+
+	// Block subscriber feeding the envelope pyramid
+	int _envelopeSubscriber;
+
+	// Envelope file next to the recording. Empty when not recording
+	std::string _envelopeFileName;
+
+	// Mutex used to enable/disable the feature engine, trial classifier, EOG detector, quality monitor and envelope while
+	// acquisition is running
+	CMutex _featureLock;
+
+	// Thread writing the scheduled triggers while acquiring, fed with the block completions for its scan clock
+	TriggerScheduler *_triggerScheduler;
+
+	// Log of the scheduled triggers next to the recording. Empty when not recording
+	std::string _triggerLogName;
+
+	// Mutex used to write the digital outputs from SendTrigger and the trigger scheduler
+	CMutex _triggerLock;
+
+	// Latest impedance of each acquired channel in kOhm, in the order of GetData. NaN until measured
+	std::vector<double> _impedances;
+
+	// Impedance sweeps over all the channels of each device (handle order)
+	std::vector<int> _impedanceSweeps;
+
+	// Workers measuring impedances, one per device. NULL if no measurement is running
+	WorkStealingPool *_impedancePool;
+
+	// Flag set to end impedance measurement
+	bool _impedanceStop;
+
+	// Mutex used to access the impedances measured by the workers
+	CMutex _impedanceLock;
+
+	// Device calls (gtec C API or simulated amplifiers)
+	AmpDriver *_driver;
+
+	// Transfers queued per device at start
+	int _queueDepth;
+
+	// Maximum queue depth when adaptive deepening is enabled
+	int _maxQueueDepth;
+
+	// Flag to deepen the queue when completion latencies rise
+	bool _adaptiveQueue;
+
+	// Current queue depth of each device
+	std::vector<int> _deviceQueueDepth;
+
+	// Completion latency of each device
+	std::vector<TransferMonitor> _transferMonitors;
+
+	// Number of blocks merged since acquisition started
+	long long _numBlocks;
+
+	// Mutex used to read transfer statistics while acquisition is running
+	CMutex _transferLock;
+
+	// Calibration of the amplifiers by serial number, reapplied on open while recent
+	CalibrationCache _calibrationCache;
+
+	// File the calibration cache is kept in. Empty if the cache is disabled
+	std::string _calibrationCacheFile;
+
+	// Age in hours beyond which a cached calibration is redone
+	double _calibrationMaxAgeHours;
+
+	// Flag per opened device set when a recent calibration has been applied. Master is last
+	std::vector<bool> _calibrationFresh;
+
+	// Cores, priority and memory locking of the acquisition and dispatch threads
+	SchedulingPolicy _schedulingPolicy;
+
+	// OS id of the acquisition thread. -1 before it has started
+	long long _acquisitionThreadId;
+
+	// Context switches of the acquisition thread when it started and when it ended (-1 while running)
+	long long _startContextSwitches;
+	long long _endContextSwitches;
+
+	// Page faults of the process when acquisition started
+	long long _startPageFaults;
+
+	// Transfers queued for one device by the acquisition loop (defined in DAQgUSBamp.cpp)
+	struct DeviceQueue;
+
+	// Transfer queues (buffers and events) kept between acquisition runs, one per device. NULL if none
+	DeviceQueue *_queues;
+
+	// Number of pooled transfer queues
+	int _numQueues;
+
+	// Flag set while the application buffer is locked in RAM
+	bool _bufferLocked;
+
+	// Flag set between start and stop, while this group counts in _numAcquiring
+	bool _holdsPriority;
+
+	// Engine whose I/O threads run the acquisition of this group. NULL to run it on a thread of its own
+	AcquisitionEngine *_engine;
+
+	// Trigger values per scan in the transfers of each device (only the master sends the trigger)
+	int _deviceTrigger[MAX_NUMBER_OF_DEVICES];
+
+	// Performance counter when the devices were started and its frequency
+	LARGE_INTEGER _startCounter;
+	LARGE_INTEGER _counterFrequency;
+
+	// Seconds from start to the last completion of any device
+	double _lastCompletionSeconds;
+
+	// Function to return a list of the serial number of connected devices (scans all ports and updates the inventory)
 	std::deque<std::string> FindDevice();                          
 
+	// Serial numbers of the device inventory in port order. Empty if no scan has been done
+	std::deque<std::string> InventorySerials();
+
 	// Converts a vector of channel list and bipolar settings to a vector of channel lists for each amp
 	void ConvertAmpChannels(std::vector<UCHAR> inputChannelList, std::vector<UCHAR> bipoSet);	
 
+	// First element and size in bytes of the application buffer in use (_buffer or _compactBuffer)
+	void *BufferData();
+	size_t BufferBytes();
+
+	// Number of values in the application buffer in use
+	int BufferedValues();
+
 	// Read the available data from the application buffer and move into the destination buffer
 	bool GetDataFromBuffer(float *destBuffer, int NumSamples);                           
+
+	// Gathers the selected channels of NumSamples samples of the application buffer into channel rows
+	bool GetChannelsFromBuffer(float *destBuffer, int NumSamples, const int *channels, int numSelected);
 	
+	// Queues one transfer after the ones in flight, with a free (or new) buffer
+	bool QueueTransfer(DeviceQueue *queue, HANDLE hDevice);
+
+	// Reuses the pooled transfer queues when they match the devices, block size and memory locking, creates them
+	// otherwise. Returns true if they were reused
+	bool PrepareQueues();
+
+	// Frees the pooled transfer queues (buffers and events)
+	void ReleaseQueues();
+
+	// Starts the devices (master last) and queues their first transfers. False on error
+	bool BeginAcquisition();
+
+	// Copies the event of the oldest transfer of each device, which completes first. Returns the number of devices
+	int HeadEvents(HANDLE *events);
+
+	// Handles the completed oldest transfer of a device: re-arms the device and merges, stores and publishes the
+	// block once every device has received it. False on error
+	bool CompleteTransfer(int deviceIndex);
+
+	// Takes the completed oldest transfer of a device without queueing another one, while the group stops on an engine
+	void DrainTransfer(int deviceIndex);
+
+	// Number of transfers in flight on all devices
+	int TransfersInFlight();
+
+	// False (with a timeout error) if no device has completed a transfer for timeoutMs
+	bool CheckTransferTimeout(int timeoutMs);
+
+	// Waits for the transfers in flight, stops the devices and signals _dataAcquisitionStopped
+	void EndAcquisition();
+
+	// Starts one worker per device measuring the impedances of its channels, once or until StopImpedanceMonitor
+	bool StartImpedanceWorkers(bool continuous);
+
+	// Measures the impedances of the channels of one device (handle index), sweep after sweep when continuous
+	void MeasureDeviceImpedances(int deviceIndex, bool continuous);
+
+	// Writes a trigger pattern (bit 0 is output 0) to the digital outputs of the master. False on error
+	bool WriteTrigger(int value);
+
 	// Applies individual channel settings to given device (handle)
 	void ApplySettings(HANDLE h_device, std::vector<UCHAR> channelList, std::vector<UCHAR> bipolarSettings, int deviceIndex);
 
@@ -139,7 +458,7 @@ public:
 	std::vector<UCHAR> channelsToAcquire;                                               
 	
 	// Constructor with full parametrization
-	DAQgUSBamp(std::vector<UCHAR> ChToAcq, int f, int trig, int BPF, int Notch, UCHAR mode, int comRef[4], int comGRN[4], std::vector<UCHAR> bipoSet);
+	DAQgUSBamp(std::vector<UCHAR> ChToAcq, int f, int trig, int BPF, int Notch, UCHAR mode, int comRef[4], int comGRN[4], std::vector<UCHAR> bipoSet, BlockPolicy blockPolicy = BlockPolicy());
 	
 	// Custom destructor
 	~DAQgUSBamp();                          
@@ -150,8 +469,15 @@ public:
 	// Opens and initializes each device in deque according to serial
 	bool OpenAndInitDevice(std::deque<std::string> inputUsbSerials);
 	
-	// Does Calibration for all channels
-	void AmpCalibration();                                        
+	// Does Calibration for all channels of all devices, or only of the devices without a recent cached calibration
+	void AmpCalibration(bool staleOnly = false);
+
+	// Keeps calibrations in fileName and reapplies them on open while they are less than maxAgeHours old (before
+	// opening the devices). An empty fileName disables the cache
+	bool SetCalibrationCache(const char *fileName, double maxAgeHours);
+
+	// True if the cache is enabled and an opened device has no recent calibration
+	bool CalibrationStale();
 	
 	// Starts acquisition loop
 	void StartAcquisition();
@@ -170,9 +496,22 @@ public:
 
 	// Collects NumSamples data and puts it to data buffer and will saved all of the data in FileName file 
 	void GetData(float *destBuffer, int  NumSamples);                             
+
+	// Collects NumSamples samples of the selected channels (indices in a scan, numChannels for the trigger) channel by
+	// channel: NumSamples values of channels[0], then of channels[1]... False if a channel is out of range, on overrun
+	// or when acquisition stops
+	bool GetChannelData(float *destBuffer, int NumSamples, std::vector<int> channels);
 	
 	// Gets number of samples available in buffer
 	int AvailableSamples();
+
+	// Waits until numSamples samples are available, woken once when they are. timeoutMs < 0 waits without deadline.
+	// False on timeout or when acquisition stops
+	bool WaitForSamples(int numSamples, int timeoutMs);
+
+	// Waits for the trigger to change to triggerValue (-1 for any non-zero value) in the data acquired after the call.
+	// Returns the position of that scan from the next sample GetData returns, or -1 on timeout or when acquisition stops
+	int WaitForTrigger(int triggerValue, int timeoutMs);
 	
 	// Prints filter information given filter index
 	void PrintFilterInfo(int filterIndex);
@@ -183,5 +522,181 @@ public:
 	// Sends 4 bit trigger
 	void SendTrigger(bool * state);
 
+	// Forgets the devices found by the last port scan, so the next OpenAndInitDevice scans the ports again
+	static void ClearDeviceInventory();
+
+	// Replaces the amplifiers by numDevices simulated ones with completion jitter (before opening the devices), whose
+	// digital outputs reach the trigger channel loopbackDelayMs after SendTrigger
+	bool UseSimulatedDevice(int numDevices, double jitterMs, double stallProbability, double maxStallMs, double loopbackDelayMs = 0);
+
+	// Replaces the amplifiers by the replay of a recording (before opening the devices): at speed times real time, as
+	// fast as the acquisition consumes it for a speed of 0, from its start again once it ends if loop is set. The
+	// device of amplifier k is UB-REPLAY.0k, k = 1 being the master
+	bool UseReplayDevice(const char *fileName, double speed, bool loop);
+
+	// True once the replayed recording has ended (acquisition stops by itself)
+	bool ReplayFinished();
+
+	// Sets block size, queue depth and wake-up granularity (before opening the devices)
+	bool SetBlockPolicy(BlockPolicy blockPolicy);
+
+	// Scans per transfer
+	int BlockScans();
+
+	// Sets the number of transfers queued per device (0 keeps the one of the block policy), deepened up to maxDepth when
+	// adaptive (before starting acquisition)
+	bool SetQueueDepth(int depth, int maxDepth, bool adaptive);
+
+	// Number of amplifiers used
+	int NumDevices();
+
+	// Copies queue depth and completion latency percentiles (50, 95 and 99, in ms) per device. Returns scans lost by
+	// the devices (-1 if the driver cannot tell) and sets numBlocks to the number of merged blocks
+	long long GetTransferStats(int *queueDepth, double *latencyMs, long long *numBlocks);
+
+	// Calls callback with every merged block (scans of all channels, then trigger) on a dispatch thread. When the
+	// subscriber lags maxQueuedBlocks blocks behind, its oldest block is dropped. Returns the subscriber id
+	int SubscribeBlocks(BlockDispatcher::BlockCallback callback, int maxQueuedBlocks);
+
+	// Removes a block subscriber, waiting for its callback in progress (not from inside that callback)
+	bool UnsubscribeBlocks(int subscriberId);
+
+	// Copies delivered and dropped blocks, queue length, lag and callback time of a subscriber
+	bool GetSubscriberStats(int subscriberId, SubscriberStats *stats);
+
+	// Sets the cores, priority and memory locking of the acquisition and dispatch threads (before starting acquisition)
+	bool SetSchedulingPolicy(SchedulingPolicy policy);
+
+	// Stores the application buffer as half precision or as int16 with gains in uV per step (one per channel, empty for
+	// SampleCodec::DEFAULT_INT16_GAIN), halving its memory. GetData converts back to floats, recordings stay float32
+	// (before starting acquisition)
+	bool SetSampleStorage(SampleStorage storage, std::vector<float> gains);
+
+	// Values clipped to the range of the compact storage since acquisition started
+	long long ClippedValues();
+
+	// Copies page faults of the process and context switches of the acquisition thread since acquisition started.
+	// False before the first start
+	bool GetSchedulingStats(long long *pageFaults, long long *contextSwitches);
+
+	// Runs the acquisition of this group on the I/O threads of the process wide engine (created with numIoThreads
+	// threads by its first user) instead of a thread of its own; 0 returns to a thread of its own. The acquisition core
+	// of the scheduling policy only applies to a thread of its own (before starting acquisition)
+	bool UseSharedEngine(int numIoThreads);
+
+	// I/O thread of the shared engine acquiring this group. -1 if not acquiring on the engine
+	int EngineThread();
+
+	// Enables signal quality metrics of every channel over windows of windowSec: RMS, power at lineFrequency, flatline
+	// (peak to peak below flatlineUv), saturation (values at or beyond saturationUv) and DC drift. They are computed on
+	// a dispatch thread and logged next to the recording (<file>.quality.csv)
+	bool EnableSignalQuality(double windowSec, double lineFrequency, double saturationUv, double flatlineUv);
+
+	// Disables the signal quality metrics
+	void DisableSignalQuality();
+
+	// Copies the quality of each channel in the last complete window. Returns the number of windows since acquisition
+	// started or -1 if disabled
+	int GetSignalQuality(ChannelQuality *quality);
+
+	// Measures the electrode impedance of every acquired channel in kOhm (in the order of GetData), all devices at once
+	// with one worker each. Devices open and not acquiring. False if a channel couldn't be measured
+	bool MeasureImpedance(double *impedanceKOhm);
+
+	// Measures impedances continuously, each device refreshing its channels in turn, until StopImpedanceMonitor (or
+	// StartAcquisition). Devices open and not acquiring
+	bool StartImpedanceMonitor();
+
+	// Ends continuous impedance measurement, waiting for the measurements in progress
+	void StopImpedanceMonitor();
+
+	// Copies the latest impedances (kOhm, NaN until measured). Returns the number of sweeps every device has
+	// completed, -1 if impedances were never measured
+	int GetImpedances(double *impedanceKOhm);
+
+	// Enables online SSVEP feature extraction (band power and CCA) on all acquired channels
+	bool EnableFeatureEngine(std::vector<double> stimFrequencies, int numHarmonics, double windowSec, double hopSec);
+
+	// Disables online feature extraction
+	void DisableFeatureEngine();
+
+	// Number of classes scored by the feature engine. 0 if disabled
+	int NumFeatureClasses();
+
+	// Copies latest per class band power and canonical correlation. Returns number of updates or -1 if disabled
+	int GetFeatureScores(double *bandPower, double *canonicalCorrelation);
+
+	// Enables early stopping: posteriors of block trials are updated on every block (needs the trigger channel)
+	bool EnableTrialClassifier(std::vector<double> stimFrequencies, int numHarmonics, std::vector<double> prior, double threshold, double minTrialSec, double evidenceGain);
+
+	// Disables early stopping
+	void DisableTrialClassifier();
+
+	// Number of classes of the trial classifier. 0 if disabled
+	int NumTrialClasses();
+
+	// Copies posteriors of the current (or last) trial. Returns the trial state or -1 if disabled
+	int GetTrialPosterior(double *aPosteriori, int *classIndex, int *numTrialSamples);
+
+	// Waits until the current trial is decided or ends. False on timeout or if disabled
+	bool WaitForTrialDecision(int timeoutMs, double *aPosteriori, int *classIndex, int *numTrialSamples);
+
+	// Enables EOG artifact detection on derivations plusChannels[i] - minusChannels[i] (positions in GetData, 0 based,
+	// -1 for a single channel): deviation above thresholdUv, slope above slopeUvPerSec (0 disables) or correlation
+	// with a blink above templateCorrelation (0 disables). Flags are widened by marginSec and attached to block trials
+	bool EnableEOGDetector(std::vector<int> plusChannels, std::vector<int> minusChannels, double thresholdUv, double slopeUvPerSec, double templateCorrelation, double marginSec);
+
+	// Disables EOG artifact detection
+	void DisableEOGDetector();
+
+	// Copies the artifact spans and the flags of the trials ended since acquisition started. False if disabled
+	bool GetEOGArtifacts(std::vector<ArtifactSpan> &spans, std::vector<TrialArtifacts> &trials);
+
+	// Waits until a block trial ends and copies its flags. False on timeout or if disabled
+	bool WaitForTrialArtifacts(int timeoutMs, TrialArtifacts *trial);
+
+	// Enables the min/max envelope of every channel and the trigger over the last historySec, kept at several
+	// resolutions on a dispatch thread for live display and written next to the recording (<file>.envelope)
+	bool EnableEnvelope(double historySec);
+
+	// Disables the envelope
+	void DisableEnvelope();
+
+	// Copies the envelope of the values (positions in GetData, numChannels being the trigger) over numScans scans from
+	// startScan (counted since acquisition started) drawn on width pixels, one row of width per value. Pixels not
+	// acquired or out of the history are NaN. Returns the level used (bins of 4^level scans) or -1 if disabled/invalid
+	int GetEnvelope(std::vector<int> values, long long startScan, long long numScans, int width, float *minimum, float *maximum);
+
+	// Scans in the envelope since acquisition started. -1 if disabled
+	long long EnvelopeScans();
+
+	// Writes the trigger pattern value (bit 0 is output 0) from the trigger scheduler thread at host time seconds
+	// (TriggerClock), or on scan (counted since acquisition started). The time each pattern is written at is kept in
+	// GetTriggerEvents and logged next to the recording (<file>.triggers.csv). Returns the event id, -1 if not acquiring
+	int ScheduleTrigger(int value, double seconds);
+	int ScheduleTriggerAtScan(int value, long long scan);
+
+	// Host clock of the trigger scheduler, in seconds
+	double TriggerClock();
+
+	// Send to sample latency of the trigger outputs in ms, as measured through the loopback (TriggerLatencyBenchmark).
+	// Triggers on a scan are written that much earlier
+	void SetTriggerLatency(double latencyMs);
+
+	// Cancels the scheduled triggers not written yet. Returns how many
+	int CancelTriggers();
+
+	// Copies the triggers scheduled since acquisition started, with the time each was written
+	void GetTriggerEvents(std::vector<TriggerEvent> &events);
+
+	// Sets when recordings are synced to disk and committed, the size of their writes and the file space reserved at a
+	// time. A crash loses only the scans not committed, SessionRecorder::Recover truncates the file to them (before
+	// starting acquisition)
+	bool SetDurabilityPolicy(DurabilityPolicy policy);
+
+	// Copies the bytes written and committed, and the cost of the writes and syncs of the recording in progress (or
+	// of the last one)
+	void GetRecorderStats(RecorderStats *stats);
+
 };
 #endif
@@ -0,0 +1,176 @@
+//_____________________________________________________________________________
+//    EOGArtifactDetector.h
+//
+//	  Created: Oct 2026
+//
+//_____________________________________________________________________________
+//
+
+#ifndef EOGARTIFACTDETECTOR_H
+#define EOGARTIFACTDETECTOR_H
+
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+
+// Span of scans contaminated by eye movements or blinks
+struct ArtifactSpan
+{
+	// First scan and one past the last scan, counted since Reset (margins included)
+	long long startScan;
+	long long endScan;
+
+	// Largest deviation from the baseline of any derivation inside the span, in uV
+	double peakUv;
+
+	// Criteria that flagged the span (EOGArtifactDetector::ARTIFACT_* bits)
+	int causes;
+};
+
+// Artifact flags of one block trial
+struct TrialArtifacts
+{
+	// First scan of the trial (last zero scan before the trigger rises, as SessionFile::FindTrials) and its length
+	long long startScan;
+	int length;
+
+	// Scans of the trial inside artifact spans
+	int artifactScans;
+
+	// Some scans of the trial inside artifact spans
+	bool contaminated;
+};
+
+/*
+ * Streaming EOG artifact detector. Each derivation is the difference of two channels (or a single channel), as the
+ * vertical and horizontal EOG of plotEOG.m. A scan is flagged when a derivation departs from its baseline (a slow
+ * moving average) by more than the threshold, when it changes faster than the slope limit over SLOPE_MS, or when the
+ * last blink template length of samples correlates with the blink template above the correlation limit while
+ * spanning at least half of the threshold. Flagged scans are widened by a margin and merged into spans as blocks
+ * arrive. Block trials are followed on the trigger, and the flags of each trial are available as soon as the trigger
+ * falls so that the speller can repeat it. Template matches are only found once the whole template has been
+ * received, so a blink in the last template length of a trial can be missed by the template (not by threshold or
+ * slope) when the trial ends.
+ */
+class EOGArtifactDetector
+{
+public:
+
+	// Criteria that flagged a span
+	static const int ARTIFACT_THRESHOLD = 1;
+	static const int ARTIFACT_SLOPE = 2;
+	static const int ARTIFACT_TEMPLATE = 4;
+
+	// Time constant of the baseline, span of the slope and length of the default blink template
+	static const int BASELINE_MS = 2000;
+	static const int SLOPE_MS = 50;
+	static const int BLINK_MS = 300;
+
+	// Spans and trials kept (the oldest are dropped)
+	static const int MAX_SPANS = 1024;
+	static const int MAX_TRIALS = 1024;
+
+	// Constructor. plusIndices and minusIndices are positions inside a scan (0 based) of the channels of each
+	// derivation, -1 for a single channel derivation. triggerIndex is -1 to flag spans without following trials.
+	// A slope or correlation of 0 disables that criterion; an empty template uses BlinkTemplate
+	EOGArtifactDetector(int sampleRate, std::vector<int> plusIndices, std::vector<int> minusIndices, int triggerIndex,
+		double thresholdUv, double slopeUvPerSec, double templateCorrelation, int marginLength, std::vector<double> blinkTemplate);
+
+	// Forgets spans, trials and baselines. Scans are counted again from 0
+	void Reset();
+
+	// Appends numScans interleaved scans of scanStride values each. Returns true if a trial ended
+	bool PushBlock(const float *block, int numScans, int scanStride);
+
+	// Copies the spans and the ended trials kept since Reset
+	void GetArtifacts(std::vector<ArtifactSpan> &spans, std::vector<TrialArtifacts> &trials);
+
+	// Appends the spans that can no longer grow to spans and forgets them, so long recordings are not limited to
+	// MAX_SPANS. Trials ended later don't count the scans of the spans taken
+	void TakeFinishedSpans(std::vector<ArtifactSpan> &spans);
+
+	// Copies the flags of the trial in progress. False if no trial is in progress
+	bool GetCurrentTrial(TrialArtifacts *trial);
+
+	// Waits until a trial ends and consumes its flags. False on timeout
+	bool WaitForTrialEnd(int timeoutMs, TrialArtifacts *trial);
+
+	// Number of derivations
+	int NumDerivations() const { return (int) _plusIndices.size(); }
+
+	// Half sine blink of BLINK_MS
+	static std::vector<double> BlinkTemplate(int sampleRate);
+
+	// Number of scans of each trial (from SessionFile::FindTrials) inside the spans
+	static void FlagTrials(const std::vector<ArtifactSpan> &spans, const std::vector<long long> &trialStarts,
+		const std::vector<int> &trialLengths, std::vector<int> &artifactScans);
+
+private:
+
+	// Flags scans [startScan, endScan) widened by the margin (called with _lock held)
+	void Flag(long long startScan, long long endScan, double peakUv, int causes);
+
+	// Scans of [startScan, endScan) inside the spans (called with _lock held)
+	int CountArtifactScans(long long startScan, long long endScan) const;
+
+	// Correlation of the last template length of samples of a derivation with the template, and their peak to peak
+	double MatchTemplate(int derivation, double *peakToPeak) const;
+
+	// Sample rate in Hz
+	int _sampleRate;
+
+	// Positions inside a scan of the channels of each derivation
+	std::vector<int> _plusIndices;
+	std::vector<int> _minusIndices;
+
+	// Position inside a scan of the trigger, -1 if not followed
+	int _triggerIndex;
+
+	// Detection limits
+	double _thresholdUv;
+	double _slopeUvPerSec;
+	double _templateCorrelation;
+	int _marginLength;
+
+	// Weight of a new sample in the baseline
+	double _baselineWeight;
+
+	// Samples between the ends of the slope
+	int _slopeLength;
+
+	// Zero mean template, its norm, and the scans between two matches
+	std::vector<double> _template;
+	double _templateNorm;
+	int _templateHop;
+
+	// Recent samples of each derivation minus its first sample, in a ring of _historyLength
+	std::vector< std::vector<float> > _history;
+	int _historyLength;
+
+	// First sample and baseline of each derivation
+	std::vector<double> _reference;
+	std::vector<double> _baseline;
+
+	// Scans received since Reset
+	long long _numScans;
+
+	// Flagged spans, merged, oldest first
+	std::deque<ArtifactSpan> _spans;
+
+	// Ended trials, oldest first
+	std::deque<TrialArtifacts> _trials;
+
+	// True while the trigger is non-zero, and the first scan of the trial in progress (-1 if none)
+	bool _triggerOn;
+	long long _trialStart;
+
+	// True when an ended trial has not been consumed by WaitForTrialEnd
+	bool _trialPending;
+
+	// Mutex and condition protecting the spans and trials
+	std::mutex _lock;
+	std::condition_variable _trialEnded;
+};
+
+#endif
@@ -0,0 +1,72 @@
+//_____________________________________________________________________________
+//    EnvelopeFile.h
+//
+//	  Created: Oct 2026
+//
+//_____________________________________________________________________________
+//
+
+#ifndef ENVELOPEFILE_H
+#define ENVELOPEFILE_H
+
+#include <vector>
+#include <fstream>
+#include "SessionFile.h"
+
+/*
+ * Reads the envelope file written by EnvelopePyramid next to a recording, so long sessions can be browsed at any
+ * zoom: pixels covering at least a bin of EnvelopePyramid::FILE_FIRST_LEVEL are drawn from the envelope file (a few
+ * bins per pixel, wherever they are in the session), finer ones from the samples of the recording itself. Without an
+ * envelope file every pixel is drawn from the samples.
+ */
+class EnvelopeFile
+{
+public:
+
+	// Constructor
+	EnvelopeFile();
+
+	// Opens the envelope file and checks its header against the layout of EnvelopePyramid
+	bool Open(const char *fileName);
+
+	// Closes the file
+	void Close();
+
+	// Same as EnvelopePyramid::GetEnvelope over the recording (values are positions in a scan, NumChannels() being
+	// the trigger). Returns the level used (0 for the samples), -1 if the arguments are invalid
+	int GetEnvelope(const SessionFile &session, const int *values, int numValues, long long startScan, long long numScans, int width, float *minimum, float *maximum);
+
+	// Header fields
+	int SampleRate() const { return _sampleRate; }
+	int NumValues() const { return _numValues; }
+
+	// Chunks in the file
+	long long NumChunks() const { return _numChunks; }
+
+private:
+
+	// Reads numBins bins of a level from firstBin for one value, NaN where the file has none
+	void ReadBins(int level, int value, long long firstBin, int numBins, float *minimum, float *maximum);
+
+	// Header fields
+	int _sampleRate;
+	int _numValues;
+
+	// Chunks in the file
+	long long _numChunks;
+
+	// File offset of each level inside a chunk, in floats
+	std::vector<long long> _levelOffsets;
+
+	// Envelope file
+	std::ifstream _file;
+
+	// Bins of one value read for a request
+	std::vector<float> _binMinimum;
+	std::vector<float> _binMaximum;
+
+	// Samples of one pixel read from the recording
+	std::vector<float> _samples;
+};
+
+#endif
@@ -0,0 +1,134 @@
+//_____________________________________________________________________________
+//    EnvelopePyramid.h
+//
+//	  Created: Oct 2026
+//
+//_____________________________________________________________________________
+//
+
+#ifndef ENVELOPEPYRAMID_H
+#define ENVELOPEPYRAMID_H
+
+#include <vector>
+#include <mutex>
+#include <fstream>
+
+/*
+ * Min/max envelope of every value of a scan (channels and trigger) at NUM_LEVELS resolutions, kept incrementally as
+ * blocks arrive so a display can draw any time range at its pixel width without copying the samples. Level 0 holds
+ * the samples, a bin of level l covers FACTOR^l scans and is derived from FACTOR bins of level l - 1 once they are
+ * complete. Each level is a ring holding at least historyLength scans, channel-major so that the bins of one channel
+ * are contiguous.
+ *
+ * The levels from FILE_FIRST_LEVEL up can also be written to an envelope file next to the recording (see
+ * EnvelopeFile): a header and then one chunk per bin of the coarsest level, holding the bins of every file level it
+ * covers, so a bin is found in the file by arithmetic alone.
+ */
+class EnvelopePyramid
+{
+public:
+
+	// Scans per bin of a level over the previous one, number of levels and first level written to file
+	static const int FACTOR = 4;
+	static const int NUM_LEVELS = 8;
+	static const int FILE_FIRST_LEVEL = 2;
+
+	// Version written in the envelope file header
+	static const int FILE_VERSION = 1;
+
+	// Constructor. Keeps the envelope of the last historyLength scans (at least one chunk)
+	EnvelopePyramid(int sampleRate, int numValues, long long historyLength);
+
+	// Destructor. Closes the file
+	~EnvelopePyramid();
+
+	// Forgets every bin. Scans are counted again from 0
+	void Reset();
+
+	// Appends numScans interleaved scans of scanStride values each (the first numValues of each are kept)
+	void PushBlock(const float *block, int numScans, int scanStride);
+
+	// Copies the envelope of the values (positions in a scan) over numScans scans from startScan split into width
+	// pixels into minimum and maximum (numValues x width, one row of width per value). The coarsest level with at
+	// least one bin per pixel is used. Pixels out of the history (or not acquired yet) are NaN. Returns the level
+	// used, -1 if the arguments are invalid
+	int GetEnvelope(const int *values, int numValues, long long startScan, long long numScans, int width, float *minimum, float *maximum);
+
+	// Scans received since Reset
+	long long NumScans();
+
+	// Writes the file levels of every chunk completed from now on to an envelope file (created with its header).
+	// False if it can't be created
+	bool OpenFile(const char *fileName);
+
+	// Writes the last (incomplete) chunk and closes the file
+	void CloseFile();
+
+	// Number of values kept per scan
+	int NumValues() const { return _numValues; }
+
+	// Scans per bin of a level
+	static long long BinScans(int level);
+
+	// Bins of a level in one file chunk
+	static int ChunkBins(int level);
+
+	// Floats of one file chunk for numValues values
+	static long long ChunkFloats(int numValues);
+
+	// Coarsest level with at least one bin per pixel when numScans are drawn on width pixels
+	static int ChooseLevel(long long numScans, int width);
+
+	// Scans [*first, *end) drawn on pixel p (at least one)
+	static void PixelScans(long long startScan, long long numScans, int width, int pixel, long long *first, long long *end);
+
+	// Bins [*firstBin, *endBin) of a level holding the scans drawn on pixel p
+	static void PixelBins(long long startScan, long long numScans, int width, int pixel, int level, long long *firstBin, long long *endBin);
+
+private:
+
+	// Bins of each level, and the minimum and maximum of the bin being filled
+	struct Level
+	{
+		// Ring of bins of each value: value v, bin b at [v * capacity + b % capacity]
+		std::vector<float> minimum;
+		std::vector<float> maximum;
+		long long capacity;
+
+		// Bins completed since Reset
+		long long numBins;
+
+		// Bin being filled, one per value, and the bins (or scans) it has received
+		std::vector<float> partialMinimum;
+		std::vector<float> partialMaximum;
+		int partialCount;
+	};
+
+	// Stores a complete bin of level l (from the partial one) and feeds it to level l + 1 (called with _lock held)
+	void CompleteBin(int level);
+
+	// Envelope of bin b of level l for one value, including the partial bins of the finer levels for the bin being
+	// filled. False if the bin is out of the history or empty
+	bool GetBin(int level, int value, long long bin, float *minimum, float *maximum) const;
+
+	// Writes the chunk that ends with the coarsest bin completed last, or the partial one (called with _lock held)
+	void WriteChunk(bool partial);
+
+	int _sampleRate;
+	int _numValues;
+
+	// Levels, level 0 holding the samples in minimum only
+	std::vector<Level> _levels;
+
+	// Scans received since Reset
+	long long _numScans;
+
+	// Chunk being written and the envelope file, written when open
+	std::vector<float> _chunk;
+	std::ofstream _file;
+
+	// Mutex used to push blocks, read the envelope and open the file from different threads
+	std::mutex _lock;
+};
+
+#endif
@@ -0,0 +1,55 @@
+//_____________________________________________________________________________
+//    FrontEndFilter.h
+//
+//	  Created: Oct 2026
+//
+//_____________________________________________________________________________
+//
+
+#ifndef FRONTENDFILTER_H
+#define FRONTENDFILTER_H
+
+#include <vector>
+
+/*
+ * Streaming version of DAQbase.ApplyFrontEndFilter: filters each channel with filter(num, den, x, state) (direct form
+ * II transposed, state kept between blocks), so a recording can be filtered block by block with the same result as
+ * filtering it at once. The coefficients come from MATLAB (e.g. frontEndFilterBP, see exportFrontEndFilter.m).
+ */
+class FrontEndFilter
+{
+public:
+
+	// Constructor. den empty means FIR (den = 1)
+	FrontEndFilter(std::vector<double> num, std::vector<double> den, int numChannels);
+
+	// Clears the filter state
+	void Reset();
+
+	// Filters numScans scans in place. The first numChannels values of each scan are filtered, the rest of the scan
+	// (scanStride values in total) is left untouched
+	void Apply(float *scans, int numScans, int scanStride);
+
+	// Reads coefficients from a text file: numerator on the first line, optional denominator on the second
+	static bool ReadCoefficients(const char *fileName, std::vector<double> &num, std::vector<double> &den);
+
+	// Group delay of a linear phase FIR filter in samples, round(order / 2) as in DAQbase
+	static int LinearPhaseDelay(const std::vector<double> &num) { return (int) (num.size() / 2); }
+
+private:
+
+	// Normalized coefficients, both of length _order + 1
+	std::vector<double> _num;
+	std::vector<double> _den;
+
+	// Filter order
+	int _order;
+
+	// Number of filtered channels
+	int _numChannels;
+
+	// Filter state, _order values per channel
+	std::vector<double> _state;
+};
+
+#endif
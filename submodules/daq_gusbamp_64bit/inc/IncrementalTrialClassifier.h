@@ -0,0 +1,135 @@
+//_____________________________________________________________________________
+//    IncrementalTrialClassifier.h
+//
+//	  Created: Oct 2026
+//
+//_____________________________________________________________________________
+//
+
+#ifndef INCREMENTALTRIALCLASSIFIER_H
+#define INCREMENTALTRIALCLASSIFIER_H
+
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+
+/*
+ * Classifies an SSVEP block trial while it is being acquired. A trial is the span where the trigger is non-zero
+ * (same convention as GetTrial in 'block' mode). After every block the canonical correlation of the samples
+ * received since trial onset is computed for each stimulus frequency and the class posteriors are updated. Once the
+ * largest posterior crosses the threshold the trial is marked as decided so the speller can stop it early.
+ *
+ * The covariances of the channels and templates are kept as running sums updated with each scan, so a block costs the
+ * same at any point of the trial, however long it has been running.
+ *
+ * Evidence model: the Fisher z of each canonical correlation is treated as Gaussian with a variance that shrinks with
+ * the number of samples n, so log p(class c | trial) = log prior(c) + n * evidenceGain * atanh(rho_c) + const, where
+ * evidenceGain = (mean z of the target - mean z of a non-target) / (per sample variance of z).
+ */
+class IncrementalTrialClassifier
+{
+public:
+
+	// States of the current trial
+	static const int TRIAL_IDLE = 0;		// no trial since Reset
+	static const int TRIAL_RUNNING = 1;		// trigger on, threshold not crossed
+	static const int TRIAL_DECIDED = 2;		// threshold crossed, trigger still on
+	static const int TRIAL_ENDED = 3;		// trigger back to zero
+
+	// Constructor. channelIndices and triggerIndex are positions inside a scan (0 based)
+	IncrementalTrialClassifier(int sampleRate, std::vector<int> channelIndices, int triggerIndex,
+		std::vector<double> stimFrequencies, int numHarmonics, std::vector<double> prior,
+		double threshold, int minTrialLength, double evidenceGain);
+
+	// Forgets the current trial and any pending decision
+	void Reset();
+
+	// Appends numScans interleaved scans of scanStride values each. Returns true if a decision became available
+	bool PushBlock(const float *block, int numScans, int scanStride);
+
+	// Copies the posteriors of the current (or last) trial. Returns the trial state
+	int GetPosterior(double *aPosteriori, int *classIndex, int *numTrialSamples);
+
+	// Waits until the current trial is decided or ended and consumes that decision. False on timeout
+	bool WaitForDecision(int timeoutMs, double *aPosteriori, int *classIndex, int *numTrialSamples);
+
+	// Number of classes (stimulus frequencies)
+	int NumClasses() const { return (int) _stimFrequencies.size(); }
+
+private:
+
+	// Recomputes the posteriors from the sums of the samples received since trial onset
+	void UpdatePosterior();
+
+	// Clears the sums for a new trial
+	void ClearTrial();
+
+	// Adds one scan of the trial to the sums
+	void AccumulateScan(const float *scan);
+
+	// Sample rate in Hz
+	int _sampleRate;
+
+	// Positions inside a scan of the channels to use
+	std::vector<int> _channelIndices;
+
+	// Position inside a scan of the trigger
+	int _triggerIndex;
+
+	// Stimulus frequencies in Hz, one per class
+	std::vector<double> _stimFrequencies;
+
+	// Number of harmonics in the templates
+	int _numHarmonics;
+
+	// Log of the class prior
+	std::vector<double> _logPrior;
+
+	// Posterior that has to be crossed to decide
+	double _threshold;
+
+	// Minimum number of samples before a decision can be taken
+	int _minTrialLength;
+
+	// Log posterior gain per sample and unit of Fisher z
+	double _evidenceGain;
+
+	// Angular frequency (radians per sample) of each template of each class: a sine and a cosine per harmonic below
+	// Nyquist
+	std::vector< std::vector<double> > _templateFrequencies;
+
+	// Samples of the current trial, and its first sample on each channel (subtracted before summing so the sums keep
+	// their precision with large offsets)
+	int _trialLength;
+	std::vector<double> _origin;
+
+	// Sums over the current trial of the channels and their products (numChannels x numChannels), then for each class
+	// of the templates, their products and the channel x template products
+	std::vector<double> _sumX;
+	std::vector<double> _sumXX;
+	std::vector< std::vector<double> > _sumY;
+	std::vector< std::vector<double> > _sumYY;
+	std::vector< std::vector<double> > _sumXY;
+
+	// Channel and template values of one scan
+	std::vector<double> _scanValues;
+	std::vector<double> _templateValues;
+
+	// True while the trigger is non-zero
+	bool _triggerOn;
+
+	// Trial state and posteriors, protected by _stateLock
+	int _state;
+	std::vector<double> _aPosteriori;
+	int _classIndex;
+	int _numTrialSamples;
+
+	// True when a decided/ended trial has not been consumed by WaitForDecision
+	bool _decisionPending;
+
+	// Mutex and condition protecting the trial state
+	std::mutex _stateLock;
+	std::condition_variable _decisionReady;
+};
+
+#endif
@@ -0,0 +1,113 @@
+//_____________________________________________________________________________
+//    ReadNotifier.h
+//
+//	  Created: Oct 2026
+//
+//_____________________________________________________________________________
+//
+
+#ifndef READNOTIFIER_H
+#define READNOTIFIER_H
+
+#include <list>
+#include <mutex>
+#include <condition_variable>
+
+/*
+ * Wakes readers of the application buffer when what they wait for has been written, instead of on every block. A
+ * reader registers a condition (a number of unread samples, or the onset of a trigger value) and sleeps on its own
+ * condition variable; the writer checks the registered conditions as it publishes each block and notifies only the
+ * readers whose condition became true, once. Without waiters, publishing a block only adds to a counter. Conditions are
+ * checked on every block, but the readers they hold for are only woken every wakeBlocks blocks (SetWakeBlocks).
+ *
+ * Samples are counted from Reset: Publish adds the written ones, Consume the read ones, and the difference is what a
+ * reader can take. Both must be called in the same order as the buffer is written and read (under the buffer lock).
+ */
+class ReadNotifier
+{
+public:
+
+	// Wait for any non-zero trigger value
+	static const int ANY_TRIGGER = -1;
+
+	// Constructor
+	ReadNotifier();
+
+	// Clears the counters and the trigger history and accepts waits again
+	void Reset();
+
+	// Blocks published per wake-up of the readers (1, every block, by default)
+	void SetWakeBlocks(int wakeBlocks);
+
+	// Wakes every waiter with a failure and makes later waits fail until Reset (acquisition stopped)
+	void Close();
+
+	// Adds numScans written scans of scanStride values each. triggerIndex is the position of the trigger inside a scan
+	// (-1 if there is none)
+	void Publish(const float *block, int numScans, int scanStride, int triggerIndex);
+
+	// Adds numSamples read samples
+	void Consume(long long numSamples);
+
+	// Counts every written sample as read (buffer reset after an overrun)
+	void Discard();
+
+	// Waits until at least numSamples samples are unread. timeoutMs < 0 waits without deadline. False on timeout or close
+	bool WaitForSamples(long long numSamples, int timeoutMs);
+
+	// Waits for the first scan written after the call where the trigger changes to triggerValue (ANY_TRIGGER for any
+	// non-zero value). Returns its position from the next sample to read, or -1 on timeout or close
+	long long WaitForTrigger(int triggerValue, int timeoutMs);
+
+	// Unread samples
+	long long AvailableSamples();
+
+	// Number of times a waiter has been woken up
+	long long NumWakeups();
+
+private:
+
+	// Condition registered by one waiting reader
+	struct Waiter
+	{
+		// Unread samples needed, or -1 when waiting for a trigger
+		long long numSamples;
+
+		// Trigger value waited for
+		int triggerValue;
+
+		// Set by the writer when the condition is met, with the sample number of the trigger scan
+		bool satisfied;
+		long long triggerSample;
+
+		std::condition_variable ready;
+	};
+
+	// Waits on waiter until it is satisfied, the deadline passes or the notifier is closed
+	bool Wait(std::unique_lock<std::mutex> &lock, Waiter &waiter, int timeoutMs);
+
+	// Samples written and read since Reset
+	long long _written;
+	long long _read;
+
+	// Blocks published since Reset, and blocks per wake-up
+	long long _numBlocks;
+	int _wakeBlocks;
+
+	// Trigger value of the last scan written
+	float _lastTrigger;
+
+	// Flag set by Close
+	bool _closed;
+
+	// Readers waiting
+	std::list<Waiter *> _waiters;
+
+	// Wake-ups of waiters
+	long long _numWakeups;
+
+	// Mutex protecting counters and waiters
+	std::mutex _lock;
+};
+
+#endif
@@ -0,0 +1,86 @@
+//_____________________________________________________________________________
+//    ReplayAmpDriver.h
+//
+//	  Created: Oct 2026
+//
+//_____________________________________________________________________________
+//
+
+#ifndef REPLAYAMPDRIVER_H
+#define REPLAYAMPDRIVER_H
+
+#include <afxwin.h>
+#include <map>
+#include <vector>
+#include <mutex>
+#include "gUSBamp.h"
+#include "SimulatedAmpDriver.h"
+#include "SessionFile.h"
+
+/*
+ * Amplifiers replaying a recording of DAQgUSBamp, so the acquisition thread, buffers, triggers and readers run on real
+ * EEG without hardware. Each amplifier of the recording (channels 1-16, 17-32, ...) is found as device UB-REPLAY.0k,
+ * k = 1 being the master (the amplifier with the highest channels, which holds the trigger) as in the serial list
+ * passed to OpenAndInitDevice. A device streams the recorded values of the channels it is set to acquire (which must
+ * have been recorded, at the recorded sample rate), and the recorded trigger on the trigger line (the digital outputs
+ * looped back if the recording has no trigger).
+ *
+ * The sample clocks of SimulatedAmpDriver pace the blocks at speed times the sample rate, or as fast as transfers are
+ * queued for a speed of 0. Once the recording ends the devices stop (Finished) unless it is looped; the scans after
+ * the last whole block are not replayed.
+ */
+class ReplayAmpDriver : public SimulatedAmpDriver
+{
+public:
+
+	// Constructor. Open() must succeed before the driver is used
+	ReplayAmpDriver(double speed, bool loop);
+
+	// Destructor. Closes devices left open
+	~ReplayAmpDriver();
+
+	// Maps the recording. False if it can't be read
+	bool Open(const char *fileName);
+
+	// Number of amplifiers in the recording
+	int NumAmplifiers() const { return _numAmplifiers; }
+
+	// Scans in the recording
+	long long NumScans() const { return _session.NumScans(); }
+
+	HANDLE OpenDevice(int usbPort);
+	HANDLE OpenDeviceEx(LPSTR serial);
+	BOOL CloseDevice(HANDLE *hDevice);
+
+	BOOL SetChannels(HANDLE hDevice, UCHAR *channels, UCHAR numChannels);
+	BOOL SetSampleRate(HANDLE hDevice, WORD sampleRate);
+
+protected:
+
+	bool ProduceScans(HANDLE hDevice, long long firstScan, int numScans, int numChannels, int trigger, float digitalOut, float *scans);
+
+private:
+
+	// Recording positions of the channels of one device (and of the trigger last, -1 if not recorded)
+	struct ReplayColumns
+	{
+		int amplifier;
+		std::vector<int> columns;
+	};
+
+	SessionFile _session;
+
+	// Amplifiers in the recording, numbered from the lowest channels
+	int _numAmplifiers;
+
+	// Replay the recording from its start once it ends
+	bool _loop;
+
+	// Columns replayed by each open device
+	std::map<HANDLE, ReplayColumns> _replayColumns;
+
+	// Mutex used to set the channels of a device while another one replays
+	std::mutex _columnsLock;
+};
+
+#endif
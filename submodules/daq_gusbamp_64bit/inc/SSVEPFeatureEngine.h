@@ -0,0 +1,150 @@
+//_____________________________________________________________________________
+//    SSVEPFeatureEngine.h
+//
+//	  Created: Oct 2026
+//
+//_____________________________________________________________________________
+//
+
+#ifndef SSVEPFEATUREENGINE_H
+#define SSVEPFEATUREENGINE_H
+
+#include <vector>
+#include <mutex>
+
+/*
+ * Sine/cosine templates of one stimulus frequency (and its harmonics) for a fixed window length.
+ * The span of the templates does not depend on phase, so the same object is valid for any window position.
+ */
+class CCAReference
+{
+public:
+
+	// Builds the centered templates for numHarmonics harmonics of frequency and a window of length samples. Harmonics at
+	// or above Nyquist are left out (none if frequency is)
+	CCAReference(double frequency, int sampleRate, int numHarmonics, int length);
+
+	// Largest canonical correlation between a channel-major window (numChannels x length) and the templates
+	double Correlate(const double *window, int numChannels) const;
+
+	// Largest canonical correlation from the covariances of two sets of variables (numX x numX, numX x numY and
+	// numY x numY), e.g. sums accumulated as samples arrive
+	static double CanonicalCorrelation(const double *covXX, const double *covXY, const double *covYY, int numX, int numY);
+
+	// Number of samples the templates were built for
+	int Length() const { return _length; }
+
+	// Largest eigenvalue of a symmetric n x n matrix (cyclic Jacobi, matrix is destroyed)
+	static double LargestEigenvalue(double *A, int n);
+
+	// In place Cholesky factorization (lower triangle) of a symmetric n x n matrix. False if not positive definite
+	static bool Cholesky(double *A, int n);
+
+private:
+
+	// Number of samples per template
+	int _length;
+
+	// Number of templates (2 per harmonic below Nyquist)
+	int _numTemplates;
+
+	// Centered templates, numTemplates x length
+	std::vector<double> _templates;
+
+	// Template covariance, numTemplates x numTemplates
+	std::vector<double> _covYY;
+};
+
+/*
+ * Streaming SSVEP feature extraction. Samples are pushed block by block as they are acquired and, every hop,
+ * the last window is scored against each stimulus frequency by band power (Goertzel, summed over harmonics and
+ * averaged over channels) and by canonical correlation against sine/cosine templates.
+ */
+class SSVEPFeatureEngine
+{
+public:
+
+	// Constructor. channelIndices are the positions inside a scan of the channels to use (0 based)
+	SSVEPFeatureEngine(int sampleRate, std::vector<int> channelIndices, std::vector<double> stimFrequencies,
+		int numHarmonics, int windowLength, int hopLength);
+
+	// Clears the window and the scores
+	void Reset();
+
+	// Appends numScans interleaved scans of scanStride values each and updates the scores on every hop
+	void PushBlock(const float *block, int numScans, int scanStride);
+
+	// Copies the latest scores (one per class). Returns the number of updates since the last Reset
+	int GetScores(double *bandPower, double *canonicalCorrelation);
+
+	// Number of classes (stimulus frequencies)
+	int NumClasses() const { return (int) _stimFrequencies.size(); }
+
+	// Number of channels used
+	int NumChannels() const { return (int) _channelIndices.size(); }
+
+	// Window length in samples
+	int WindowLength() const { return _windowLength; }
+
+private:
+
+	// Scores the current window
+	void ComputeScores();
+
+	// Sample rate in Hz
+	int _sampleRate;
+
+	// Positions inside a scan of the channels to use
+	std::vector<int> _channelIndices;
+
+	// Stimulus frequencies in Hz, one per class
+	std::vector<double> _stimFrequencies;
+
+	// Number of harmonics per frequency
+	int _numHarmonics;
+
+	// Number of samples in the sliding window
+	int _windowLength;
+
+	// Number of samples between score updates
+	int _hopLength;
+
+	// Sliding window as a ring per channel, channel-major (numChannels x windowLength)
+	std::vector<double> _window;
+
+	// Position of the next sample to write in the ring
+	int _writeIndex;
+
+	// Number of valid samples in the ring (saturates at windowLength)
+	int _filledSamples;
+
+	// Samples pushed since the last score update
+	int _samplesSinceUpdate;
+
+	// Unwrapped copy of the window used for scoring
+	std::vector<double> _linearWindow;
+
+	// Goertzel coefficients (2 cos(w)) per class and harmonic below Nyquist, class-major
+	std::vector<double> _goertzelCoeff;
+
+	// First Goertzel coefficient of each class (numClasses + 1 entries)
+	std::vector<int> _goertzelOffset;
+
+	// CCA templates for each class
+	std::vector<CCAReference> _references;
+
+	// Latest scores per class
+	std::vector<double> _bandPower;
+	std::vector<double> _canonicalCorrelation;
+
+	// Number of score updates since the last Reset
+	int _updateCount;
+
+	// Mutex protecting the window against a Reset from another thread
+	std::mutex _windowLock;
+
+	// Mutex protecting the scores against concurrent readers
+	std::mutex _scoreLock;
+};
+
+#endif
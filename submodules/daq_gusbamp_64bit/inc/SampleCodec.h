@@ -0,0 +1,95 @@
+//_____________________________________________________________________________
+//    SampleCodec.h
+//
+//	  Created: Oct 2026
+//
+//_____________________________________________________________________________
+//
+
+#ifndef SAMPLECODEC_H
+#define SAMPLECODEC_H
+
+#include <vector>
+#include <stdint.h>
+#include <stddef.h>
+
+// How the application buffer stores a sample
+enum SampleStorage
+{
+	// 32 bit floats as acquired
+	STORAGE_FLOAT32 = 0,
+
+	// IEEE half precision: 11 significant bits, up to 65504 uV
+	STORAGE_HALF = 1,
+
+	// Integers scaled by a gain per channel: steps of gain uV, up to 32767 gains
+	STORAGE_INT16 = 2
+};
+
+/*
+ * Converts scans (channels, then the trigger if any) between 32 bit floats and 16 bit lanes, halving the memory and
+ * bandwidth of the application buffer. Channels are stored as half precision or as int16 scaled by a gain per channel;
+ * the trigger is stored as an integer lane in both modes, so it is kept exactly. Values beyond the range of the lane
+ * are clipped to it and counted.
+ *
+ * Conversions run over whole blocks: half precision uses the F16C instructions when the build targets them (AVX2),
+ * the scalar loops are written so that the compiler can vectorize them otherwise.
+ */
+class SampleCodec
+{
+public:
+
+	// Gain of the int16 lanes when none is given, in uV per step (range +-3.3 mV)
+	static const float DEFAULT_INT16_GAIN;
+
+	// Largest half precision value
+	static const float HALF_MAX;
+
+	// Constructor. Stores float32, no channel
+	SampleCodec();
+
+	// Sets the storage of numChannels channels, followed by a trigger lane if trigger. gains (uV per step, one per
+	// channel, empty for DEFAULT_INT16_GAIN) are used by STORAGE_INT16. False if the gains don't fit
+	bool Configure(SampleStorage storage, int numChannels, bool trigger, std::vector<float> gains);
+
+	// Storage of the channels
+	SampleStorage Storage() const;
+
+	// Lanes per scan (channels and trigger)
+	int ScanStride() const;
+
+	// Converts numScans scans into 16 bit lanes (not for STORAGE_FLOAT32). Returns the number of clipped values
+	long long Encode(const float *scans, int numScans, uint16_t *lanes) const;
+
+	// Converts numScans scans of 16 bit lanes back into floats (not for STORAGE_FLOAT32)
+	void Decode(const uint16_t *lanes, int numScans, float *scans) const;
+
+	// Converts one value to half precision, rounding to nearest even
+	static uint16_t FloatToHalf(float value);
+
+	// Converts one half precision value to float
+	static float HalfToFloat(uint16_t half);
+
+private:
+
+	// Converts numValues values to half precision (clipped to HALF_MAX beforehand)
+	static void EncodeHalf(const float *values, size_t numValues, uint16_t *halves);
+
+	// Converts numValues half precision values to floats
+	static void DecodeHalf(const uint16_t *halves, size_t numValues, float *values);
+
+	// Storage of the channels
+	SampleStorage _storage;
+
+	// Number of channels
+	int _numChannels;
+
+	// True if each scan ends with a trigger lane
+	bool _trigger;
+
+	// Gain and inverse gain of each channel (int16)
+	std::vector<float> _gains;
+	std::vector<float> _inverseGains;
+};
+
+#endif
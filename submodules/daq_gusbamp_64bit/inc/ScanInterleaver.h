@@ -0,0 +1,63 @@
+//_____________________________________________________________________________
+//    ScanInterleaver.h
+//
+//	  Created: Oct 2026
+//
+//_____________________________________________________________________________
+//
+
+#ifndef SCANINTERLEAVER_H
+#define SCANINTERLEAVER_H
+
+/*
+ * Merges the blocks received from each amplifier into scans of all channels: the channels of the master (the last
+ * device) first, then those of the other devices from the last to the first, then the trigger of the master. Every
+ * device delivers scans of its channels, the master followed by its trigger value.
+ *
+ * Configure selects the kernel once per acquisition. When every device has the same number of channels (1 to
+ * MAX_CHANNELS, up to MAX_DEVICES devices), a kernel instantiated for that number of devices, channels and trigger is
+ * used: copy widths and offsets are constants, so the compiler unrolls each scan into a few vector moves (and a single
+ * device is one copy of the block). Other configurations (devices with different channels, or none on some) use the
+ * generic kernel, which reads them from the configuration every scan.
+ */
+class ScanInterleaver
+{
+public:
+
+	// Devices and channels per device the specialized kernels are instantiated for
+	static const int MAX_DEVICES = 4;
+	static const int MAX_CHANNELS = 16;
+
+	// Constructor. No device
+	ScanInterleaver();
+
+	// Sets the channels of numDevices devices (channels[i] of device i, the last one the master), followed by a
+	// trigger on the master if trigger, and selects the kernel. False if too many devices or a negative channel count
+	bool Configure(int numDevices, const int *channels, bool trigger);
+
+	// If a specialized kernel is used
+	bool Specialized() const;
+
+	// Values per merged scan (channels of every device and trigger)
+	int ScanStride() const;
+
+	// Merges numScans scans from the block of each device (devices[i] of device i) into scans
+	void Interleave(const float *const *devices, int numScans, float *scans) const;
+
+	// Merges with the generic kernel whatever the configuration, to compare with the specialized ones
+	void InterleaveGeneric(const float *const *devices, int numScans, float *scans) const;
+
+private:
+
+	// A merge kernel and the generic one
+	typedef void (*Kernel)(const ScanInterleaver &config, const float *const *devices, int numScans, float *scans);
+	static void Generic(const ScanInterleaver &config, const float *const *devices, int numScans, float *scans);
+
+	Kernel _kernel;
+	int _numDevices;
+	int _channels[MAX_DEVICES];
+	int _trigger;
+	int _scanStride;
+};
+
+#endif
@@ -0,0 +1,99 @@
+//_____________________________________________________________________________
+//    SessionFile.h
+//
+//	  Created: Oct 2026
+//
+//_____________________________________________________________________________
+//
+
+#ifndef SESSIONFILE_H
+#define SESSIONFILE_H
+
+#include <vector>
+
+/*
+ * Read-only view of a recording written by DAQgUSBamp::StartAcquisition(const char*). The file is memory mapped, so
+ * only the pages holding the requested channels and trials are read from disk and nothing is copied twice.
+ *
+ * V1 layout: version (int32), sample rate (int32), number of channels (uint8), trigger flag (int32), channel list
+ * (uint8 x numChannels) and then interleaved float32 scans (ch1, ..., chN, trigger). Channels are addressed by their
+ * position in the file (0 based); position NumChannels() is the trigger. A recording with a commit sidecar (being
+ * written, or left by a crash, see SessionRecorder) is read up to its committed length.
+ */
+class SessionFile
+{
+public:
+
+	// Constructor
+	SessionFile();
+
+	// Destructor
+	~SessionFile();
+
+	// Maps the file and parses its header
+	bool Open(const char *fileName);
+
+	// Unmaps the file
+	void Close();
+
+	// Header fields
+	int Version() const { return _version; }
+	int SampleRate() const { return _sampleRate; }
+	int NumChannels() const { return _numChannels; }
+	int TriggerFlag() const { return _triggerFlag; }
+	const std::vector<int> &ChannelList() const { return _channelList; }
+
+	// Number of complete scans in the file
+	long long NumScans() const { return _numScans; }
+
+	// Value of one channel (or the trigger) at one scan
+	float Sample(long long scan, int channel) const;
+
+	// Finds block trials the same way loadBlockTriggerData.m does: a trial starts at the last zero sample before the
+	// trigger rises and lasts until the last non-zero sample. Trials shorter than minToMaxTrial times the longest one
+	// are dropped. Returns the number of trials
+	int FindTrials(std::vector<long long> &trialStarts, std::vector<int> &trialLengths, double minToMaxTrial) const;
+
+	// Copies numScans scans from startScan of the given channels into out, numChannels x numScans (column-major),
+	// multiplied by scale
+	bool ReadSlice(const std::vector<int> &channels, long long startScan, int numScans, double scale, float *out) const;
+	bool ReadSlice(const std::vector<int> &channels, long long startScan, int numScans, double scale, double *out) const;
+
+	// Copies trialLength scans from each trial start into out, numChannels x trialLength x numTrials (column-major),
+	// multiplied by scale
+	bool ReadTrials(const std::vector<int> &channels, const std::vector<long long> &trialStarts, int trialLength, double scale, float *out) const;
+	bool ReadTrials(const std::vector<int> &channels, const std::vector<long long> &trialStarts, int trialLength, double scale, double *out) const;
+
+private:
+
+	// Checks channels and scan range before a read
+	bool CheckRange(const std::vector<int> &channels, long long startScan, int numScans) const;
+
+	// Shared implementation of the read methods
+	template <typename T> void CopyScans(const std::vector<int> &channels, long long startScan, int numScans, double scale, T *out) const;
+
+	// Header fields
+	int _version;
+	int _sampleRate;
+	int _numChannels;
+	int _triggerFlag;
+	std::vector<int> _channelList;
+
+	// Number of complete scans
+	long long _numScans;
+
+	// Values per scan (channels plus trigger)
+	int _scanSize;
+
+	// Mapped file and first byte of the scans
+	const unsigned char *_mapping;
+	const unsigned char *_scans;
+	long long _fileSize;
+
+	// OS handles of the mapping
+	void *_fileHandle;
+	void *_mappingHandle;
+	int _fileDescriptor;
+};
+
+#endif
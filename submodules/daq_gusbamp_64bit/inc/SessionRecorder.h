@@ -0,0 +1,212 @@
+//_____________________________________________________________________________
+//    SessionRecorder.h
+//
+//	  Created: Oct 2026
+//
+//_____________________________________________________________________________
+//
+
+#ifndef SESSIONRECORDER_H
+#define SESSIONRECORDER_H
+
+#include <stdint.h>
+#include <vector>
+#include <deque>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <functional>
+
+// When the recording is forced to disk and committed (see SessionRecorder). Chunks still in memory are lost by any crash
+enum DurabilityMode
+{
+	// Never: chunks are committed once written, a power loss may lose what the OS had not written yet (and leave the
+	// commit ahead of the data)
+	DURABILITY_NONE = 0,
+
+	// Every syncSeconds: chunks are committed once synced, a crash loses the last syncSeconds at most
+	DURABILITY_PERIODIC = 1,
+
+	// Every chunk: each chunk is committed once synced
+	DURABILITY_CHUNK = 2
+};
+
+/*
+ * Durability of a recording and the size of its writes: scans are gathered into chunks of chunkBytes (or whatever
+ * gathered in chunkSeconds) written with a single call, into file space reserved extentBytes at a time.
+ */
+struct DurabilityPolicy
+{
+	DurabilityMode mode;
+
+	// Time between syncs of DURABILITY_PERIODIC
+	double syncSeconds;
+
+	// Largest chunk, and longest time a chunk gathers scans
+	int chunkBytes;
+	double chunkSeconds;
+
+	// File space reserved at a time
+	long long extentBytes;
+
+	// Default policy: synced every second, chunks of up to 1 MB or 250 ms, extents of 64 MB
+	DurabilityPolicy() : mode(DURABILITY_PERIODIC), syncSeconds(1), chunkBytes(1 << 20), chunkSeconds(0.25), extentBytes(64LL << 20) {}
+
+	DurabilityPolicy(DurabilityMode durability, double sync) : mode(durability), syncSeconds(sync), chunkBytes(1 << 20), chunkSeconds(0.25), extentBytes(64LL << 20) {}
+};
+
+// Cost of the recording so far
+struct RecorderStats
+{
+	// Bytes written to the file and bytes committed (recovered after a crash)
+	long long writtenBytes;
+	long long committedBytes;
+
+	// Chunks written, extents reserved and syncs
+	long long numChunks;
+	long long numExtents;
+	long long numSyncs;
+
+	// Duration of the chunk writes and of the syncs (data and commit record)
+	double meanWriteMs;
+	double maxWriteMs;
+	double meanSyncMs;
+	double maxSyncMs;
+
+	// Chunks waiting for the writer thread now, and the most that ever waited
+	int queuedChunks;
+	int maxQueuedChunks;
+};
+
+/*
+ * Writes a recording (header, then the scans) from a thread of its own, so the acquisition thread only copies each
+ * block into the chunk being gathered and never waits for the disk. File space is reserved in large extents instead of
+ * growing the file by each block.
+ *
+ * The length of the file that holds valid data is kept in a sidecar, <file>.commit, updated once the chunks up to it
+ * are written and, depending on the DurabilityPolicy, synced (the data before the record). A crash leaves the reserved
+ * space beyond it: Recover truncates the file to the committed length and removes the sidecar, and SessionFile reads
+ * only the committed scans until then. Close truncates the file to its data and removes the sidecar.
+ *
+ * The sidecar holds two checksummed records written alternately, so a record torn by a power loss leaves the other.
+ */
+class SessionRecorder
+{
+public:
+
+	// Suffix of the sidecar
+	static const char *COMMIT_SUFFIX;
+
+	// Chunk buffers allocated ahead when a recording opens
+	static const int SPARE_CHUNKS = 3;
+
+	// Called on the writer thread before it writes anything (core, priority)
+	typedef std::function<void()> ThreadSetup;
+
+	// Constructor
+	SessionRecorder();
+
+	// Destructor. Closes the recording
+	~SessionRecorder();
+
+	// Creates fileName (replacing it), writes the header and starts the writer thread, which runs setup first. False
+	// if the file or its sidecar can't be created
+	bool Open(const char *fileName, const void *header, int headerBytes, DurabilityPolicy policy, ThreadSetup setup = ThreadSetup());
+
+	// Whether a recording is open
+	bool IsOpen() const { return _open; }
+
+	// Appends numValues values to the recording. Copies them and returns, the writer thread writes them
+	void Append(const float *values, size_t numValues);
+
+	// Writes the chunk being gathered and the ones queued, syncs them unless DURABILITY_NONE, truncates the file to its
+	// data and removes the sidecar. False if a write failed during the recording
+	bool Close();
+
+	// Copies the cost of the recording so far (or of the last one once closed)
+	void GetStats(RecorderStats *stats);
+
+	// Length of fileName holding valid data according to its sidecar. False if there is no valid sidecar (the file was
+	// closed)
+	static bool CommittedLength(const char *fileName, long long *length);
+
+	// Truncates a recording left by a crash to its committed length and removes the sidecar. Returns the length of
+	// the file (unchanged if it was closed), -1 if it can't be opened or truncated
+	static long long Recover(const char *fileName);
+
+private:
+
+	// Record of the sidecar
+	struct CommitRecord
+	{
+		unsigned int magic;
+		unsigned int sequence;
+		long long length;
+		unsigned int check;
+		unsigned int reserved;
+	};
+
+	// Writer thread: writes the queued chunks, reserves extents, syncs and commits
+	void WriteLoop();
+
+	// Writes one chunk at the end of the data. False on error
+	bool WriteChunk(const std::vector<char> &chunk);
+
+	// Syncs the data (if sync) and writes the next commit record for the data written so far
+	bool Commit(bool sync);
+
+	// Hands the chunk being gathered to the writer thread. Lock must be held
+	void QueueChunk();
+
+	// Checksum of a record
+	static unsigned int Check(const CommitRecord &record);
+
+	// File handle (HANDLE on Windows, descriptor elsewhere), -1 if none
+	typedef intptr_t NativeFile;
+
+	// Platform file operations: open (creating or not), size, write at an offset, resize, sync, close
+	static NativeFile OpenNative(const char *fileName, bool create);
+	static long long SizeNative(NativeFile file);
+	static bool WriteNative(NativeFile file, long long offset, const void *data, size_t numBytes);
+	static bool ResizeNative(NativeFile file, long long length, bool reserve);
+	static bool SyncNative(NativeFile file);
+	static void CloseNative(NativeFile file);
+
+	bool _open;
+	std::string _fileName;
+	std::string _commitName;
+	DurabilityPolicy _policy;
+
+	// File and sidecar
+	NativeFile _file;
+	NativeFile _commitFile;
+
+	// Bytes of data written, file space reserved, and the records written to the sidecar
+	long long _writtenBytes;
+	long long _reservedBytes;
+	unsigned int _commitSequence;
+	std::chrono::steady_clock::time_point _lastSync;
+
+	// Chunk being gathered, since when, and the chunks waiting for the writer thread
+	std::vector<char> _gathering;
+	std::chrono::steady_clock::time_point _gatherStart;
+	std::deque<std::vector<char> > _queued;
+
+	// Chunks written, reused for gathering
+	std::vector<std::vector<char> > _spare;
+
+	RecorderStats _stats;
+	double _totalWriteMs;
+	double _totalSyncMs;
+	bool _failed;
+
+	std::thread _thread;
+	ThreadSetup _setup;
+	bool _closing;
+	std::mutex _lock;
+	std::condition_variable _wake;
+};
+
+#endif
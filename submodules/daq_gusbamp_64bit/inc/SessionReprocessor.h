@@ -0,0 +1,66 @@
+//_____________________________________________________________________________
+//    SessionReprocessor.h
+//
+//	  Created: Oct 2026
+//
+//_____________________________________________________________________________
+//
+
+#ifndef SESSIONREPROCESSOR_H
+#define SESSIONREPROCESSOR_H
+
+#include <vector>
+
+// Statistics of one processed session
+struct ReprocessStats
+{
+	int numTrials;
+	long long numScans;
+	long long bytesRead;
+	long long bytesWritten;
+	double seconds;
+};
+
+/*
+ * Filters a daq file with the front end filter, cuts its block trials and writes them to a trial tensor file.
+ * The recording is streamed in chunks of a fixed number of scans, so memory does not grow with the session length.
+ * Trials are found as in loadBlockTriggerData.m and shifted by the group delay of the filter, which is what delaying
+ * the trigger in DAQbase.ApplyFrontEndFilter amounts to. Process does not change the object, so one instance can be
+ * shared by several threads.
+ *
+ * Trial tensor file (.trials), version 1:
+ *      version (int32), sample rate (int32), number of channels (int32), trial length (int32), number of trials (int32),
+ *      channel list (int32 x numChannels), trial starts in the filtered recording (int64 x numTrials, 0 based), then
+ *      float32 data, numChannels x trialLength x numTrials (column-major). See loadTrialTensor.m
+ */
+class SessionReprocessor
+{
+public:
+
+	// Constructor. channels are positions in the file (0 based), all channels if empty. trialSec <= 0 uses the
+	// shortest trial kept. An empty filterNum disables filtering
+	SessionReprocessor(std::vector<int> channels, std::vector<double> filterNum, std::vector<double> filterDen, int groupDelay,
+		double trialSec, double minToMaxTrial, int chunkScans);
+
+	// Processes one recording
+	bool Process(const char *inputFile, const char *outputFile, ReprocessStats *stats) const;
+
+private:
+
+	// Channels to export
+	std::vector<int> _channels;
+
+	// Front end filter coefficients and group delay in samples
+	std::vector<double> _filterNum;
+	std::vector<double> _filterDen;
+	int _groupDelay;
+
+	// Trial length in seconds (<= 0 for the shortest trial) and threshold to drop short trials
+	double _trialSec;
+	double _minToMaxTrial;
+
+	// Scans read and filtered at a time
+	int _chunkScans;
+};
+
+#endif
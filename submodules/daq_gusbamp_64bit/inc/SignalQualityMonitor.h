@@ -0,0 +1,119 @@
+//_____________________________________________________________________________
+//    SignalQualityMonitor.h
+//
+//	  Created: Oct 2026
+//
+//_____________________________________________________________________________
+//
+
+#ifndef SIGNALQUALITYMONITOR_H
+#define SIGNALQUALITYMONITOR_H
+
+#include <vector>
+#include <mutex>
+#include <fstream>
+
+// Quality of one channel over the last complete window
+struct ChannelQuality
+{
+	// Mean (DC offset) and RMS around it, in uV
+	double meanUv;
+	double rmsUv;
+
+	// Power of the line frequency component, in uV^2
+	double linePowerUv2;
+
+	// Largest minus smallest value, in uV
+	double peakToPeakUv;
+
+	// Fraction of the samples at or beyond the saturation level
+	double saturatedFraction;
+
+	// Change of the mean since the previous window, in uV per second (0 for the first window)
+	double driftUvPerSec;
+
+	// Peak to peak below the flatline level (disconnected or shorted electrode)
+	bool flatline;
+
+	// Some samples at or beyond the saturation level
+	bool saturated;
+};
+
+/*
+ * Per channel signal quality over consecutive windows of windowLength scans: mean and RMS, line noise power (Goertzel
+ * at the line frequency), peak to peak with flatline detection, saturation and DC drift between windows. The samples
+ * are accumulated scan by scan into per channel arrays, so the inner loop runs over contiguous channels and
+ * vectorizes; the window statistics are derived once per window. Each completed window can be appended to a CSV log
+ * (one row per channel).
+ */
+class SignalQualityMonitor
+{
+public:
+
+	// Constructor. The channels are the first numChannels values of each scan
+	SignalQualityMonitor(int sampleRate, int numChannels, int windowLength, double lineFrequency, double saturationUv, double flatlineUv);
+
+	// Destructor. Closes the log
+	~SignalQualityMonitor();
+
+	// Clears the window, the results and the drift reference
+	void Reset();
+
+	// Appends numScans interleaved scans of scanStride values each, completing windows as they fill
+	void PushBlock(const float *block, int numScans, int scanStride);
+
+	// Copies the quality of each channel in the last complete window. Returns the number of windows since Reset
+	int GetQuality(ChannelQuality *quality);
+
+	// Appends every completed window to a CSV file (created with a header row). False if it can't be created
+	bool OpenLog(const char *fileName);
+
+	// Stops logging
+	void CloseLog();
+
+	// Number of channels monitored
+	int NumChannels() const { return _numChannels; }
+
+private:
+
+	// Derives the quality of the full window and starts the next one (called with _lock held)
+	void FinishWindow();
+
+	int _sampleRate;
+	int _numChannels;
+	int _windowLength;
+	double _saturationUv;
+	double _flatlineUv;
+
+	// Goertzel coefficient of the line frequency
+	double _lineCoefficient;
+
+	// Scans in the current window and windows completed
+	int _windowScans;
+	int _numWindows;
+
+	// Accumulators of the current window, one per channel. The sums are taken around _offset (the mean of the previous
+	// window) so that a large DC offset neither loses precision nor leaks into the line frequency bin
+	std::vector<double> _offset;
+	std::vector<double> _sum;
+	std::vector<double> _sumSquares;
+	std::vector<float> _min;
+	std::vector<float> _max;
+	std::vector<int> _numSaturated;
+	std::vector<double> _goertzel1;
+	std::vector<double> _goertzel2;
+
+	// Flag set once _offset holds the mean of a window
+	bool _hasOffset;
+
+	// Quality of the last complete window
+	std::vector<ChannelQuality> _quality;
+
+	// CSV log, written when open
+	std::ofstream _log;
+
+	// Mutex used to push blocks, read the results and open the log from different threads
+	std::mutex _lock;
+};
+
+#endif
@@ -0,0 +1,134 @@
+//_____________________________________________________________________________
+//    SimulatedAmpDriver.h
+//
+//	  Created: Oct 2026
+//
+//_____________________________________________________________________________
+//
+
+#ifndef SIMULATEDAMPDRIVER_H
+#define SIMULATEDAMPDRIVER_H
+
+#include <afxwin.h>
+#include <vector>
+#include <mutex>
+#include "gUSBamp.h"
+#include "AmpDriver.h"
+
+// State of one simulated amplifier (defined in SimulatedAmpDriver.cpp)
+struct SimulatedDevice;
+
+/*
+ * Amplifiers simulated in software, to run and benchmark the acquisition without hardware. Each device has its own
+ * sample clock thread: every bufferSize scans it fills the oldest queued transfer with synthetic data (sines, noise and
+ * the digital outputs looped back on the trigger channel). If no transfer is queued the block is held in a small
+ * device FIFO, and dropped (counted in LostScans) once the FIFO is full, as a real amplifier would.
+ *
+ * Jitter is injected on the completion notifications: each one is delayed by up to jitterMs and, with probability
+ * stallProbability, by up to maxStallMs. Notifications stay in order, so a stall delays the ones queued behind it.
+ *
+ * The digital outputs reach the trigger input loopbackDelayMs after SetDigitalOutEx and show up from the first scan
+ * acquired after that (the next scan produced for a speed of 0), as through the loopback cable of a real amplifier.
+ *
+ * Impedances are synthetic: stable per serial and channel between 2 and 30 kOhm (channel 16 is left unconnected),
+ * with a little measurement noise, and each measurement takes IMPEDANCE_MS as on a real amplifier.
+ *
+ * Subclasses replace the synthetic scans by overriding ProduceScans (see ReplayAmpDriver).
+ */
+class SimulatedAmpDriver : public AmpDriver
+{
+public:
+
+	// Blocks a device holds while no transfer is queued before it starts dropping data
+	static const int DEVICE_FIFO_BLOCKS = 2;
+
+	// Duration of one simulated impedance measurement
+	static const int IMPEDANCE_MS = 20;
+
+	// Constructor. numDevices amplifiers (UB-SIM.00.01, ...) are found by OpenDevice; OpenDeviceEx accepts any other
+	// serial, standing in for a real amplifier, but not a simulated one beyond numDevices (unplugged)
+	SimulatedAmpDriver(int numDevices, double jitterMs, double stallProbability, double maxStallMs, double loopbackDelayMs = 0);
+
+	// Destructor. Closes devices left open
+	~SimulatedAmpDriver();
+
+	HANDLE OpenDevice(int usbPort);
+	HANDLE OpenDeviceEx(LPSTR serial);
+	BOOL CloseDevice(HANDLE *hDevice);
+	BOOL GetSerial(HANDLE hDevice, LPSTR serial, UINT size);
+
+	BOOL SetSlave(HANDLE hDevice, BOOL slave) { return TRUE; }
+	BOOL SetReference(HANDLE hDevice, REF reference) { return TRUE; }
+	BOOL SetGround(HANDLE hDevice, GND ground) { return TRUE; }
+	BOOL SetChannels(HANDLE hDevice, UCHAR *channels, UCHAR numChannels);
+	BOOL SetSampleRate(HANDLE hDevice, WORD sampleRate);
+	BOOL EnableTriggerLine(HANDLE hDevice, BOOL enable);
+	BOOL SetBufferSize(HANDLE hDevice, WORD numScans);
+	BOOL SetBandPass(HANDLE hDevice, UCHAR channel, int filterIndex) { return TRUE; }
+	BOOL SetNotch(HANDLE hDevice, UCHAR channel, int filterIndex) { return TRUE; }
+	BOOL EnableSC(HANDLE hDevice, BOOL enable) { return TRUE; }
+	BOOL SetBipolar(HANDLE hDevice, CHANNEL bipolar) { return TRUE; }
+	BOOL SetMode(HANDLE hDevice, UCHAR mode) { return TRUE; }
+
+	BOOL GetScale(HANDLE hDevice, SCALE *scaling);
+	BOOL Calibrate(HANDLE hDevice, SCALE *scaling) { return TRUE; }
+	BOOL SetScale(HANDLE hDevice, SCALE *scaling) { return TRUE; }
+
+	BOOL Start(HANDLE hDevice);
+	BOOL Stop(HANDLE hDevice);
+	BOOL ResetTransfer(HANDLE hDevice);
+
+	BOOL GetData(HANDLE hDevice, BYTE *buffer, DWORD sizeBytes, OVERLAPPED *ov);
+	BOOL GetOverlappedResult(HANDLE hDevice, OVERLAPPED *ov, DWORD *numBytes, BOOL wait);
+
+	BOOL SetDigitalOutEx(HANDLE hDevice, DigitalOUT digitalOut);
+
+	BOOL GetImpedance(HANDLE hDevice, UCHAR channel, double *impedance);
+
+	// Scans dropped by all devices opened by this driver
+	long long LostScans();
+
+	// True once a device has run out of scans
+	bool Finished();
+
+protected:
+
+	// Writes numScans scans of a device from scan firstScan into scans: numChannels values and, if trigger is set, the
+	// trigger (digitalOut being the value of the digital outputs). Called with the device lock held on its sample clock
+	// thread. False once the device has no more scans
+	virtual bool ProduceScans(HANDLE hDevice, long long firstScan, int numScans, int numChannels, int trigger, float digitalOut, float *scans);
+
+	// Pace of the sample clocks relative to the sample rate, 0 producing a block as soon as a transfer is queued
+	double _speed;
+
+private:
+
+	// Sample clock of one device
+	void ClockLoop(SimulatedDevice *device);
+
+	// Fills a transfer with the next block of a device and schedules its notification. Device lock must be held.
+	// False if the device has no more scans
+	bool FillTransfer(SimulatedDevice *device, BYTE *buffer, DWORD sizeBytes, OVERLAPPED *ov);
+
+	// Number of devices found by OpenDevice
+	int _numDevices;
+
+	// Injected jitter
+	double _jitterMs;
+	double _stallProbability;
+	double _maxStallMs;
+
+	// Delay from the digital outputs to the trigger input
+	double _loopbackDelayMs;
+
+	// Open devices
+	std::vector<SimulatedDevice *> _devices;
+
+	// Scans lost by devices already closed
+	long long _closedLostScans;
+
+	// Mutex used to open and close devices
+	std::mutex _devicesLock;
+};
+
+#endif
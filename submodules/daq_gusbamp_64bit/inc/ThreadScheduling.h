@@ -0,0 +1,73 @@
+//_____________________________________________________________________________
+//    ThreadScheduling.h
+//
+//	  Created: Oct 2026
+//
+//_____________________________________________________________________________
+//
+
+#ifndef THREADSCHEDULING_H
+#define THREADSCHEDULING_H
+
+#include <vector>
+#include <stddef.h>
+
+/*
+ * Where and how the acquisition, dispatch and recording writer threads run. By default threads may run on any core at the priorities
+ * set by StartAcquisition (high priority class, time critical acquisition thread) and buffers can be paged out.
+ */
+struct SchedulingPolicy
+{
+	// Core the acquisition thread is pinned to. -1 for any core
+	int acquisitionCpu;
+
+	// Cores the dispatch threads are pinned to, round robin. Empty for any core
+	std::vector<int> dispatchCpus;
+
+	// Core the thread writing the recording is pinned to. -1 for any core
+	int writerCpu;
+
+	// Real-time priority: realtime priority class on Windows, SCHED_FIFO on Linux (needs the privilege)
+	bool realTime;
+
+	// Touch every page of the application and transfer buffers and lock them in RAM while acquiring
+	bool lockMemory;
+
+	SchedulingPolicy() : acquisitionCpu(-1), writerCpu(-1), realTime(false), lockMemory(false) {}
+};
+
+/*
+ * Thread placement, priority and memory locking on Windows and Linux, and the counters that show their effect (page
+ * faults of the process, context switches of a thread). Calls return false when the OS refuses (e.g. no privilege).
+ */
+class ThreadScheduling
+{
+public:
+
+	// Number of cores
+	static int NumCpus();
+
+	// Pins the calling thread to one core
+	static bool PinCurrentThread(int cpu);
+
+	// Raises the calling thread to real-time priority. timeCritical selects the highest level (acquisition) over the
+	// one below it (dispatch)
+	static bool SetCurrentThreadRealTime(bool timeCritical);
+
+	// Touches every page of the range so it is mapped now, then locks it in RAM
+	static bool LockMemory(void *address, size_t numBytes);
+
+	// Unlocks a range locked with LockMemory
+	static void UnlockMemory(void *address, size_t numBytes);
+
+	// OS id of the calling thread
+	static long long CurrentThreadId();
+
+	// Context switches of a thread of this process so far. -1 if unknown
+	static long long ThreadContextSwitches(long long threadId);
+
+	// Page faults of this process so far. -1 if unknown
+	static long long ProcessPageFaults();
+};
+
+#endif
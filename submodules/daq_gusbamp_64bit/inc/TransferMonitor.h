@@ -0,0 +1,64 @@
+//_____________________________________________________________________________
+//    TransferMonitor.h
+//
+//	  Created: Oct 2026
+//
+//_____________________________________________________________________________
+//
+
+#ifndef TRANSFERMONITOR_H
+#define TRANSFERMONITOR_H
+
+#include <vector>
+
+/*
+ * Completion latency of the transfers of one device. The device produces a block every blockSeconds, so block k is
+ * ready at t0 + (k + 1) * blockSeconds; latency is how much later than that its completion is handled. The unknown
+ * t0 is taken from the earliest completion of the window, so latencies are relative to the best recent case and a
+ * constant offset (blocks dropped by the device, drift between the device and host clocks) does not accumulate.
+ *
+ * A queue of depth D lets the acquisition loop be late by up to (D - 1) blocks before the device has no transfer to
+ * write into. When the 95th percentile of the recent latencies uses more than half of that slack, RecommendDepth
+ * adds one transfer.
+ */
+class TransferMonitor
+{
+public:
+
+	// Constructor. windowLength is the number of recent completions the percentiles are computed on
+	TransferMonitor(double blockSeconds, int windowLength);
+
+	// Clears the history
+	void Reset();
+
+	// Records the completion of block blockIndex (0 based) handled at time seconds (any monotonic clock)
+	void AddCompletion(long long blockIndex, double seconds);
+
+	// Latency percentile (0 to 100) in seconds over the recent completions
+	double LatencyPercentile(double percent) const;
+
+	// Queue depth for the next transfers, never below currentDepth nor above maxDepth
+	int RecommendDepth(int currentDepth, int maxDepth);
+
+	// Number of completions recorded
+	long long NumCompletions() const { return _numCompletions; }
+
+	// Duration of one block in seconds
+	double BlockSeconds() const { return _blockSeconds; }
+
+private:
+
+	// Duration of one block in seconds
+	double _blockSeconds;
+
+	// Lateness (completion time minus block index times block duration) of the recent completions, circular
+	std::vector<double> _lateness;
+
+	// Number of completions recorded
+	long long _numCompletions;
+
+	// Completion count of the last depth change, to let the new depth take effect before the next one
+	long long _lastChange;
+};
+
+#endif
@@ -0,0 +1,113 @@
+//_____________________________________________________________________________
+//    TriggerLatencyMeter.h
+//
+//	  Created: Oct 2026
+//
+//_____________________________________________________________________________
+//
+
+#ifndef TRIGGERLATENCYMETER_H
+#define TRIGGERLATENCYMETER_H
+
+#include <deque>
+#include <vector>
+
+// Distribution of one latency over the matched triggers, in seconds
+struct LatencyDistribution
+{
+	int count;
+	double mean;
+	double minimum;
+	double median;
+	double p95;
+	double p99;
+	double maximum;
+};
+
+/*
+ * Latency of the trigger loopback: patterns written to the digital outputs (Sent) are found again on the trigger
+ * channel of the blocks returned by GetData (Received). For every pattern that shows up, the sample it shows up on
+ * splits the send to GetData return latency into send to sample (output, cable and input of the amplifier) and sample
+ * to GetData return (transfer, acquisition loop and buffer).
+ *
+ * Scan n is acquired at t0 + (n + 1) / sampleRate. As in TransferMonitor, the unknown t0 is taken from the earliest
+ * return of a block relative to its last scan, so sample to return latencies are relative to the fastest block seen
+ * (at least the time the last scan of a block waits for the block to fill) and their sum with send to sample is exact.
+ *
+ * A pattern is matched by the first change of the trigger channel to its value; patterns sent after it that show up
+ * first (or never) are counted as missed. Consecutive patterns must differ. Patterns scheduled on a scan (see
+ * TriggerScheduler) also give how far from that scan they showed up.
+ */
+class TriggerLatencyMeter
+{
+public:
+
+	// Constructor. The trigger is value triggerIndex of scans of scanStride values
+	TriggerLatencyMeter(int sampleRate, int scanStride, int triggerIndex);
+
+	// Clears the patterns, the matches and the clock estimate
+	void Reset();
+
+	// Records a pattern written to the digital outputs at time seconds (the clock of Received), or scheduled then to
+	// show up on targetScan (-1 if not scheduled)
+	void Sent(int pattern, double seconds, long long targetScan = -1);
+
+	// Looks for the sent patterns in numScans scans, scan firstScan (0 based since the start of the acquisition)
+	// first, returned by GetData at time seconds
+	void Received(const float *scans, int numScans, long long firstScan, double seconds);
+
+	// Number of patterns found, not found, and still expected
+	int NumMatched() const { return (int) _matches.size(); }
+	int NumMissed() const { return _numMissed; }
+	int NumPending() const { return (int) _pending.size(); }
+
+	// Latency distributions over the matched patterns
+	LatencyDistribution SendToSample() const;
+	LatencyDistribution SampleToReturn() const;
+	LatencyDistribution SendToReturn() const;
+
+	// Distribution of the scan each scheduled pattern showed up on minus its target scan, in seconds
+	LatencyDistribution TargetOffset() const;
+
+private:
+
+	// A pattern found on the trigger channel
+	struct Match
+	{
+		double sendTime;
+		long long scan;
+		double returnTime;
+		long long targetScan;
+	};
+
+	// A pattern sent and not found yet
+	struct Pending
+	{
+		int pattern;
+		double sendTime;
+		long long targetScan;
+	};
+
+	// Acquisition time of a scan
+	double ScanTime(long long scan) const;
+
+	// Distribution of the latencies, sorted in place
+	static LatencyDistribution Distribution(std::vector<double> &latencies);
+
+	int _sampleRate;
+	int _scanStride;
+	int _triggerIndex;
+
+	std::deque<Pending> _pending;
+	std::vector<Match> _matches;
+	int _numMissed;
+
+	// Trigger value of the last scan received, -1 before the first one
+	int _lastValue;
+
+	// Earliest return time of a block minus the duration of its scans (t0), and if it has been set
+	double _clockOffset;
+	bool _clockSet;
+};
+
+#endif
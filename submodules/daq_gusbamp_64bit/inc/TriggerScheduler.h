@@ -0,0 +1,158 @@
+//_____________________________________________________________________________
+//    TriggerScheduler.h
+//
+//	  Created: Oct 2026
+//
+//_____________________________________________________________________________
+//
+
+#ifndef TRIGGERSCHEDULER_H
+#define TRIGGERSCHEDULER_H
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <fstream>
+
+// State of a scheduled trigger event
+enum TriggerEventState
+{
+	TRIGGER_PENDING = 0,
+	TRIGGER_EMITTED = 1,
+	TRIGGER_CANCELLED = 2,
+	TRIGGER_FAILED = 3
+};
+
+// A trigger pattern scheduled at a host time or at a scan, and when it was actually written
+struct TriggerEvent
+{
+	// Id returned when the event was scheduled (0 based since Reset)
+	int id;
+
+	// Pattern of the digital outputs (bit 0 is output 0)
+	int value;
+
+	// Scan the pattern was scheduled on (counted since acquisition started), -1 if scheduled at a host time
+	long long targetScan;
+
+	// Host time (seconds on TriggerScheduler::Now) the pattern was due to be written. For a scan, the time estimated
+	// when it was written
+	double targetTime;
+
+	// Host time the pattern was written and the scan being acquired then (estimated, -1 before the first block)
+	double emitTime;
+	long long emitScan;
+
+	TriggerEventState state;
+};
+
+/*
+ * Emits trigger patterns at a future host time or on a future scan from a thread of its own at time critical
+ * priority, so the markers do not depend on when the application thread (MATLAB, Psychtoolbox) gets to run. The
+ * thread sleeps until SPIN_SECONDS before the next event and spins the rest of the way; each event records the host
+ * time it was written at.
+ *
+ * Scans are placed on the host clock as in TransferMonitor: scan n is acquired at t0 + (n + 1) / sampleRate, t0 being
+ * the earliest return of a block relative to its last scan over the last CLOCK_WINDOW blocks (so drift between the
+ * amplifier and host clocks does not accumulate). An event on scan n is written in the middle of the sampling
+ * interval of that scan, outputLatency earlier (the send to sample latency measured through the loopback).
+ *
+ * Completed events are kept (Events) and can be appended to a CSV log, one row per event.
+ */
+class TriggerScheduler
+{
+public:
+
+	// Writes a pattern to the digital outputs. False on error
+	typedef std::function<bool(int value)> EmitFunction;
+
+	// Time before an event spent spinning instead of sleeping
+	static const double SPIN_SECONDS;
+
+	// Blocks the clock estimate is taken over
+	static const int CLOCK_WINDOW = 256;
+
+	// Constructor
+	TriggerScheduler(int sampleRate, EmitFunction emit);
+
+	// Destructor. Stops the thread
+	~TriggerScheduler();
+
+	// Host clock, in seconds (steady clock, the performance counter on Windows)
+	static double Now();
+
+	// Clears the events and the clock estimate. Not while started
+	void Reset();
+
+	// Starts the emission thread, pinned to cpu unless -1. False if it already runs
+	bool Start(int cpu);
+
+	// Stops the emission thread. Pending events are cancelled
+	void Stop();
+
+	// Delay from writing a pattern to the first scan showing it, in seconds. Events on a scan are written that early
+	void SetOutputLatency(double seconds);
+
+	// Records that numScans scans have been acquired so far, the last block having been returned at time seconds
+	void AddBlock(long long numScans, double seconds);
+
+	// Host time scan is acquired at, and the scan acquired at a host time. False/-1 before the first block
+	bool ScanTime(long long scan, double *seconds);
+	long long ScanAt(double seconds);
+
+	// Schedules a pattern at a host time or on a scan. Returns its id, -1 if the thread doesn't run
+	int ScheduleAtTime(int value, double seconds);
+	int ScheduleAtScan(int value, long long scan);
+
+	// Cancels the pending events. Returns how many
+	int Cancel();
+
+	// Copies every event scheduled since Reset (pending ones included)
+	void Events(std::vector<TriggerEvent> &events);
+
+	// Appends every completed event to a CSV log from now on. False if the file can't be opened
+	bool OpenLog(const char *fileName);
+
+	// Closes the log
+	void CloseLog();
+
+private:
+
+	// Thread emitting the events
+	void EmitLoop(int cpu);
+
+	// Time an event is due, false if unknown (an event on a scan before the first block). Lock must be held
+	bool DueTime(const TriggerEvent &event, double *seconds) const;
+
+	// Scan time and scan at time from the clock estimate. Lock must be held
+	double ScanTimeLocked(long long scan) const;
+	long long ScanAtLocked(double seconds) const;
+
+	// Marks a pending event completed and logs it. Lock must be held
+	void Complete(TriggerEvent &event, TriggerEventState state);
+
+	int _sampleRate;
+	EmitFunction _emit;
+
+	// Every event since Reset, indexed by id, and the ids of the pending ones
+	std::vector<TriggerEvent> _events;
+	std::vector<int> _pending;
+
+	double _outputLatency;
+
+	// Offsets (return time minus duration of the scans) of the recent blocks, and the minimum kept over them
+	std::deque<double> _offsets;
+	double _clockOffset;
+
+	std::ofstream _log;
+
+	std::thread _thread;
+	bool _running;
+	std::mutex _lock;
+	std::condition_variable _wake;
+};
+
+#endif
@@ -0,0 +1,99 @@
+//_____________________________________________________________________________
+//    WorkStealingPool.h
+//
+//	  Created: Oct 2026
+//
+//_____________________________________________________________________________
+//
+
+#ifndef WORKSTEALINGPOOL_H
+#define WORKSTEALINGPOOL_H
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+/*
+ * Fixed set of worker threads, each with its own task queue. Workers run their own tasks newest first and, when
+ * idle, steal the oldest task of another worker, so uneven tasks (e.g. long and short trial lengths) balance out.
+ */
+class WorkStealingPool
+{
+public:
+
+	// Constructor. numThreads <= 0 uses one thread per core
+	WorkStealingPool(int numThreads);
+
+	// Destructor. Waits for queued tasks and joins the workers
+	~WorkStealingPool();
+
+	// Queues a task. Tasks submitted from a worker go to that worker's queue
+	void Submit(std::function<void()> task);
+
+	// Blocks until every submitted task has finished
+	void Wait();
+
+	// Runs setup(workerIndex) once on every worker thread (e.g. to pin or prioritize it) and waits until all have run
+	// it. Workers busy with a task run it after that task
+	void ConfigureWorkers(std::function<void(int)> setup);
+
+	// Number of worker threads
+	int NumThreads() const { return (int) _workers.size(); }
+
+	// Number of tasks that were run by a worker other than the one they were queued on
+	long StolenTasks() const { return _stolenTasks; }
+
+private:
+
+	// Task queue of one worker
+	struct WorkerQueue
+	{
+		std::mutex lock;
+		std::deque< std::function<void()> > tasks;
+	};
+
+	// Loop run by each worker
+	void WorkerLoop(int workerIndex);
+
+	// Pops from the own queue or steals from the others. False if every queue is empty
+	bool TryGetTask(int workerIndex, std::function<void()> &task);
+
+	// One queue per worker
+	std::vector< std::unique_ptr<WorkerQueue> > _queues;
+
+	// Worker threads
+	std::vector<std::thread> _workers;
+
+	// Tasks queued but not yet taken by a worker
+	std::atomic<int> _queuedTasks;
+
+	// Tasks submitted but not yet finished
+	std::atomic<int> _pendingTasks;
+
+	// Round robin queue index for tasks submitted from outside the pool
+	std::atomic<unsigned int> _nextQueue;
+
+	// Tasks taken from another worker's queue
+	std::atomic<long> _stolenTasks;
+
+	// Set by the destructor to stop the workers
+	bool _stopping;
+
+	// Worker setup of the last ConfigureWorkers call, its generation and the workers that have not run it yet
+	std::function<void(int)> _setup;
+	std::atomic<int> _setupGeneration;
+	int _setupPending;
+	std::condition_variable _setupDone;
+
+	// Mutex and conditions used to sleep idle workers and waiting callers
+	std::mutex _stateLock;
+	std::condition_variable _workAvailable;
+	std::condition_variable _allDone;
+};
+
+#endif
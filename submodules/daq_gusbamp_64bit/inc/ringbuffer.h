@@ -39,6 +39,7 @@ public:
 			VirtualFree(_buffer, 0, MEM_RELEASE);
 			_buffer = NULL;
 		}
+		_capacity = 0;
 
 		if (capacity > 0)
 		{
@@ -89,6 +90,12 @@ public:
 			return _capacity - (_start - _end);
 	}
 
+	//Returns the first element of the allocated memory (GetCapacity() elements), e.g. to lock it in RAM. NULL if not initialized.
+	T* Data()
+	{
+		return _buffer;
+	}
+
 	/*
 	 * Writes the specified number of elements from the specified source array into the ring buffer. If the number of elements to copy exceeds the free buffer space, only the free buffer space will be written, existing elements will NOT be overwritten.
 	 * float* source:		pointer to the first element of the source array whose elements should be stored into the ring buffer.
@@ -145,6 +152,34 @@ public:
 			_isEmpty = true;
 	}
 
+	/*
+	 * Gives access to the oldest elements without copying them, as up to two contiguous parts (the second one starts at the beginning of the memory when the elements wrap around).
+	 * Returns the number of elements of the first part; the second part holds the rest of min(length, GetSize()) elements. Remove them with Skip.
+	 * T **first:			receives the first element of the first part.
+	 * T **second:			receives the first element of the second part.
+	 */
+	unsigned int GetReadParts(unsigned int length, T **first, T **second)
+	{
+		length = min(length, (unsigned int) GetSize());
+
+		*first = &_buffer[_start];
+		*second = &_buffer[0];
+		return min(length, _capacity - _start);
+	}
+
+	//Removes the oldest length elements (or all of them if there are less) without copying them.
+	void Skip(unsigned int length)
+	{
+		length = min(length, (unsigned int) GetSize());
+		if (length == 0)
+			return;
+
+		_start = (_start + length) % _capacity;
+
+		if (_start == _end)
+			_isEmpty = true;
+	}
+
 protected:
 	//the buffer array
 	T* _buffer;
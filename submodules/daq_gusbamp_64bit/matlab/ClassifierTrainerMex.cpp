@@ -0,0 +1,103 @@
+// This mex function evaluates the CCA-KDE classifier on a k-fold x trial length grid in parallel.
+// Unlike DAQgUSBampMex it keeps no state between calls, so no class handle is needed.
+//
+// Features (CCA against sine/cosine templates) are computed once per trial and trial length and shared by all
+// folds. Folds are passed from matlab so that the results can be compared fold by fold with the matlab path.
+//
+// Usage:
+//      [accuracy, aPosteriori, features, timing] = ClassifierTrainerMex(double(data), int32(labels), int32(folds), ...
+//                      double(trialLengthSec), double(fs), double(freq), int32(numHarmonics), double(prior), int32(numThreads));
+//
+//      data            - [numChannels x numSamples x numTrials] trials
+//      labels          - [numTrials x 1] class of each trial (1 based)
+//      folds           - [numTrials x 1] fold of each trial (1 based)
+//      trialLengthSec  - [numTrialLengths x 1] trial lengths to evaluate in seconds
+//      numThreads      - number of worker threads, 0 for one per core
+//
+//      accuracy        - [numTrialLengths x numFolds] held out accuracy
+//      aPosteriori     - [numClasses x numTrials x numTrialLengths] held out posteriors
+//      features        - [numClasses x numTrials x numTrialLengths] canonical correlations
+//      timing          - [2 x 1] seconds spent on features and on folds
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <math.h>
+#include "mex.h"
+#include "ClassifierTrainer.h"
+
+void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+{
+    // Check parameters
+    if (nrhs != 9 || nlhs < 1 || nlhs > 4)
+        mexErrMsgTxt("ClassifierTrainerMex: Unexpected arguments.");
+    
+    if (mxGetClassID(prhs[0]) != mxDOUBLE_CLASS || mxGetClassID(prhs[1]) != mxINT32_CLASS || mxGetClassID(prhs[2]) != mxINT32_CLASS)
+        mexErrMsgTxt("ClassifierTrainerMex: data must be double, labels and folds int32.");
+    
+    // Trials are [numChannels x numSamples x numTrials]
+    mwSize numDims = mxGetNumberOfDimensions(prhs[0]);
+    const mwSize * dims = mxGetDimensions(prhs[0]);
+    int numChannels = (int) dims[0];
+    int numSamples = (int) dims[1];
+    int numTrials = (numDims > 2) ? (int) dims[2] : 1;
+    
+    if ((int) mxGetNumberOfElements(prhs[1]) != numTrials || (int) mxGetNumberOfElements(prhs[2]) != numTrials)
+        mexErrMsgTxt("ClassifierTrainerMex: labels and folds need one entry per trial.");
+    
+    // Convert labels and folds to 0 based
+    int * tmpLabels = (int *) mxGetData(prhs[1]);
+    int * tmpFolds = (int *) mxGetData(prhs[2]);
+    std::vector<int> labels(numTrials);
+    std::vector<int> folds(numTrials);
+    int numFolds = 0;
+    for (int i = 0; i < numTrials; i++)
+    {
+        labels[i] = tmpLabels[i] - 1;
+        folds[i] = tmpFolds[i] - 1;
+        numFolds = std::max(numFolds, tmpFolds[i]);
+    }
+    
+    double fs = mxGetScalar(prhs[4]);
+    double * tmpLengthArray = (double *) mxGetData(prhs[3]);
+    std::vector<int> trialLengths;
+    for (size_t i = 0; i < mxGetNumberOfElements(prhs[3]); i++)
+        trialLengths.push_back((int) floor(tmpLengthArray[i] * fs + 0.5));
+    
+    double * tmpFreqArray = (double *) mxGetData(prhs[5]);
+    std::vector<double> stimFrequencies(tmpFreqArray, tmpFreqArray + mxGetNumberOfElements(prhs[5]));
+    int numHarmonics = mxGetScalar(prhs[6]);
+    double * tmpPriorArray = (double *) mxGetData(prhs[7]);
+    std::vector<double> prior(tmpPriorArray, tmpPriorArray + mxGetNumberOfElements(prhs[7]));
+    int numThreads = mxGetScalar(prhs[8]);
+    
+    // Run the grid
+    ClassifierTrainer trainer((int) fs, stimFrequencies, numHarmonics, prior, numThreads);
+    trainer.SetData(mxGetPr(prhs[0]), numChannels, numSamples, numTrials, &labels[0]);
+    
+    if (!trainer.Run(trialLengths, &folds[0], numFolds))
+        mexErrMsgTxt("ClassifierTrainerMex: Could not run the training grid.");
+    
+    // Copy results to matlab
+    int numLengths = (int) trialLengths.size();
+    plhs[0] = mxCreateDoubleMatrix(numLengths, numFolds, mxREAL);
+    std::copy(trainer.Accuracy().begin(), trainer.Accuracy().end(), mxGetPr(plhs[0]));
+    
+    mwSize outDims[3] = {stimFrequencies.size(), (mwSize) numTrials, (mwSize) numLengths};
+    if (nlhs > 1)
+    {
+        plhs[1] = mxCreateNumericArray(3, outDims, mxDOUBLE_CLASS, mxREAL);
+        std::copy(trainer.Posterior().begin(), trainer.Posterior().end(), mxGetPr(plhs[1]));
+    }
+    if (nlhs > 2)
+    {
+        plhs[2] = mxCreateNumericArray(3, outDims, mxDOUBLE_CLASS, mxREAL);
+        std::copy(trainer.Features().begin(), trainer.Features().end(), mxGetPr(plhs[2]));
+    }
+    if (nlhs > 3)
+    {
+        plhs[3] = mxCreateDoubleMatrix(2, 1, mxREAL);
+        mxGetPr(plhs[3])[0] = trainer.FeatureSeconds();
+        mxGetPr(plhs[3])[1] = trainer.FoldSeconds();
+    }
+}
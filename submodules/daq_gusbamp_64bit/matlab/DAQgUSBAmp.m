@@ -27,6 +27,19 @@
 %       .ParallelPortTriggerTest
 %       .USBTriggerTest
 %       .SendTrigger
+%       .ScheduleTrigger
+%       .TriggerClock
+%       .SetTriggerLatency
+%       .CancelTriggers
+%       .GetTriggerEvents
+%       .GetRecorderStats
+%       .EnableFeatureEngine
+%       .GetFeatures
+%       .EnableEarlyStopping
+%       .WaitForDecision
+%       .WaitForSamples
+%       .WaitForTrigger
+%       .GetTransferStats
 %   
 %   From DAQBase
 %       .ApplyFrontEndFilter
@@ -118,6 +131,13 @@ classdef DAQgUSBAmp < DAQbase
         % True to perform calibration
         calibrationFlag;
         
+        % File where calibrations are kept per amplifier serial. Empty to
+        % calibrate on every construction
+        calibrationCacheFile;
+        
+        % Age in hours beyond which a cached calibration is redone
+        calibrationMaxAgeHours;
+        
         % True to perform parallel port test
         testParallelPortFlag;
         
@@ -132,6 +152,76 @@ classdef DAQgUSBAmp < DAQbase
         % Amp serial number as a cell. If empty, first amp detected will be
         % used
         ampSerialNumbers;
+        
+        % True to acquire from simulated amplifiers instead of real ones
+        simulatedFlag;
+        
+        % [jitterMs stallProbability maxStallMs] completion jitter of the
+        % simulated amplifiers
+        simulatedJitter;
+        
+        % Delay in ms from SendTrigger to the trigger channel of the
+        % simulated amplifiers
+        simulatedLoopbackMs;
+        
+        % Recording (.bin) replayed instead of acquiring from amplifiers.
+        % Empty to acquire
+        replayFile;
+        
+        % Pace of the replay relative to real time, 0 as fast as possible
+        replaySpeed;
+        
+        % True to replay the recording from its start once it ends
+        replayLoopFlag;
+        
+        % Block size policy: 'default', 'lowLatency', 'highThroughput' or
+        % [blockScans queueDepth wakeBlocks]
+        blockPolicy;
+        
+        % Number of transfers queued per amplifier. Empty to use the one of
+        % the block policy
+        queueDepth;
+        
+        % Maximum number of transfers queued per amplifier when the queue
+        % is adaptive
+        maxQueueDepth;
+        
+        % True to deepen the queue when completion latencies rise
+        adaptiveQueueFlag;
+        
+        % Core the acquisition thread is pinned to. -1 for any core
+        acquisitionCpu;
+        
+        % Cores the dispatch threads are pinned to. Empty for any core
+        dispatchCpus;
+        
+        % Core the thread writing the recording is pinned to. -1 for any
+        % core
+        writerCpu;
+        
+        % True to run acquisition at real-time priority
+        realTimeFlag;
+        
+        % True to lock the acquisition buffers in RAM
+        lockMemoryFlag;
+        
+        % I/O threads of the engine shared by the DAQgUSBAmp objects of
+        % the process. 0 to acquire on a thread of its own
+        sharedEngineThreads;
+        
+        % Storage of the application buffer: 'float32', 'half' or 'int16'
+        sampleStorage;
+        
+        % Gains of the int16 storage in uV per step, one per channel.
+        % Empty for 0.1 uV
+        storageGains;
+        
+        % When recordings are synced to disk: 'none', 'periodic' (every
+        % syncSec) or 'chunk'
+        durability;
+        
+        % Seconds between syncs of the 'periodic' durability
+        syncSec;
 
     end
     
@@ -189,6 +279,17 @@ classdef DAQgUSBAmp < DAQbase
         %                             construction. False by default.
         %                             Calibration can be called on demand
         %                             by the user if needed. 
+        %   'calibrationCacheFile'  - File where calibrations are kept by
+        %                             amplifier serial. With a cache,
+        %                             calibration is done when the device
+        %                             is opened and only for amplifiers
+        %                             without a recent calibration, the
+        %                             others get their cached one.
+        %                             gUSBampCalibration.txt in prefdir by
+        %                             default. Empty to calibrate during
+        %                             construction every time
+        %   'calibrationMaxAgeHours'- Age in hours beyond which a cached
+        %                             calibration is redone. 24 by default
         %   'testParallelPortFlag'  - True to perform parallel port trigger test during
         %                             construction. False by default.
         %                             Test can be called on demand
@@ -203,6 +304,77 @@ classdef DAQgUSBAmp < DAQbase
         %   'ampSerialNumbers'      - Amp serial number as a cell. If empty, first amp detected will be
         %                             used. Empty by default. First serial
         %                             is considered master
+        %   'simulatedFlag'         - True to acquire from simulated
+        %                             amplifiers (no hardware needed).
+        %                             False by default
+        %   'simulatedJitter'       - [jitterMs stallProbability maxStallMs]
+        %                             completion delay of the simulated
+        %                             amplifiers: up to jitterMs, and up to
+        %                             maxStallMs with probability
+        %                             stallProbability. [0 0 0] by default
+        %   'simulatedLoopbackMs'   - Delay from SendTrigger to the trigger
+        %                             channel of the simulated amplifiers
+        %                             in ms. 0 by default
+        %   'replayFile'            - Recording (.bin) streamed through the
+        %                             acquisition instead of amplifiers,
+        %                             with the channels, fs and trigger
+        %                             it was recorded with. Empty by default
+        %   'replaySpeed'           - Pace of the replay: 1 real time, N
+        %                             N times faster, 0 as fast as
+        %                             possible. 1 by default
+        %   'replayLoopFlag'        - True to replay the recording again
+        %                             once it ends. False by default
+        %   'blockPolicy'           - Transfer block size policy:
+        %                             'default' (blocks of fs/32 scans, 4
+        %                             queued), 'lowLatency' (blocks of about
+        %                             8 ms), 'highThroughput' (blocks of
+        %                             about 250 ms, read wake-up every
+        %                             second) or [blockScans queueDepth
+        %                             wakeBlocks]. 'default' by default
+        %   'queueDepth'            - Number of transfers queued per
+        %                             amplifier. Empty (default) to use the
+        %                             one of the block policy
+        %   'maxQueueDepth'         - Maximum depth reached by the adaptive
+        %                             queue. 32 by default
+        %   'adaptiveQueueFlag'     - True to deepen the queue when
+        %                             completion latencies rise. False by
+        %                             default
+        %   'acquisitionCpu'        - Core (from 0) the acquisition thread
+        %                             is pinned to. -1 (any core) by default
+        %   'dispatchCpus'          - Cores the dispatch threads are
+        %                             pinned to. [] (any core) by default
+        %   'writerCpu'             - Core the thread writing the recording
+        %                             is pinned to. -1 (any core) by default
+        %   'realTimeFlag'          - True to run acquisition at real-time
+        %                             priority. False by default
+        %   'lockMemoryFlag'        - True to lock the acquisition buffers
+        %                             in RAM. False by default
+        %   'sharedEngineThreads'   - Number of I/O threads of the engine
+        %                             shared by the objects of this process
+        %                             (one per amplifier group, e.g. one
+        %                             per subject, each with its own
+        %                             'ampSerialNumbers'). 0 (a thread per
+        %                             object) by default
+        %   'sampleStorage'         - Storage of the application buffer:
+        %                             'float32', 'half' (half precision,
+        %                             up to 65504 uV) or 'int16' (steps of
+        %                             'storageGains'). Compact storage
+        %                             halves the memory of the buffer.
+        %                             'float32' by default
+        %   'storageGains'          - uV per step of the int16 storage,
+        %                             one per channel. [] (0.1 uV) by
+        %                             default
+        %   'durability'            - When the recording is synced to disk
+        %                             and committed: 'none' (never, fastest),
+        %                             'periodic' (every 'syncSec') or
+        %                             'chunk' (every write, about 4 per
+        %                             second). A crash loses only what was
+        %                             not committed, recover the file with
+        %                             SessionFileMex('recover', fileName)
+        %                             or RecoverSession. 'periodic' by
+        %                             default
+        %   'syncSec'               - Seconds between syncs of the
+        %                             'periodic' durability. 1 by default
         
         function self = DAQgUSBAmp(varargin)
             
@@ -223,12 +395,35 @@ classdef DAQgUSBAmp < DAQbase
             p.addParameter('notchFilterNdx',3,@isscalar);
             p.addParameter('ampFilterNdx',49,@isscalar);
             p.addParameter('calibrationFlag',false,@isscalar);
+            p.addParameter('calibrationCacheFile',fullfile(prefdir,'gUSBampCalibration.txt'),@ischar);
+            p.addParameter('calibrationMaxAgeHours',24,@isscalar);
             p.addParameter('testParallelPortFlag',false,@islogical);
             p.addParameter('testUSBTriggerFlag',false,@islogical);
             
             p.addParameter('ampBufferLengthSec',inf,@isscalar);
             
             p.addParameter('ampSerialNumbers',[],@iscell);
+            
+            p.addParameter('simulatedFlag',false,@islogical);
+            p.addParameter('simulatedJitter',[0 0 0],@(x)(numel(x) == 3));
+            p.addParameter('simulatedLoopbackMs',0,@(x)(isscalar(x) && x >= 0));
+            p.addParameter('replayFile','',@ischar);
+            p.addParameter('replaySpeed',1,@isscalar);
+            p.addParameter('replayLoopFlag',false,@islogical);
+            p.addParameter('blockPolicy','default',@(x)(ischar(x) || numel(x) == 3));
+            p.addParameter('queueDepth',[],@(x)(isempty(x) || isscalar(x)));
+            p.addParameter('maxQueueDepth',32,@isscalar);
+            p.addParameter('adaptiveQueueFlag',false,@islogical);
+            p.addParameter('acquisitionCpu',-1,@isscalar);
+            p.addParameter('dispatchCpus',[],@isnumeric);
+            p.addParameter('writerCpu',-1,@isscalar);
+            p.addParameter('realTimeFlag',false,@islogical);
+            p.addParameter('lockMemoryFlag',false,@islogical);
+            p.addParameter('sharedEngineThreads',0,@isscalar);
+            p.addParameter('sampleStorage','float32',@(x)(any(strcmp(x, {'float32', 'half', 'int16'}))));
+            p.addParameter('storageGains',[],@isnumeric);
+            p.addParameter('durability','periodic',@(x)(any(strcmp(x, {'none', 'periodic', 'chunk'}))));
+            p.addParameter('syncSec',1,@(x)(isscalar(x) && x > 0));
 
             p.parse(varargin{:});
             
@@ -241,9 +436,31 @@ classdef DAQgUSBAmp < DAQbase
             self.notchFilterNdx         = p.Results.notchFilterNdx;
             self.ampFilterNdx           = p.Results.ampFilterNdx;
             self.calibrationFlag        = p.Results.calibrationFlag;
+            self.calibrationCacheFile   = p.Results.calibrationCacheFile;
+            self.calibrationMaxAgeHours = p.Results.calibrationMaxAgeHours;
             self.testParallelPortFlag   = p.Results.testParallelPortFlag;
             self.testUSBTriggerFlag     = p.Results.testUSBTriggerFlag;
             self.ampSerialNumbers       = p.Results.ampSerialNumbers;
+            self.simulatedFlag          = p.Results.simulatedFlag;
+            self.simulatedJitter        = p.Results.simulatedJitter;
+            self.simulatedLoopbackMs    = p.Results.simulatedLoopbackMs;
+            self.replayFile             = p.Results.replayFile;
+            self.replaySpeed            = p.Results.replaySpeed;
+            self.replayLoopFlag         = p.Results.replayLoopFlag;
+            self.blockPolicy            = p.Results.blockPolicy;
+            self.queueDepth             = p.Results.queueDepth;
+            self.maxQueueDepth          = p.Results.maxQueueDepth;
+            self.adaptiveQueueFlag      = p.Results.adaptiveQueueFlag;
+            self.acquisitionCpu         = p.Results.acquisitionCpu;
+            self.dispatchCpus           = p.Results.dispatchCpus;
+            self.writerCpu              = p.Results.writerCpu;
+            self.realTimeFlag           = p.Results.realTimeFlag;
+            self.lockMemoryFlag         = p.Results.lockMemoryFlag;
+            self.sharedEngineThreads    = p.Results.sharedEngineThreads;
+            self.sampleStorage          = p.Results.sampleStorage;
+            self.storageGains           = p.Results.storageGains;
+            self.durability             = p.Results.durability;
+            self.syncSec                = p.Results.syncSec;
             
             % Hardcoded for normal operations
             self.ampMode = 0;
@@ -261,8 +478,9 @@ classdef DAQgUSBAmp < DAQbase
             
             self.status = self.STATUS_STANDBY;                        
             
-            % Calibrate amplifiers if need be
-            if self.calibrationFlag
+            % Calibrate amplifiers if need be (with a cache, OpenDevice
+            % calibrates the amplifiers whose calibration is not recent)
+            if self.calibrationFlag && isempty(self.calibrationCacheFile)
                 self.CalibrateAmps();
             end
             
@@ -285,6 +503,12 @@ classdef DAQgUSBAmp < DAQbase
             
             numChannels = length(self.channelList);
             
+            % Presets are passed by name, explicit policies as integers
+            blockPolicy = self.blockPolicy;
+            if ~ischar(blockPolicy)
+                blockPolicy = int32(blockPolicy(:));
+            end
+            
             if self.status == self.STATUS_STANDBY
            
                 successFlag = 0;
@@ -296,9 +520,51 @@ classdef DAQgUSBAmp < DAQbase
                                  int32(self.triggerFlag), int32(self.ampFilterNdx),... 
                                  int32(self.notchFilterNdx), uint8(self.ampMode), ...
                                  int32(self.commonReference), int32(self.commonGround), ...
-                                 uint8(self.bipolarSettings));
+                                 uint8(self.bipolarSettings), blockPolicy);
+                    
+                    ampSerialNumbers = self.ampSerialNumbers;
+                    if self.simulatedFlag
+                        % One simulated amplifier per group of 16 channels
+                        numAmps = ceil(max(self.channelList) / 16);
+                        DAQgUSBampMex('UseSimulatedDevice', self.objectHandle, int32(numAmps), double([self.simulatedJitter(:); self.simulatedLoopbackMs]));
+                        if isempty(ampSerialNumbers) && numAmps > 1
+                            ampSerialNumbers = arrayfun(@(x)(sprintf('UB-SIM.00.%02d', x)), 1:numAmps, 'UniformOutput', false);
+                        end
+                    end
+                    if ~isempty(self.replayFile)
+                        % One replayed amplifier per group of 16 channels, master first
+                        numAmps = ceil(max(self.channelList) / 16);
+                        DAQgUSBampMex('UseReplayDevice', self.objectHandle, self.replayFile, ...
+                                 double(self.replaySpeed), int32(self.replayLoopFlag));
+                        if isempty(ampSerialNumbers) && numAmps > 1
+                            ampSerialNumbers = arrayfun(@(x)(sprintf('UB-REPLAY.%02d', x)), 1:numAmps, 'UniformOutput', false);
+                        end
+                    end
+                    
+                    % Depth 0 keeps the one of the block policy
+                    queueDepth = self.queueDepth;
+                    if isempty(queueDepth)
+                        queueDepth = 0;
+                    end
+                    DAQgUSBampMex('SetQueueDepth', self.objectHandle, int32(queueDepth), ...
+                                 int32(self.maxQueueDepth), int32(self.adaptiveQueueFlag));
+                    
+                    DAQgUSBampMex('SetSchedulingPolicy', self.objectHandle, int32(self.acquisitionCpu), ...
+                                 int32(self.dispatchCpus(:)), int32(self.realTimeFlag), int32(self.lockMemoryFlag), ...
+                                 int32(self.writerCpu));
+                    DAQgUSBampMex('UseSharedEngine', self.objectHandle, int32(self.sharedEngineThreads));
+                    DAQgUSBampMex('SetSampleStorage', self.objectHandle, ...
+                                 int32(find(strcmp(self.sampleStorage, {'float32', 'half', 'int16'})) - 1), double(self.storageGains(:)));
+                    DAQgUSBampMex('SetDurabilityPolicy', self.objectHandle, ...
+                                 int32(find(strcmp(self.durability, {'none', 'periodic', 'chunk'})) - 1), double(self.syncSec), 0.25);
+                    
+                    % Recent calibrations are reapplied when opening
+                    if self.calibrationFlag
+                        DAQgUSBampMex('SetCalibrationCache', self.objectHandle, ...
+                                 self.calibrationCacheFile, double(self.calibrationMaxAgeHours));
+                    end
                              
-                    successFlag = DAQgUSBampMex('OpenDevice', self.objectHandle, self.ampSerialNumbers);
+                    successFlag = DAQgUSBampMex('OpenDevice', self.objectHandle, ampSerialNumbers);
                     
                     if ~successFlag
                         disp('No amplifers detected.');
@@ -315,6 +581,11 @@ classdef DAQgUSBAmp < DAQbase
                     
                     
                 end
+                
+                % Calibrate the amplifiers without a recent calibration
+                if self.calibrationFlag && DAQgUSBampMex('CalibrationStale', self.objectHandle)
+                    DAQgUSBampMex('Calibration', self.objectHandle, int32(1));
+                end
 
                 self.status = self.STATUS_OPEN;
             else
@@ -387,6 +658,69 @@ classdef DAQgUSBAmp < DAQbase
             end
         end
         
+        % GetChannelData - gets available data of some channels from
+        % buffer, without the front end and adaptive filters. The channels
+        % are gathered one column each straight from the buffer, which is
+        % faster than selecting them after GetData
+        %
+        %   Inputs: 
+        %       channels                -   Channels to collect (from 1)
+        %
+        %       'numSamples'            -   Number of samples to collect.
+        %                                   Blocking if not enough samples
+        %                                   are available. [] gets all
+        %                                   available samples (default
+        %                                   behavior)
+        %
+        %   Outputs:
+        %
+        %       data                    -   [nSamples x numel(channels)]
+        %                                   array with data from amp in
+        %                                   volts. Scaled inside by 1e-6
+        %
+        %       triggerSignal           -   [nSamples x 1] trigger signal.
+        %                                   Empty if trigger disabled
+        %
+        function [data, triggerSignal] = GetChannelData(self, channels, varargin)
+            
+            p = inputParser;
+            p.addParameter('numSamples',[],@isscalar);
+            p.parse(varargin{:});
+            
+            numSamples = p.Results.numSamples;
+            
+            % Mex needs numSamples = -1 if we want all data 
+            if isempty(numSamples)
+                numSamples = -1;
+            end
+            
+            if self.status ~= self.STATUS_ACQUIRINGDATA
+                triggerSignal = [];
+                data = [];
+                warning('GetChannelData only works when device is acquiring data');
+                return
+            end
+            
+            % If no data is available, return empty
+            if (self.AvailableSamples() == 0) && (numSamples == -1)
+                triggerSignal = [];
+                data = [];
+                return
+            end
+            
+            % The trigger is gathered in the same pass as last column
+            numChannels = length(self.channelList);
+            dataBuffer = double(DAQgUSBampMex('GetChannelData', self.objectHandle, int32(numSamples), ...
+                                 int32([channels(:); (numChannels + 1)*ones(self.triggerFlag, 1)])));
+            
+            data = (1e-6)*dataBuffer(:,1:end-self.triggerFlag);
+            if self.triggerFlag
+                triggerSignal = dataBuffer(:,end);
+            else
+                triggerSignal = [];
+            end
+        end
+        
         % GetData - gets available data from buffer
         %
         %   Inputs: 
@@ -504,6 +838,673 @@ classdef DAQgUSBAmp < DAQbase
             end
         end
         
+        % ScheduleTrigger - Sends a trigger at a future time or on a future
+        % sample from a high priority thread of the library, so it does not
+        % depend on when MATLAB gets to run. Needs Trigger Loopback Connector
+        %
+        %   Inputs:
+        %       triggerValue    -   4 bit trigger as an integer (0-15)
+        %       'atSec'         -   Time to send it at, on TriggerClock
+        %       'atSample'      -   Sample to show it on (as GetData counts
+        %                           them since acquisition started). Set
+        %                           the latency with SetTriggerLatency
+        %
+        %   Outputs:
+        %       eventId         -   Row of the trigger in GetTriggerEvents.
+        %                           0 if it couldn't be scheduled
+        function eventId = ScheduleTrigger(self, triggerValue, varargin)
+            
+            p = inputParser;
+            p.addParameter('atSec',[],@isscalar);
+            p.addParameter('atSample',[],@isscalar);
+            p.parse(varargin{:});
+            
+            eventId = 0;
+            if self.status ~= self.STATUS_ACQUIRINGDATA
+                warning('ScheduleTrigger only works when device is acquiring data')
+            elseif ~isempty(p.Results.atSample)
+                eventId = DAQgUSBampMex('ScheduleTrigger', self.objectHandle, ...
+                    int32(triggerValue), double(p.Results.atSample), true);
+            elseif ~isempty(p.Results.atSec)
+                eventId = DAQgUSBampMex('ScheduleTrigger', self.objectHandle, ...
+                    int32(triggerValue), double(p.Results.atSec), false);
+            else
+                error('ScheduleTrigger needs atSec or atSample')
+            end
+        end
+        
+        % TriggerClock - Host clock ScheduleTrigger times are on, in seconds
+        function timeSec = TriggerClock(self)
+            timeSec = DAQgUSBampMex('TriggerClock', self.objectHandle);
+        end
+        
+        % SetTriggerLatency - Sets the delay from sending a trigger to the
+        % first sample showing it, in ms (the median send to sample latency
+        % of TriggerLatencyBenchmark). Triggers on a sample are sent that
+        % much earlier
+        function SetTriggerLatency(self, latencyMs)
+            DAQgUSBampMex('SetTriggerLatency', self.objectHandle, double(latencyMs));
+        end
+        
+        % CancelTriggers - Cancels the scheduled triggers not sent yet
+        %
+        %   Outputs:
+        %       numCancelled    -   Number of triggers cancelled
+        function numCancelled = CancelTriggers(self)
+            numCancelled = DAQgUSBampMex('CancelTriggers', self.objectHandle);
+        end
+        
+        % GetTriggerEvents - Gets the triggers scheduled since acquisition
+        % started and when they were actually sent (also written next to
+        % the recording as <file>.triggers.csv)
+        %
+        %   Outputs:
+        %       eventStruct
+        %           .value          -   [numEvents x 1] trigger values
+        %           .targetSample   -   [numEvents x 1] sample scheduled
+        %                               on. 0 if scheduled at a time
+        %           .targetSec      -   [numEvents x 1] time it was due
+        %           .sentSec        -   [numEvents x 1] time it was sent.
+        %                               NaN if not sent
+        %           .sentSample     -   [numEvents x 1] sample acquired
+        %                               when it was sent
+        %           .state          -   [numEvents x 1] 0 pending, 1 sent,
+        %                               2 cancelled, 3 failed
+        function eventStruct = GetTriggerEvents(self)
+            
+            events = DAQgUSBampMex('GetTriggerEvents', self.objectHandle);
+            
+            eventStruct.value = events(:, 1);
+            eventStruct.targetSample = events(:, 2);
+            eventStruct.targetSec = events(:, 3);
+            eventStruct.sentSec = events(:, 4);
+            eventStruct.sentSample = events(:, 5);
+            eventStruct.state = events(:, 6);
+        end
+        
+        % GetRecorderStats - Gets the cost of writing the recording in
+        % progress (or the last one) with its 'durability'
+        %
+        %   Outputs:
+        %       statsStruct
+        %           .writtenMB      -   MB written to the file
+        %           .committedMB    -   MB a crash would keep
+        %           .numChunks      -   writes
+        %           .numExtents     -   file space reservations
+        %           .numSyncs       -   syncs to disk
+        %           .meanWriteMs    -   mean and max time of a write
+        %           .maxWriteMs
+        %           .meanSyncMs     -   mean and max time of a sync
+        %           .maxSyncMs
+        %           .maxQueuedChunks -  most writes waiting at once
+        function statsStruct = GetRecorderStats(self)
+            
+            stats = DAQgUSBampMex('GetRecorderStats', self.objectHandle);
+            
+            statsStruct.writtenMB = stats(1);
+            statsStruct.committedMB = stats(2);
+            statsStruct.numChunks = stats(3);
+            statsStruct.numExtents = stats(4);
+            statsStruct.numSyncs = stats(5);
+            statsStruct.meanWriteMs = stats(6);
+            statsStruct.maxWriteMs = stats(7);
+            statsStruct.meanSyncMs = stats(8);
+            statsStruct.maxSyncMs = stats(9);
+            statsStruct.maxQueuedChunks = stats(10);
+        end
+        
+        % MeasureImpedance - Measures the electrode impedances of all
+        % channels, all amplifiers at once. Only works when the device is
+        % open and not acquiring
+        %
+        %   Outputs:
+        %       impedanceTable  -   [numChannels x 2] channel (as in
+        %                           'channelList') and its impedance in
+        %                           kOhm. NaN if it couldn't be measured
+        function impedanceTable = MeasureImpedance(self)
+            
+            if self.status ~= self.STATUS_OPEN
+                impedanceTable = [];
+                warning('MeasureImpedance only works on STATUS_OPEN');
+                return
+            end
+            
+            impedanceKOhm = DAQgUSBampMex('MeasureImpedance', self.objectHandle);
+            impedanceTable = [double(self.channelList(:)) impedanceKOhm];
+        end
+        
+        % StartImpedanceMonitor - Measures the impedances continuously
+        % while the electrodes are adjusted, read them with GetImpedances.
+        % Ends with StopImpedanceMonitor or StartAcquisition
+        function StartImpedanceMonitor(self)
+            
+            if self.status ~= self.STATUS_OPEN
+                warning('StartImpedanceMonitor only works on STATUS_OPEN');
+                return
+            end
+            
+            DAQgUSBampMex('StartImpedanceMonitor', self.objectHandle);
+        end
+        
+        % StopImpedanceMonitor - Ends continuous impedance measurement
+        function StopImpedanceMonitor(self)
+            
+            if self.status == self.STATUS_STANDBY
+                return
+            end
+            
+            DAQgUSBampMex('StopImpedanceMonitor', self.objectHandle);
+        end
+        
+        % GetImpedances - Gets the latest impedances measured by
+        % MeasureImpedance or the impedance monitor
+        %
+        %   Outputs:
+        %       impedanceTable  -   [numChannels x 2] channel and its
+        %                           impedance in kOhm. NaN until measured
+        %       numSweeps       -   Sweeps over all channels completed by
+        %                           every amplifier. -1 if never measured
+        function [impedanceTable, numSweeps] = GetImpedances(self)
+            
+            if self.status == self.STATUS_STANDBY
+                impedanceTable = [];
+                numSweeps = -1;
+                warning('GetImpedances only works when device is open');
+                return
+            end
+            
+            [impedanceKOhm, numSweeps] = DAQgUSBampMex('GetImpedances', self.objectHandle);
+            impedanceTable = [double(self.channelList(:)) impedanceKOhm];
+        end
+        
+        % EnableSignalQuality - Enables per channel signal quality metrics
+        % in the acquisition library, computed over consecutive windows on
+        % a dispatch thread. When recording, each window is also logged to
+        % <fileName>.quality.csv
+        %
+        %   Inputs:
+        %       'windowSec'     -   Length of the windows in seconds. 0
+        %                           disables the metrics. 1 by default
+        %       'lineFrequency' -   Line noise frequency in Hz. 50 by
+        %                           default
+        %       'saturationUv'  -   Level at which a sample is saturated,
+        %                           in uV. 250000 (amplifier range) by
+        %                           default
+        %       'flatlineUv'    -   Peak to peak below which a channel is
+        %                           flat, in uV. 1 by default
+        function EnableSignalQuality(self, varargin)
+            
+            p = inputParser;
+            p.addParameter('windowSec',1,@isscalar);
+            p.addParameter('lineFrequency',50,@isscalar);
+            p.addParameter('saturationUv',250000,@isscalar);
+            p.addParameter('flatlineUv',1,@isscalar);
+            p.parse(varargin{:});
+            
+            if self.status == self.STATUS_STANDBY
+                warning('EnableSignalQuality only works when device is open');
+                return
+            end
+            
+            DAQgUSBampMex('EnableSignalQuality', self.objectHandle, ...
+                double(p.Results.windowSec), double(p.Results.lineFrequency), ...
+                double(p.Results.saturationUv), double(p.Results.flatlineUv));
+        end
+        
+        % GetSignalQuality - Gets the signal quality of each channel in the
+        % last complete window
+        %
+        %   Outputs:
+        %       qualityStruct
+        %           .meanUv         -   [numChannels x 1] DC offset in uV
+        %           .rmsUv          -   [numChannels x 1] RMS around the
+        %                               mean in uV
+        %           .linePowerUv2   -   [numChannels x 1] power at the line
+        %                               frequency in uV^2
+        %           .peakToPeakUv   -   [numChannels x 1] peak to peak in uV
+        %           .saturatedFraction - [numChannels x 1] fraction of
+        %                               saturated samples
+        %           .driftUvPerSec  -   [numChannels x 1] change of the mean
+        %                               since the previous window
+        %           .flatline       -   [numChannels x 1] true if flat
+        %           .saturated      -   [numChannels x 1] true if saturated
+        %           .numWindows     -   Windows since acquisition started.
+        %                               -1 if disabled
+        function qualityStruct = GetSignalQuality(self)
+            
+            if self.status == self.STATUS_STANDBY
+                qualityStruct = [];
+                warning('GetSignalQuality only works when device is open');
+                return
+            end
+            
+            [quality, qualityStruct.numWindows] = DAQgUSBampMex('GetSignalQuality', self.objectHandle);
+            qualityStruct.meanUv = quality(:,1);
+            qualityStruct.rmsUv = quality(:,2);
+            qualityStruct.linePowerUv2 = quality(:,3);
+            qualityStruct.peakToPeakUv = quality(:,4);
+            qualityStruct.saturatedFraction = quality(:,5);
+            qualityStruct.driftUvPerSec = quality(:,6);
+            qualityStruct.flatline = quality(:,7) ~= 0;
+            qualityStruct.saturated = quality(:,8) ~= 0;
+        end
+        
+        % EnableFeatureEngine - Enables online SSVEP feature extraction in
+        % the acquisition library. Band power and CCA against sine/cosine
+        % templates are computed on a sliding window as blocks arrive
+        %
+        %   Inputs:
+        %       'freq'          -   [numClasses x 1] stimulus frequencies in
+        %                           Hz. Empty disables feature extraction
+        %       'numHarmonics'  -   Number of harmonics in the templates. 2
+        %                           by default
+        %       'windowSec'     -   Length of the sliding window in seconds.
+        %                           2 by default
+        %       'hopSec'        -   Time between score updates in seconds.
+        %                           0.25 by default
+        function EnableFeatureEngine(self, varargin)
+            
+            p = inputParser;
+            p.addParameter('freq',[],@isnumeric);
+            p.addParameter('numHarmonics',2,@isscalar);
+            p.addParameter('windowSec',2,@isscalar);
+            p.addParameter('hopSec',0.25,@isscalar);
+            p.parse(varargin{:});
+            
+            if self.status == self.STATUS_STANDBY
+                warning('EnableFeatureEngine only works when device is open');
+                return
+            end
+            
+            DAQgUSBampMex('EnableFeatures', self.objectHandle, ...
+                double(p.Results.freq(:)), int32(p.Results.numHarmonics), ...
+                double(p.Results.windowSec), double(p.Results.hopSec));
+        end
+        
+        % GetFeatures - Gets latest features computed by the acquisition
+        % library so that a classifier can use them without processing the
+        % raw trial
+        %
+        %   Outputs:
+        %       featureStruct
+        %           .bandPower      -   [numClasses x 1] band power at each
+        %                               stimulus frequency (summed over
+        %                               harmonics, averaged over channels)
+        %           .cca            -   [numClasses x 1] canonical
+        %                               correlation with each template
+        %           .updateCount    -   Number of updates since acquisition
+        %                               started. -1 if disabled
+        function featureStruct = GetFeatures(self)
+            
+            if self.status == self.STATUS_STANDBY
+                featureStruct = [];
+                warning('GetFeatures only works when device is open');
+                return
+            end
+            
+            [featureStruct.bandPower, featureStruct.cca, featureStruct.updateCount] = ...
+                DAQgUSBampMex('GetFeatures', self.objectHandle);
+        end
+        
+        % EnableEarlyStopping - Enables incremental classification of block
+        % trials in the acquisition library. Class posteriors are updated
+        % as each block of the trial arrives and a decision is signaled as
+        % soon as the largest posterior crosses the threshold
+        %
+        %   Inputs:
+        %       'freq'          -   [numClasses x 1] stimulus frequencies in
+        %                           Hz. Empty disables early stopping
+        %       'numHarmonics'  -   Number of harmonics in the CCA
+        %                           templates. 2 by default
+        %       'prior'         -   [numClasses x 1] class prior. Uniform by
+        %                           default
+        %       'threshold'     -   Posterior needed to decide. 0.95 by
+        %                           default
+        %       'minTrialSec'   -   No decision is taken before this many
+        %                           seconds of trial. 0.5 by default
+        %       'evidenceGain'  -   Log posterior gain per sample and unit
+        %                           of Fisher z of the canonical
+        %                           correlation. 0.05 by default
+        function EnableEarlyStopping(self, varargin)
+            
+            p = inputParser;
+            p.addParameter('freq',[],@isnumeric);
+            p.addParameter('numHarmonics',2,@isscalar);
+            p.addParameter('prior',[],@isnumeric);
+            p.addParameter('threshold',0.95,@isscalar);
+            p.addParameter('minTrialSec',0.5,@isscalar);
+            p.addParameter('evidenceGain',0.05,@isscalar);
+            p.parse(varargin{:});
+            
+            if self.status == self.STATUS_STANDBY
+                warning('EnableEarlyStopping only works when device is open');
+                return
+            end
+            
+            if ~self.triggerFlag && ~isempty(p.Results.freq)
+                warning('EnableEarlyStopping needs the trigger channel');
+                return
+            end
+            
+            DAQgUSBampMex('EnableEarlyStop', self.objectHandle, ...
+                double(p.Results.freq(:)), int32(p.Results.numHarmonics), ...
+                double(p.Results.prior(:)), double(p.Results.threshold), ...
+                double(p.Results.minTrialSec), double(p.Results.evidenceGain));
+        end
+        
+        % WaitForDecision - Waits until the current block trial is decided
+        % by the early stopping classifier (or ends). The stimulus can be
+        % stopped as soon as this returns with decidedFlag set
+        %
+        %   Inputs:
+        %       'maxWaitSec'    -   Timeout in seconds. 10 by default
+        %
+        %   Outputs:
+        %       estimateStruct
+        %           .aPosteriori    -   [numClasses x 1] class posteriors
+        %           .classIdx       -   Most likely class
+        %           .decidedFlag    -   False on timeout
+        %           .trialLengthSec -   Length of trial used to decide
+        function estimateStruct = WaitForDecision(self, varargin)
+            
+            p = inputParser;
+            p.addParameter('maxWaitSec',10,@isscalar);
+            p.parse(varargin{:});
+            
+            if self.status ~= self.STATUS_ACQUIRINGDATA
+                estimateStruct = [];
+                warning('WaitForDecision only works when device is acquiring data');
+                return
+            end
+            
+            [estimateStruct.aPosteriori, estimateStruct.decidedFlag, numSamples] = ...
+                DAQgUSBampMex('WaitForDecision', self.objectHandle, double(p.Results.maxWaitSec));
+            
+            [~, estimateStruct.classIdx] = max(estimateStruct.aPosteriori);
+            estimateStruct.decidedFlag = logical(estimateStruct.decidedFlag);
+            estimateStruct.trialLengthSec = numSamples / self.fs;
+        end
+        
+        % EnableEOGDetector - Flags blinks and eye movements on EOG
+        % derivations as blocks arrive, and each block trial as soon as its
+        % trigger falls (see WaitForTrialArtifacts) so it can be repeated.
+        % Call with an empty 'plus' to disable it
+        %
+        %   Inputs:
+        %       'plus'          -   Channels (position in channelList) of
+        %                           each derivation. [2 3 6 3] by default
+        %                           (plotEOG.m)
+        %       'minus'         -   Channel subtracted from each
+        %                           derivation, 0 for none. [1 0 5 7] by
+        %                           default
+        %       'thresholdUv'   -   Deviation from the baseline flagged.
+        %                           100 uV by default
+        %       'slopeUvPerSec' -   Slope flagged (over 50 ms), 0 disables.
+        %                           3000 uV/s by default
+        %       'templateCorrelation' - Correlation with a 300 ms blink
+        %                           flagged, 0 disables. 0.9 by default
+        %       'marginSec'     -   Margin added around flagged samples.
+        %                           0.1 s by default
+        function EnableEOGDetector(self, varargin)
+            
+            p = inputParser;
+            p.addParameter('plus',[2 3 6 3],@isnumeric);
+            p.addParameter('minus',[1 0 5 7],@isnumeric);
+            p.addParameter('thresholdUv',100,@isscalar);
+            p.addParameter('slopeUvPerSec',3000,@isscalar);
+            p.addParameter('templateCorrelation',0.9,@isscalar);
+            p.addParameter('marginSec',0.1,@isscalar);
+            p.parse(varargin{:});
+            
+            if self.status == self.STATUS_STANDBY
+                warning('EnableEOGDetector only works when device is open');
+                return
+            end
+            
+            DAQgUSBampMex('EnableEOGDetector', self.objectHandle, ...
+                int32(p.Results.plus(:)), int32(p.Results.minus(:)), ...
+                double([p.Results.thresholdUv p.Results.slopeUvPerSec ...
+                p.Results.templateCorrelation p.Results.marginSec]));
+        end
+        
+        % GetEOGArtifacts - Gets the artifact spans and the flags of the
+        % block trials ended since acquisition started
+        %
+        %   Outputs:
+        %       artifactStruct
+        %           .spans          -   [numSpans x 2] first and last
+        %                               sample of each span
+        %           .peakUv         -   [numSpans x 1] largest deviation
+        %           .causes         -   [numSpans x 1] flagging criteria
+        %                               (1 threshold, 2 slope, 4 template)
+        %           .trialStarts    -   [numTrials x 1] first sample of
+        %                               each trial (as loadSessionTrials)
+        %           .trialLengths   -   [numTrials x 1] trial lengths
+        %           .artifactSamples -  [numTrials x 1] flagged samples
+        %           .contaminatedFlag - [numTrials x 1] any sample flagged
+        function artifactStruct = GetEOGArtifacts(self)
+            
+            [spans, trials] = DAQgUSBampMex('GetEOGArtifacts', self.objectHandle);
+            
+            artifactStruct.spans = spans(:, 1:2);
+            artifactStruct.peakUv = spans(:, 3);
+            artifactStruct.causes = spans(:, 4);
+            artifactStruct.trialStarts = trials(:, 1);
+            artifactStruct.trialLengths = trials(:, 2);
+            artifactStruct.artifactSamples = trials(:, 3);
+            artifactStruct.contaminatedFlag = trials(:, 3) > 0;
+        end
+        
+        % WaitForTrialArtifacts - Waits until the current block trial ends
+        % and returns its EOG artifact flags. Call it after GetTrial to
+        % decide whether the trial has to be repeated
+        %
+        %   Inputs:
+        %       'maxWaitSec'    -   Timeout in seconds. 10 by default
+        %
+        %   Outputs:
+        %       artifactStruct
+        %           .endedFlag      -   False on timeout
+        %           .contaminatedFlag - Some samples of the trial flagged
+        %           .artifactSamples -  Number of flagged samples
+        %           .trialStart     -   First sample of the trial
+        %           .trialLength    -   Length of the trial in samples
+        function artifactStruct = WaitForTrialArtifacts(self, varargin)
+            
+            p = inputParser;
+            p.addParameter('maxWaitSec',10,@isscalar);
+            p.parse(varargin{:});
+            
+            if self.status ~= self.STATUS_ACQUIRINGDATA
+                artifactStruct = [];
+                warning('WaitForTrialArtifacts only works when device is acquiring data');
+                return
+            end
+            
+            trial = DAQgUSBampMex('WaitForTrialArtifacts', self.objectHandle, double(p.Results.maxWaitSec));
+            
+            artifactStruct.endedFlag = ~isempty(trial);
+            artifactStruct.contaminatedFlag = ~isempty(trial) && trial(3) > 0;
+            artifactStruct.artifactSamples = sum(trial(:, 3));
+            artifactStruct.trialStart = trial(:, 1);
+            artifactStruct.trialLength = trial(:, 2);
+        end
+        
+        % EnableEnvelope - Keeps the min/max envelope of every channel and
+        % the trigger at several resolutions as blocks arrive, so any time
+        % range can be drawn at the width of a plot without reading the
+        % samples (see GetEnvelope). Recordings get the same envelope next
+        % to them (<file>.envelope, see SessionFileMex 'envelope')
+        %
+        %   Inputs:
+        %       'historySec'    -   Time kept for display. 600 s by
+        %                           default, 0 disables it
+        function EnableEnvelope(self, varargin)
+            
+            p = inputParser;
+            p.addParameter('historySec',600,@isscalar);
+            p.parse(varargin{:});
+            
+            if self.status == self.STATUS_STANDBY
+                warning('EnableEnvelope only works when device is open');
+                return
+            end
+            
+            DAQgUSBampMex('EnableEnvelope', self.objectHandle, double(p.Results.historySec));
+        end
+        
+        % GetEnvelope - Gets the min/max envelope of the channels over a
+        % time range, one value per pixel
+        %
+        %   Inputs:
+        %       'channels'      -   Channels (position in channelList,
+        %                           numChannels + 1 for the trigger). All
+        %                           but the trigger by default
+        %       'startSec'      -   Start since acquisition started,
+        %                           negative for the last durationSec. -1
+        %                           by default
+        %       'durationSec'   -   Time range. 10 s by default
+        %       'width'         -   Pixels. 1000 by default
+        %
+        %   Outputs:
+        %       envelopeStruct
+        %           .minimum        -   [width x numChannels] NaN where
+        %                               nothing was acquired
+        %           .maximum        -   [width x numChannels]
+        %           .level          -   Samples per bin are 4^level
+        %           .numSamples     -   Samples in the envelope
+        function envelopeStruct = GetEnvelope(self, varargin)
+            
+            p = inputParser;
+            p.addParameter('channels',1:length(self.channelList),@isnumeric);
+            p.addParameter('startSec',-1,@isscalar);
+            p.addParameter('durationSec',10,@isscalar);
+            p.addParameter('width',1000,@isscalar);
+            p.parse(varargin{:});
+            
+            if self.status == self.STATUS_STANDBY
+                envelopeStruct = [];
+                warning('GetEnvelope only works when device is open');
+                return
+            end
+            
+            [envelopeStruct.minimum, envelopeStruct.maximum, envelopeStruct.level, envelopeStruct.numSamples] = ...
+                DAQgUSBampMex('GetEnvelope', self.objectHandle, int32(p.Results.channels(:)), ...
+                double(p.Results.startSec), double(p.Results.durationSec), int32(p.Results.width));
+        end
+        
+        % ReplayFinished - True once the replayed recording has ended
+        % (replayFile), acquisition then stops by itself
+        function finishedFlag = ReplayFinished(self)
+            
+            finishedFlag = false;
+            if self.status ~= self.STATUS_STANDBY
+                finishedFlag = logical(DAQgUSBampMex('ReplayFinished', self.objectHandle));
+            end
+        end
+        
+        % WaitForSamples - Waits until numSamples samples can be read. The
+        % acquisition loop wakes the caller once, when they are written
+        %
+        %   Inputs:
+        %       numSamples      -   Number of samples to wait for
+        %       'maxWaitSec'    -   Timeout in seconds. Inf by default
+        %
+        %   Outputs:
+        %       availableFlag   -   False on timeout
+        function availableFlag = WaitForSamples(self, numSamples, varargin)
+            
+            p = inputParser;
+            p.addParameter('maxWaitSec',inf,@isscalar);
+            p.parse(varargin{:});
+            
+            if self.status ~= self.STATUS_ACQUIRINGDATA
+                availableFlag = false;
+                warning('WaitForSamples only works when device is acquiring data');
+                return
+            end
+            
+            % Negative timeout waits without deadline
+            maxWaitSec = p.Results.maxWaitSec;
+            if isinf(maxWaitSec)
+                maxWaitSec = -1;
+            end
+            
+            availableFlag = DAQgUSBampMex('WaitForSamples', self.objectHandle, int32(numSamples), double(maxWaitSec));
+        end
+        
+        % WaitForTrigger - Waits for the trigger to change to a value in
+        % the data acquired after the call
+        %
+        %   Inputs:
+        %       'triggerValue'  -   Trigger value to wait for. -1 (default)
+        %                           for any non-zero value
+        %       'maxWaitSec'    -   Timeout in seconds. 10 by default
+        %
+        %   Outputs:
+        %       triggerNdx      -   Index of the trigger onset in the data
+        %                           the next GetData returns. Empty on
+        %                           timeout
+        function triggerNdx = WaitForTrigger(self, varargin)
+            
+            p = inputParser;
+            p.addParameter('triggerValue',-1,@isscalar);
+            p.addParameter('maxWaitSec',10,@isscalar);
+            p.parse(varargin{:});
+            
+            triggerNdx = [];
+            if self.status ~= self.STATUS_ACQUIRINGDATA || ~self.triggerFlag
+                warning('WaitForTrigger only works when device is acquiring data with trigger');
+                return
+            end
+            
+            position = DAQgUSBampMex('WaitForTrigger', self.objectHandle, ...
+                         int32(p.Results.triggerValue), double(p.Results.maxWaitSec));
+            if position >= 0
+                triggerNdx = position + 1;
+            end
+        end
+        
+        % GetTransferStats - Gets the state of the transfer queues of the
+        % acquisition loop
+        %
+        %   Outputs:
+        %       transferStruct
+        %           .queueDepth     -   [numAmps x 1] transfers queued per
+        %                               amplifier
+        %           .latencyMs      -   [3 x numAmps] 50th, 95th and 99th
+        %                               percentile of the completion
+        %                               latency over the last 128 blocks
+        %           .lostScans      -   Scans dropped by the amplifiers. -1
+        %                               if the driver cannot tell
+        %           .numBlocks      -   Blocks acquired since acquisition
+        %                               started
+        %           .pageFaults     -   Page faults of the process since
+        %                               acquisition started. -1 if unknown
+        %           .contextSwitches -  Context switches of the
+        %                               acquisition thread since it
+        %                               started. -1 if unknown
+        %           .engineThread   -   I/O thread of the shared engine
+        %                               acquiring this object. -1 if none
+        %           .clippedValues  -   Values clipped to the range of the
+        %                               compact storage since acquisition
+        %                               started
+        function transferStruct = GetTransferStats(self)
+            
+            if self.status == self.STATUS_STANDBY
+                transferStruct = [];
+                warning('GetTransferStats only works when device is open');
+                return
+            end
+            
+            [transferStruct.queueDepth, transferStruct.latencyMs, transferStruct.lostScans, transferStruct.numBlocks] = ...
+                DAQgUSBampMex('GetTransferStats', self.objectHandle);
+            [transferStruct.pageFaults, transferStruct.contextSwitches] = ...
+                DAQgUSBampMex('GetSchedulingStats', self.objectHandle);
+            transferStruct.engineThread = DAQgUSBampMex('EngineThread', self.objectHandle);
+            transferStruct.clippedValues = DAQgUSBampMex('ClippedValues', self.objectHandle);
+        end
+        
         % Tests the triggers received by the amplifiers. This function uses
         % the USB triggers provided by the library.             
         %   * The connection of the all bits.
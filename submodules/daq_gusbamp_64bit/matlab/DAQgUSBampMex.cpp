@@ -13,6 +13,7 @@
 #define _AFXDLL
 #include <afx.h>
 #include <string>
+#include <math.h>
 #include "mex.h"
 #include "class_handle.hpp"
 #include "DAQgUSBamp.h"
@@ -33,11 +34,12 @@ void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
     //                      int32(self.triggerFlag), int32(self.ampFilterNdx),... 
     //                      int32(self.notchFilterNdx), uint8(ampMode), ...
     //                      int32(self.commonReference), int32(self.commonGround), ...
-    //                      uint8(self.bipolarSettings));
+    //                      uint8(self.bipolarSettings), blockPolicy);
+    // blockPolicy is optional: 'default', 'lowLatency', 'highThroughput' or int32([blockScans queueDepth wakeBlocks])
     if (!strcmp("new", cmd)) 
     {        
         // Check parameters
-        if (nlhs != 1 || nrhs != 11)
+        if (nlhs != 1 || (nrhs != 11 && nrhs != 12))
             mexErrMsgTxt("DAQgUSBamp: One output expected.");
         
         // Constructor parameters. Type checking is important here so this assumes that 
@@ -55,10 +57,31 @@ void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
         unsigned char * tmpBipolarArray = (unsigned char *)  mxGetData(prhs[10]);
         std::vector<unsigned char> bipolarSettings(tmpBipolarArray, tmpBipolarArray + NumChannels);
         
+        // Block policy preset or explicit values
+        BlockPolicy blockPolicy;
+        if (nrhs == 12 && mxIsChar(prhs[11]))
+        {
+            char preset[32];
+            mxGetString(prhs[11], preset, sizeof(preset));
+            if (!strcmp("lowLatency", preset))
+                blockPolicy = BlockPolicy::LowLatency(SampleRate);
+            else if (!strcmp("highThroughput", preset))
+                blockPolicy = BlockPolicy::HighThroughput(SampleRate);
+            else if (strcmp("default", preset))
+                mexErrMsgTxt("DAQgUSBamp: Unknown block policy.");
+        }
+        else if (nrhs == 12)
+        {
+            if (mxGetNumberOfElements(prhs[11]) != 3)
+                mexErrMsgTxt("DAQgUSBamp: Block policy should be [blockScans queueDepth wakeBlocks].");
+            int * tmpPolicyArray = (int *) mxGetData(prhs[11]);
+            blockPolicy = BlockPolicy(tmpPolicyArray[0], tmpPolicyArray[1], tmpPolicyArray[2]);
+        }
+        
         // Return a handle to a new C++ instance
         plhs[0] = convertPtr2Mat<DAQgUSBamp>(new DAQgUSBamp( 
                 channelsToAcquire, SampleRate, TRIGGER, BPFindex, 
-                Notchindex, _mode, commonReference, commonGround, bipolarSettings));
+                Notchindex, _mode, commonReference, commonGround, bipolarSettings, blockPolicy));
         return;
     }
     
@@ -149,16 +172,51 @@ void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
         return;
         
     }
-    // Calibration: command to perform calibration
+    // Calibration: command to perform calibration. If staleOnly is set, only the amplifiers without a recent
+    // cached calibration are calibrated
     // Usage: 
     //      DAQgUSBampMex('Calibration', self.objectHandle);
+    //      DAQgUSBampMex('Calibration', self.objectHandle, int32(staleOnly));
     if (!strcmp("Calibration", cmd)) 
     {
         // Check parameters
-        if (nlhs != 0 || nrhs != 2)
+        if (nlhs != 0 || nrhs < 2 || nrhs > 3)
             mexErrMsgTxt("Calibration: Unexpected arguments.");
+        
+        bool staleOnly = (nrhs == 3) && mxGetScalar(prhs[2]) != 0;
+        
         // Call the method        
-        DAQgUSBampObj->AmpCalibration();
+        DAQgUSBampObj->AmpCalibration(staleOnly);
+        return;
+    }
+    // SetCalibrationCache: keeps calibrations in fileName and reapplies them on open while less than maxAgeHours
+    // old. An empty fileName disables the cache. Must be called before OpenDevice
+    // Usage:
+    //      DAQgUSBampMex('SetCalibrationCache', self.objectHandle, fileName, double(maxAgeHours));
+    if (!strcmp("SetCalibrationCache", cmd)) 
+    {
+        // Check parameters
+        if (nlhs != 0 || nrhs != 4 || !mxIsChar(prhs[2]))
+            mexErrMsgTxt("SetCalibrationCache: Unexpected arguments.");
+        
+        char * fileName = mxArrayToString(prhs[2]);
+        bool success = DAQgUSBampObj->SetCalibrationCache(fileName, mxGetScalar(prhs[3]));
+        mxFree(fileName);
+        
+        if (!success)
+            mexErrMsgTxt("SetCalibrationCache: Could not set the calibration cache.");
+        return;
+    }
+    // CalibrationStale: true if the calibration cache is enabled and an opened amplifier has no recent calibration
+    // Usage:
+    //      staleFlag = DAQgUSBampMex('CalibrationStale', self.objectHandle);
+    if (!strcmp("CalibrationStale", cmd)) 
+    {
+        // Check parameters
+        if (nlhs != 1 || nrhs != 2)
+            mexErrMsgTxt("CalibrationStale: Unexpected arguments.");
+        
+        plhs[0] = mxCreateLogicalScalar(DAQgUSBampObj->CalibrationStale());
         return;
     }
     // StartAcquisition: command to perform acquisition. If filename is empty, no recording will be done
@@ -218,6 +276,36 @@ void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
         return;
     }
     
+    // GetChannelData: command to get numSamples samples of a subset of channels (indices from 1, numChannels + 1 for
+    // the trigger) from buffer, one column per channel. If numSamples is -1, all samples from buffer will be output
+    // The output is in float32 type.
+    // Usage:
+    //      dataBuffer = DAQgUSBampMex('GetChannelData', self.objectHandle, int32(numSamples), int32(channels))
+    if (!strcmp("GetChannelData", cmd)) 
+    {
+        // Check parameters
+        if (nlhs != 1 || nrhs != 4)
+            mexErrMsgTxt("GetChannelData: Unexpected arguments.");
+        int NumSamples = mxGetScalar(prhs[2]);
+        
+        if (NumSamples < 0)
+            NumSamples = DAQgUSBampObj->AvailableSamples();
+        
+        std::vector<int> channels;
+        int numSelected = mxGetNumberOfElements(prhs[3]);
+        for (int i = 0; i < numSelected; i++)
+            channels.push_back(((int *) mxGetData(prhs[3]))[i] - 1);
+        
+        // Channel-major rows are the columns of a MATLAB matrix
+        plhs[0] = mxCreateNumericMatrix(NumSamples, numSelected, mxSINGLE_CLASS, mxREAL);
+        float * dataBuffer = (float *) mxGetData(plhs[0]);
+        
+        // Call the method
+        if (!DAQgUSBampObj->GetChannelData(dataBuffer, NumSamples, channels))
+            mexErrMsgTxt("GetChannelData: Invalid channel, buffer overrun or acquisition stopped.");
+        return;
+    }
+    
     // AvailableSamples: command to return the number of available samples in buffer
     // Usage:
     //      nSamples = DAQgUSBampMex('AvailableSamples', self.objectHandle);
@@ -255,6 +343,786 @@ void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
         return;
     }
     
+    // ScheduleTrigger: writes triggerValue (0-15) to the digital outputs from the trigger scheduler thread at host time
+    // timeSec (TriggerClock) or, with onScanFlag, on sample timeSec (1 based, counted since acquisition started).
+    // Returns the event id (1 based), 0 if not acquiring
+    // Usage:
+    //      eventId = DAQgUSBampMex('ScheduleTrigger', self.objectHandle, int32(triggerValue), double(timeSec), logical(onScanFlag));
+    if (!strcmp("ScheduleTrigger", cmd)) 
+    {
+        // Check parameters
+        if (nlhs != 1 || nrhs != 5)
+            mexErrMsgTxt("ScheduleTrigger: Unexpected arguments.");
+        
+        int triggerValue = (int) mxGetScalar(prhs[2]);
+        double target = mxGetScalar(prhs[3]);
+        bool onScan = mxGetScalar(prhs[4]) != 0;
+        
+        // Call the method
+        int id = onScan ? DAQgUSBampObj->ScheduleTriggerAtScan(triggerValue, (long long) target - 1)
+            : DAQgUSBampObj->ScheduleTrigger(triggerValue, target);
+        plhs[0] = mxCreateDoubleScalar((double) id + 1);
+        return;
+    }
+    
+    // TriggerClock: returns the host clock of the trigger scheduler in seconds
+    // Usage:
+    //      timeSec = DAQgUSBampMex('TriggerClock', self.objectHandle);
+    if (!strcmp("TriggerClock", cmd)) 
+    {
+        // Check parameters
+        if (nlhs != 1 || nrhs != 2)
+            mexErrMsgTxt("TriggerClock: Unexpected arguments.");
+        
+        // Call the method
+        plhs[0] = mxCreateDoubleScalar(DAQgUSBampObj->TriggerClock());
+        return;
+    }
+    
+    // SetTriggerLatency: sets the send to sample latency of the trigger outputs in ms, triggers on a sample are written
+    // that much earlier
+    // Usage:
+    //      DAQgUSBampMex('SetTriggerLatency', self.objectHandle, double(latencyMs));
+    if (!strcmp("SetTriggerLatency", cmd)) 
+    {
+        // Check parameters
+        if (nlhs != 0 || nrhs != 3)
+            mexErrMsgTxt("SetTriggerLatency: Unexpected arguments.");
+        
+        // Call the method
+        DAQgUSBampObj->SetTriggerLatency(mxGetScalar(prhs[2]));
+        return;
+    }
+    
+    // CancelTriggers: cancels the scheduled triggers not written yet and returns how many
+    // Usage:
+    //      numCancelled = DAQgUSBampMex('CancelTriggers', self.objectHandle);
+    if (!strcmp("CancelTriggers", cmd)) 
+    {
+        // Check parameters
+        if (nlhs != 1 || nrhs != 2)
+            mexErrMsgTxt("CancelTriggers: Unexpected arguments.");
+        
+        // Call the method
+        plhs[0] = mxCreateDoubleScalar((double) DAQgUSBampObj->CancelTriggers());
+        return;
+    }
+    
+    // GetTriggerEvents: returns the triggers scheduled since acquisition started [numEvents x 6]: value, target
+    // sample (1 based, 0 if scheduled at a time), target time, time written, sample being acquired then (1 based) and
+    // state (0 pending, 1 written, 2 cancelled, 3 failed). Times are on TriggerClock, NaN until written
+    // Usage:
+    //      events = DAQgUSBampMex('GetTriggerEvents', self.objectHandle);
+    if (!strcmp("GetTriggerEvents", cmd)) 
+    {
+        // Check parameters
+        if (nlhs != 1 || nrhs != 2)
+            mexErrMsgTxt("GetTriggerEvents: Unexpected arguments.");
+        
+        std::vector<TriggerEvent> events;
+        
+        // Call the method
+        DAQgUSBampObj->GetTriggerEvents(events);
+        
+        size_t numEvents = events.size();
+        plhs[0] = mxCreateDoubleMatrix(numEvents, 6, mxREAL);
+        double * eventMatrix = mxGetPr(plhs[0]);
+        for (size_t i = 0; i < numEvents; i++)
+        {
+            eventMatrix[i] = events[i].value;
+            eventMatrix[i + numEvents] = (double) events[i].targetScan + 1;
+            eventMatrix[i + 2 * numEvents] = events[i].targetTime;
+            eventMatrix[i + 3 * numEvents] = events[i].emitTime;
+            eventMatrix[i + 4 * numEvents] = (double) events[i].emitScan + 1;
+            eventMatrix[i + 5 * numEvents] = events[i].state;
+        }
+        return;
+    }
+    
+    // MeasureImpedance: measures the electrode impedance of every channel in kOhm [numChannels x 1], all devices at
+    // once. Devices must be open and not acquiring
+    // Usage:
+    //      impedanceKOhm = DAQgUSBampMex('MeasureImpedance', self.objectHandle);
+    if (!strcmp("MeasureImpedance", cmd)) 
+    {
+        // Check parameters
+        if (nlhs != 1 || nrhs != 2)
+            mexErrMsgTxt("MeasureImpedance: Unexpected arguments.");
+        
+        plhs[0] = mxCreateDoubleMatrix(DAQgUSBampObj->numChannels, 1, mxREAL);
+        
+        // Call the method, channels that couldn't be measured are NaN
+        if (!DAQgUSBampObj->MeasureImpedance(mxGetPr(plhs[0])))
+            mexWarnMsgTxt("MeasureImpedance: Some channels couldn't be measured.");
+        return;
+    }
+    
+    // StartImpedanceMonitor / StopImpedanceMonitor: measures impedances continuously until stopped (or acquisition
+    // starts). Devices must be open and not acquiring
+    // Usage:
+    //      DAQgUSBampMex('StartImpedanceMonitor', self.objectHandle);
+    //      DAQgUSBampMex('StopImpedanceMonitor', self.objectHandle);
+    if (!strcmp("StartImpedanceMonitor", cmd)) 
+    {
+        // Check parameters
+        if (nlhs != 0 || nrhs != 2)
+            mexErrMsgTxt("StartImpedanceMonitor: Unexpected arguments.");
+        
+        // Call the method
+        if (!DAQgUSBampObj->StartImpedanceMonitor())
+            mexErrMsgTxt("StartImpedanceMonitor: Devices not open, acquiring or already measuring.");
+        return;
+    }
+    if (!strcmp("StopImpedanceMonitor", cmd)) 
+    {
+        // Check parameters
+        if (nlhs != 0 || nrhs != 2)
+            mexErrMsgTxt("StopImpedanceMonitor: Unexpected arguments.");
+        
+        // Call the method
+        DAQgUSBampObj->StopImpedanceMonitor();
+        return;
+    }
+    
+    // GetImpedances: returns the latest impedances in kOhm [numChannels x 1] (NaN until measured) and the number of
+    // sweeps every device has completed (-1 if never measured)
+    // Usage:
+    //      [impedanceKOhm, numSweeps] = DAQgUSBampMex('GetImpedances', self.objectHandle);
+    if (!strcmp("GetImpedances", cmd)) 
+    {
+        // Check parameters
+        if (nlhs != 2 || nrhs != 2)
+            mexErrMsgTxt("GetImpedances: Unexpected arguments.");
+        
+        plhs[0] = mxCreateDoubleMatrix(DAQgUSBampObj->numChannels, 1, mxREAL);
+        
+        // Call the method
+        int numSweeps = DAQgUSBampObj->GetImpedances(mxGetPr(plhs[0]));
+        
+        plhs[1] = mxCreateDoubleScalar((double) numSweeps);
+        return;
+    }
+    
+    // EnableSignalQuality: enables per channel signal quality metrics over windows of windowSec, computed on a
+    // dispatch thread and logged next to the recording. A window of 0 disables them
+    // Usage:
+    //      DAQgUSBampMex('EnableSignalQuality', self.objectHandle, double(windowSec), double(lineFrequency), double(saturationUv), double(flatlineUv));
+    if (!strcmp("EnableSignalQuality", cmd)) 
+    {
+        // Check parameters
+        if (nlhs != 0 || nrhs != 6)
+            mexErrMsgTxt("EnableSignalQuality: Unexpected arguments.");
+        
+        double windowSec = mxGetScalar(prhs[2]);
+        
+        // Call the method
+        if (windowSec <= 0)
+            DAQgUSBampObj->DisableSignalQuality();
+        else if (!DAQgUSBampObj->EnableSignalQuality(windowSec, mxGetScalar(prhs[3]), mxGetScalar(prhs[4]), mxGetScalar(prhs[5])))
+            mexErrMsgTxt("EnableSignalQuality: Invalid window, line frequency or levels.");
+        return;
+    }
+    
+    // GetSignalQuality: returns the quality of each channel in the last window [numChannels x 8]: mean, RMS, line
+    // power, peak to peak, saturated fraction, drift, flatline and saturated flags, and the number of windows since
+    // acquisition started (-1 if disabled)
+    // Usage:
+    //      [quality, numWindows] = DAQgUSBampMex('GetSignalQuality', self.objectHandle);
+    if (!strcmp("GetSignalQuality", cmd)) 
+    {
+        // Check parameters
+        if (nlhs != 2 || nrhs != 2)
+            mexErrMsgTxt("GetSignalQuality: Unexpected arguments.");
+        
+        int numChannels = DAQgUSBampObj->numChannels;
+        std::vector<ChannelQuality> quality(numChannels);
+        
+        // Call the method
+        int numWindows = DAQgUSBampObj->GetSignalQuality(numChannels > 0 ? &quality[0] : NULL);
+        
+        plhs[0] = mxCreateDoubleMatrix(numChannels, 8, mxREAL);
+        double * qualityMatrix = mxGetPr(plhs[0]);
+        for (int i = 0; i < numChannels && numWindows >= 0; i++)
+        {
+            qualityMatrix[i] = quality[i].meanUv;
+            qualityMatrix[i + numChannels] = quality[i].rmsUv;
+            qualityMatrix[i + 2 * numChannels] = quality[i].linePowerUv2;
+            qualityMatrix[i + 3 * numChannels] = quality[i].peakToPeakUv;
+            qualityMatrix[i + 4 * numChannels] = quality[i].saturatedFraction;
+            qualityMatrix[i + 5 * numChannels] = quality[i].driftUvPerSec;
+            qualityMatrix[i + 6 * numChannels] = quality[i].flatline ? 1 : 0;
+            qualityMatrix[i + 7 * numChannels] = quality[i].saturated ? 1 : 0;
+        }
+        plhs[1] = mxCreateDoubleScalar((double) numWindows);
+        return;
+    }
+    
+    // EnableFeatures: enables online SSVEP feature extraction (band power and CCA) on all channels.
+    // An empty frequency vector disables it
+    // Usage:
+    //      DAQgUSBampMex('EnableFeatures', self.objectHandle, double(freq), int32(numHarmonics), double(windowSec), double(hopSec));
+    if (!strcmp("EnableFeatures", cmd)) 
+    {
+        // Check parameters
+        if (nlhs != 0 || nrhs != 6)
+            mexErrMsgTxt("EnableFeatures: Unexpected arguments.");
+        
+        double * tmpFreqArray = (double *) mxGetData(prhs[2]);
+        std::vector<double> stimFrequencies(tmpFreqArray, tmpFreqArray + mxGetNumberOfElements(prhs[2]));
+        int numHarmonics = mxGetScalar(prhs[3]);
+        double windowSec = mxGetScalar(prhs[4]);
+        double hopSec = mxGetScalar(prhs[5]);
+        
+        // Call the method
+        if (stimFrequencies.empty())
+            DAQgUSBampObj->DisableFeatureEngine();
+        else if (!DAQgUSBampObj->EnableFeatureEngine(stimFrequencies, numHarmonics, windowSec, hopSec))
+            mexErrMsgTxt("EnableFeatures: Could not enable feature engine.");
+        return;
+    }
+    
+    // GetFeatures: returns latest per class band power and canonical correlation [numClasses x 1]
+    // and the number of updates since acquisition started (-1 if disabled)
+    // Usage:
+    //      [bandPower, cca, updateCount] = DAQgUSBampMex('GetFeatures', self.objectHandle);
+    if (!strcmp("GetFeatures", cmd)) 
+    {
+        // Check parameters
+        if (nlhs != 3 || nrhs != 2)
+            mexErrMsgTxt("GetFeatures: Unexpected arguments.");
+        
+        int numClasses = DAQgUSBampObj->NumFeatureClasses();
+        plhs[0] = mxCreateDoubleMatrix(numClasses, 1, mxREAL);
+        plhs[1] = mxCreateDoubleMatrix(numClasses, 1, mxREAL);
+        
+        // Call the method
+        int updateCount = DAQgUSBampObj->GetFeatureScores(mxGetPr(plhs[0]), mxGetPr(plhs[1]));
+        
+        plhs[2] = mxCreateDoubleScalar((double) updateCount);
+        return;
+    }
+    
+    // EnableEarlyStop: enables incremental classification of block trials. Posteriors are updated on every block
+    // and a decision is signaled when the largest one crosses the threshold. An empty frequency vector disables it
+    // Usage:
+    //      DAQgUSBampMex('EnableEarlyStop', self.objectHandle, double(freq), int32(numHarmonics), double(prior), ...
+    //                    double(threshold), double(minTrialSec), double(evidenceGain));
+    if (!strcmp("EnableEarlyStop", cmd)) 
+    {
+        // Check parameters
+        if (nlhs != 0 || nrhs != 8)
+            mexErrMsgTxt("EnableEarlyStop: Unexpected arguments.");
+        
+        double * tmpFreqArray = (double *) mxGetData(prhs[2]);
+        std::vector<double> stimFrequencies(tmpFreqArray, tmpFreqArray + mxGetNumberOfElements(prhs[2]));
+        int numHarmonics = mxGetScalar(prhs[3]);
+        double * tmpPriorArray = (double *) mxGetData(prhs[4]);
+        std::vector<double> prior(tmpPriorArray, tmpPriorArray + mxGetNumberOfElements(prhs[4]));
+        double threshold = mxGetScalar(prhs[5]);
+        double minTrialSec = mxGetScalar(prhs[6]);
+        double evidenceGain = mxGetScalar(prhs[7]);
+        
+        // Call the method
+        if (stimFrequencies.empty())
+            DAQgUSBampObj->DisableTrialClassifier();
+        else if (!DAQgUSBampObj->EnableTrialClassifier(stimFrequencies, numHarmonics, prior, threshold, minTrialSec, evidenceGain))
+            mexErrMsgTxt("EnableEarlyStop: Could not enable trial classifier.");
+        return;
+    }
+    
+    // GetPosterior: returns posteriors [numClasses x 1] of the current (or last) trial, the trial state
+    // (-1 disabled, 0 idle, 1 running, 2 decided, 3 ended) and the number of samples used
+    // Usage:
+    //      [aPosteriori, state, numSamples] = DAQgUSBampMex('GetPosterior', self.objectHandle);
+    if (!strcmp("GetPosterior", cmd)) 
+    {
+        // Check parameters
+        if (nlhs != 3 || nrhs != 2)
+            mexErrMsgTxt("GetPosterior: Unexpected arguments.");
+        
+        int classIndex = -1;
+        int numTrialSamples = 0;
+        plhs[0] = mxCreateDoubleMatrix(DAQgUSBampObj->NumTrialClasses(), 1, mxREAL);
+        
+        // Call the method
+        int state = DAQgUSBampObj->GetTrialPosterior(mxGetPr(plhs[0]), &classIndex, &numTrialSamples);
+        
+        plhs[1] = mxCreateDoubleScalar((double) state);
+        plhs[2] = mxCreateDoubleScalar((double) numTrialSamples);
+        return;
+    }
+    
+    // WaitForSamples: blocks until numSamples samples are available or the timeout expires (negative for no timeout)
+    // Usage:
+    //      availableFlag = DAQgUSBampMex('WaitForSamples', self.objectHandle, int32(numSamples), double(timeoutSec));
+    if (!strcmp("WaitForSamples", cmd)) 
+    {
+        // Check parameters
+        if (nlhs != 1 || nrhs != 4)
+            mexErrMsgTxt("WaitForSamples: Unexpected arguments.");
+        
+        int numSamples = (int) mxGetScalar(prhs[2]);
+        int timeoutMs = (int) (1000 * mxGetScalar(prhs[3]));
+        
+        // Call the method
+        plhs[0] = mxCreateLogicalScalar(DAQgUSBampObj->WaitForSamples(numSamples, timeoutMs));
+        return;
+    }
+    
+    // WaitForTrigger: blocks until the trigger changes to triggerValue (-1 for any non-zero value) or the timeout
+    // expires. Returns the position of that sample from the next one GetData returns (0 based), -1 on timeout
+    // Usage:
+    //      position = DAQgUSBampMex('WaitForTrigger', self.objectHandle, int32(triggerValue), double(timeoutSec));
+    if (!strcmp("WaitForTrigger", cmd)) 
+    {
+        // Check parameters
+        if (nlhs != 1 || nrhs != 4)
+            mexErrMsgTxt("WaitForTrigger: Unexpected arguments.");
+        
+        int triggerValue = (int) mxGetScalar(prhs[2]);
+        int timeoutMs = (int) (1000 * mxGetScalar(prhs[3]));
+        
+        // Call the method
+        plhs[0] = mxCreateDoubleScalar((double) DAQgUSBampObj->WaitForTrigger(triggerValue, timeoutMs));
+        return;
+    }
+    
+    // WaitForDecision: blocks until the current trial is decided (or ends) or the timeout expires
+    // Usage:
+    //      [aPosteriori, decidedFlag, numSamples] = DAQgUSBampMex('WaitForDecision', self.objectHandle, double(timeoutSec));
+    if (!strcmp("WaitForDecision", cmd)) 
+    {
+        // Check parameters
+        if (nlhs != 3 || nrhs != 3)
+            mexErrMsgTxt("WaitForDecision: Unexpected arguments.");
+        
+        int timeoutMs = (int) (1000 * mxGetScalar(prhs[2]));
+        int classIndex = -1;
+        int numTrialSamples = 0;
+        plhs[0] = mxCreateDoubleMatrix(DAQgUSBampObj->NumTrialClasses(), 1, mxREAL);
+        
+        // Call the method
+        bool decided = DAQgUSBampObj->WaitForTrialDecision(timeoutMs, mxGetPr(plhs[0]), &classIndex, &numTrialSamples);
+        
+        plhs[1] = mxCreateDoubleScalar((double) decided);
+        plhs[2] = mxCreateDoubleScalar((double) numTrialSamples);
+        return;
+    }
+    
+    // EnableEOGDetector: enables EOG artifact detection on the derivations plus - minus (1 based channels of GetData,
+    // 0 for a single channel derivation). An empty plus vector disables it
+    // Usage:
+    //      DAQgUSBampMex('EnableEOGDetector', self.objectHandle, int32(plus), int32(minus), double([thresholdUv slopeUvPerSec templateCorrelation marginSec]));
+    if (!strcmp("EnableEOGDetector", cmd)) 
+    {
+        // Check parameters
+        if (nlhs != 0 || nrhs != 5 || mxGetClassID(prhs[2]) != mxINT32_CLASS || mxGetClassID(prhs[3]) != mxINT32_CLASS || mxGetNumberOfElements(prhs[4]) != 4)
+            mexErrMsgTxt("EnableEOGDetector: Unexpected arguments.");
+        
+        std::vector<int> plusChannels, minusChannels;
+        int * tmpPlusArray = (int *) mxGetData(prhs[2]);
+        int * tmpMinusArray = (int *) mxGetData(prhs[3]);
+        for (size_t i = 0; i < mxGetNumberOfElements(prhs[2]); i++)
+            plusChannels.push_back(tmpPlusArray[i] - 1);
+        for (size_t i = 0; i < mxGetNumberOfElements(prhs[3]); i++)
+            minusChannels.push_back(tmpMinusArray[i] - 1);
+        double * limits = (double *) mxGetData(prhs[4]);
+        
+        // Call the method
+        if (plusChannels.empty())
+            DAQgUSBampObj->DisableEOGDetector();
+        else if (!DAQgUSBampObj->EnableEOGDetector(plusChannels, minusChannels, limits[0], limits[1], limits[2], limits[3]))
+            mexErrMsgTxt("EnableEOGDetector: Invalid derivations, threshold, slope, correlation or margin.");
+        return;
+    }
+    
+    // GetEOGArtifacts: returns the artifact spans [numSpans x 4]: first and last sample (1 based, counted since
+    // acquisition started), peak deviation in uV and flagging criteria (1 threshold, 2 slope, 4 template), and the
+    // ended trials [numTrials x 3]: first sample, length and number of contaminated samples. Empty if disabled
+    // Usage:
+    //      [spans, trials] = DAQgUSBampMex('GetEOGArtifacts', self.objectHandle);
+    if (!strcmp("GetEOGArtifacts", cmd)) 
+    {
+        // Check parameters
+        if (nlhs != 2 || nrhs != 2)
+            mexErrMsgTxt("GetEOGArtifacts: Unexpected arguments.");
+        
+        std::vector<ArtifactSpan> spans;
+        std::vector<TrialArtifacts> trials;
+        
+        // Call the method
+        DAQgUSBampObj->GetEOGArtifacts(spans, trials);
+        
+        size_t numSpans = spans.size();
+        plhs[0] = mxCreateDoubleMatrix(numSpans, 4, mxREAL);
+        double * spanMatrix = mxGetPr(plhs[0]);
+        for (size_t i = 0; i < numSpans; i++)
+        {
+            spanMatrix[i] = (double) spans[i].startScan + 1;
+            spanMatrix[i + numSpans] = (double) spans[i].endScan;
+            spanMatrix[i + 2 * numSpans] = spans[i].peakUv;
+            spanMatrix[i + 3 * numSpans] = spans[i].causes;
+        }
+        
+        size_t numTrials = trials.size();
+        plhs[1] = mxCreateDoubleMatrix(numTrials, 3, mxREAL);
+        double * trialMatrix = mxGetPr(plhs[1]);
+        for (size_t i = 0; i < numTrials; i++)
+        {
+            trialMatrix[i] = (double) trials[i].startScan + 1;
+            trialMatrix[i + numTrials] = trials[i].length;
+            trialMatrix[i + 2 * numTrials] = trials[i].artifactScans;
+        }
+        return;
+    }
+    
+    // WaitForTrialArtifacts: blocks until a block trial ends or the timeout expires, and returns its flags
+    // [first sample, length, contaminated samples] (empty on timeout or if disabled)
+    // Usage:
+    //      trial = DAQgUSBampMex('WaitForTrialArtifacts', self.objectHandle, double(timeoutSec));
+    if (!strcmp("WaitForTrialArtifacts", cmd)) 
+    {
+        // Check parameters
+        if (nlhs != 1 || nrhs != 3)
+            mexErrMsgTxt("WaitForTrialArtifacts: Unexpected arguments.");
+        
+        int timeoutMs = (int) (1000 * mxGetScalar(prhs[2]));
+        TrialArtifacts trial;
+        
+        // Call the method
+        if (DAQgUSBampObj->WaitForTrialArtifacts(timeoutMs, &trial))
+        {
+            plhs[0] = mxCreateDoubleMatrix(1, 3, mxREAL);
+            mxGetPr(plhs[0])[0] = (double) trial.startScan + 1;
+            mxGetPr(plhs[0])[1] = trial.length;
+            mxGetPr(plhs[0])[2] = trial.artifactScans;
+        }
+        else
+            plhs[0] = mxCreateDoubleMatrix(0, 3, mxREAL);
+        return;
+    }
+    
+    // EnableEnvelope: keeps the min/max envelope of every channel and the trigger over the last historySec at several
+    // resolutions, for live display, and writes it next to the recording. A history of 0 disables it
+    // Usage:
+    //      DAQgUSBampMex('EnableEnvelope', self.objectHandle, double(historySec));
+    if (!strcmp("EnableEnvelope", cmd)) 
+    {
+        // Check parameters
+        if (nlhs != 0 || nrhs != 3)
+            mexErrMsgTxt("EnableEnvelope: Unexpected arguments.");
+        
+        double historySec = mxGetScalar(prhs[2]);
+        
+        // Call the method
+        if (historySec <= 0)
+            DAQgUSBampObj->DisableEnvelope();
+        else if (!DAQgUSBampObj->EnableEnvelope(historySec))
+            mexErrMsgTxt("EnableEnvelope: Invalid history.");
+        return;
+    }
+    
+    // GetEnvelope: returns the min/max envelope of the channels (1 based positions in GetData, numChannels + 1 being
+    // the trigger) when durationSec from startSec (since acquisition started, negative for the last durationSec) are
+    // drawn on width pixels [width x numSelected], NaN where nothing was acquired, the level used and the number of
+    // samples in the envelope. The outputs are in float32 type
+    // Usage:
+    //      [minimum, maximum, level, numSamples] = DAQgUSBampMex('GetEnvelope', self.objectHandle, int32(channels), double(startSec), double(durationSec), int32(width));
+    if (!strcmp("GetEnvelope", cmd)) 
+    {
+        // Check parameters
+        if (nlhs != 4 || nrhs != 6 || mxGetClassID(prhs[2]) != mxINT32_CLASS)
+            mexErrMsgTxt("GetEnvelope: Unexpected arguments.");
+        
+        std::vector<int> values;
+        int numSelected = mxGetNumberOfElements(prhs[2]);
+        for (int i = 0; i < numSelected; i++)
+            values.push_back(((int *) mxGetData(prhs[2]))[i] - 1);
+        
+        long long numEnvelopeScans = DAQgUSBampObj->EnvelopeScans();
+        long long numScans = (long long) floor(mxGetScalar(prhs[4]) * DAQgUSBampObj->SampleRate + 0.5);
+        long long startScan = (long long) floor(mxGetScalar(prhs[3]) * DAQgUSBampObj->SampleRate + 0.5);
+        if (mxGetScalar(prhs[3]) < 0)
+            startScan = numEnvelopeScans - numScans;
+        int width = mxGetScalar(prhs[5]);
+        
+        // Value-major rows are the columns of a MATLAB matrix
+        plhs[0] = mxCreateNumericMatrix(width > 0 ? width : 0, numSelected, mxSINGLE_CLASS, mxREAL);
+        plhs[1] = mxCreateNumericMatrix(width > 0 ? width : 0, numSelected, mxSINGLE_CLASS, mxREAL);
+        
+        // Call the method
+        int level = DAQgUSBampObj->GetEnvelope(values, startScan, numScans, width, (float *) mxGetData(plhs[0]), (float *) mxGetData(plhs[1]));
+        if (level < 0)
+            mexErrMsgTxt("GetEnvelope: Envelope disabled, invalid channels, duration or width.");
+        
+        plhs[2] = mxCreateDoubleScalar((double) level);
+        plhs[3] = mxCreateDoubleScalar((double) numEnvelopeScans);
+        return;
+    }
+    
+    // UseReplayDevice: replaces the amplifiers by the replay of a recording at speed times real time (0 as fast as
+    // possible), looped if loopFlag is set. Must be called before OpenDevice
+    // Usage:
+    //      DAQgUSBampMex('UseReplayDevice', self.objectHandle, fileName, double(speed), int32(loopFlag));
+    if (!strcmp("UseReplayDevice", cmd)) 
+    {
+        // Check parameters
+        char fileName[1024];
+        if (nlhs != 0 || nrhs != 5 || mxGetString(prhs[2], fileName, sizeof(fileName)))
+            mexErrMsgTxt("UseReplayDevice: Unexpected arguments.");
+        
+        // Call the method
+        if (!DAQgUSBampObj->UseReplayDevice(fileName, mxGetScalar(prhs[3]), mxGetScalar(prhs[4]) != 0))
+            mexErrMsgTxt("UseReplayDevice: Could not replay the recording.");
+        return;
+    }
+    
+    // ReplayFinished: returns true once the replayed recording has ended
+    // Usage:
+    //      finishedFlag = DAQgUSBampMex('ReplayFinished', self.objectHandle);
+    if (!strcmp("ReplayFinished", cmd)) 
+    {
+        // Check parameters
+        if (nlhs != 1 || nrhs != 2)
+            mexErrMsgTxt("ReplayFinished: Unexpected arguments.");
+        
+        // Call the method
+        plhs[0] = mxCreateDoubleScalar((double) DAQgUSBampObj->ReplayFinished());
+        return;
+    }
+    
+    // UseSimulatedDevice: replaces the amplifiers by simulated ones whose completions are delayed by up to jitterMs
+    // and, with probability stallProbability, stalled by up to maxStallMs. Their digital outputs reach the trigger
+    // channel loopbackDelayMs (0 if omitted) after SendTrigger. Must be called before OpenDevice
+    // Usage:
+    //      DAQgUSBampMex('UseSimulatedDevice', self.objectHandle, int32(numDevices), double([jitterMs stallProbability maxStallMs loopbackDelayMs]));
+    if (!strcmp("UseSimulatedDevice", cmd)) 
+    {
+        // Check parameters
+        if (nlhs != 0 || nrhs != 4 || mxGetNumberOfElements(prhs[3]) < 3 || mxGetNumberOfElements(prhs[3]) > 4)
+            mexErrMsgTxt("UseSimulatedDevice: Unexpected arguments.");
+        
+        int numDevices = mxGetScalar(prhs[2]);
+        double * jitter = (double *) mxGetData(prhs[3]);
+        double loopbackDelayMs = (mxGetNumberOfElements(prhs[3]) == 4) ? jitter[3] : 0;
+        
+        // Call the method
+        if (!DAQgUSBampObj->UseSimulatedDevice(numDevices, jitter[0], jitter[1], jitter[2], loopbackDelayMs))
+            mexErrMsgTxt("UseSimulatedDevice: Could not use simulated devices.");
+        return;
+    }
+    
+    // SetQueueDepth: sets the number of transfers queued per device (0 keeps the one of the block policy),
+    // deepened up to maxDepth while completion latencies rise if adaptiveFlag is set. Must be called before StartAcquisition
+    // Usage:
+    //      DAQgUSBampMex('SetQueueDepth', self.objectHandle, int32(depth), int32(maxDepth), int32(adaptiveFlag));
+    if (!strcmp("SetQueueDepth", cmd)) 
+    {
+        // Check parameters
+        if (nlhs != 0 || nrhs != 5)
+            mexErrMsgTxt("SetQueueDepth: Unexpected arguments.");
+        
+        int depth = mxGetScalar(prhs[2]);
+        int maxDepth = mxGetScalar(prhs[3]);
+        bool adaptive = mxGetScalar(prhs[4]) != 0;
+        
+        // Call the method
+        if (!DAQgUSBampObj->SetQueueDepth(depth, maxDepth, adaptive))
+            mexErrMsgTxt("SetQueueDepth: Invalid queue depth.");
+        return;
+    }
+    
+    // GetTransferStats: returns the queue depth of each device [numDevices x 1], the completion latency
+    // percentiles 50, 95 and 99 in ms [3 x numDevices], the scans lost by the devices (-1 if unknown)
+    // and the number of blocks acquired
+    // Usage:
+    //      [queueDepth, latencyMs, lostScans, numBlocks] = DAQgUSBampMex('GetTransferStats', self.objectHandle);
+    if (!strcmp("GetTransferStats", cmd)) 
+    {
+        // Check parameters
+        if (nlhs != 4 || nrhs != 2)
+            mexErrMsgTxt("GetTransferStats: Unexpected arguments.");
+        
+        int numDevices = DAQgUSBampObj->NumDevices();
+        std::vector<int> queueDepth(numDevices);
+        long long numBlocks = 0;
+        plhs[1] = mxCreateDoubleMatrix(3, numDevices, mxREAL);
+        
+        // Call the method
+        long long lostScans = DAQgUSBampObj->GetTransferStats(&queueDepth[0], mxGetPr(plhs[1]), &numBlocks);
+        
+        plhs[0] = mxCreateDoubleMatrix(numDevices, 1, mxREAL);
+        for (int i = 0; i < numDevices; i++)
+            mxGetPr(plhs[0])[i] = queueDepth[i];
+        plhs[2] = mxCreateDoubleScalar((double) lostScans);
+        plhs[3] = mxCreateDoubleScalar((double) numBlocks);
+        return;
+    }
+
+    // SetSchedulingPolicy: pins the acquisition thread to a core (-1 for any), the dispatch threads to cores (empty
+    // for any) and the thread writing the recording to a core (-1 for any, optional), sets real-time priority and
+    // locks the buffers in RAM. Must be called before StartAcquisition
+    // Usage:
+    //      DAQgUSBampMex('SetSchedulingPolicy', self.objectHandle, int32(acquisitionCpu), int32(dispatchCpus), int32(realTimeFlag), int32(lockMemoryFlag), int32(writerCpu));
+    if (!strcmp("SetSchedulingPolicy", cmd))
+    {
+        // Check parameters
+        if (nlhs != 0 || (nrhs != 6 && nrhs != 7))
+            mexErrMsgTxt("SetSchedulingPolicy: Unexpected arguments.");
+
+        SchedulingPolicy policy;
+        policy.acquisitionCpu = mxGetScalar(prhs[2]);
+        int numDispatchCpus = mxGetNumberOfElements(prhs[3]);
+        for (int i = 0; i < numDispatchCpus; i++)
+            policy.dispatchCpus.push_back(((int *) mxGetData(prhs[3]))[i]);
+        policy.realTime = mxGetScalar(prhs[4]) != 0;
+        policy.lockMemory = mxGetScalar(prhs[5]) != 0;
+        if (nrhs == 7)
+            policy.writerCpu = mxGetScalar(prhs[6]);
+
+        // Call the method
+        if (!DAQgUSBampObj->SetSchedulingPolicy(policy))
+            mexErrMsgTxt("SetSchedulingPolicy: Invalid core or acquisition running.");
+        return;
+    }
+
+    // GetSchedulingStats: returns the page faults of the process and the context switches of the acquisition
+    // thread since acquisition started (-1 if unknown, before the first start)
+    // Usage:
+    //      [pageFaults, contextSwitches] = DAQgUSBampMex('GetSchedulingStats', self.objectHandle);
+    if (!strcmp("GetSchedulingStats", cmd))
+    {
+        // Check parameters
+        if (nlhs != 2 || nrhs != 2)
+            mexErrMsgTxt("GetSchedulingStats: Unexpected arguments.");
+
+        long long pageFaults = -1, contextSwitches = -1;
+
+        // Call the method
+        DAQgUSBampObj->GetSchedulingStats(&pageFaults, &contextSwitches);
+
+        plhs[0] = mxCreateDoubleScalar((double) pageFaults);
+        plhs[1] = mxCreateDoubleScalar((double) contextSwitches);
+        return;
+    }
+
+    // UseSharedEngine: acquires on the I/O threads of the process wide engine (created with numIoThreads threads
+    // by its first user), shared with the other objects using it; 0 acquires on a thread of its own. Must be called
+    // before StartAcquisition
+    // Usage:
+    //      DAQgUSBampMex('UseSharedEngine', self.objectHandle, int32(numIoThreads));
+    if (!strcmp("UseSharedEngine", cmd))
+    {
+        // Check parameters
+        if (nlhs != 0 || nrhs != 3)
+            mexErrMsgTxt("UseSharedEngine: Unexpected arguments.");
+
+        // Call the method
+        if (!DAQgUSBampObj->UseSharedEngine(mxGetScalar(prhs[2])))
+            mexErrMsgTxt("UseSharedEngine: Invalid number of threads or acquisition running.");
+        return;
+    }
+
+    // EngineThread: returns the I/O thread of the shared engine acquiring this object, -1 if none
+    // Usage:
+    //      engineThread = DAQgUSBampMex('EngineThread', self.objectHandle);
+    if (!strcmp("EngineThread", cmd))
+    {
+        // Check parameters
+        if (nlhs != 1 || nrhs != 2)
+            mexErrMsgTxt("EngineThread: Unexpected arguments.");
+
+        // Call the method
+        plhs[0] = mxCreateDoubleScalar(DAQgUSBampObj->EngineThread());
+        return;
+    }
+
+    // SetSampleStorage: stores the application buffer as float32 (0), half precision (1) or int16 (2) with gains in uV
+    // per step (one per channel, empty for 0.1 uV). GetData still returns doubles, recordings stay float32. Must be
+    // called before StartAcquisition
+    // Usage:
+    //      DAQgUSBampMex('SetSampleStorage', self.objectHandle, int32(storage), double(gains));
+    if (!strcmp("SetSampleStorage", cmd))
+    {
+        // Check parameters
+        if (nlhs != 0 || nrhs != 4)
+            mexErrMsgTxt("SetSampleStorage: Unexpected arguments.");
+
+        std::vector<float> gains;
+        int numGains = mxGetNumberOfElements(prhs[3]);
+        for (int i = 0; i < numGains; i++)
+            gains.push_back((float) mxGetPr(prhs[3])[i]);
+
+        // Call the method
+        if (!DAQgUSBampObj->SetSampleStorage((SampleStorage) (int) mxGetScalar(prhs[2]), gains))
+            mexErrMsgTxt("SetSampleStorage: Invalid storage or gains, or acquisition running.");
+        return;
+    }
+
+    // SetDurabilityPolicy: sets when recordings are synced to disk and committed: never (0), every syncSec seconds (1)
+    // or every chunk (2), chunks being written every chunkSec seconds. A crash loses only the samples not committed.
+    // Must be called before StartAcquisition
+    // Usage:
+    //      DAQgUSBampMex('SetDurabilityPolicy', self.objectHandle, int32(mode), double(syncSec), double(chunkSec));
+    if (!strcmp("SetDurabilityPolicy", cmd))
+    {
+        // Check parameters
+        if (nlhs != 0 || nrhs != 5)
+            mexErrMsgTxt("SetDurabilityPolicy: Unexpected arguments.");
+
+        DurabilityPolicy policy((DurabilityMode) (int) mxGetScalar(prhs[2]), mxGetScalar(prhs[3]));
+        policy.chunkSeconds = mxGetScalar(prhs[4]);
+
+        // Call the method
+        if (!DAQgUSBampObj->SetDurabilityPolicy(policy))
+            mexErrMsgTxt("SetDurabilityPolicy: Invalid mode or times, or acquisition running.");
+        return;
+    }
+
+    // GetRecorderStats: returns the cost of the recording in progress (or of the last one) [1 x 10]: MB written, MB
+    // committed, chunks written, extents reserved, syncs, mean and max write ms, mean and max sync ms, most chunks queued
+    // Usage:
+    //      stats = DAQgUSBampMex('GetRecorderStats', self.objectHandle);
+    if (!strcmp("GetRecorderStats", cmd))
+    {
+        // Check parameters
+        if (nlhs != 1 || nrhs != 2)
+            mexErrMsgTxt("GetRecorderStats: Unexpected arguments.");
+
+        RecorderStats stats;
+
+        // Call the method
+        DAQgUSBampObj->GetRecorderStats(&stats);
+
+        plhs[0] = mxCreateDoubleMatrix(1, 10, mxREAL);
+        double * statsRow = mxGetPr(plhs[0]);
+        statsRow[0] = stats.writtenBytes / 1048576.0;
+        statsRow[1] = stats.committedBytes / 1048576.0;
+        statsRow[2] = (double) stats.numChunks;
+        statsRow[3] = (double) stats.numExtents;
+        statsRow[4] = (double) stats.numSyncs;
+        statsRow[5] = stats.meanWriteMs;
+        statsRow[6] = stats.maxWriteMs;
+        statsRow[7] = stats.meanSyncMs;
+        statsRow[8] = stats.maxSyncMs;
+        statsRow[9] = stats.maxQueuedChunks;
+        return;
+    }
+
+    // ClippedValues: returns the values clipped to the range of the compact storage since acquisition started
+    // Usage:
+    //      clippedValues = DAQgUSBampMex('ClippedValues', self.objectHandle);
+    if (!strcmp("ClippedValues", cmd))
+    {
+        // Check parameters
+        if (nlhs != 1 || nrhs != 2)
+            mexErrMsgTxt("ClippedValues: Unexpected arguments.");
+
+        // Call the method
+        plhs[0] = mxCreateDoubleScalar((double) DAQgUSBampObj->ClippedValues());
+        return;
+    }
+
     // StopAcquisition: stops acquisition and closes file if applicable 
     // Usage: 
     //      DAQgUSBampMex('StopAcquisition', self.objectHandle);
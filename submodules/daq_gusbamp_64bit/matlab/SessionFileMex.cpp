@@ -0,0 +1,262 @@
+// This mex function loads parts of a daq file (.bin) written by DAQgUSBamp without reading the whole file.
+// The file is memory mapped by SessionFile, and only the requested channels and trials are copied, straight into
+// the output arrays, and long sessions are browsed from the envelope file written next to them. Unlike DAQgUSBampMex it keeps no state between calls, so no class handle is needed.
+//
+// Channels are positions in the file (1 based, as in the channelList output); numChannels + 1 is the trigger.
+// An empty channel vector loads every channel but the trigger. Values are scaled to volts as in loadSessionDataBin.
+
+#include <string>
+#include <vector>
+#include <string.h>
+#include <math.h>
+#include "mex.h"
+#include "SessionFile.h"
+#include "SessionRecorder.h"
+#include "EOGArtifactDetector.h"
+#include "EnvelopeFile.h"
+
+using namespace std;
+
+// Converts the 1 based channel vector from matlab, empty meaning every channel
+static std::vector<int> GetChannels(const mxArray *array, const SessionFile &session)
+{
+    std::vector<int> channels;
+    int * tmpChannelArray = (int *) mxGetData(array);
+    for (size_t i = 0; i < mxGetNumberOfElements(array); i++)
+        channels.push_back(tmpChannelArray[i] - 1);
+
+    if (channels.empty())
+        for (int c = 0; c < session.NumChannels(); c++)
+            channels.push_back(c);
+
+    return channels;
+}
+
+void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+{
+    // Get the command string and file name
+    char cmd[64];
+    char fileName[1024];
+    if (nrhs < 2 || mxGetString(prhs[0], cmd, sizeof(cmd)) || mxGetString(prhs[1], fileName, sizeof(fileName)))
+        mexErrMsgTxt("SessionFileMex: First input should be a command string and second input a file name.");
+
+    // Recover: truncates a recording left by a crash to the samples committed before it (before it is opened)
+    // Usage:
+    //      fileBytes = SessionFileMex('recover', fileName);
+    if (!strcmp("recover", cmd))
+    {
+        if (nrhs != 2 || nlhs > 1)
+            mexErrMsgTxt("SessionFileMex recover: Unexpected arguments.");
+
+        long long fileBytes = SessionRecorder::Recover(fileName);
+        if (fileBytes < 0)
+            mexErrMsgTxt("SessionFileMex recover: Could not open or truncate the file.");
+        plhs[0] = mxCreateDoubleScalar((double) fileBytes);
+        return;
+    }
+
+    SessionFile session;
+    if (!session.Open(fileName))
+        mexErrMsgTxt("SessionFileMex: Could not open file.");
+
+    // Trials: block trials cut at the trigger, all with the length of the shortest one kept
+    // Usage:
+    //      [trials, trialStarts, trialLengths, fs, channelList] = SessionFileMex('trials', fileName, int32(channels), double(minToMaxTrial));
+    //
+    //      trials          - [numChannels x trialLength x numTrials]
+    //      trialStarts     - [numTrials x 1] first sample of each trial (1 based)
+    //      trialLengths    - [numTrials x 1] length of each trial in samples before trimming
+    if (!strcmp("trials", cmd))
+    {
+        if (nrhs != 4 || nlhs > 5 || mxGetClassID(prhs[2]) != mxINT32_CLASS)
+            mexErrMsgTxt("SessionFileMex trials: Unexpected arguments.");
+
+        std::vector<int> channels = GetChannels(prhs[2], session);
+        std::vector<long long> trialStarts;
+        std::vector<int> trialLengths;
+        int numTrials = session.FindTrials(trialStarts, trialLengths, mxGetScalar(prhs[3]));
+
+        int trialLength = numTrials ? trialLengths[0] : 0;
+        for (int i = 0; i < numTrials; i++)
+            trialLength = (trialLengths[i] < trialLength) ? trialLengths[i] : trialLength;
+
+        mwSize dims[3] = {channels.size(), (mwSize) trialLength, (mwSize) numTrials};
+        plhs[0] = mxCreateNumericArray(3, dims, mxDOUBLE_CLASS, mxREAL);
+        if (!session.ReadTrials(channels, trialStarts, trialLength, 1e-6, mxGetPr(plhs[0])))
+            mexErrMsgTxt("SessionFileMex trials: Channels out of range.");
+
+        if (nlhs > 1)
+        {
+            plhs[1] = mxCreateDoubleMatrix(numTrials, 1, mxREAL);
+            for (int i = 0; i < numTrials; i++)
+                mxGetPr(plhs[1])[i] = (double) trialStarts[i] + 1;
+        }
+        if (nlhs > 2)
+        {
+            plhs[2] = mxCreateDoubleMatrix(numTrials, 1, mxREAL);
+            for (int i = 0; i < numTrials; i++)
+                mxGetPr(plhs[2])[i] = trialLengths[i];
+        }
+    }
+    // EOG flags: the block trials of 'trials' with the number of samples flagged by EOGArtifactDetector on the
+    // derivations plus - minus (1 based channels, 0 for a single channel derivation)
+    // Usage:
+    //      [artifactSamples, trialStarts, trialLengths, fs, channelList] = SessionFileMex('eogflags', fileName, int32(plus), int32(minus), double(minToMaxTrial), double([thresholdUv slopeUvPerSec templateCorrelation marginSec]));
+    //
+    //      artifactSamples - [numTrials x 1] samples of each trial inside artifact spans
+    else if (!strcmp("eogflags", cmd))
+    {
+        if (nrhs != 6 || nlhs > 5 || mxGetClassID(prhs[2]) != mxINT32_CLASS || mxGetClassID(prhs[3]) != mxINT32_CLASS
+            || mxGetNumberOfElements(prhs[2]) != mxGetNumberOfElements(prhs[3]) || mxGetNumberOfElements(prhs[5]) != 4)
+            mexErrMsgTxt("SessionFileMex eogflags: Unexpected arguments.");
+        if (!session.TriggerFlag())
+            mexErrMsgTxt("SessionFileMex eogflags: File has no trigger channel.");
+
+        // read plus channels, minus channels and the trigger, so each derivation indexes this slice
+        int numDerivations = (int) mxGetNumberOfElements(prhs[2]);
+        int * tmpPlusArray = (int *) mxGetData(prhs[2]);
+        int * tmpMinusArray = (int *) mxGetData(prhs[3]);
+        std::vector<int> channels, plusIndices, minusIndices;
+        for (int i = 0; i < numDerivations; i++)
+        {
+            plusIndices.push_back((int) channels.size());
+            channels.push_back(tmpPlusArray[i] - 1);
+        }
+        for (int i = 0; i < numDerivations; i++)
+        {
+            minusIndices.push_back(tmpMinusArray[i] > 0 ? (int) channels.size() : -1);
+            if (tmpMinusArray[i] > 0)
+                channels.push_back(tmpMinusArray[i] - 1);
+        }
+        int triggerIndex = (int) channels.size();
+        channels.push_back(session.NumChannels());
+
+        double * limits = (double *) mxGetData(prhs[5]);
+        EOGArtifactDetector detector(session.SampleRate(), plusIndices, minusIndices, triggerIndex, limits[0], limits[1], limits[2],
+            (int) floor(limits[3] * session.SampleRate() + 0.5), std::vector<double>());
+
+        // stream the file through the detector one second at a time, keeping the finished spans
+        const int blockScans = session.SampleRate();
+        std::vector<float> block((size_t) blockScans * channels.size());
+        std::vector<ArtifactSpan> spans, openSpans;
+        std::vector<TrialArtifacts> streamedTrials;
+        for (long long scan = 0; scan < session.NumScans(); scan += blockScans)
+        {
+            int numScans = (int) ((session.NumScans() - scan < blockScans) ? session.NumScans() - scan : blockScans);
+            if (!session.ReadSlice(channels, scan, numScans, 1.0, &block[0]))
+                mexErrMsgTxt("SessionFileMex eogflags: Channels out of range.");
+            detector.PushBlock(&block[0], numScans, (int) channels.size());
+            detector.TakeFinishedSpans(spans);
+        }
+        detector.GetArtifacts(openSpans, streamedTrials);
+        spans.insert(spans.end(), openSpans.begin(), openSpans.end());
+
+        std::vector<long long> trialStarts;
+        std::vector<int> trialLengths, artifactScans;
+        int numTrials = session.FindTrials(trialStarts, trialLengths, mxGetScalar(prhs[4]));
+        EOGArtifactDetector::FlagTrials(spans, trialStarts, trialLengths, artifactScans);
+
+        plhs[0] = mxCreateDoubleMatrix(numTrials, 1, mxREAL);
+        for (int i = 0; i < numTrials; i++)
+            mxGetPr(plhs[0])[i] = artifactScans[i];
+        if (nlhs > 1)
+        {
+            plhs[1] = mxCreateDoubleMatrix(numTrials, 1, mxREAL);
+            for (int i = 0; i < numTrials; i++)
+                mxGetPr(plhs[1])[i] = (double) trialStarts[i] + 1;
+        }
+        if (nlhs > 2)
+        {
+            plhs[2] = mxCreateDoubleMatrix(numTrials, 1, mxREAL);
+            for (int i = 0; i < numTrials; i++)
+                mxGetPr(plhs[2])[i] = trialLengths[i];
+        }
+    }
+    // Slice: continuous data between two times
+    // Usage:
+    //      [data, trigger, fs, channelList] = SessionFileMex('slice', fileName, int32(channels), double(startSec), double(durationSec));
+    //
+    //      data            - [numChannels x numSamples]
+    //      trigger         - [1 x numSamples], empty if the file has no trigger
+    //      durationSec     - Inf reads until the end of the file
+    else if (!strcmp("slice", cmd))
+    {
+        if (nrhs != 5 || nlhs > 4 || mxGetClassID(prhs[2]) != mxINT32_CLASS)
+            mexErrMsgTxt("SessionFileMex slice: Unexpected arguments.");
+
+        std::vector<int> channels = GetChannels(prhs[2], session);
+        long long startScan = (long long) floor(mxGetScalar(prhs[3]) * session.SampleRate() + 0.5);
+        double durationSec = mxGetScalar(prhs[4]);
+        long long numScans = session.NumScans() - startScan;
+        if (!mxIsInf(durationSec))
+            numScans = (long long) floor(durationSec * session.SampleRate() + 0.5);
+
+        plhs[0] = mxCreateDoubleMatrix(channels.size(), (mwSize) (numScans > 0 ? numScans : 0), mxREAL);
+        if (!session.ReadSlice(channels, startScan, (int) numScans, 1e-6, mxGetPr(plhs[0])))
+            mexErrMsgTxt("SessionFileMex slice: Channels or times out of range.");
+
+        if (nlhs > 1)
+        {
+            std::vector<int> trigger(session.TriggerFlag(), session.NumChannels());
+            plhs[1] = mxCreateDoubleMatrix(session.TriggerFlag(), (mwSize) numScans, mxREAL);
+            session.ReadSlice(trigger, startScan, (int) numScans, 1.0, mxGetPr(plhs[1]));
+        }
+    }
+    // Envelope: min/max of each pixel when durationSec from startSec are drawn on width pixels, from the envelope file
+    // (<fileName>.envelope) when pixels are coarse enough and it exists, from the samples otherwise
+    // Usage:
+    //      [minimum, maximum, fs, channelList] = SessionFileMex('envelope', fileName, int32(channels), double(startSec), double(durationSec), int32(width));
+    //
+    //      minimum         - [numChannels x width], NaN where nothing was recorded
+    //      maximum         - [numChannels x width]
+    //      durationSec     - Inf draws until the end of the file
+    else if (!strcmp("envelope", cmd))
+    {
+        if (nrhs != 6 || nlhs > 4 || mxGetClassID(prhs[2]) != mxINT32_CLASS)
+            mexErrMsgTxt("SessionFileMex envelope: Unexpected arguments.");
+
+        std::vector<int> channels = GetChannels(prhs[2], session);
+        long long startScan = (long long) floor(mxGetScalar(prhs[3]) * session.SampleRate() + 0.5);
+        double durationSec = mxGetScalar(prhs[4]);
+        long long numScans = session.NumScans() - startScan;
+        if (!mxIsInf(durationSec))
+            numScans = (long long) floor(durationSec * session.SampleRate() + 0.5);
+        int width = (int) mxGetScalar(prhs[5]);
+
+        // without an envelope file (older recordings) every pixel is drawn from the samples
+        EnvelopeFile envelope;
+        envelope.Open((std::string(fileName) + ".envelope").c_str());
+
+        std::vector<float> minimum((size_t) channels.size() * (width > 0 ? width : 0)), maximum(minimum.size());
+        if (channels.empty() || envelope.GetEnvelope(session, &channels[0], (int) channels.size(), startScan, numScans, width,
+            &minimum[0], &maximum[0]) < 0)
+            mexErrMsgTxt("SessionFileMex envelope: Channels, times or width out of range.");
+
+        // one row of width per channel, in volts but for the trigger
+        size_t numSelected = channels.size();
+        for (int output = 0; output < 2 && output < (nlhs > 1 ? nlhs : 1); output++)
+        {
+            const std::vector<float> &envelopeValues = output ? maximum : minimum;
+            plhs[output] = mxCreateDoubleMatrix(numSelected, width, mxREAL);
+            for (size_t i = 0; i < numSelected; i++)
+            {
+                double scale = (channels[i] < session.NumChannels()) ? 1e-6 : 1.0;
+                for (int p = 0; p < width; p++)
+                    mxGetPr(plhs[output])[i + p * numSelected] = scale * envelopeValues[i * width + p];
+            }
+        }
+    }
+    else
+        mexErrMsgTxt("SessionFileMex: Command not recognized.");
+
+    // Outputs shared by every command
+    int fsIndex = (!strcmp("trials", cmd) || !strcmp("eogflags", cmd)) ? 3 : 2;
+    if (nlhs > fsIndex)
+        plhs[fsIndex] = mxCreateDoubleScalar(session.SampleRate());
+    if (nlhs > fsIndex + 1)
+    {
+        plhs[fsIndex + 1] = mxCreateDoubleMatrix(session.NumChannels(), 1, mxREAL);
+        for (int c = 0; c < session.NumChannels(); c++)
+            mxGetPr(plhs[fsIndex + 1])[c] = session.ChannelList()[c];
+    }
+}
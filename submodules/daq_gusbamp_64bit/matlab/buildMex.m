@@ -19,3 +19,25 @@ mex( '-IC:\Program Files\gtec\gUSBampCAPI\API\Win32',...
 	'-L..\lib',...
 	'-lDAQgUSBAmp', '-lgUSBamp',...
 	'DAQgUSBampMex.cpp');
+
+%% Execute code section to build the classifier trainer mex file (no gtec dependency)
+
+clear; clc
+
+mex('-I..\inc',...
+	'ClassifierTrainerMex.cpp',...
+	'..\src\ClassifierTrainer.cpp',...
+	'..\src\WorkStealingPool.cpp',...
+	'..\src\SSVEPFeatureEngine.cpp');
+
+%% Execute code section to build the session file loader mex file (no gtec dependency)
+
+clear; clc
+
+mex('-I..\inc',...
+	'SessionFileMex.cpp',...
+	'..\src\SessionFile.cpp',...
+	'..\src\SessionRecorder.cpp',...
+	'..\src\EOGArtifactDetector.cpp',...
+	'..\src\EnvelopePyramid.cpp',...
+	'..\src\EnvelopeFile.cpp');
@@ -0,0 +1,19 @@
+%% exportFrontEndFilter(fileName, fs)
+%  Writes the coefficients of the default front end filter (frontEndFilterBP)
+%  to a text file for tools/BatchReprocess (--filter option): numerator on
+%  the first line, denominator on the second.
+%
+%   Inputs:
+%            fileName       -  Output text file
+%            fs             -  Sample rate in Hz the filter is designed for
+
+function exportFrontEndFilter(fileName, fs)
+
+Hd = frontEndFilterBP(fs);
+
+fid = fopen(fileName, 'w');
+fprintf(fid, '%.17g ', Hd.Numerator);
+fprintf(fid, '\n1\n');
+fclose(fid);
+
+end
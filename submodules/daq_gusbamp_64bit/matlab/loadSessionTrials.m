@@ -0,0 +1,60 @@
+%% [trials, fs, channelList, trialStarts, trialLengths, artifactSamples] = loadSessionTrials(varargin)
+%  Loads block trials of a .bin file recorded by the CSL daq library with
+%  the native loader (SessionFileMex). The file is memory mapped and only
+%  the requested channels and trials are read, so long sessions load
+%  without reading the whole file. Trials are cut as in loadBlockTriggerData.
+%
+%   Inputs:
+%            'daqFileName'    -  Full path filename of .bin file with data
+%            'channels'       -  Positions of the channels to load (1 based),
+%                                all channels if empty
+%            'minToMaxTrial'  -  Trials shorter than this fraction of the
+%                                longest one are discarded
+%            'eogChannels'    -  [numDerivations x 2] EOG derivations as
+%                                [plus minus] channel positions (minus 0
+%                                for a single channel), e.g. [2 1; 3 0; 6 5;
+%                                3 7] as plotEOG.m. Trials are flagged by
+%                                the EOG detector of EnableEOGDetector if given
+%            'eogLimits'      -  [thresholdUv slopeUvPerSec
+%                                templateCorrelation marginSec] of the
+%                                EOG detector. [100 3000 0.9 0.1] by default
+%
+%   Outputs:
+%           trials          -   [nChannels x trialLength x nTrials] data in volts
+%           fs              -   The sampling frequency in Hz
+%           channelList     -   Channel list stored in the file
+%           trialStarts     -   First sample of each trial
+%           trialLengths    -   Length of each trial in samples (before trimming to the shortest one)
+%           artifactSamples -   Samples of each trial flagged as EOG artifacts
+%                               (empty without 'eogChannels')
+
+function [trials, fs, channelList, trialStarts, trialLengths, artifactSamples] = loadSessionTrials(varargin)
+
+% input parser
+p = inputParser;
+p.addParameter('daqFileName',[],@isstr);
+p.addParameter('channels',[],@isnumeric);
+p.addParameter('minToMaxTrial',0,@isscalar);
+p.addParameter('eogChannels',[],@isnumeric);
+p.addParameter('eogLimits',[100 3000 0.9 0.1],@isnumeric);
+p.parse(varargin{:});
+
+if ~exist(p.Results.daqFileName, 'file')
+    error(['File ' p.Results.daqFileName ' not found']);
+end
+
+[trials, trialStarts, trialLengths, fs, channelList] = SessionFileMex('trials', p.Results.daqFileName, ...
+    int32(p.Results.channels), double(p.Results.minToMaxTrial));
+
+fprintf('%g trials of length %g samples in %g channels were found\n', ...
+    size(trials,3), size(trials,2), size(trials,1));
+
+artifactSamples = [];
+if ~isempty(p.Results.eogChannels)
+    artifactSamples = SessionFileMex('eogflags', p.Results.daqFileName, ...
+        int32(p.Results.eogChannels(:,1)), int32(p.Results.eogChannels(:,2)), ...
+        double(p.Results.minToMaxTrial), double(p.Results.eogLimits));
+    fprintf('%g of them contaminated by EOG artifacts\n', sum(artifactSamples > 0));
+end
+
+end
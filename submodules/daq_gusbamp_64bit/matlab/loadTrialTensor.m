@@ -0,0 +1,44 @@
+%% [trials, fs, channelList, trialStarts] = loadTrialTensor(fileName)
+%  Loads a trial tensor file (.trials) written by tools/BatchReprocess.
+%
+%   Inputs:
+%            fileName       -  Full path filename of the .trials file
+%
+%   Outputs:
+%           trials          -   [nChannels x trialLength x nTrials] filtered data
+%                               (same units as the .bin file, not scaled to volts)
+%           fs              -   The sampling frequency in Hz
+%           channelList     -   Channel list of the exported channels
+%           trialStarts     -   First sample of each trial in the filtered recording (1 based)
+%
+%  V1.0:
+%       version         (int32) [1]  1 for version 1
+%       SampleRate      (int32) [1]  Sample rate in Hz
+%       nChannels       (int32) [1]  Number of channels
+%       trialLength     (int32) [1]  Samples per trial
+%       nTrials         (int32) [1]  Number of trials
+%       channelList     (int32) [1 x nChannels]
+%       trialStarts     (int64) [1 x nTrials]  0 based
+%       trials          (float32) [nChannels x trialLength x nTrials]
+
+function [trials, fs, channelList, trialStarts] = loadTrialTensor(fileName)
+
+fid = fopen(fileName, 'rb');
+if fid < 0
+    error(['File ' fileName ' not found']);
+end
+
+version = double(fread(fid, 1, 'int32'));
+assert(version == 1, 'unsupported trial tensor version');
+fs = double(fread(fid, 1, 'int32'));
+nChannels = double(fread(fid, 1, 'int32'));
+trialLength = double(fread(fid, 1, 'int32'));
+nTrials = double(fread(fid, 1, 'int32'));
+channelList = double(fread(fid, nChannels, 'int32'));
+trialStarts = double(fread(fid, nTrials, 'int64')) + 1;
+
+trials = fread(fid, nChannels * trialLength * nTrials, 'float32=>double');
+trials = reshape(trials, [nChannels, trialLength, nTrials]);
+fclose(fid);
+
+end
@@ -0,0 +1,62 @@
+%% [accuracy, aPosteriori, features, timing] = trainClassifierNative(data, labels, varargin)
+%  Evaluates the CCA-KDE classifier for several trial lengths with k-fold
+%  cross validation using the multithreaded C++ backend (ClassifierTrainerMex).
+%  Features are computed once per trial and trial length and shared by every fold.
+%
+%   Inputs:
+%            data             -  [nChannels x nSamples x nTrials] trials
+%            labels           -  [nTrials x 1] class of each trial (1 based)
+%            'fs'             -  Sample rate in Hz
+%            'freq'           -  Stimulus frequencies in Hz, one per class
+%            'trialLengthSec' -  Trial lengths to evaluate in seconds
+%            'numHarmonics'   -  Harmonics in the CCA templates
+%            'prior'          -  Class prior, uniform if empty
+%            'folds'          -  [nTrials x 1] fold of each trial. Pass the
+%                                folds of the matlab path to compare both.
+%                                If empty, random folds are drawn
+%            'numFolds'       -  Number of folds drawn if 'folds' is empty
+%            'numThreads'     -  Worker threads, 0 for one per core
+%
+%   Outputs:
+%           accuracy        -   [nTrialLengths x numFolds] held out accuracy
+%           aPosteriori     -   [nClasses x nTrials x nTrialLengths] held out posteriors
+%           features        -   [nClasses x nTrials x nTrialLengths] canonical correlations
+%           timing          -   [2 x 1] seconds spent on features and on folds
+
+function [accuracy, aPosteriori, features, timing] = trainClassifierNative(data, labels, varargin)
+
+% input parser
+p = inputParser;
+p.addParameter('fs',256,@isnumeric);
+p.addParameter('freq',[],@isnumeric);
+p.addParameter('trialLengthSec',[],@isnumeric);
+p.addParameter('numHarmonics',2,@isnumeric);
+p.addParameter('prior',[],@isnumeric);
+p.addParameter('folds',[],@isnumeric);
+p.addParameter('numFolds',10,@isnumeric);
+p.addParameter('numThreads',0,@isnumeric);
+p.parse(varargin{:});
+
+nTrials = size(data,3);
+numClasses = numel(p.Results.freq);
+
+folds = p.Results.folds;
+if isempty(folds)
+    folds = mod(randperm(nTrials), p.Results.numFolds) + 1;
+end
+
+prior = p.Results.prior;
+if isempty(prior)
+    prior = ones(numClasses,1)/numClasses;
+end
+
+trialLengthSec = p.Results.trialLengthSec;
+if isempty(trialLengthSec)
+    trialLengthSec = size(data,2)/p.Results.fs;
+end
+
+[accuracy, aPosteriori, features, timing] = ClassifierTrainerMex(double(data), int32(labels(:)), int32(folds(:)), ...
+    double(trialLengthSec(:)), double(p.Results.fs), double(p.Results.freq(:)), int32(p.Results.numHarmonics), ...
+    double(prior(:)), int32(p.Results.numThreads));
+
+end
@@ -0,0 +1,229 @@
+#include <afxwin.h>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <algorithm>
+#include "DAQgUSBamp.h"
+#include "AcquisitionEngine.h"
+
+// Engine shared by the groups of the process
+AcquisitionEngine *AcquisitionEngine::_shared = NULL;
+int AcquisitionEngine::_numSharedUsers = 0;
+std::mutex AcquisitionEngine::_sharedLock;
+
+// An I/O thread and the groups it serves
+struct AcquisitionEngine::IoThread
+{
+	std::thread thread;
+
+	// Signalled when a group is attached or the engine ends
+	HANDLE wake;
+
+	// Groups acquiring, changed by the thread under _lock
+	std::vector<DAQgUSBamp *> groups;
+
+	// Groups attached and not begun yet
+	std::vector<DAQgUSBamp *> starting;
+
+	// Devices of the groups of both lists
+	int numDevices;
+};
+
+// Constructor
+AcquisitionEngine::AcquisitionEngine(int numThreads)
+{
+	_isRunning = true;
+
+	for (int i = 0; i < (std::max)(numThreads, 1); i++)
+	{
+		_threads.push_back(std::unique_ptr<IoThread>(new IoThread()));
+		_threads.back()->wake = CreateEvent(NULL, false, false, NULL);
+		_threads.back()->numDevices = 0;
+	}
+
+	for (size_t i = 0; i < _threads.size(); i++)
+		_threads[i]->thread = std::thread(&AcquisitionEngine::Run, this, _threads[i].get());
+}
+
+// Destructor
+AcquisitionEngine::~AcquisitionEngine()
+{
+	{
+		std::lock_guard<std::mutex> lock(_lock);
+		_isRunning = false;
+		for (size_t i = 0; i < _threads.size(); i++)
+			SetEvent(_threads[i]->wake);
+	}
+
+	for (size_t i = 0; i < _threads.size(); i++)
+	{
+		_threads[i]->thread.join();
+		CloseHandle(_threads[i]->wake);
+	}
+}
+
+AcquisitionEngine *AcquisitionEngine::AcquireShared(int numThreads)
+{
+	std::lock_guard<std::mutex> lock(_sharedLock);
+
+	if (_shared == NULL)
+		_shared = new AcquisitionEngine(numThreads);
+	_numSharedUsers++;
+	return _shared;
+}
+
+void AcquisitionEngine::ReleaseShared()
+{
+	std::lock_guard<std::mutex> lock(_sharedLock);
+
+	if (_numSharedUsers > 0 && --_numSharedUsers == 0)
+	{
+		delete _shared;
+		_shared = NULL;
+	}
+}
+
+bool AcquisitionEngine::Attach(DAQgUSBamp *group, int numDevices)
+{
+	std::lock_guard<std::mutex> lock(_lock);
+
+	//the thread with the fewest devices that can still wait on the new ones (and on its wake-up event)
+	IoThread *io = NULL;
+	for (size_t i = 0; i < _threads.size(); i++)
+		if (_threads[i]->numDevices + numDevices < MAX_WAIT_HANDLES && (io == NULL || _threads[i]->numDevices < io->numDevices))
+			io = _threads[i].get();
+
+	if (!_isRunning || io == NULL)
+		return false;
+
+	io->numDevices += numDevices;
+	io->starting.push_back(group);
+	SetEvent(io->wake);
+	return true;
+}
+
+int AcquisitionEngine::NumThreads()
+{
+	return (int) _threads.size();
+}
+
+int AcquisitionEngine::NumGroups(int threadIndex)
+{
+	std::lock_guard<std::mutex> lock(_lock);
+
+	if (threadIndex < 0 || threadIndex >= (int) _threads.size())
+		return 0;
+	return (int) (_threads[threadIndex]->groups.size() + _threads[threadIndex]->starting.size());
+}
+
+int AcquisitionEngine::ThreadOfGroup(DAQgUSBamp *group)
+{
+	std::lock_guard<std::mutex> lock(_lock);
+
+	for (size_t i = 0; i < _threads.size(); i++)
+	{
+		IoThread *io = _threads[i].get();
+		if (std::find(io->groups.begin(), io->groups.end(), group) != io->groups.end() ||
+			std::find(io->starting.begin(), io->starting.end(), group) != io->starting.end())
+			return (int) i;
+	}
+	return -1;
+}
+
+void AcquisitionEngine::Detach(IoThread *io, size_t groupIndex)
+{
+	DAQgUSBamp *group = io->groups[groupIndex];
+	{
+		std::lock_guard<std::mutex> lock(_lock);
+		io->numDevices -= group->numDevices;
+		io->groups.erase(io->groups.begin() + groupIndex);
+	}
+
+	//the group may be deleted as soon as it has signalled its end
+	group->EndAcquisition();
+}
+
+void AcquisitionEngine::Run(IoThread *io)
+{
+	SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL);
+
+	HANDLE handles[MAX_WAIT_HANDLES];
+	size_t handleGroup[MAX_WAIT_HANDLES];
+	int handleDevice[MAX_WAIT_HANDLES];
+	size_t rotation = 0;
+
+	while (true)
+	{
+		//start the groups attached since the last wait, ending the ones whose devices don't start
+		while (true)
+		{
+			DAQgUSBamp *group;
+			{
+				std::lock_guard<std::mutex> lock(_lock);
+				if (io->starting.empty())
+					break;
+				group = io->starting.front();
+			}
+
+			bool started = group->BeginAcquisition();
+			{
+				std::lock_guard<std::mutex> lock(_lock);
+				io->starting.erase(io->starting.begin());
+				io->groups.push_back(group);
+			}
+			if (!started)
+				Detach(io, io->groups.size() - 1);
+		}
+
+		bool isRunning;
+		{
+			std::lock_guard<std::mutex> lock(_lock);
+			isRunning = _isRunning;
+		}
+
+		//end the groups without completions, the ones asked to stop once their transfers in flight have completed (the
+		//other groups are served meanwhile), and all of them when the engine ends
+		for (size_t i = io->groups.size(); i-- > 0; )
+		{
+			DAQgUSBamp *group = io->groups[i];
+			bool drained = !group->_isRunning && group->TransfersInFlight() == 0;
+			if (!isRunning || drained || !group->CheckTransferTimeout(TIMEOUT_MS))
+				Detach(io, i);
+		}
+
+		if (!isRunning)
+			return;
+
+		//wait for the wake-up event and the oldest transfer of each device, starting with a different group each time
+		int numHandles = 0;
+		handles[numHandles++] = io->wake;
+		size_t numGroups = io->groups.size();
+		for (size_t k = 0; k < numGroups; k++)
+		{
+			size_t groupIndex = (k + rotation) % numGroups;
+			int numEvents = io->groups[groupIndex]->HeadEvents(&handles[numHandles]);
+			for (int deviceIndex = 0; deviceIndex < numEvents; deviceIndex++)
+			{
+				handleGroup[numHandles + deviceIndex] = groupIndex;
+				handleDevice[numHandles + deviceIndex] = deviceIndex;
+			}
+			numHandles += numEvents;
+		}
+		rotation++;
+
+		DWORD waitResult = WaitForMultipleObjects(numHandles, handles, false, (numGroups > 0) ? 100 : INFINITE);
+
+		//on wake-up or timeout the groups are checked again
+		DWORD handleIndex = waitResult - WAIT_OBJECT_0;
+		if (handleIndex == 0 || handleIndex >= (DWORD) numHandles)
+			continue;
+
+		//a stopping group only takes back its transfers, the devices of an empty queue are never signalled
+		DAQgUSBamp *group = io->groups[handleGroup[handleIndex]];
+		if (!group->_isRunning)
+			group->DrainTransfer(handleDevice[handleIndex]);
+		else if (!group->CompleteTransfer(handleDevice[handleIndex]))
+			Detach(io, handleGroup[handleIndex]);
+	}
+}
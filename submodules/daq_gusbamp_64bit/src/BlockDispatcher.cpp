@@ -0,0 +1,240 @@
+#include <vector>
+#include <deque>
+#include <map>
+#include <memory>
+#include <functional>
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+#include "WorkStealingPool.h"
+#include "BlockDispatcher.h"
+
+// Milliseconds between two time points
+static double DurationMs(std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end)
+{
+	return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+// Constructor
+BlockDispatcher::BlockDispatcher(int numThreads) : _pool(numThreads)
+{
+	_writing = NULL;
+	_nextBlockIndex = 0;
+	_nextSubscriberId = 1;
+}
+
+// Destructor
+BlockDispatcher::~BlockDispatcher()
+{
+	std::vector<int> subscriberIds;
+	{
+		std::lock_guard<std::mutex> lock(_lock);
+		for (std::map<int, std::shared_ptr<Subscriber> >::iterator it = _subscribers.begin(); it != _subscribers.end(); ++it)
+			subscriberIds.push_back(it->first);
+	}
+
+	for (size_t i = 0; i < subscriberIds.size(); i++)
+		Unsubscribe(subscriberIds[i]);
+}
+
+int BlockDispatcher::Subscribe(BlockCallback callback, int maxQueuedBlocks)
+{
+	std::shared_ptr<Subscriber> subscriber(new Subscriber());
+	subscriber->callback = callback;
+	subscriber->maxQueuedBlocks = std::max(maxQueuedBlocks, 1);
+	subscriber->scheduled = false;
+	subscriber->removed = false;
+	subscriber->stats = SubscriberStats();
+	subscriber->sumLagMs = 0;
+	subscriber->sumCallbackMs = 0;
+
+	std::lock_guard<std::mutex> lock(_lock);
+	int subscriberId = _nextSubscriberId++;
+	_subscribers[subscriberId] = subscriber;
+	return subscriberId;
+}
+
+bool BlockDispatcher::Unsubscribe(int subscriberId)
+{
+	std::unique_lock<std::mutex> lock(_lock);
+
+	std::map<int, std::shared_ptr<Subscriber> >::iterator it = _subscribers.find(subscriberId);
+	if (it == _subscribers.end())
+		return false;
+
+	std::shared_ptr<Subscriber> subscriber = it->second;
+	_subscribers.erase(it);
+
+	//drop what is queued, then wait for the callback in progress
+	subscriber->removed = true;
+	while (!subscriber->queue.empty())
+	{
+		Release(subscriber->queue.front());
+		subscriber->queue.pop_front();
+	}
+	_drained.wait(lock, [&subscriber] { return !subscriber->scheduled; });
+
+	return true;
+}
+
+int BlockDispatcher::NumSubscribers()
+{
+	std::lock_guard<std::mutex> lock(_lock);
+	return (int) _subscribers.size();
+}
+
+float *BlockDispatcher::AcquireBlock(size_t numValues)
+{
+	std::lock_guard<std::mutex> lock(_lock);
+
+	if (_writing == NULL)
+	{
+		if (_freeBlocks.empty())
+		{
+			_blocks.push_back(std::unique_ptr<Block>(new Block()));
+			_freeBlocks.push_back(_blocks.back().get());
+		}
+		_writing = _freeBlocks.back();
+		_freeBlocks.pop_back();
+	}
+
+	if (_writing->data.size() < numValues)
+		_writing->data.resize(numValues);
+	return &_writing->data[0];
+}
+
+void BlockDispatcher::Publish(int numScans, int scanStride)
+{
+	std::vector< std::shared_ptr<Subscriber> > toSchedule;
+	{
+		std::lock_guard<std::mutex> lock(_lock);
+
+		Block *block = _writing;
+		if (block == NULL)
+			return;
+		_writing = NULL;
+
+		block->numScans = numScans;
+		block->scanStride = scanStride;
+		block->blockIndex = _nextBlockIndex++;
+		block->published = std::chrono::steady_clock::now();
+		block->references = 1;
+
+		for (std::map<int, std::shared_ptr<Subscriber> >::iterator it = _subscribers.begin(); it != _subscribers.end(); ++it)
+		{
+			Subscriber &subscriber = *it->second;
+
+			//a full queue loses its oldest block, the writer never waits
+			if ((int) subscriber.queue.size() >= subscriber.maxQueuedBlocks)
+			{
+				Release(subscriber.queue.front());
+				subscriber.queue.pop_front();
+				subscriber.stats.dropped++;
+			}
+
+			block->references++;
+			subscriber.queue.push_back(block);
+			subscriber.stats.maxQueuedBlocks = std::max(subscriber.stats.maxQueuedBlocks, (int) subscriber.queue.size());
+
+			if (!subscriber.scheduled)
+			{
+				subscriber.scheduled = true;
+				toSchedule.push_back(it->second);
+			}
+		}
+
+		//reference of the writer
+		Release(block);
+	}
+
+	for (size_t i = 0; i < toSchedule.size(); i++)
+	{
+		std::shared_ptr<Subscriber> subscriber = toSchedule[i];
+		_pool.Submit([this, subscriber]() { Drain(subscriber); });
+	}
+}
+
+void BlockDispatcher::ResetBlockIndex()
+{
+	std::lock_guard<std::mutex> lock(_lock);
+	_nextBlockIndex = 0;
+}
+
+void BlockDispatcher::Drain(std::shared_ptr<Subscriber> subscriber)
+{
+	while (true)
+	{
+		Block *block;
+		{
+			std::lock_guard<std::mutex> lock(_lock);
+			if (subscriber->queue.empty() || subscriber->removed)
+			{
+				subscriber->scheduled = false;
+				_drained.notify_all();
+				return;
+			}
+			block = subscriber->queue.front();
+			subscriber->queue.pop_front();
+		}
+
+		TimePoint start = std::chrono::steady_clock::now();
+		BlockSpan span = {&block->data[0], block->numScans, block->scanStride, block->blockIndex};
+		subscriber->callback(span);
+		TimePoint end = std::chrono::steady_clock::now();
+
+		std::lock_guard<std::mutex> lock(_lock);
+		double lagMs = DurationMs(block->published, start);
+		double callbackMs = DurationMs(start, end);
+		SubscriberStats &stats = subscriber->stats;
+		stats.delivered++;
+		stats.maxLagMs = std::max(stats.maxLagMs, lagMs);
+		stats.maxCallbackMs = std::max(stats.maxCallbackMs, callbackMs);
+		subscriber->sumLagMs += lagMs;
+		subscriber->sumCallbackMs += callbackMs;
+		Release(block);
+	}
+}
+
+void BlockDispatcher::Release(Block *block)
+{
+	if (--block->references == 0)
+		_freeBlocks.push_back(block);
+}
+
+void BlockDispatcher::Flush()
+{
+	std::unique_lock<std::mutex> lock(_lock);
+	_drained.wait(lock, [this]
+	{
+		for (std::map<int, std::shared_ptr<Subscriber> >::iterator it = _subscribers.begin(); it != _subscribers.end(); ++it)
+			if (it->second->scheduled)
+				return false;
+		return true;
+	});
+}
+
+bool BlockDispatcher::GetStats(int subscriberId, SubscriberStats *stats)
+{
+	std::lock_guard<std::mutex> lock(_lock);
+
+	std::map<int, std::shared_ptr<Subscriber> >::iterator it = _subscribers.find(subscriberId);
+	if (it == _subscribers.end())
+		return false;
+
+	Subscriber &subscriber = *it->second;
+	*stats = subscriber.stats;
+	stats->queuedBlocks = (int) subscriber.queue.size();
+	if (stats->delivered > 0)
+	{
+		stats->meanLagMs = subscriber.sumLagMs / stats->delivered;
+		stats->meanCallbackMs = subscriber.sumCallbackMs / stats->delivered;
+	}
+	return true;
+}
+
+int BlockDispatcher::NumBuffers()
+{
+	std::lock_guard<std::mutex> lock(_lock);
+	return (int) _blocks.size();
+}
@@ -0,0 +1,114 @@
+#ifdef _WIN32
+#include <Windows.h>
+#endif
+#include <string>
+#include <map>
+#include <fstream>
+#include <sstream>
+#include <stdio.h>
+#include <string.h>
+#include "CalibrationCache.h"
+
+// Constructor
+CalibrationCache::CalibrationCache()
+{
+}
+
+bool CalibrationCache::Load(const char *fileName)
+{
+	_entries.clear();
+
+	std::ifstream file(fileName);
+	if (!file.is_open())
+		return true;
+
+	//one amplifier per line, lines that do not parse are skipped
+	std::string line;
+	while (std::getline(file, line))
+	{
+		std::istringstream fields(line);
+		std::string serial;
+		long long measured;
+		Entry entry;
+
+		if (!(fields >> serial >> measured))
+			continue;
+
+		bool complete = true;
+		for (int i = 0; i < NUM_CHANNELS && complete; i++)
+			complete = (bool) (fields >> entry.factor[i]);
+		for (int i = 0; i < NUM_CHANNELS && complete; i++)
+			complete = (bool) (fields >> entry.offset[i]);
+		if (!complete)
+			continue;
+
+		entry.measured = (time_t) measured;
+		_entries[serial] = entry;
+	}
+
+	return true;
+}
+
+bool CalibrationCache::Save(const char *fileName) const
+{
+	//write a temporary file next to the cache and swap it in, so a crash never leaves a truncated cache
+	std::string tmpName = std::string(fileName) + ".tmp";
+	{
+		std::ofstream file(tmpName.c_str(), std::ios::trunc);
+		if (!file.is_open())
+			return false;
+
+		file.precision(9);
+		for (std::map<std::string, Entry>::const_iterator it = _entries.begin(); it != _entries.end(); ++it)
+		{
+			file << it->first << " " << (long long) it->second.measured;
+			for (int i = 0; i < NUM_CHANNELS; i++)
+				file << " " << it->second.factor[i];
+			for (int i = 0; i < NUM_CHANNELS; i++)
+				file << " " << it->second.offset[i];
+			file << "\n";
+		}
+
+		file.flush();
+		if (!file.good())
+			return false;
+	}
+
+#ifdef _WIN32
+	return MoveFileExA(tmpName.c_str(), fileName, MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+	return rename(tmpName.c_str(), fileName) == 0;
+#endif
+}
+
+void CalibrationCache::Store(const std::string &serial, time_t measured, const float *factor, const float *offset)
+{
+	Entry entry;
+	entry.measured = measured;
+	memcpy(entry.factor, factor, sizeof(entry.factor));
+	memcpy(entry.offset, offset, sizeof(entry.offset));
+	_entries[serial] = entry;
+}
+
+bool CalibrationCache::Find(const std::string &serial, time_t now, double maxAgeSeconds, float *factor, float *offset, double *ageSeconds) const
+{
+	std::map<std::string, Entry>::const_iterator it = _entries.find(serial);
+	if (it == _entries.end())
+		return false;
+
+	//calibrations from the future (clock changed) are not trusted
+	double age = difftime(now, it->second.measured);
+	if (age < 0 || age > maxAgeSeconds)
+		return false;
+
+	memcpy(factor, it->second.factor, sizeof(it->second.factor));
+	memcpy(offset, it->second.offset, sizeof(it->second.offset));
+	if (ageSeconds != NULL)
+		*ageSeconds = age;
+	return true;
+}
+
+void CalibrationCache::Remove(const std::string &serial)
+{
+	_entries.erase(serial);
+}
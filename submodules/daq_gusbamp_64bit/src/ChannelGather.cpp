@@ -0,0 +1,64 @@
+#include <stddef.h>
+#if defined(__SSE2__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define CHANNELGATHER_SSE
+#endif
+#include "ChannelGather.h"
+
+void ChannelGather::Gather(const float *scans, int numScans, int scanStride, const int *channels, int numChannels, float *channelMajor, int rowStride)
+{
+	for (int blockStart = 0; blockStart < numScans; blockStart += BLOCK_SCANS)
+	{
+		int blockEnd = (blockStart + BLOCK_SCANS < numScans) ? blockStart + BLOCK_SCANS : numScans;
+		int channel = 0;
+
+#ifdef CHANNELGATHER_SSE
+		//4 channels by 4 scans: load the channels of each scan into a register, transpose, store one row per channel
+		for (; channel + 4 <= numChannels; channel += 4)
+		{
+			const int c0 = channels[channel], c1 = channels[channel + 1], c2 = channels[channel + 2], c3 = channels[channel + 3];
+			float *row0 = channelMajor + (size_t) channel * rowStride;
+			float *row1 = row0 + rowStride;
+			float *row2 = row1 + rowStride;
+			float *row3 = row2 + rowStride;
+
+			int scan = blockStart;
+			for (; scan + 4 <= blockEnd; scan += 4)
+			{
+				const float *s0 = scans + (size_t) scan * scanStride;
+				const float *s1 = s0 + scanStride;
+				const float *s2 = s1 + scanStride;
+				const float *s3 = s2 + scanStride;
+
+				__m128 r0 = _mm_setr_ps(s0[c0], s0[c1], s0[c2], s0[c3]);
+				__m128 r1 = _mm_setr_ps(s1[c0], s1[c1], s1[c2], s1[c3]);
+				__m128 r2 = _mm_setr_ps(s2[c0], s2[c1], s2[c2], s2[c3]);
+				__m128 r3 = _mm_setr_ps(s3[c0], s3[c1], s3[c2], s3[c3]);
+				_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+				_mm_storeu_ps(row0 + scan, r0);
+				_mm_storeu_ps(row1 + scan, r1);
+				_mm_storeu_ps(row2 + scan, r2);
+				_mm_storeu_ps(row3 + scan, r3);
+			}
+
+			for (; scan < blockEnd; scan++)
+			{
+				const float *s = scans + (size_t) scan * scanStride;
+				row0[scan] = s[c0];
+				row1[scan] = s[c1];
+				row2[scan] = s[c2];
+				row3[scan] = s[c3];
+			}
+		}
+#endif
+
+		for (; channel < numChannels; channel++)
+		{
+			const float *source = scans + channels[channel];
+			float *row = channelMajor + (size_t) channel * rowStride;
+			for (int scan = blockStart; scan < blockEnd; scan++)
+				row[scan] = source[(size_t) scan * scanStride];
+		}
+	}
+}
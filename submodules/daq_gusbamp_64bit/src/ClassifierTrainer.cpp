@@ -0,0 +1,254 @@
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <iostream>
+#include <algorithm>
+#include <math.h>
+#include "SSVEPFeatureEngine.h"
+#include "WorkStealingPool.h"
+#include "ClassifierTrainer.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Constructor
+ClassifierTrainer::ClassifierTrainer(int sampleRate, std::vector<double> stimFrequencies, int numHarmonics, std::vector<double> prior, int numThreads)
+{
+	_sampleRate = sampleRate;
+	_stimFrequencies = stimFrequencies;
+	_numHarmonics = numHarmonics;
+	_numThreads = numThreads;
+
+	//uniform prior if none (or a wrong one) is given
+	if (prior.size() != stimFrequencies.size())
+		prior.assign(stimFrequencies.size(), 1.0 / stimFrequencies.size());
+	_prior = prior;
+
+	_data = NULL;
+	_numChannels = 0;
+	_numSamples = 0;
+	_numTrials = 0;
+	_numFolds = 0;
+	_featureSeconds = 0;
+	_foldSeconds = 0;
+}
+
+void ClassifierTrainer::SetData(const double *data, int numChannels, int numSamples, int numTrials, const int *labels)
+{
+	_data = data;
+	_numChannels = numChannels;
+	_numSamples = numSamples;
+	_numTrials = numTrials;
+	_labels.assign(labels, labels + numTrials);
+}
+
+bool ClassifierTrainer::Run(std::vector<int> trialLengths, const int *folds, int numFolds)
+{
+	int numClasses = (int) _stimFrequencies.size();
+
+	if (_data == NULL || _numTrials == 0 || numClasses == 0 || numFolds < 2)
+	{
+		// error 30
+		std::cout << "Error on ClassifierTrainer::Run: no data, classes or folds." << "\n";
+		return false;
+	}
+
+	for (size_t i = 0; i < trialLengths.size(); i++)
+		if (trialLengths[i] < 2 || trialLengths[i] > _numSamples)
+		{
+			// error 31
+			std::cout << "Error on ClassifierTrainer::Run: trial length " << trialLengths[i] << " is out of range." << "\n";
+			return false;
+		}
+
+	for (int trialIndex = 0; trialIndex < _numTrials; trialIndex++)
+		if (_labels[trialIndex] < 0 || _labels[trialIndex] >= numClasses || folds[trialIndex] < 0 || folds[trialIndex] >= numFolds)
+		{
+			// error 32
+			std::cout << "Error on ClassifierTrainer::Run: label or fold of trial " << trialIndex + 1 << " is out of range." << "\n";
+			return false;
+		}
+
+	_trialLengths = trialLengths;
+	_folds.assign(folds, folds + _numTrials);
+	_numFolds = numFolds;
+
+	int numLengths = (int) _trialLengths.size();
+	_features.assign(numClasses * _numTrials * numLengths, 0);
+	_posterior.assign(numClasses * _numTrials * numLengths, 0);
+	_accuracy.assign(numLengths * numFolds, 0);
+	_references.clear();
+	_references.resize(numLengths * numClasses);
+
+	WorkStealingPool pool(_numThreads);
+	_numThreads = pool.NumThreads();
+
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+	//templates per trial length and class
+	for (int lengthIndex = 0; lengthIndex < numLengths; lengthIndex++)
+		for (int classIndex = 0; classIndex < numClasses; classIndex++)
+			pool.Submit([this, lengthIndex, classIndex, numClasses]() {
+				_references[lengthIndex * numClasses + classIndex].reset(new CCAReference(
+					_stimFrequencies[classIndex], _sampleRate, _numHarmonics, _trialLengths[lengthIndex]));
+			});
+	pool.Wait();
+
+	//features are shared by every fold, so they are computed once per trial and trial length
+	for (int lengthIndex = 0; lengthIndex < numLengths; lengthIndex++)
+		for (int trialIndex = 0; trialIndex < _numTrials; trialIndex++)
+			pool.Submit([this, lengthIndex, trialIndex]() { ComputeFeatures(lengthIndex, trialIndex); });
+	pool.Wait();
+
+	std::chrono::steady_clock::time_point featureTime = std::chrono::steady_clock::now();
+
+	for (int lengthIndex = 0; lengthIndex < numLengths; lengthIndex++)
+		for (int fold = 0; fold < numFolds; fold++)
+			pool.Submit([this, lengthIndex, fold]() { EvaluateFold(lengthIndex, fold); });
+	pool.Wait();
+
+	std::chrono::steady_clock::time_point foldTime = std::chrono::steady_clock::now();
+
+	_featureSeconds = std::chrono::duration<double>(featureTime - startTime).count();
+	_foldSeconds = std::chrono::duration<double>(foldTime - featureTime).count();
+
+	return true;
+}
+
+void ClassifierTrainer::ComputeFeatures(int lengthIndex, int trialIndex)
+{
+	int numClasses = (int) _stimFrequencies.size();
+	int length = _trialLengths[lengthIndex];
+
+	//first length samples of the trial, channel-major and without the channel mean
+	std::vector<double> window(_numChannels * length);
+	const double *trial = _data + (size_t) _numChannels * _numSamples * trialIndex;
+	for (int c = 0; c < _numChannels; c++)
+	{
+		double mean = 0;
+		for (int n = 0; n < length; n++)
+			mean += trial[c + _numChannels * n];
+		mean /= length;
+		for (int n = 0; n < length; n++)
+			window[c * length + n] = trial[c + _numChannels * n] - mean;
+	}
+
+	double *features = &_features[numClasses * (trialIndex + _numTrials * lengthIndex)];
+	for (int classIndex = 0; classIndex < numClasses; classIndex++)
+		features[classIndex] = _references[lengthIndex * numClasses + classIndex]->Correlate(&window[0], _numChannels);
+}
+
+void ClassifierTrainer::EvaluateFold(int lengthIndex, int fold)
+{
+	int numClasses = (int) _stimFrequencies.size();
+	int numDims = numClasses;
+	const double *features = &_features[numClasses * _numTrials * lengthIndex];
+
+	//training trials of each class
+	std::vector< std::vector<int> > classTrials(numClasses);
+	for (int trialIndex = 0; trialIndex < _numTrials; trialIndex++)
+		if (_folds[trialIndex] != fold)
+			classTrials[_labels[trialIndex]].push_back(trialIndex);
+
+	//kernel bandwidth per class and dimension
+	std::vector<double> bandwidth(numClasses * numDims, 1);
+	for (int classIndex = 0; classIndex < numClasses; classIndex++)
+	{
+		int n = (int) classTrials[classIndex].size();
+		if (n == 0)
+			continue;
+
+		for (int d = 0; d < numDims; d++)
+		{
+			std::vector<double> values(n);
+			for (int i = 0; i < n; i++)
+				values[i] = features[numClasses * classTrials[classIndex][i] + d];
+
+			std::nth_element(values.begin(), values.begin() + n / 2, values.end());
+			double median = values[n / 2];
+			if (n % 2 == 0)
+				median = (median + *std::max_element(values.begin(), values.begin() + n / 2)) / 2;
+
+			for (int i = 0; i < n; i++)
+				values[i] = fabs(values[i] - median);
+
+			std::nth_element(values.begin(), values.begin() + n / 2, values.end());
+			double mad = values[n / 2];
+			if (n % 2 == 0)
+				mad = (mad + *std::max_element(values.begin(), values.begin() + n / 2)) / 2;
+
+			double sigma = std::max(mad / 0.6745, 1e-6);
+			bandwidth[classIndex * numDims + d] = sigma * pow(4.0 / ((numDims + 2.0) * n), 1.0 / (numDims + 4.0));
+		}
+	}
+
+	//score held out trials
+	int numCorrect = 0;
+	int numTested = 0;
+	std::vector<double> logPosterior(numClasses);
+	for (int trialIndex = 0; trialIndex < _numTrials; trialIndex++)
+	{
+		if (_folds[trialIndex] != fold)
+			continue;
+
+		const double *x = &features[numClasses * trialIndex];
+		double largest = -1e300;
+
+		for (int classIndex = 0; classIndex < numClasses; classIndex++)
+		{
+			int n = (int) classTrials[classIndex].size();
+			if (n == 0 || _prior[classIndex] <= 0)
+			{
+				logPosterior[classIndex] = -1e300;
+				continue;
+			}
+
+			const double *h = &bandwidth[classIndex * numDims];
+			double logNorm = 0;
+			for (int d = 0; d < numDims; d++)
+				logNorm -= log(h[d] * sqrt(2 * M_PI));
+
+			//log of the mean kernel value, accumulated with log-sum-exp
+			std::vector<double> logKernel(n);
+			double maxLogKernel = -1e300;
+			for (int i = 0; i < n; i++)
+			{
+				const double *xi = &features[numClasses * classTrials[classIndex][i]];
+				double exponent = 0;
+				for (int d = 0; d < numDims; d++)
+				{
+					double u = (x[d] - xi[d]) / h[d];
+					exponent -= 0.5 * u * u;
+				}
+				logKernel[i] = exponent;
+				maxLogKernel = std::max(maxLogKernel, exponent);
+			}
+
+			double sum = 0;
+			for (int i = 0; i < n; i++)
+				sum += exp(logKernel[i] - maxLogKernel);
+
+			logPosterior[classIndex] = log(_prior[classIndex]) + logNorm + maxLogKernel + log(sum / n);
+			largest = std::max(largest, logPosterior[classIndex]);
+		}
+
+		double *posterior = &_posterior[numClasses * (trialIndex + _numTrials * lengthIndex)];
+		double total = 0;
+		int best = 0;
+		for (int classIndex = 0; classIndex < numClasses; classIndex++)
+		{
+			posterior[classIndex] = exp(logPosterior[classIndex] - largest);
+			total += posterior[classIndex];
+			if (posterior[classIndex] > posterior[best])
+				best = classIndex;
+		}
+		for (int classIndex = 0; classIndex < numClasses; classIndex++)
+			posterior[classIndex] /= total;
+
+		numCorrect += (best == _labels[trialIndex]);
+		numTested++;
+	}
+
+	_accuracy[lengthIndex + _trialLengths.size() * fold] = numTested ? (double) numCorrect / numTested : 0;
+}
@@ -8,20 +8,64 @@
 #include <time.h>
 #include <vector>
 #include <algorithm>
+#include <map>
+#include <set>
 #include <math.h>
+#include <limits>
 #include "ringbuffer.h"
 #include "gUSBamp.h"
+#include "SSVEPFeatureEngine.h"
+#include "IncrementalTrialClassifier.h"
+#include "AmpDriver.h"
+#include "SimulatedAmpDriver.h"
+#include "ReplayAmpDriver.h"
+#include "TransferMonitor.h"
+#include "WorkStealingPool.h"
+#include "CalibrationCache.h"
+#include "ReadNotifier.h"
+#include "BlockDispatcher.h"
+#include "ThreadScheduling.h"
+#include "AcquisitionEngine.h"
 #include "DAQgUSBamp.h"
 
+// Serial and USB port of the devices found by the last port scan
+std::map<std::string, int> DAQgUSBamp::_deviceInventory;
+CMutex DAQgUSBamp::_inventoryLock;
+
+// Devices opened and groups acquiring in this process
+std::set<std::string> DAQgUSBamp::_openedSerials;
+int DAQgUSBamp::_numAcquiring = 0;
+CMutex DAQgUSBamp::_priorityLock;
+
+// Milliseconds elapsed since start on the performance counter
+static double ElapsedMs(LARGE_INTEGER start)
+{
+	LARGE_INTEGER counter, frequency;
+	QueryPerformanceCounter(&counter);
+	QueryPerformanceFrequency(&frequency);
+	return 1000.0 * (counter.QuadPart - start.QuadPart) / frequency.QuadPart;
+}
+
+BlockPolicy BlockPolicy::LowLatency(int sampleRate)
+{
+	int blockScans = (sampleRate >= 256) ? sampleRate / 128 : 1;
+	return BlockPolicy(blockScans, (int) ceil(0.125 * sampleRate / blockScans), 1);
+}
+
+BlockPolicy BlockPolicy::HighThroughput(int sampleRate)
+{
+	int blockScans = (sampleRate / 4 < 512) ? sampleRate / 4 : 512;
+	return BlockPolicy(blockScans, 4, (int) ceil((double) sampleRate / blockScans));
+}
+
 // Constructor
-DAQgUSBamp::DAQgUSBamp(std::vector<UCHAR> inputChannelList, int f, int trig, int BPF, int Notch, UCHAR mode, int comRef[4], int comGRN[4], std::vector<UCHAR> bipoSet)
+DAQgUSBamp::DAQgUSBamp(std::vector<UCHAR> inputChannelList, int f, int trig, int BPF, int Notch, UCHAR mode, int comRef[4], int comGRN[4], std::vector<UCHAR> bipoSet, BlockPolicy blockPolicy)
 {
 	// Get total number of channels to be acquired
 	numChannels = inputChannelList.size();
 
 	// Sample rate in Hz
 	SampleRate = f;
-	NumScans = SampleRate / 32;
 	TRIGGER = trig;
 	_mode = mode;
 	BPFindex = BPF;
@@ -42,7 +86,46 @@ DAQgUSBamp::DAQgUSBamp(std::vector<UCHAR> inputChannelList, int f, int trig, int
 	ConvertAmpChannels(inputChannelList, bipoSet);
 
 	writeToFile = false;
+	_isRunning = false;
 
+	_featureEngine = NULL;
+	_featureSubscriber = -1;
+	_qualityMonitor = NULL;
+	_qualitySubscriber = -1;
+	_envelope = NULL;
+	_envelopeSubscriber = -1;
+	_impedancePool = NULL;
+	_impedanceStop = false;
+	_trialClassifier = NULL;
+	_classifierSubscriber = -1;
+	_eogDetector = NULL;
+	_eogSubscriber = -1;
+	_dispatcher = new BlockDispatcher(DISPATCH_THREADS);
+	_triggerScheduler = new TriggerScheduler(SampleRate, [this](int value) { return WriteTrigger(value); });
+
+	_driver = new GtecAmpDriver();
+	_queueDepth = DEFAULT_QUEUE_SIZE;
+	_maxQueueDepth = DEFAULT_QUEUE_SIZE;
+	_adaptiveQueue = false;
+	_numBlocks = 0;
+
+	_calibrationMaxAgeHours = 0;
+
+	_acquisitionThreadId = -1;
+	_startContextSwitches = 0;
+	_endContextSwitches = -1;
+	_startPageFaults = 0;
+
+	_queues = NULL;
+	_numQueues = 0;
+	_bufferLocked = false;
+	_numClipped = 0;
+	_engine = NULL;
+	_holdsPriority = false;
+
+	//fall back to the default block size if the requested policy is not valid
+	if (!SetBlockPolicy(blockPolicy))
+		SetBlockPolicy(BlockPolicy());
 }
 
 void DAQgUSBamp::ConvertAmpChannels(std::vector<UCHAR> inputChannelList, std::vector<UCHAR> bipoSet)
@@ -71,33 +154,93 @@ void DAQgUSBamp::ConvertAmpChannels(std::vector<UCHAR> inputChannelList, std::ve
 std::deque<std::string> DAQgUSBamp::FindDevice()
 {
 	std::deque<std::string> deviceSerialList;
-	HANDLE hDevice; 
+	std::vector<std::string> portSerials(MAX_NUMBER_USB_PORTS);
+	LARGE_INTEGER startTime;
 
-	const UINT uiSize = 16;	
+	QueryPerformanceCounter(&startTime);
 
-	for (int usbIndex = 0 ; usbIndex < MAX_NUMBER_USB_PORTS; usbIndex++){
-		hDevice = GT_OpenDevice(usbIndex);
-		if (hDevice)
+	//probe the ports in parallel, each probe opens and closes its own handle
+	{
+		WorkStealingPool pool(DISCOVERY_THREADS);
+		for (int usbIndex = 0 ; usbIndex < MAX_NUMBER_USB_PORTS; usbIndex++)
 		{
-			char tmpSerial[uiSize];
-			if (GT_GetSerial(hDevice, tmpSerial, uiSize))
-			{				
-				deviceSerialList.push_back(std::string(tmpSerial));
-				std::cout << "gUSBDevice "<< deviceSerialList.size() << "   " << tmpSerial <<"\n";
-			} 
-			GT_CloseDevice(&hDevice);
+			pool.Submit([this, usbIndex, &portSerials]()
+			{
+				const UINT uiSize = 16;
+				HANDLE hDevice = _driver->OpenDevice(usbIndex);
+				if (hDevice)
+				{
+					char tmpSerial[uiSize];
+					if (_driver->GetSerial(hDevice, tmpSerial, uiSize))
+						portSerials[usbIndex] = tmpSerial;
+					_driver->CloseDevice(&hDevice);
+				}
+			});
 		}
+		pool.Wait();
 	}
 
+	//list the devices in port order and keep them in the inventory
+	_inventoryLock.Lock();
+	_deviceInventory.clear();
+	for (int usbIndex = 0 ; usbIndex < MAX_NUMBER_USB_PORTS; usbIndex++)
+	{
+		if (portSerials[usbIndex].empty())
+			continue;
+
+		deviceSerialList.push_back(portSerials[usbIndex]);
+		_deviceInventory[portSerials[usbIndex]] = usbIndex;
+		std::cout << "gUSBDevice "<< deviceSerialList.size() << "   " << portSerials[usbIndex] <<"\n";
+	}
+	_inventoryLock.Unlock();
+
+	std::cout << "Discovery: " << MAX_NUMBER_USB_PORTS << " USB ports scanned in " << ElapsedMs(startTime) << " ms\n";
+	return deviceSerialList;
+}
+
+std::deque<std::string> DAQgUSBamp::InventorySerials()
+{
+	std::map<int, std::string> portSerials;
+
+	_inventoryLock.Lock();
+	for (std::map<std::string, int>::iterator it = _deviceInventory.begin(); it != _deviceInventory.end(); ++it)
+		portSerials[it->second] = it->first;
+	_inventoryLock.Unlock();
+
+	std::deque<std::string> deviceSerialList;
+	for (std::map<int, std::string>::iterator it = portSerials.begin(); it != portSerials.end(); ++it)
+		deviceSerialList.push_back(it->second);
+
 	return deviceSerialList;
 }
 
+void DAQgUSBamp::ClearDeviceInventory()
+{
+	_inventoryLock.Lock();
+	_deviceInventory.clear();
+	_inventoryLock.Unlock();
+}
+
 bool DAQgUSBamp::OpenAndInitDevice()
 {   
-	//find the device
+	//find the device, from the inventory of a previous scan if there is one
 	bool successFlag = false;
 
-	deviceSerialList = FindDevice();
+	deviceSerialList = InventorySerials();
+	bool fromInventory = !deviceSerialList.empty();
+	if (fromInventory)
+		std::cout << "Discovery: " << deviceSerialList.size() << " device(s) from inventory\n";
+	else
+		deviceSerialList = FindDevice();
+
+	//devices opened by the other groups of this process are not available
+	std::deque<std::string> availableSerials;
+	_inventoryLock.Lock();
+	for (size_t i = 0; i < deviceSerialList.size(); i++)
+		if (_openedSerials.count(deviceSerialList[i]) == 0)
+			availableSerials.push_back(deviceSerialList[i]);
+	_inventoryLock.Unlock();
+	deviceSerialList = availableSerials;
 
 	if (deviceSerialList.empty())
 	{
@@ -130,12 +273,21 @@ bool DAQgUSBamp::OpenAndInitDevice()
 	deviceSerialList.push_back(usbSerial);
 
 	successFlag = OpenAndInitDevice(deviceSerialList);
+
+	//the device of the inventory may have been unplugged, scan again
+	if (!successFlag && fromInventory)
+	{
+		std::cout << "Device inventory out of date, scanning USB ports" << "\n";
+		CloseDevice();
+		ClearDeviceInventory();
+		successFlag = OpenAndInitDevice();
+	}
+
 	return successFlag;
 }
 
 bool DAQgUSBamp::OpenAndInitDevice(std::deque<std::string> inputUsbSerials)
 {   
-	HANDLE hDevice;
 	//find the device
 	bool successFlag = false;
 
@@ -145,63 +297,122 @@ bool DAQgUSBamp::OpenAndInitDevice(std::deque<std::string> inputUsbSerials)
 		return successFlag;
 	}
 
+	//each device belongs to one group, claim them all or none
+	_inventoryLock.Lock();
+	bool opened = false;
+	for (size_t i = 0; i < inputUsbSerials.size(); i++)
+		opened = opened || _openedSerials.count(inputUsbSerials[i]) > 0;
+	if (!opened)
+		_openedSerials.insert(inputUsbSerials.begin(), inputUsbSerials.end());
+	_inventoryLock.Unlock();
+
+	if (opened)
+	{
+		// error 52
+		std::cout << "Error on OpenAndInitDevice: a device is already opened by another group of this process." << "\n";
+		return successFlag;
+	}
+
 	deviceSerialList = inputUsbSerials;
 	std::reverse(deviceSerialList.begin(), deviceSerialList.end());
 	
 	std::string masterDevice = deviceSerialList.back();		
 
-	for (int deviceIndex=0; deviceIndex < numDevices; deviceIndex++)
+	LARGE_INTEGER startTime;
+	QueryPerformanceCounter(&startTime);
+
+	//open and configure the devices in parallel (they are started later, master last)
+	std::vector<HANDLE> handles(numDevices, (HANDLE) NULL);
+	std::vector<double> openMs(numDevices, 0), configureMs(numDevices, 0), calibrationAge(numDevices, -1);
 	{
-		//open the device
-		hDevice = GT_OpenDeviceEx(const_cast<LPSTR>(deviceSerialList[deviceIndex].c_str()));
+		WorkStealingPool pool(numDevices);
+		for (int deviceIndex=0; deviceIndex < numDevices; deviceIndex++)
+		{
+			pool.Submit([this, deviceIndex, &masterDevice, &handles, &openMs, &configureMs, &calibrationAge]()
+			{
+				LARGE_INTEGER deviceStartTime;
+				QueryPerformanceCounter(&deviceStartTime);
+
+				//open the device
+				HANDLE hDevice = _driver->OpenDeviceEx(const_cast<LPSTR>(deviceSerialList[deviceIndex].c_str()));
+				handles[deviceIndex] = hDevice;
+				openMs[deviceIndex] = ElapsedMs(deviceStartTime);
+				if (hDevice == NULL)
+					return;
+
+				//determine master device as the last device in the list
+				bool isSlave = (deviceSerialList[deviceIndex] != masterDevice);
+
+				//set slave/master mode of the device
+				if (!_driver->SetSlave(hDevice, isSlave))
+				{
+					// error 2
+					std::cout << "Error on GT_SetSlave: Couldn't set slave/master mode for device "<< "\n";
+				}
+
+				ApplySettings(hDevice, correctedChannelList[numDevices-1-deviceIndex], correctedBipolarSettings[numDevices-1-deviceIndex], deviceIndex);
+
+				//for g.USBamp devices set common ground and common reference
+				if (strncmp(deviceSerialList[deviceIndex].c_str(), "U", 1) == 0 && (_mode == M_NORMAL || _mode == M_COUNTER))
+				{
+					//set the common reference
+					REF RefSetting = {commonReference[0], commonReference[1], commonReference[2], commonReference[3]};
+					if (!_driver->SetReference(hDevice, RefSetting))
+					{
+						// error 3
+						std::cout << "Error on GT_SetReference: Couldn't set common reference for device " << "\n";
+					}
+
+					//set the common ground
+					GND GNDSetting = {commonGround[0], commonGround[1], commonGround[2], commonGround[3]};
+					if (!_driver->SetGround(hDevice, GNDSetting))
+					{
+						// error 4
+						std::cout << "Error on GT_SetGround: Couldn't set common ground for device " << "\n";
+					}
+				}
+
+				//reapply the calibration of this amplifier if the cache has a recent one
+				SCALE scaling;
+				if (!_calibrationCacheFile.empty() && _calibrationCache.Find(deviceSerialList[deviceIndex], time(NULL), 3600 * _calibrationMaxAgeHours, scaling.factor, scaling.offset, &calibrationAge[deviceIndex]))
+				{
+					if (!_driver->SetScale(hDevice, &scaling))
+					{
+						// error 44
+						std::cout << "Error on GT_SetScale: Could not set the cached scaling values for device " << "\n";
+						calibrationAge[deviceIndex] = -1;
+					}
+				}
+
+				configureMs[deviceIndex] = ElapsedMs(deviceStartTime) - openMs[deviceIndex];
+			});
+		}
+		pool.Wait();
+	}
 
-		//add the device handle to the list of opened devices
-		deviceHandleList.push_back(hDevice);
-		if (hDevice == NULL)
+	//add the device handles to the list of opened devices
+	successFlag = true;
+	for (int deviceIndex=0; deviceIndex < numDevices; deviceIndex++)
+	{
+		deviceHandleList.push_back(handles[deviceIndex]);
+		_calibrationFresh.push_back(calibrationAge[deviceIndex] >= 0);
+		if (handles[deviceIndex] == NULL)
 		{
 			// error 1
 			std::cout << "Could not open device "<< deviceIndex << "\n";
-			return successFlag;
-		}
-		else
-		{
-			std::cout << " Device  "<< deviceIndex + 1 << " opened "<< "\n";
-			successFlag = true;
+			successFlag = false;
+			continue;
 		}
-		//determine master device as the last device in the list
-		bool isSlave = (deviceSerialList[deviceIndex] != masterDevice);
 
-		//set slave/master mode of the device
-		if (!GT_SetSlave(hDevice, isSlave))
-		{
-			// error 2
-			std::cout << "Error on GT_SetSlave: Couldn't set slave/master mode for device "<< "\n";
-		}
-	
-		ApplySettings(hDevice, correctedChannelList[numDevices-1-deviceIndex], correctedBipolarSettings[numDevices-1-deviceIndex], deviceIndex);
+		std::cout << " Device  "<< deviceIndex + 1 << " (" << deviceSerialList[deviceIndex] << ") opened in " << openMs[deviceIndex] << " ms, configured in " << configureMs[deviceIndex] << " ms\n";
+		if (calibrationAge[deviceIndex] >= 0)
+			std::cout << "  calibration reused from cache (" << calibrationAge[deviceIndex] / 3600 << " h old)\n";
+	}
 
-		//for g.USBamp devices set common ground and common reference
-		if (strncmp(deviceSerialList[deviceIndex].c_str(), "U", 1) == 0 && (_mode == M_NORMAL || _mode == M_COUNTER))
-		{
-			//set the common reference
-			REF RefSetting = {commonReference[0], commonReference[1], commonReference[2], commonReference[3]};
-			//REF tmp = {0,0,0,0};
-			if (!GT_SetReference(hDevice, RefSetting))
-			{
-				// error 3
-				std::cout << "Error on GT_SetReference: Couldn't set common reference for device " << "\n";				
-			}
+	if (!successFlag)
+		return successFlag;
 
-			//set the common ground
-			GND GNDSetting = {commonGround[0], commonGround[1], commonGround[2], commonGround[3]};
-			if (!GT_SetGround(hDevice, GNDSetting))
-			{
-				// error 4
-				std::cout << "Error on GT_SetGround: Couldn't set common ground for device " << "\n";
-			}
-		}
-	}
-	std::cout << "All gUSBamp devices are initialized! " << "\n";
+	std::cout << "All gUSBamp devices are initialized in " << ElapsedMs(startTime) << " ms! " << "\n";
 	return successFlag;
 }
 
@@ -217,28 +428,28 @@ void DAQgUSBamp::ApplySettings(HANDLE h_device, std::vector<UCHAR> channelList,
 		_trigger = 0;
 
 	//set the channels from that data should be acquired
-	if (!GT_SetChannels(h_device, &channelList[0], channelList.size()))
+	if (!_driver->SetChannels(h_device, &channelList[0], channelList.size()))
 	{
 		// error 5
 		std::cout << "Error on GT_SetChannels: Couldn't set channels to acquire for device " << "\n";
 	}
 
 	//set the sample rate
-	if (!GT_SetSampleRate(h_device, SampleRate))
+	if (!_driver->SetSampleRate(h_device, SampleRate))
 	{
 		// error 6
 		std::cout << "Error on GT_SetSampleRate: Couldn't set sample rate for device " << "\n";
 	}
 
 	//disable the trigger line
-	if (!GT_EnableTriggerLine(h_device, _trigger))
+	if (!_driver->EnableTriggerLine(h_device, _trigger))
 	{
 		// error 7
 		std::cout << "Error on GT_EnableTriggerLine: Couldn't enable/disable trigger line for device " << "\n";
 	}
 
 	//set the number of scans that should be received simultaneously
-	if (!GT_SetBufferSize(h_device, NumScans))
+	if (!_driver->SetBufferSize(h_device, NumScans))
 	{
 		// error 8
 		std::cout << "Error on GT_SetBufferSize: Couldn't set the buffer size for device " << "\n";
@@ -247,14 +458,14 @@ void DAQgUSBamp::ApplySettings(HANDLE h_device, std::vector<UCHAR> channelList,
 	for (int i=0; i < channelList.size(); i++)
 	{
 		//don't use a bandpass filter for any channel
-		if (!GT_SetBandPass(h_device, channelList[i], BPFindex))
+		if (!_driver->SetBandPass(h_device, channelList[i], BPFindex))
 		{
 			// error 9
 			std::cout << "Error on GT_SetBandPass: Couldn't set no bandpass filter for device " << "\n";			
 		}
 
 		//don't use a notch filter for any channel
-		if (!GT_SetNotch(h_device, channelList[i], Notchindex))
+		if (!_driver->SetNotch(h_device, channelList[i], Notchindex))
 		{
 			// error 10
 			std::cout << "Error on GT_SetNotch: Couldn't set no notch filter for device " << "\n";
@@ -262,7 +473,7 @@ void DAQgUSBamp::ApplySettings(HANDLE h_device, std::vector<UCHAR> channelList,
 	}
 
 	//disable shortcut function
-	if (!GT_EnableSC(h_device, false))
+	if (!_driver->EnableSC(h_device, false))
 	{
 		// error 11
 		std::cout << "Error on GT_EnableSC: Couldn't disable shortcut function for device " << "\n";
@@ -273,21 +484,21 @@ void DAQgUSBamp::ApplySettings(HANDLE h_device, std::vector<UCHAR> channelList,
 								bipolarSettings[8], bipolarSettings[9], bipolarSettings[10], bipolarSettings[11], 
 								bipolarSettings[12], bipolarSettings[13], bipolarSettings[14], bipolarSettings[15]};
 
-	if (!GT_SetBipolar(h_device, bipolarSettingsStruct))
+	if (!_driver->SetBipolar(h_device, bipolarSettingsStruct))
 	{
 		// error 12
 		std::cout << "Error on GT_SetBipolar: Couldn't set unipolar derivation for device " << "\n";
 	}
 
 	if (_mode == M_COUNTER)
-		if (!GT_SetMode(h_device, M_NORMAL))
+		if (!_driver->SetMode(h_device, M_NORMAL))
 		{
 			// error 13
 			std::cout << "Error on GT_SetMode: Couldn't set mode M_NORMAL (before mode M_COUNTER) for device " << "\n";
 		}
 
 	//set the acquisition mode
-	if (!GT_SetMode(h_device, _mode))
+	if (!_driver->SetMode(h_device, _mode))
 	{
 		// error 14
 		std::cout << "Error on GT_SetMode: Couldn't set mode for device " << "\n";
@@ -295,40 +506,92 @@ void DAQgUSBamp::ApplySettings(HANDLE h_device, std::vector<UCHAR> channelList,
 
 }
 
-//Starts the thread that does the data acquisition.
-void DAQgUSBamp::AmpCalibration()
+//Calibrates the devices, stores the results in the calibration cache and restores the acquisition settings
+void DAQgUSBamp::AmpCalibration(bool staleOnly)
 { 
 	HANDLE hDevice;
 	SCALE Scaling = {{0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0},{0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0}};
+	bool cacheUpdated = false;
 
-	for (int i = 0; i < numDevices; i++)
+	for (int i = 0; i < (int) deviceHandleList.size(); i++)
 	{
+		//devices with a recent cached calibration are already calibrated
+		if (staleOnly && i < (int) _calibrationFresh.size() && _calibrationFresh[i])
+			continue;
+
 		hDevice = deviceHandleList[i];
-		if (!GT_SetMode(hDevice, M_CALIBRATE))
+		if (!_driver->SetMode(hDevice, M_CALIBRATE))
 		{
 			// error 15
 			std::cout << "Error on GT_SetMode: Could not enable calibration mode." << "\n";
 		}
-		if (!GT_GetScale(hDevice, &Scaling))
+		if (!_driver->GetScale(hDevice, &Scaling))
 		{
 			// error 16
 			std::cout << "Error on GT_GetScale: Could not get the scaling values." << "\n";
 		}
-		if (!GT_Calibrate(hDevice, &Scaling))
+		if (!_driver->Calibrate(hDevice, &Scaling))
 		{
 			// error 17
 			std::cout << "Error on GT_Calibrate: Could not do calibration." << "\n";
 		}
-		if (!GT_SetScale(hDevice, &Scaling))
+		else if (!_driver->SetScale(hDevice, &Scaling))
 		{
 			// error 18
 			std::cout << "Error on GT_SetScale: Could not set the scaling values." << "\n";
 		}
 		else
+		{
 			std::cout << "Calibration is performed successfully." << "\n";
+			if (!_calibrationCacheFile.empty())
+			{
+				_calibrationCache.Store(deviceSerialList[i], time(NULL), Scaling.factor, Scaling.offset);
+				cacheUpdated = true;
+				if (i < (int) _calibrationFresh.size())
+					_calibrationFresh[i] = true;
+			}
+		}
+
+		//calibration mode replaces the acquisition mode
+		ApplySettings(hDevice, correctedChannelList[numDevices-1-i], correctedBipolarSettings[numDevices-1-i], i);
+	}
+
+	if (cacheUpdated && !_calibrationCache.Save(_calibrationCacheFile.c_str()))
+	{
+		// error 45
+		std::cout << "Could not write the calibration cache " << _calibrationCacheFile << "\n";
 	}
 }
 
+bool DAQgUSBamp::SetCalibrationCache(const char *fileName, double maxAgeHours)
+{
+	if (!deviceHandleList.empty() || maxAgeHours < 0)
+	{
+		// error 43
+		std::cout << "Calibration cache must be set before opening the devices, with a non negative maximum age" << "\n";
+		return false;
+	}
+
+	_calibrationCacheFile = fileName;
+	_calibrationMaxAgeHours = maxAgeHours;
+	if (!_calibrationCacheFile.empty())
+		_calibrationCache.Load(fileName);
+
+	return true;
+}
+
+bool DAQgUSBamp::CalibrationStale()
+{
+	if (_calibrationCacheFile.empty())
+		return false;
+
+	for (size_t i = 0; i < _calibrationFresh.size(); i++)
+		if (!_calibrationFresh[i])
+			return true;
+
+	return false;
+}
+
 void DAQgUSBamp::PrintFilterInfo(int filterIndex)
 { 
 	int nFilters = 0;
@@ -365,30 +628,135 @@ void DAQgUSBamp::PrintNotchInfo(int filterIndex)
 //Starts the thread that does the data acquisition
 void DAQgUSBamp::StartAcquisition()
 {
+	LARGE_INTEGER startTime;
+	QueryPerformanceCounter(&startTime);
+
+	//impedance measurement and acquisition can't run together
+	StopImpedanceMonitor();
+
 	_isRunning = true;
 	_bufferOverrun = false;
 	int modestatus;
 
 	for (int deviceIndex=0; deviceIndex < numDevices; deviceIndex++)
 	{
-		modestatus = GT_SetMode(deviceHandleList[deviceIndex], _mode);
+		modestatus = _driver->SetMode(deviceHandleList[deviceIndex], _mode);
 	}
 
-	//give main process (the data processing thread) high priority
+	//give main process (the data processing thread) high priority, or real-time priority if requested (the first group
+	//to start raises it, a later one only to real-time)
 	HANDLE hProcess = GetCurrentProcess();
-	SetPriorityClass(hProcess, HIGH_PRIORITY_CLASS);
+	_priorityLock.Lock();
+	if (_schedulingPolicy.realTime)
+		SetPriorityClass(hProcess, REALTIME_PRIORITY_CLASS);
+	else if (_numAcquiring == 0)
+		SetPriorityClass(hProcess, HIGH_PRIORITY_CLASS);
+	if (!_holdsPriority)
+		_numAcquiring++;
+	_holdsPriority = true;
+	_priorityLock.Unlock();
+
+	//initialize application data buffer to the specified number of seconds, the one of the previous run is kept if it has the same size
+	//(only the ring of the storage in use is allocated, the other one has been freed by SetSampleStorage)
+	int capacity = BUFFER_SIZE_SECONDS * SampleRate * (numChannels + TRIGGER);
+	bool compact = (_codec.Storage() != STORAGE_FLOAT32);
+	bool reused = compact ? (_compactBuffer.GetCapacity() == capacity) : (_buffer.GetCapacity() == capacity);
+	if (reused)
+	{
+		_buffer.Reset();
+		_compactBuffer.Reset();
+	}
+	else
+	{
+		if (_bufferLocked)
+			ThreadScheduling::UnlockMemory(BufferData(), BufferBytes());
+		_bufferLocked = false;
+		if (compact)
+			_compactBuffer.Initialize(capacity);
+		else
+			_buffer.Initialize(capacity);
+	}
+	_compactWrite.resize(compact ? NumScans * (numChannels + TRIGGER) : 0);
+	_numClipped = 0;
+
+	//map the application buffer now and keep it in RAM, so writing it never faults (it stays locked while pooled)
+	if (_schedulingPolicy.lockMemory && !_bufferLocked)
+	{
+		_bufferLocked = ThreadScheduling::LockMemory(BufferData(), BufferBytes());
+		if (!_bufferLocked)
+		{
+			// error 49
+			std::cout << "Error on LockMemory: the application buffer couldn't be locked (working set limit or privilege), it stays pageable." << "\n";
+		}
+	}
+	else if (!_schedulingPolicy.lockMemory && _bufferLocked)
+	{
+		ThreadScheduling::UnlockMemory(BufferData(), BufferBytes());
+		_bufferLocked = false;
+	}
+
+	//transfer buffers and events of the previous run are reused if the devices and block size are unchanged
+	reused = PrepareQueues() && reused;
 
-	//initialize application data buffer to the specified number of seconds
-	_buffer.Initialize(BUFFER_SIZE_SECONDS * SampleRate * (numChannels + TRIGGER));
+	//place the dispatch threads on their cores and priority
+	SchedulingPolicy policy = _schedulingPolicy;
+	_dispatcher->Pool().ConfigureWorkers([policy](int workerIndex)
+	{
+		if (!policy.dispatchCpus.empty())
+			ThreadScheduling::PinCurrentThread(policy.dispatchCpus[workerIndex % policy.dispatchCpus.size()]);
+		if (policy.realTime)
+			ThreadScheduling::SetCurrentThreadRealTime(false);
+	});
+
+	//subscribers see block indices from 0
+	_dispatcher->ResetBlockIndex();
+
+	//start transfer statistics from the configured queue depth
+	_transferLock.Lock();
+	_deviceQueueDepth.assign(numDevices, _queueDepth);
+	_transferMonitors.assign(numDevices, TransferMonitor((double) NumScans / SampleRate, LATENCY_WINDOW));
+	_numBlocks = 0;
+	_acquisitionThreadId = -1;
+	_startPageFaults = ThreadScheduling::ProcessPageFaults();
+	_transferLock.Unlock();
+
+	//start feature extraction from an empty window
+	_featureLock.Lock();
+	if (_featureEngine != NULL)
+		_featureEngine->Reset();
+	if (_trialClassifier != NULL)
+		_trialClassifier->Reset();
+	if (_eogDetector != NULL)
+		_eogDetector->Reset();
+	if (_qualityMonitor != NULL)
+		_qualityMonitor->Reset();
+	if (_envelope != NULL)
+		_envelope->Reset();
+	_featureLock.Unlock();
+
+	//readers wait for samples acquired from now on
+	_readNotifier.Reset();
+
+	//triggers are scheduled on the scans of this run
+	_triggerScheduler->Reset();
+	_triggerScheduler->Start(-1);
 
 	//reset event
 	_dataAcquisitionStopped.ResetEvent();
 
-	//create data acquisition thread with high priority
-	_dataAcquisitionThread = AfxBeginThread(StaticThreadProc, this, THREAD_PRIORITY_TIME_CRITICAL, 0, 0, NULL);
-	_dataAcquisitionThread->ResumeThread();
+	//hand the group to an I/O thread of the engine, or create data acquisition thread with high priority
+	if (_engine == NULL || !_engine->Attach(this, numDevices))
+	{
+		if (_engine != NULL)
+		{
+			// error 53
+			std::cout << "Error on AcquisitionEngine: no I/O thread can wait on " << numDevices << " more device(s), acquiring on a thread of its own." << "\n";
+		}
+		_dataAcquisitionThread = AfxBeginThread(StaticThreadProc, this, THREAD_PRIORITY_TIME_CRITICAL, 0, 0, NULL);
+		_dataAcquisitionThread->ResumeThread();
+	}
 
-	std::cout << " started!" << "\n";
+	std::cout << " started in " << ElapsedMs(startTime) << " ms (buffers " << (reused ? "reused" : "allocated") << ")!" << "\n";
 }
 
 //Starts the thread and generates a file from measured data
@@ -396,21 +764,56 @@ void DAQgUSBamp::StartAcquisition(const char *FileName)
 {  
 	std::cout << "opening file" << std::endl;
 
-	// check the output file
-	if (!outputFile.Open(FileName, CFile::modeCreate | CFile::modeWrite | CFile::typeBinary))
+	// Write file header
+	std::vector<char> header(3 * sizeof(int) + sizeof(UCHAR) + numChannels * sizeof(UCHAR));
+	memcpy(&header[0], &DAQ_VERSION, sizeof(int));
+	memcpy(&header[sizeof(int)], &SampleRate, sizeof(int));
+	memcpy(&header[2 * sizeof(int)], &numChannels, sizeof(UCHAR));
+	memcpy(&header[2 * sizeof(int) + sizeof(UCHAR)], &TRIGGER, sizeof(int));
+	memcpy(&header[3 * sizeof(int) + sizeof(UCHAR)], &channelsToAcquire[0], numChannels * sizeof(UCHAR));
+
+	// check the output file, the recorder writes it from its own thread, placed on its core and priority
+	SchedulingPolicy policy = _schedulingPolicy;
+	writeToFile = _recorder.Open(FileName, &header[0], (int) header.size(), _durabilityPolicy, [policy]()
+	{
+		if (policy.writerCpu >= 0)
+			ThreadScheduling::PinCurrentThread(policy.writerCpu);
+		if (policy.realTime)
+			ThreadScheduling::SetCurrentThreadRealTime(false);
+	});
+	if (!writeToFile)
 	{
 		// error 19
 		std::cout <<"Error on creating/opening output file: the file couldn't be opened." << "\n";
 	}
 
-	// Write file header
-	outputFile.Write(&DAQ_VERSION, 1 * sizeof(int));
-	outputFile.Write(&SampleRate, 1 * sizeof(int));
-	outputFile.Write(&numChannels, 1 * sizeof(UCHAR));
-	outputFile.Write(&TRIGGER, 1 * sizeof(int));
-	outputFile.Write(&channelsToAcquire[0], numChannels * sizeof(UCHAR));
+	//signal quality is logged next to the recording
+	_qualityLogName = std::string(FileName) + ".quality.csv";
+	_featureLock.Lock();
+	if (_qualityMonitor != NULL && !_qualityMonitor->OpenLog(_qualityLogName.c_str()))
+	{
+		// error 57
+		std::cout << "Error on creating the signal quality log " << _qualityLogName << "." << "\n";
+	}
+	_featureLock.Unlock();
 
-	writeToFile = true;
+	//and so is the envelope, for browsing the recording at any zoom
+	_envelopeFileName = std::string(FileName) + ".envelope";
+	_featureLock.Lock();
+	if (_envelope != NULL && !_envelope->OpenFile(_envelopeFileName.c_str()))
+	{
+		// error 62
+		std::cout << "Error on creating the envelope file " << _envelopeFileName << "." << "\n";
+	}
+	_featureLock.Unlock();
+
+	//with the time each scheduled trigger was written
+	_triggerLogName = std::string(FileName) + ".triggers.csv";
+	if (!_triggerScheduler->OpenLog(_triggerLogName.c_str()))
+	{
+		// error 65
+		std::cout << "Error on creating the trigger log " << _triggerLogName << "." << "\n";
+	}
 
 	// Call start acquisition method with no arguments
 	StartAcquisition();
@@ -420,304 +823,704 @@ void DAQgUSBamp::StartAcquisition(const char *FileName)
 //Stops the data acquisition thread
 void DAQgUSBamp::StopAcquisition()
 {
+	//no trigger is written once the devices stop, the ones still scheduled are cancelled
+	_triggerScheduler->Stop();
+
 	//tell thread to stop data acquisition
 	_isRunning = false;
 
 	//wait until the thread has stopped data acquisition
 	DWORD ret = WaitForSingleObject(_dataAcquisitionStopped.m_hObject, 60000);
 
-	//reset the main process (data processing thread) to normal priority
+	//release the readers still waiting, no more data will come
+	_readNotifier.Close();
+
+	//let the subscribers process the last blocks
+	_dispatcher->Flush();
+
+	//the last windows of signal quality have been logged
+	_featureLock.Lock();
+	if (_qualityMonitor != NULL)
+		_qualityMonitor->CloseLog();
+	_qualityLogName.clear();
+	if (_envelope != NULL)
+		_envelope->CloseFile();
+	_envelopeFileName.clear();
+	_featureLock.Unlock();
+	_triggerScheduler->CloseLog();
+	_triggerLogName.clear();
+
+	//reset the main process (data processing thread) to normal priority once no group is acquiring
 	HANDLE hProcess = GetCurrentProcess();
-	SetPriorityClass(hProcess, NORMAL_PRIORITY_CLASS);
+	_priorityLock.Lock();
+	if (_holdsPriority && --_numAcquiring == 0)
+		SetPriorityClass(hProcess, NORMAL_PRIORITY_CLASS);
+	_holdsPriority = false;
+	_priorityLock.Unlock();
 	//close output file
-	if (writeToFile)
-		outputFile.Close();
+	if (writeToFile && !_recorder.Close())
+	{
+		// error 67
+		std::cout << "Error on closing the recording: some blocks couldn't be written." << "\n";
+	}
 
+	//the application buffer is kept for the next run
 	_buffer.Reset();
+	_compactBuffer.Reset();
+	_readNotifier.Discard();
 
 	writeToFile = false;
 }
 
-UINT DAQgUSBamp::DoAcquisition()
+// Transfers queued for one device by the acquisition loop
+struct DAQgUSBamp::DeviceQueue
 {
-	int _trigger[MAX_NUMBER_OF_DEVICES];
-	int queueIndex = 0;
-	int _NPoints = NumScans * (numChannels + TRIGGER);
-	DWORD numBytesReceived = 0;
-	// This variable ....
-	const int QUEUE_SIZE = 4;
-
-	//create the temporary data buffers (the device will write data into those)
-	BYTE*** buffers = new BYTE**[numDevices];
-	OVERLAPPED** overlapped = new OVERLAPPED*[numDevices];
-
-	__try 
-	{
-		//for each device create a number of QUEUE_SIZE data buffers
-		for (int deviceIndex=0; deviceIndex < numDevices; deviceIndex++)
-		{
-			if (deviceIndex == numDevices-1)
-				_trigger[deviceIndex] = TRIGGER;
-			else 
-				_trigger[deviceIndex] = 0;
-
-			int nPoints = NumScans * (numChannelsPerAmp[deviceIndex] + _trigger[deviceIndex]);
-			DWORD bufferSizeBytes = HEADER_SIZE + nPoints * sizeof(float);
-
-			buffers[deviceIndex] = new BYTE*[QUEUE_SIZE];
-			overlapped[deviceIndex] = new OVERLAPPED[QUEUE_SIZE];
-
-			//for each data buffer allocate a number of bufferSizeBytes bytes
-			for (queueIndex=0; queueIndex < QUEUE_SIZE; queueIndex++)
-			{
-				buffers[deviceIndex][queueIndex] = new BYTE[bufferSizeBytes];
-				memset(&(overlapped[deviceIndex][queueIndex]), 0, sizeof(OVERLAPPED));
-
-				//create a windows event handle that will be signalled when new data from the device has been received for each data buffer
-				overlapped[deviceIndex][queueIndex].hEvent = CreateEvent(NULL, false, false, NULL);
-			}
-		}
+	// Transfer slots, circular: the count transfers in flight start at head (the oldest)
+	OVERLAPPED overlapped[MAX_QUEUE_SIZE];
+	BYTE *slotBuffers[MAX_QUEUE_SIZE];
+	int head;
+	int count;
 
-		//start the devices (master device must be started at last)
-		for (int deviceIndex=0; deviceIndex < numDevices; deviceIndex++)
-		{
-			int nPoints = NumScans * (numChannelsPerAmp[deviceIndex] + _trigger[deviceIndex]);
-			DWORD bufferSizeBytes = HEADER_SIZE + nPoints * sizeof(float);
+	// Received blocks waiting for the other devices, oldest first
+	std::deque<BYTE *> readyBuffers;
 
-			HANDLE hDevice = deviceHandleList[deviceIndex];
+	// Buffers neither queued nor ready
+	std::vector<BYTE *> freeBuffers;
 
-			if (!GT_Start(hDevice))
-			{
-				// error 20
-				std::cout << "\tError on GT_Start: Couldn't start data acquisition of device.\n";
-				return 0;
-			}
+	// Every buffer allocated for the device
+	std::vector<BYTE *> allBuffers;
 
-			//queue-up the first batch of transfer requests
-			for (queueIndex=0; queueIndex <QUEUE_SIZE; queueIndex++)
-			{
-				if (!GT_GetData(hDevice, buffers[deviceIndex][queueIndex], bufferSizeBytes, &overlapped[deviceIndex][queueIndex]))
-				{
-					// error 21
-					std::cout << "\tError on GT_GetData.\n";
-					return 0;
-				}
-			}
-		}
+	// Size of one transfer (header and scans) in bytes
+	DWORD bufferSizeBytes;
 
-		queueIndex = 0;
+	// Flag set if the buffers are locked in RAM
+	bool lockedBuffers;
 
-		//continouos data acquisition
-		while (_isRunning) 
-		{
-			//receive data from each device
-			for (int deviceIndex = 0; deviceIndex < numDevices; deviceIndex++)
-			{
-				int nPoints = NumScans * (numChannelsPerAmp[deviceIndex] + _trigger[deviceIndex]);
-				DWORD bufferSizeBytes = HEADER_SIZE + nPoints * sizeof(float);
+	// Number of blocks received
+	long long numReceived;
+};
 
-				//wait for notification from the system telling that new data is available
-				if (WaitForSingleObject(overlapped[deviceIndex][queueIndex].hEvent, 1000) == WAIT_TIMEOUT)
-				{
-					// error 22
-					std::cout << "Error on data transfer: timeout occurred." << "\n";
-					return 0;
-				}
-				//get number of received bytes...
-				GetOverlappedResult(deviceHandleList[deviceIndex], &overlapped[deviceIndex][queueIndex], &numBytesReceived, false);
-			
-				//check if we lost something (number of received bytes must be equal to the previously allocated buffer size)
-				if (numBytesReceived != bufferSizeBytes)
-				{
-					// error 23
-					std::cout << "Error on data transfer: samples lost." << "\n";
-					return 0;
-				}
-			}
+bool DAQgUSBamp::QueueTransfer(DeviceQueue *queue, HANDLE hDevice)
+{
+	if (queue->count >= MAX_QUEUE_SIZE)
+		return false;
 
-			//to store the received data into the application data buffer at once, lock it
-			_bufferLock.Lock();
+	//reuse a buffer that has been merged already, allocate one if all are in use
+	BYTE *buffer;
+	if (queue->freeBuffers.empty())
+	{
+		buffer = new BYTE[queue->bufferSizeBytes];
+		queue->allBuffers.push_back(buffer);
 
-			float * bufferAddress;
+		//the device writes it from the driver, keep it mapped
+		if (queue->lockedBuffers)
+			ThreadScheduling::LockMemory(buffer, queue->bufferSizeBytes);
+	}
+	else
+	{
+		buffer = queue->freeBuffers.back();
+		queue->freeBuffers.pop_back();
+	}
 
-			__try 
-			{
-				//if we are going to overrun on writing the received data into the buffer, set the appropriate flag; the reading thread will handle the overrun
-				_bufferOverrun = (_buffer.GetFreeSize() < _NPoints);
+	int slot = (queue->head + queue->count) % MAX_QUEUE_SIZE;
+	if (!_driver->GetData(hDevice, buffer, queue->bufferSizeBytes, &queue->overlapped[slot]))
+	{
+		queue->freeBuffers.push_back(buffer);
+		return false;
+	}
 
-				//store received data from each device in the correct order (that is scan-wise, where one scan includes all channels of all devices) ignoring the header
-				for (int scanIndex = 0; scanIndex < NumScans; scanIndex++)
-				{
-					// start from master
-					for (int deviceIndex=numDevices-1; deviceIndex >= 0; deviceIndex--)
-					{
-						// get address of data 
-						bufferAddress = (float*) (buffers[deviceIndex][queueIndex] + scanIndex * (numChannelsPerAmp[deviceIndex] + _trigger[deviceIndex]) * sizeof(float) + HEADER_SIZE);
-
-						// if device index is master
-						if (deviceIndex==numDevices-1)
-						{
-							// write only channel data
-							_buffer.Write(bufferAddress, numChannelsPerAmp[deviceIndex]);
-							if (writeToFile)
-								outputFile.Write(bufferAddress, numChannelsPerAmp[deviceIndex] * sizeof(float));
-						} // for the other devices
-						else 
-						{
-							// write the data and triggers (none existing in current implementation)
-							_buffer.Write(bufferAddress, numChannelsPerAmp[deviceIndex] + _trigger[deviceIndex]);
-							if (writeToFile)
-								outputFile.Write(bufferAddress, (numChannelsPerAmp[deviceIndex] + _trigger[deviceIndex]) * sizeof(float));
-						}
-						
-					}
-					
-					// after all devices have been process, write trigger data only
-					bufferAddress = (float*) (buffers[numDevices-1][queueIndex] + numChannelsPerAmp[numDevices-1] * sizeof(float) + scanIndex * (numChannelsPerAmp[numDevices-1] + _trigger[numDevices-1]) * sizeof(float) + HEADER_SIZE);
-					_buffer.Write(bufferAddress, _trigger[numDevices-1]);
-					if (writeToFile)
-						outputFile.Write(bufferAddress, (_trigger[numDevices-1]) * sizeof(float));
-				}
-			} 
-			__finally 
-			{
-				//release the previously acquired lock
-				_bufferLock.Unlock();
-			}
+	queue->slotBuffers[slot] = buffer;
+	queue->count++;
+	return true;
+}
 
-			//add new GetData call to the queue replacing the currently received one
-			for (int deviceIndex = 0; deviceIndex < numDevices; deviceIndex++)
-			{
-				int nPoints = NumScans * (numChannelsPerAmp[deviceIndex] + _trigger[deviceIndex]);
-				DWORD bufferSizeBytes = HEADER_SIZE + nPoints * sizeof(float);
+bool DAQgUSBamp::PrepareQueues()
+{
+	bool reusable = (_queues != NULL && _numQueues == numDevices);
+	for (int deviceIndex=0; reusable && deviceIndex < numDevices; deviceIndex++)
+	{
+		int trigger = (deviceIndex == numDevices-1) ? TRIGGER : 0;
+		reusable = _queues[deviceIndex].bufferSizeBytes == HEADER_SIZE + NumScans * (numChannelsPerAmp[deviceIndex] + trigger) * sizeof(float)
+			&& _queues[deviceIndex].lockedBuffers == _schedulingPolicy.lockMemory;
+	}
 
-				if (!GT_GetData(deviceHandleList[deviceIndex], buffers[deviceIndex][queueIndex], bufferSizeBytes, &overlapped[deviceIndex][queueIndex]))
-				{
-					// error 24
-					std::cout << "\tError on GT_GetData.\n";
+	if (!reusable)
+	{
+		ReleaseQueues();
 
-					return 0;
-				}
-			}
+		//the events of all transfer slots are created once, buffers are allocated when transfers are queued
+		_queues = new DeviceQueue[numDevices];
+		_numQueues = numDevices;
+		for (int deviceIndex=0; deviceIndex < numDevices; deviceIndex++)
+		{
+			int trigger = (deviceIndex == numDevices-1) ? TRIGGER : 0;
+			_queues[deviceIndex].bufferSizeBytes = HEADER_SIZE + NumScans * (numChannelsPerAmp[deviceIndex] + trigger) * sizeof(float);
+			_queues[deviceIndex].lockedBuffers = _schedulingPolicy.lockMemory;
 
-			//signal processing (main) thread that new data is available
-			_newDataAvailable.SetEvent();
-			
-			//increment circular queueIndex to process the next queue at the next loop repitition (on overrun start at index 0 again)
-			queueIndex = (queueIndex + 1) % QUEUE_SIZE;
+			//create a windows event handle that will be signalled when new data from the device has been received for each slot
+			for (int slot=0; slot < MAX_QUEUE_SIZE; slot++)
+				_queues[deviceIndex].overlapped[slot].hEvent = CreateEvent(NULL, false, false, NULL);
 		}
 	}
-	__finally
-	{
-		std::cout << "Stopping devices and cleaning up..." << "\n";
 
-		//clean up allocated resources for each device
-		for (int i=0; i < numDevices; i++)
+	//start from empty queues, every buffer is free
+	for (int deviceIndex=0; deviceIndex < numDevices; deviceIndex++)
+	{
+		DeviceQueue *queue = &_queues[deviceIndex];
+		queue->head = 0;
+		queue->count = 0;
+		queue->numReceived = 0;
+		queue->readyBuffers.clear();
+		queue->freeBuffers = queue->allBuffers;
+
+		for (int slot=0; slot < MAX_QUEUE_SIZE; slot++)
 		{
-
-			//clean up allocated resources for each queue per device
-			for (int j=0; j < QUEUE_SIZE; j++)
-			{
-				WaitForSingleObject(overlapped[i][queueIndex].hEvent, 1000);
-				CloseHandle(overlapped[i][queueIndex].hEvent);
-
-				delete [] buffers[i][queueIndex];
-
-				//increment queue index
-				queueIndex = (queueIndex + 1) % QUEUE_SIZE;
-			}
-
-			//stop device
-			GT_Stop(deviceHandleList[i]);
-
-			//reset device
-			GT_ResetTransfer(deviceHandleList[i]);
-
-			delete [] overlapped[i];
-			delete [] buffers[i];
+			HANDLE hEvent = queue->overlapped[slot].hEvent;
+			memset(&queue->overlapped[slot], 0, sizeof(OVERLAPPED));
+			queue->overlapped[slot].hEvent = hEvent;
+			ResetEvent(hEvent);
+			queue->slotBuffers[slot] = NULL;
 		}
-
-		delete [] buffers;
-		delete [] overlapped;
-
-		//reset _isRunning flag
-		_isRunning = false;
-
-		//signal event
-		_dataAcquisitionStopped.SetEvent();
-
-		//end thread
-		AfxEndThread(0xdead);
 	}
 
-	return 0xdead;
+	return reusable;
 }
 
-UINT DAQgUSBamp::StaticThreadProc(LPVOID param)
+void DAQgUSBamp::ReleaseQueues()
 {
-	// Cast user parameter to type DAQgUSBamp
-	DAQgUSBamp* pThis = reinterpret_cast<DAQgUSBamp*>(param);
-	if ( pThis != NULL )
+	for (int i=0; i < _numQueues; i++)
 	{
-		// Run acquisition loop
-		pThis->DoAcquisition();
+		for (int slot=0; slot < MAX_QUEUE_SIZE; slot++)
+			CloseHandle(_queues[i].overlapped[slot].hEvent);
+
+		for (size_t j=0; j < _queues[i].allBuffers.size(); j++)
+		{
+			if (_queues[i].lockedBuffers)
+				ThreadScheduling::UnlockMemory(_queues[i].allBuffers[j], _queues[i].bufferSizeBytes);
+			delete [] _queues[i].allBuffers[j];
+		}
 	}
 
-	return (0);
+	delete [] _queues;
+	_queues = NULL;
+	_numQueues = 0;
 }
 
-bool DAQgUSBamp::GetDataFromBuffer(float *destBuffer, int NumSamples)
+bool DAQgUSBamp::BeginAcquisition()
 {
-	int validPoints = (numChannels + TRIGGER) * NumSamples;
-	
-	//wait until requested amount of data is ready
-	if (_buffer.GetSize() < validPoints)
+	DeviceQueue *queues = _queues;
+
+	_transferLock.Lock();
+	_acquisitionThreadId = ThreadScheduling::CurrentThreadId();
+	_startContextSwitches = ThreadScheduling::ThreadContextSwitches(_acquisitionThreadId);
+	_endContextSwitches = -1;
+	_transferLock.Unlock();
+
+	//only the master device sends the trigger
+	for (int deviceIndex=0; deviceIndex < numDevices; deviceIndex++)
 	{
-		// error 25
-		std::cout << "Not enough data available"<< "\n";
-		return false;
+		if (deviceIndex == numDevices-1)
+			_deviceTrigger[deviceIndex] = TRIGGER;
+		else 
+			_deviceTrigger[deviceIndex] = 0;
 	}
 
-	//acquire lock on the application buffer for reading
-	_bufferLock.Lock();
+	//the merge kernel is chosen once for this configuration of devices, channels and trigger
+	int deviceChannels[MAX_NUMBER_OF_DEVICES];
+	for (int deviceIndex = 0; deviceIndex < numDevices; deviceIndex++)
+		deviceChannels[deviceIndex] = numChannelsPerAmp[deviceIndex];
+	_interleaver.Configure(numDevices, deviceChannels, TRIGGER != 0);
 
-	__try
+	//start the devices (master device must be started at last)
+	for (int deviceIndex=0; deviceIndex < numDevices; deviceIndex++)
 	{
-		//if buffer run over report error and reset buffer
-		if (_bufferOverrun)
-		{
-			_buffer.Reset();
-			// error 26
-			std::cout << "Error on reading data from the application data buffer: buffer overrun."<< "\n";
+		HANDLE hDevice = deviceHandleList[deviceIndex];
 
-			_bufferOverrun = false;
+		if (!_driver->Start(hDevice))
+		{
+			// error 20
+			std::cout << "\tError on GT_Start: Couldn't start data acquisition of device.\n";
 			return false;
 		}
 
-		//copy the data from the application buffer into the destination buffer
-		_buffer.Read(destBuffer, validPoints);
+		//queue-up the first batch of transfer requests
+		while (queues[deviceIndex].count < _deviceQueueDepth[deviceIndex])
+		{
+			if (!QueueTransfer(&queues[deviceIndex], hDevice))
+			{
+				// error 21
+				std::cout << "\tError on GT_GetData.\n";
+				return false;
+			}
+		}
 	}
-	__finally
+
+	QueryPerformanceFrequency(&_counterFrequency);
+	QueryPerformanceCounter(&_startCounter);
+	_lastCompletionSeconds = 0;
+	return true;
+}
+
+int DAQgUSBamp::HeadEvents(HANDLE *events)
+{
+	//transfers of one device complete in order, so waiting for the oldest one of each device is enough
+	for (int deviceIndex = 0; deviceIndex < numDevices; deviceIndex++)
+		events[deviceIndex] = _queues[deviceIndex].overlapped[_queues[deviceIndex].head].hEvent;
+
+	return numDevices;
+}
+
+bool DAQgUSBamp::CompleteTransfer(int deviceIndex)
+{
+	int _NPoints = NumScans * (numChannels + TRIGGER);
+	DWORD numBytesReceived = 0;
+	LARGE_INTEGER counter;
+	DeviceQueue *queues = _queues;
+	DeviceQueue *queue = &queues[deviceIndex];
+
+	//get number of received bytes...
+	_driver->GetOverlappedResult(deviceHandleList[deviceIndex], &queue->overlapped[queue->head], &numBytesReceived, false);
+
+	//check if we lost something (number of received bytes must be equal to the previously allocated buffer size)
+	if (numBytesReceived != queue->bufferSizeBytes)
+	{
+		// error 23
+		std::cout << "Error on data transfer: samples lost." << "\n";
+		return false;
+	}
+
+	//keep the block until the other devices have received theirs and re-arm the device right away
+	queue->readyBuffers.push_back(queue->slotBuffers[queue->head]);
+	queue->slotBuffers[queue->head] = NULL;
+	queue->head = (queue->head + 1) % MAX_QUEUE_SIZE;
+	queue->count--;
+
+	if (!QueueTransfer(queue, deviceHandleList[deviceIndex]))
+	{
+		// error 24
+		std::cout << "\tError on GT_GetData.\n";
+		return false;
+	}
+
+	//record the completion time and deepen the queue if completions are getting late
+	double completionTime = TriggerScheduler::Now();
+	QueryPerformanceCounter(&counter);
+	double seconds = (double) (counter.QuadPart - _startCounter.QuadPart) / _counterFrequency.QuadPart;
+	_lastCompletionSeconds = seconds;
+
+	_transferLock.Lock();
+	_transferMonitors[deviceIndex].AddCompletion(queue->numReceived, seconds);
+	if (_adaptiveQueue)
+		_deviceQueueDepth[deviceIndex] = _transferMonitors[deviceIndex].RecommendDepth(_deviceQueueDepth[deviceIndex], _maxQueueDepth);
+	int queueDepth = _deviceQueueDepth[deviceIndex];
+	_transferLock.Unlock();
+
+	queue->numReceived++;
+
+	while (queue->count < queueDepth)
+	{
+		if (!QueueTransfer(queue, deviceHandleList[deviceIndex]))
+		{
+			// error 24
+			std::cout << "\tError on GT_GetData.\n";
+			return false;
+		}
+	}
+
+	//merge as soon as every device has received the next block
+	bool blockReady = true;
+	for (int i = 0; i < numDevices; i++)
+		blockReady = blockReady && !queues[i].readyBuffers.empty();
+
+	if (!blockReady)
+		return true;
+
+	//merge received data from each device in the correct order (that is scan-wise, where one scan includes all channels of all devices) ignoring the header
+	//merge straight into a dispatcher buffer, so the subscribers get the block without a copy
+	float * mergedBlock = _dispatcher->AcquireBlock(_NPoints);
+	const float * deviceBlocks[MAX_NUMBER_OF_DEVICES];
+	for (int i = 0; i < numDevices; i++)
+		deviceBlocks[i] = (const float *) (queues[i].readyBuffers.front() + HEADER_SIZE);
+	_interleaver.Interleave(deviceBlocks, NumScans, mergedBlock);
+
+	//the merged buffers can be queued again
+	for (int i = 0; i < numDevices; i++)
+	{
+		queues[i].freeBuffers.push_back(queues[i].readyBuffers.front());
+		queues[i].readyBuffers.pop_front();
+	}
+
+	//in compact storage, convert the block before taking the lock
+	bool compact = (_codec.Storage() != STORAGE_FLOAT32);
+	long long numClipped = compact ? _codec.Encode(mergedBlock, NumScans, &_compactWrite[0]) : 0;
+
+	//to store the merged block into the application data buffer at once, lock it
+	_bufferLock.Lock();
+
+	__try 
+	{
+		//if we are going to overrun on writing the received data into the buffer, set the appropriate flag; the reading thread will handle the overrun
+		if (compact)
+		{
+			_bufferOverrun = (_compactBuffer.GetFreeSize() < _NPoints);
+			_compactBuffer.Write(&_compactWrite[0], _NPoints);
+			_numClipped += numClipped;
+		}
+		else
+		{
+			_bufferOverrun = (_buffer.GetFreeSize() < _NPoints);
+			_buffer.Write(mergedBlock, _NPoints);
+		}
+
+		//wake the readers whose sample count or trigger has just been written
+		_readNotifier.Publish(mergedBlock, NumScans, numChannels + TRIGGER, TRIGGER ? numChannels : -1);
+	} 
+	__finally 
 	{
+		//release the previously acquired lock
 		_bufferLock.Unlock();
 	}
+
+	//copy the whole block to the recorder, its thread writes it
+	if (writeToFile)
+		_recorder.Append(mergedBlock, _NPoints);
+
+	//hand the block to the subscribers, their callbacks run on the dispatch threads
+	_dispatcher->Publish(NumScans, numChannels + TRIGGER);
+
+	_transferLock.Lock();
+	long long numBlocks = ++_numBlocks;
+	_transferLock.Unlock();
+
+	//the scan clock of the scheduled triggers, from the completion of the last device of the block
+	_triggerScheduler->AddBlock(numBlocks * NumScans, completionTime);
+
+	return true;
+}
+
+void DAQgUSBamp::DrainTransfer(int deviceIndex)
+{
+	DeviceQueue *queue = &_queues[deviceIndex];
+	if (queue->count == 0)
+		return;
+
+	//the block is not stored any more, its buffer goes back to the pool
+	DWORD numBytesReceived = 0;
+	_driver->GetOverlappedResult(deviceHandleList[deviceIndex], &queue->overlapped[queue->head], &numBytesReceived, false);
+	queue->freeBuffers.push_back(queue->slotBuffers[queue->head]);
+	queue->slotBuffers[queue->head] = NULL;
+	queue->head = (queue->head + 1) % MAX_QUEUE_SIZE;
+	queue->count--;
+
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter(&counter);
+	_lastCompletionSeconds = (double) (counter.QuadPart - _startCounter.QuadPart) / _counterFrequency.QuadPart;
+}
+
+int DAQgUSBamp::TransfersInFlight()
+{
+	int numTransfers = 0;
+	for (int deviceIndex = 0; deviceIndex < numDevices; deviceIndex++)
+		numTransfers += _queues[deviceIndex].count;
+	return numTransfers;
+}
+
+bool DAQgUSBamp::CheckTransferTimeout(int timeoutMs)
+{
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter(&counter);
+	double seconds = (double) (counter.QuadPart - _startCounter.QuadPart) / _counterFrequency.QuadPart;
+
+	if (1000 * (seconds - _lastCompletionSeconds) > timeoutMs)
+	{
+		//a replayed recording has ended, not an error
+		if (_driver->Finished())
+			std::cout << "Replay finished, no more data." << "\n";
+		else
+		{
+			// error 22
+			std::cout << "Error on data transfer: timeout occurred." << "\n";
+		}
+		return false;
+	}
+
+	return true;
+}
+
+void DAQgUSBamp::EndAcquisition()
+{
+	std::cout << "Stopping devices and cleaning up..." << "\n";
+
+	//clean up allocated resources for each device
+	for (int i=0; i < numDevices; i++)
+	{
+		//wait for the transfers still in flight
+		for (int j=0; j < _queues[i].count; j++)
+			WaitForSingleObject(_queues[i].overlapped[(_queues[i].head + j) % MAX_QUEUE_SIZE].hEvent, 1000);
+
+		//stop device
+		_driver->Stop(deviceHandleList[i]);
+
+		//reset device
+		_driver->ResetTransfer(deviceHandleList[i]);
+	}
+
+	//buffers and events stay in the pool for the next run, PrepareQueues frees them all
+
+	//the count of the thread can't be read once it has ended
+	_transferLock.Lock();
+	if (_acquisitionThreadId >= 0)
+		_endContextSwitches = ThreadScheduling::ThreadContextSwitches(_acquisitionThreadId);
+	_transferLock.Unlock();
+
+	//reset _isRunning flag
+	_isRunning = false;
+
+	//signal event
+	_dataAcquisitionStopped.SetEvent();
+}
+
+UINT DAQgUSBamp::DoAcquisition()
+{
+	HANDLE headEvents[MAX_NUMBER_OF_DEVICES];
+
+	__try 
+	{
+		//place this thread on its core and priority, the recording is written by the recorder thread
+		if (_schedulingPolicy.acquisitionCpu >= 0 && !ThreadScheduling::PinCurrentThread(_schedulingPolicy.acquisitionCpu))
+		{
+			// error 50
+			std::cout << "Error on PinCurrentThread: the acquisition thread couldn't be pinned to core " << _schedulingPolicy.acquisitionCpu << "." << "\n";
+		}
+		if (_schedulingPolicy.realTime && !ThreadScheduling::SetCurrentThreadRealTime(true))
+		{
+			// error 68
+			std::cout << "Error on SetCurrentThreadRealTime: the acquisition thread couldn't be given real-time priority." << "\n";
+		}
+
+		if (!BeginAcquisition())
+			return 0;
+
+		//continouos data acquisition, each completion is handled as soon as it is signalled
+		while (_isRunning) 
+		{
+			int numEvents = HeadEvents(headEvents);
+
+			//wait for notification from the system telling that new data is available on any device
+			DWORD waitResult = WaitForMultipleObjects(numEvents, headEvents, false, 1000);
+			if (waitResult - WAIT_OBJECT_0 >= (DWORD) numEvents)
+			{
+				//a replayed recording has ended, not an error
+				if (_driver->Finished())
+					std::cout << "Replay finished, no more data." << "\n";
+				else
+				{
+					// error 22
+					std::cout << "Error on data transfer: timeout occurred." << "\n";
+				}
+				return 0;
+			}
+
+			if (!CompleteTransfer(waitResult - WAIT_OBJECT_0))
+				return 0;
+		}
+	}
+	__finally
+	{
+		EndAcquisition();
+
+		//end thread
+		AfxEndThread(0xdead);
+	}
+
+	return 0xdead;
+}
+
+UINT DAQgUSBamp::StaticThreadProc(LPVOID param)
+{
+	// Cast user parameter to type DAQgUSBamp
+	DAQgUSBamp* pThis = reinterpret_cast<DAQgUSBamp*>(param);
+	if ( pThis != NULL )
+	{
+		// Run acquisition loop
+		pThis->DoAcquisition();
+	}
+
+	return (0);
+}
+
+bool DAQgUSBamp::GetDataFromBuffer(float *destBuffer, int NumSamples)
+{
+	int validPoints = (numChannels + TRIGGER) * NumSamples;
+	bool compact = (_codec.Storage() != STORAGE_FLOAT32);
+
+	//compact values are copied under the buffer lock and converted after it, other readers wait until they are
+	_readLock.Lock();
+
+	__try
+	{
+		if (compact && (int) _compactRead.size() < validPoints)
+			_compactRead.resize(validPoints);
+
+		//acquire lock on the application buffer for reading
+		_bufferLock.Lock();
+
+		__try
+		{
+			//another reader may have taken the samples this one waited for
+			if (BufferedValues() < validPoints)
+			{
+				// error 25
+				std::cout << "Not enough data available"<< "\n";
+				return false;
+			}
+
+			//if buffer run over report error and reset buffer
+			if (_bufferOverrun)
+			{
+				_buffer.Reset();
+				_compactBuffer.Reset();
+				_readNotifier.Discard();
+				// error 26
+				std::cout << "Error on reading data from the application data buffer: buffer overrun."<< "\n";
+
+				_bufferOverrun = false;
+				return false;
+			}
+
+			//copy the data from the application buffer into the destination buffer
+			if (compact)
+				_compactBuffer.Read(&_compactRead[0], validPoints);
+			else
+				_buffer.Read(destBuffer, validPoints);
+			_readNotifier.Consume(NumSamples);
+		}
+		__finally
+		{
+			_bufferLock.Unlock();
+		}
+
+		if (compact)
+			_codec.Decode(&_compactRead[0], NumSamples, destBuffer);
+	}
+	__finally
+	{
+		_readLock.Unlock();
+	}
+	return true;
+}
+
+bool DAQgUSBamp::GetChannelsFromBuffer(float *destBuffer, int NumSamples, const int *channels, int numSelected)
+{
+	int scanStride = numChannels + TRIGGER;
+	int validPoints = scanStride * NumSamples;
+	bool compact = (_codec.Storage() != STORAGE_FLOAT32);
+
+	//compact values are copied under the buffer lock, decoded and gathered after it, other readers wait until they are
+	_readLock.Lock();
+
+	__try
+	{
+		if (compact && (int) _compactRead.size() < validPoints)
+			_compactRead.resize(validPoints);
+		if (compact && (int) _decodedRead.size() < validPoints)
+			_decodedRead.resize(validPoints);
+
+		//acquire lock on the application buffer for reading
+		_bufferLock.Lock();
+
+		__try
+		{
+			//another reader may have taken the samples this one waited for
+			if (BufferedValues() < validPoints)
+			{
+				// error 25
+				std::cout << "Not enough data available"<< "\n";
+				return false;
+			}
+
+			//if buffer run over report error and reset buffer
+			if (_bufferOverrun)
+			{
+				_buffer.Reset();
+				_compactBuffer.Reset();
+				_readNotifier.Discard();
+				// error 26
+				std::cout << "Error on reading data from the application data buffer: buffer overrun."<< "\n";
+
+				_bufferOverrun = false;
+				return false;
+			}
+
+			if (compact)
+				_compactBuffer.Read(&_compactRead[0], validPoints);
+			else
+			{
+				//gather straight out of the ring, in two parts if the samples wrap around (the ring holds whole scans,
+				//so the wrap falls between two scans)
+				float *firstPart, *secondPart;
+				int firstScans = _buffer.GetReadParts(validPoints, &firstPart, &secondPart) / scanStride;
+				ChannelGather::Gather(firstPart, firstScans, scanStride, channels, numSelected, destBuffer, NumSamples);
+				ChannelGather::Gather(secondPart, NumSamples - firstScans, scanStride, channels, numSelected, destBuffer + firstScans, NumSamples);
+				_buffer.Skip(validPoints);
+			}
+			_readNotifier.Consume(NumSamples);
+		}
+		__finally
+		{
+			_bufferLock.Unlock();
+		}
+
+		if (compact)
+		{
+			_codec.Decode(&_compactRead[0], NumSamples, &_decodedRead[0]);
+			ChannelGather::Gather(&_decodedRead[0], NumSamples, scanStride, channels, numSelected, destBuffer, NumSamples);
+		}
+	}
+	__finally
+	{
+		_readLock.Unlock();
+	}
 	return true;
 }
 
+void *DAQgUSBamp::BufferData()
+{
+	if (_codec.Storage() != STORAGE_FLOAT32)
+		return _compactBuffer.Data();
+	return _buffer.Data();
+}
+
+size_t DAQgUSBamp::BufferBytes()
+{
+	if (_codec.Storage() != STORAGE_FLOAT32)
+		return _compactBuffer.GetCapacity() * sizeof(uint16_t);
+	return _buffer.GetCapacity() * sizeof(float);
+}
+
+int DAQgUSBamp::BufferedValues()
+{
+	if (_codec.Storage() != STORAGE_FLOAT32)
+		return _compactBuffer.GetSize();
+	return _buffer.GetSize();
+}
+
 int DAQgUSBamp::AvailableSamples()
 { 
 	int numberOfSamples;
-	numberOfSamples = _buffer.GetSize() / (numChannels + TRIGGER);
+	numberOfSamples = BufferedValues() / (numChannels + TRIGGER);
 	return numberOfSamples;
 }
 
 void DAQgUSBamp::GetData(float * destBuffer, int  NumSamples)
 {
 	
-	//to stop the application after a specified time, get start time
-	while (AvailableSamples() < NumSamples)
+	//sleep until the acquisition loop has written the requested amount of data
+	if (!WaitForSamples(NumSamples, -1))
 	{
-		WaitForSingleObject(_newDataAvailable.m_hObject, 100);
+		// error 46
+		std::cout << "Acquisition stopped before " << NumSamples << " samples were available" << "\n";
+		return;
 	}
 	
 	//read data from the application buffer and stop application if buffer overrun
@@ -725,35 +1528,876 @@ void DAQgUSBamp::GetData(float * destBuffer, int  NumSamples)
 
 }
 
+bool DAQgUSBamp::GetChannelData(float *destBuffer, int NumSamples, std::vector<int> channels)
+{
+	for (size_t i = 0; i < channels.size(); i++)
+	{
+		if (channels[i] < 0 || channels[i] >= numChannels + TRIGGER)
+		{
+			// error 55
+			std::cout << "Error on GetChannelData: channel " << channels[i] << " out of range (0 to " << numChannels + TRIGGER - 1 << ")." << "\n";
+			return false;
+		}
+	}
+
+	//sleep until the acquisition loop has written the requested amount of data
+	if (!WaitForSamples(NumSamples, -1))
+	{
+		// error 46
+		std::cout << "Acquisition stopped before " << NumSamples << " samples were available" << "\n";
+		return false;
+	}
+
+	//read the channels from the application buffer, the samples are consumed even if no channel is selected
+	return GetChannelsFromBuffer(destBuffer, NumSamples, channels.empty() ? NULL : &channels[0], (int) channels.size());
+}
+
+bool DAQgUSBamp::WaitForSamples(int numSamples, int timeoutMs)
+{
+	return _readNotifier.WaitForSamples(numSamples, timeoutMs);
+}
+
+int DAQgUSBamp::WaitForTrigger(int triggerValue, int timeoutMs)
+{
+	if (!TRIGGER)
+	{
+		// error 47
+		std::cout << "WaitForTrigger needs the trigger channel" << "\n";
+		return -1;
+	}
+
+	return (int) _readNotifier.WaitForTrigger(triggerValue, timeoutMs);
+}
+
 void DAQgUSBamp::SendTrigger(bool * state)
 {
-	
-	DigitalOUT dout = {1, state[0], 1, state[1], 1, state[2], 1, state[3]};
+	if (TRIGGER)
+		WriteTrigger((state[0] ? 1 : 0) + (state[1] ? 2 : 0) + (state[2] ? 4 : 0) + (state[3] ? 8 : 0));
+}
+
+bool DAQgUSBamp::WriteTrigger(int value)
+{
+	DigitalOUT dout = {1, (value & 1) != 0, 1, (value & 2) != 0, 1, (value & 4) != 0, 1, (value & 8) != 0};
+
 	//select master device 
+	_triggerLock.Lock();
 	HANDLE hDevice = deviceHandleList[numDevices-1];
-	if (TRIGGER)
-		BOOL status = GT_SetDigitalOutEx(hDevice, dout);	
-	
+	BOOL status = _driver->SetDigitalOutEx(hDevice, dout);
+	_triggerLock.Unlock();
+
+	return status != FALSE;
 }
 
-void DAQgUSBamp::CloseDevice()
+bool DAQgUSBamp::UseSimulatedDevice(int numDevices, double jitterMs, double stallProbability, double maxStallMs, double loopbackDelayMs)
 {
-	std::cout << "Closing devices...\n";
-	while (!deviceHandleList.empty())
+	if (!deviceHandleList.empty() || numDevices < 1 || numDevices > MAX_NUMBER_OF_DEVICES || jitterMs < 0 || stallProbability < 0 || stallProbability > 1 || maxStallMs < 0 || loopbackDelayMs < 0)
 	{
-		//closes each opened device and removes it from the call sequence
-		GT_Stop(&deviceHandleList.front());
-		BOOL ret = GT_CloseDevice(&deviceHandleList.front());
-		deviceHandleList.pop_front();
+		// error 40
+		std::cout << "Error on UseSimulatedDevice: devices already open or invalid number of devices, jitter or loopback delay." << "\n";
+		return false;
 	}
 
-	deviceSerialList.clear();
+	delete _driver;
+	_driver = new SimulatedAmpDriver(numDevices, jitterMs, stallProbability, maxStallMs, loopbackDelayMs);
+
+	//serials found by a previous scan belong to the other driver
+	ClearDeviceInventory();
+
+	std::cout << "Using " << numDevices << " simulated device(s)\n";
+	return true;
+}
+
+bool DAQgUSBamp::UseReplayDevice(const char *fileName, double speed, bool loop)
+{
+	ReplayAmpDriver *replayDriver = new ReplayAmpDriver(speed, loop);
+
+	if (!deviceHandleList.empty() || speed < 0 || !replayDriver->Open(fileName))
+	{
+		// error 63
+		std::cout << "Error on UseReplayDevice: devices already open, invalid speed or the recording " << fileName << " couldn't be read." << "\n";
+		delete replayDriver;
+		return false;
+	}
+
+	delete _driver;
+	_driver = replayDriver;
+
+	//serials found by a previous scan belong to the other driver
+	ClearDeviceInventory();
+
+	std::cout << "Replaying " << fileName << " (" << replayDriver->NumAmplifiers() << " device(s), " << replayDriver->NumScans() << " scans) ";
+	if (speed > 0)
+		std::cout << "at " << speed << "x real time" << (loop ? ", looped" : "") << "\n";
+	else
+		std::cout << "as fast as possible" << (loop ? ", looped" : "") << "\n";
+	return true;
+}
+
+bool DAQgUSBamp::ReplayFinished()
+{
+	return _driver->Finished();
+}
+
+bool DAQgUSBamp::SetBlockPolicy(BlockPolicy blockPolicy)
+{
+	if (!deviceHandleList.empty() || blockPolicy.blockScans < 0 || blockPolicy.blockScans > MAX_BLOCK_SCANS || blockPolicy.queueDepth < 1 || blockPolicy.queueDepth > MAX_QUEUE_SIZE || blockPolicy.wakeBlocks < 1)
+	{
+		// error 42
+		std::cout << "Error on SetBlockPolicy: devices already open or block size (up to " << MAX_BLOCK_SCANS << " scans), queue depth or wake-up out of range." << "\n";
+		return false;
+	}
+
+	NumScans = (blockPolicy.blockScans > 0) ? blockPolicy.blockScans : SampleRate / 32;
+	_readNotifier.SetWakeBlocks(blockPolicy.wakeBlocks);
+	_queueDepth = blockPolicy.queueDepth;
+	_maxQueueDepth = _adaptiveQueue ? (std::max)(_maxQueueDepth, _queueDepth) : _queueDepth;
+	return true;
+}
+
+int DAQgUSBamp::BlockScans()
+{
+	return NumScans;
+}
+
+bool DAQgUSBamp::SetQueueDepth(int depth, int maxDepth, bool adaptive)
+{
+	//0 keeps the depth of the block policy
+	if (depth == 0)
+		depth = _queueDepth;
+
+	if (_isRunning || depth < 1 || depth > MAX_QUEUE_SIZE || (adaptive && (maxDepth < depth || maxDepth > MAX_QUEUE_SIZE)))
+	{
+		// error 41
+		std::cout << "Error on SetQueueDepth: acquisition running or depth out of range (1 to " << MAX_QUEUE_SIZE << ")." << "\n";
+		return false;
+	}
+
+	_queueDepth = depth;
+	_maxQueueDepth = adaptive ? maxDepth : depth;
+	_adaptiveQueue = adaptive;
+	return true;
+}
+
+int DAQgUSBamp::NumDevices()
+{
+	return numDevices;
+}
+
+long long DAQgUSBamp::GetTransferStats(int *queueDepth, double *latencyMs, long long *numBlocks)
+{
+	_transferLock.Lock();
+	for (int deviceIndex = 0; deviceIndex < numDevices; deviceIndex++)
+	{
+		//before the first start report the configured depth
+		if (deviceIndex >= (int) _transferMonitors.size())
+		{
+			queueDepth[deviceIndex] = _queueDepth;
+			latencyMs[3 * deviceIndex] = latencyMs[3 * deviceIndex + 1] = latencyMs[3 * deviceIndex + 2] = 0;
+			continue;
+		}
+
+		queueDepth[deviceIndex] = _deviceQueueDepth[deviceIndex];
+		latencyMs[3 * deviceIndex] = 1000 * _transferMonitors[deviceIndex].LatencyPercentile(50);
+		latencyMs[3 * deviceIndex + 1] = 1000 * _transferMonitors[deviceIndex].LatencyPercentile(95);
+		latencyMs[3 * deviceIndex + 2] = 1000 * _transferMonitors[deviceIndex].LatencyPercentile(99);
+	}
+	*numBlocks = _numBlocks;
+	_transferLock.Unlock();
+
+	return _driver->LostScans();
+}
+
+int DAQgUSBamp::SubscribeBlocks(BlockDispatcher::BlockCallback callback, int maxQueuedBlocks)
+{
+	return _dispatcher->Subscribe(callback, maxQueuedBlocks);
+}
+
+bool DAQgUSBamp::UnsubscribeBlocks(int subscriberId)
+{
+	return _dispatcher->Unsubscribe(subscriberId);
+}
+
+bool DAQgUSBamp::GetSubscriberStats(int subscriberId, SubscriberStats *stats)
+{
+	return _dispatcher->GetStats(subscriberId, stats);
+}
+
+bool DAQgUSBamp::SetSchedulingPolicy(SchedulingPolicy policy)
+{
+	bool cpusValid = policy.acquisitionCpu >= -1 && policy.acquisitionCpu < ThreadScheduling::NumCpus()
+		&& policy.writerCpu >= -1 && policy.writerCpu < ThreadScheduling::NumCpus();
+	for (size_t i = 0; i < policy.dispatchCpus.size(); i++)
+		cpusValid = cpusValid && policy.dispatchCpus[i] >= 0 && policy.dispatchCpus[i] < ThreadScheduling::NumCpus();
+
+	if (_isRunning || !cpusValid)
+	{
+		// error 48
+		std::cout << "Error on SetSchedulingPolicy: acquisition running or core out of range (0 to " << ThreadScheduling::NumCpus() - 1 << ")." << "\n";
+		return false;
+	}
+
+	_schedulingPolicy = policy;
+	return true;
+}
+
+bool DAQgUSBamp::SetSampleStorage(SampleStorage storage, std::vector<float> gains)
+{
+	SampleCodec codec;
+	if (_isRunning || storage < STORAGE_FLOAT32 || storage > STORAGE_INT16 || !codec.Configure(storage, numChannels, TRIGGER != 0, gains))
+	{
+		// error 54
+		std::cout << "Error on SetSampleStorage: acquisition running, unknown storage or not one positive gain per channel (" << (int) numChannels << ")." << "\n";
+		return false;
+	}
+
+	//the application buffer of the previous storage is freed, the next start allocates the one in use
+	if (storage != _codec.Storage())
+	{
+		if (_bufferLocked)
+			ThreadScheduling::UnlockMemory(BufferData(), BufferBytes());
+		_bufferLocked = false;
+		_buffer.Initialize(0);
+		_compactBuffer.Initialize(0);
+	}
+
+	_codec = codec;
+	return true;
+}
+
+long long DAQgUSBamp::ClippedValues()
+{
+	_bufferLock.Lock();
+	long long numClipped = _numClipped;
+	_bufferLock.Unlock();
+	return numClipped;
+}
+
+bool DAQgUSBamp::UseSharedEngine(int numIoThreads)
+{
+	if (_isRunning || numIoThreads < 0)
+	{
+		// error 51
+		std::cout << "Error on UseSharedEngine: acquisition running or negative number of I/O threads." << "\n";
+		return false;
+	}
+
+	if (_engine != NULL)
+		AcquisitionEngine::ReleaseShared();
+	_engine = (numIoThreads > 0) ? AcquisitionEngine::AcquireShared(numIoThreads) : NULL;
+	return true;
+}
+
+int DAQgUSBamp::EngineThread()
+{
+	return (_engine != NULL) ? _engine->ThreadOfGroup(this) : -1;
+}
+
+bool DAQgUSBamp::GetSchedulingStats(long long *pageFaults, long long *contextSwitches)
+{
+	_transferLock.Lock();
+	long long threadId = _acquisitionThreadId;
+	long long startContextSwitches = _startContextSwitches;
+	long long endContextSwitches = _endContextSwitches;
+	long long startPageFaults = _startPageFaults;
+	_transferLock.Unlock();
+
+	if (threadId < 0)
+		return false;
+
+	//the counters are -1 when the OS doesn't report them, an ended thread keeps its last count
+	long long numPageFaults = ThreadScheduling::ProcessPageFaults();
+	long long numContextSwitches = (endContextSwitches >= 0) ? endContextSwitches : ThreadScheduling::ThreadContextSwitches(threadId);
+	*pageFaults = (numPageFaults >= 0 && startPageFaults >= 0) ? numPageFaults - startPageFaults : -1;
+	*contextSwitches = (numContextSwitches >= 0 && startContextSwitches >= 0) ? numContextSwitches - startContextSwitches : -1;
+	return true;
+}
+
+bool DAQgUSBamp::StartImpedanceWorkers(bool continuous)
+{
+	if (_isRunning || _impedancePool != NULL || deviceHandleList.empty())
+	{
+		// error 58
+		std::cout << "Error on measuring impedances: devices not open, acquisition running or impedances already being measured." << "\n";
+		return false;
+	}
+
+	_impedanceLock.Lock();
+	_impedances.assign(numChannels, std::numeric_limits<double>::quiet_NaN());
+	_impedanceSweeps.assign(numDevices, 0);
+	_impedanceStop = false;
+	_impedanceLock.Unlock();
+
+	//measurements take a while per electrode and devices don't depend on each other: one worker per device
+	_impedancePool = new WorkStealingPool(numDevices);
+	for (int deviceIndex = 0; deviceIndex < numDevices; deviceIndex++)
+		_impedancePool->Submit([this, deviceIndex, continuous]() { MeasureDeviceImpedances(deviceIndex, continuous); });
+	return true;
+}
+
+void DAQgUSBamp::MeasureDeviceImpedances(int deviceIndex, bool continuous)
+{
+	HANDLE hDevice = deviceHandleList[deviceIndex];
+	if (hDevice == NULL)
+		return;
+
+	//the channels of the first channel list come first in GetData (they are acquired by the master, the last handle)
+	int listIndex = numDevices - 1 - deviceIndex;
+	int firstChannel = 0;
+	for (int i = 0; i < listIndex; i++)
+		firstChannel += (int) correctedChannelList[i].size();
+
+	bool stop = false;
+	while (!stop)
+	{
+		for (size_t k = 0; k < correctedChannelList[listIndex].size() && !stop; k++)
+		{
+			double impedance = std::numeric_limits<double>::quiet_NaN();
+			if (!_driver->GetImpedance(hDevice, correctedChannelList[listIndex][k], &impedance))
+			{
+				// error 59
+				std::cout << "Error on GT_GetImpedance: couldn't measure channel " << (int) correctedChannelList[listIndex][k] << " of device " << deviceSerialList[deviceIndex] << "." << "\n";
+				impedance = std::numeric_limits<double>::quiet_NaN();
+			}
+
+			_impedanceLock.Lock();
+			_impedances[firstChannel + k] = impedance / 1000.0;
+			stop = _impedanceStop;
+			_impedanceLock.Unlock();
+		}
+
+		_impedanceLock.Lock();
+		if (!stop)
+			_impedanceSweeps[deviceIndex]++;
+		stop = stop || !continuous;
+		_impedanceLock.Unlock();
+	}
+}
+
+bool DAQgUSBamp::MeasureImpedance(double *impedanceKOhm)
+{
+	if (!StartImpedanceWorkers(false))
+		return false;
+
+	_impedancePool->Wait();
+	delete _impedancePool;
+	_impedancePool = NULL;
+
+	GetImpedances(impedanceKOhm);
+	for (int i = 0; i < numChannels; i++)
+		if (impedanceKOhm[i] != impedanceKOhm[i])
+			return false;
+	return true;
+}
+
+bool DAQgUSBamp::StartImpedanceMonitor()
+{
+	return StartImpedanceWorkers(true);
+}
+
+void DAQgUSBamp::StopImpedanceMonitor()
+{
+	if (_impedancePool == NULL)
+		return;
+
+	_impedanceLock.Lock();
+	_impedanceStop = true;
+	_impedanceLock.Unlock();
+
+	//the workers end after their current measurement
+	_impedancePool->Wait();
+	delete _impedancePool;
+	_impedancePool = NULL;
+}
+
+int DAQgUSBamp::GetImpedances(double *impedanceKOhm)
+{
+	_impedanceLock.Lock();
+	int numSweeps = -1;
+	if (!_impedances.empty())
+	{
+		std::copy(_impedances.begin(), _impedances.end(), impedanceKOhm);
+		numSweeps = *std::min_element(_impedanceSweeps.begin(), _impedanceSweeps.end());
+	}
+	_impedanceLock.Unlock();
+	return numSweeps;
+}
+
+bool DAQgUSBamp::EnableSignalQuality(double windowSec, double lineFrequency, double saturationUv, double flatlineUv)
+{
+	int windowLength = (int) floor(windowSec * SampleRate + 0.5);
+
+	if (windowLength < 2 || lineFrequency <= 0 || lineFrequency >= SampleRate / 2.0 || saturationUv <= 0 || flatlineUv < 0)
+	{
+		// error 56
+		std::cout << "Error on EnableSignalQuality: invalid window, line frequency (below " << SampleRate / 2 << " Hz) or levels." << "\n";
+		return false;
+	}
+
+	DisableSignalQuality();
+
+	SignalQualityMonitor *newMonitor = new SignalQualityMonitor(SampleRate, numChannels, windowLength, lineFrequency, saturationUv, flatlineUv);
+
+	_featureLock.Lock();
+	if (!_qualityLogName.empty() && !newMonitor->OpenLog(_qualityLogName.c_str()))
+	{
+		// error 57
+		std::cout << "Error on creating the signal quality log " << _qualityLogName << "." << "\n";
+	}
+	_qualityMonitor = newMonitor;
+	_featureLock.Unlock();
+
+	//the metrics are computed on a dispatch thread, the channels are the first values of each scan
+	_qualitySubscriber = _dispatcher->Subscribe([newMonitor](const BlockSpan &block)
+	{
+		newMonitor->PushBlock(block.data, block.numScans, block.scanStride);
+	}, QUALITY_QUEUED_BLOCKS);
+	return true;
+}
+
+void DAQgUSBamp::DisableSignalQuality()
+{
+	//no callback uses the monitor once unsubscribed
+	if (_qualitySubscriber >= 0)
+		_dispatcher->Unsubscribe(_qualitySubscriber);
+	_qualitySubscriber = -1;
+
+	_featureLock.Lock();
+	SignalQualityMonitor *oldMonitor = _qualityMonitor;
+	_qualityMonitor = NULL;
+	_featureLock.Unlock();
+
+	delete oldMonitor;
+}
+
+int DAQgUSBamp::GetSignalQuality(ChannelQuality *quality)
+{
+	int numWindows = -1;
+
+	_featureLock.Lock();
+	if (_qualityMonitor != NULL)
+		numWindows = _qualityMonitor->GetQuality(quality);
+	_featureLock.Unlock();
+
+	return numWindows;
+}
+
+bool DAQgUSBamp::EnableFeatureEngine(std::vector<double> stimFrequencies, int numHarmonics, double windowSec, double hopSec)
+{
+	int windowLength = (int) floor(windowSec * SampleRate + 0.5);
+	int hopLength = (int) floor(hopSec * SampleRate + 0.5);
+
+	bool validFrequencies = !stimFrequencies.empty();
+	for (size_t i = 0; i < stimFrequencies.size(); i++)
+		validFrequencies = validFrequencies && stimFrequencies[i] > 0 && stimFrequencies[i] < SampleRate / 2.0;
+
+	if (!validFrequencies || numHarmonics < 1 || windowLength < 2 || hopLength < 1)
+	{
+		// error 27
+		std::cout << "Error on EnableFeatureEngine: invalid frequencies (below " << SampleRate / 2 << " Hz), harmonics, window or hop." << "\n";
+		return false;
+	}
+
+	DisableFeatureEngine();
+
+	//use every acquired channel (the trigger is the last value of each scan)
+	std::vector<int> channelIndices;
+	for (int i = 0; i < numChannels; i++)
+		channelIndices.push_back(i);
+
+	SSVEPFeatureEngine *newEngine = new SSVEPFeatureEngine(SampleRate, channelIndices, stimFrequencies, numHarmonics, windowLength, hopLength);
+
+	_featureLock.Lock();
+	_featureEngine = newEngine;
+	_featureLock.Unlock();
+
+	//the scores are computed on a dispatch thread
+	_featureSubscriber = _dispatcher->Subscribe([newEngine](const BlockSpan &block)
+	{
+		newEngine->PushBlock(block.data, block.numScans, block.scanStride);
+	}, FEATURE_QUEUED_BLOCKS);
+	return true;
+}
+
+void DAQgUSBamp::DisableFeatureEngine()
+{
+	//no callback uses the engine once unsubscribed
+	if (_featureSubscriber >= 0)
+		_dispatcher->Unsubscribe(_featureSubscriber);
+	_featureSubscriber = -1;
+
+	_featureLock.Lock();
+	SSVEPFeatureEngine *oldEngine = _featureEngine;
+	_featureEngine = NULL;
+	_featureLock.Unlock();
+
+	delete oldEngine;
+}
+
+int DAQgUSBamp::NumFeatureClasses()
+{
+	int numClasses = 0;
+
+	_featureLock.Lock();
+	if (_featureEngine != NULL)
+		numClasses = _featureEngine->NumClasses();
+	_featureLock.Unlock();
+
+	return numClasses;
+}
+
+int DAQgUSBamp::GetFeatureScores(double *bandPower, double *canonicalCorrelation)
+{
+	int updateCount = -1;
+
+	_featureLock.Lock();
+	if (_featureEngine != NULL)
+		updateCount = _featureEngine->GetScores(bandPower, canonicalCorrelation);
+	_featureLock.Unlock();
+
+	return updateCount;
+}
+
+bool DAQgUSBamp::EnableTrialClassifier(std::vector<double> stimFrequencies, int numHarmonics, std::vector<double> prior, double threshold, double minTrialSec, double evidenceGain)
+{
+	if (!TRIGGER)
+	{
+		// error 28
+		std::cout << "Error on EnableTrialClassifier: trials are defined by the trigger but the trigger channel is disabled." << "\n";
+		return false;
+	}
+
+	if (stimFrequencies.empty() || numHarmonics < 1 || threshold <= 0 || threshold > 1 || evidenceGain <= 0)
+	{
+		// error 29
+		std::cout << "Error on EnableTrialClassifier: invalid frequencies, harmonics, threshold or evidence gain." << "\n";
+		return false;
+	}
+
+	//use every acquired channel, the trigger is the last value of each scan
+	std::vector<int> channelIndices;
+	for (int i = 0; i < numChannels; i++)
+		channelIndices.push_back(i);
+
+	DisableTrialClassifier();
+
+	int minTrialLength = (int) floor(minTrialSec * SampleRate + 0.5);
+
+	IncrementalTrialClassifier *newClassifier = new IncrementalTrialClassifier(SampleRate, channelIndices, numChannels,
+		stimFrequencies, numHarmonics, prior, threshold, minTrialLength, evidenceGain);
+
+	_featureLock.Lock();
+	_trialClassifier = newClassifier;
+	_featureLock.Unlock();
+
+	//the trials are scored on a dispatch thread, WaitForTrialDecision wakes when a block decides or ends one
+	_classifierSubscriber = _dispatcher->Subscribe([newClassifier](const BlockSpan &block)
+	{
+		newClassifier->PushBlock(block.data, block.numScans, block.scanStride);
+	}, CLASSIFIER_QUEUED_BLOCKS);
+	return true;
+}
+
+void DAQgUSBamp::DisableTrialClassifier()
+{
+	//no callback uses the classifier once unsubscribed
+	if (_classifierSubscriber >= 0)
+		_dispatcher->Unsubscribe(_classifierSubscriber);
+	_classifierSubscriber = -1;
+
+	_featureLock.Lock();
+	IncrementalTrialClassifier *oldClassifier = _trialClassifier;
+	_trialClassifier = NULL;
+	_featureLock.Unlock();
+
+	delete oldClassifier;
+}
+
+int DAQgUSBamp::NumTrialClasses()
+{
+	int numClasses = 0;
+
+	_featureLock.Lock();
+	if (_trialClassifier != NULL)
+		numClasses = _trialClassifier->NumClasses();
+	_featureLock.Unlock();
+
+	return numClasses;
+}
+
+int DAQgUSBamp::GetTrialPosterior(double *aPosteriori, int *classIndex, int *numTrialSamples)
+{
+	int state = -1;
+
+	_featureLock.Lock();
+	if (_trialClassifier != NULL)
+		state = _trialClassifier->GetPosterior(aPosteriori, classIndex, numTrialSamples);
+	_featureLock.Unlock();
+
+	return state;
+}
+
+bool DAQgUSBamp::WaitForTrialDecision(int timeoutMs, double *aPosteriori, int *classIndex, int *numTrialSamples)
+{
+	//the classifier is only replaced by the calling (control) thread, so the lock is not held while waiting
+	_featureLock.Lock();
+	IncrementalTrialClassifier *classifier = _trialClassifier;
+	_featureLock.Unlock();
+
+	if (classifier == NULL)
+		return false;
+
+	return classifier->WaitForDecision(timeoutMs, aPosteriori, classIndex, numTrialSamples);
+}
+
+bool DAQgUSBamp::EnableEOGDetector(std::vector<int> plusChannels, std::vector<int> minusChannels, double thresholdUv, double slopeUvPerSec, double templateCorrelation, double marginSec)
+{
+	bool validChannels = !plusChannels.empty() && minusChannels.size() == plusChannels.size();
+	for (size_t i = 0; i < plusChannels.size() && validChannels; i++)
+		validChannels = plusChannels[i] >= 0 && plusChannels[i] < numChannels && minusChannels[i] >= -1 && minusChannels[i] < numChannels;
+
+	if (!validChannels || thresholdUv <= 0 || slopeUvPerSec < 0 || templateCorrelation < 0 || templateCorrelation > 1 || marginSec < 0)
+	{
+		// error 60
+		std::cout << "Error on EnableEOGDetector: invalid derivations (channels below " << (int) numChannels << "), threshold, slope, correlation or margin." << "\n";
+		return false;
+	}
+
+	DisableEOGDetector();
+
+	//without the trigger channel only the spans are flagged
+	int marginLength = (int) floor(marginSec * SampleRate + 0.5);
+	EOGArtifactDetector *newDetector = new EOGArtifactDetector(SampleRate, plusChannels, minusChannels, TRIGGER ? numChannels : -1,
+		thresholdUv, slopeUvPerSec, templateCorrelation, marginLength, std::vector<double>());
+
+	_featureLock.Lock();
+	_eogDetector = newDetector;
+	_featureLock.Unlock();
+
+	//the scans are flagged on a dispatch thread, WaitForTrialArtifacts wakes when the trial end is delivered
+	_eogSubscriber = _dispatcher->Subscribe([newDetector](const BlockSpan &block)
+	{
+		newDetector->PushBlock(block.data, block.numScans, block.scanStride);
+	}, EOG_QUEUED_BLOCKS);
+	return true;
+}
+
+void DAQgUSBamp::DisableEOGDetector()
+{
+	//no callback uses the detector once unsubscribed
+	if (_eogSubscriber >= 0)
+		_dispatcher->Unsubscribe(_eogSubscriber);
+	_eogSubscriber = -1;
+
+	_featureLock.Lock();
+	EOGArtifactDetector *oldDetector = _eogDetector;
+	_eogDetector = NULL;
+	_featureLock.Unlock();
+
+	delete oldDetector;
+}
+
+bool DAQgUSBamp::GetEOGArtifacts(std::vector<ArtifactSpan> &spans, std::vector<TrialArtifacts> &trials)
+{
+	bool enabled = false;
+
+	_featureLock.Lock();
+	if (_eogDetector != NULL)
+	{
+		_eogDetector->GetArtifacts(spans, trials);
+		enabled = true;
+	}
+	_featureLock.Unlock();
+
+	return enabled;
+}
+
+bool DAQgUSBamp::WaitForTrialArtifacts(int timeoutMs, TrialArtifacts *trial)
+{
+	//as WaitForTrialDecision, the detector is only replaced by the calling thread so the lock is not held while waiting
+	_featureLock.Lock();
+	EOGArtifactDetector *detector = _eogDetector;
+	_featureLock.Unlock();
+
+	if (detector == NULL)
+		return false;
+
+	return detector->WaitForTrialEnd(timeoutMs, trial);
+}
+
+bool DAQgUSBamp::EnableEnvelope(double historySec)
+{
+	long long historyLength = (long long) floor(historySec * SampleRate + 0.5);
+
+	if (historyLength < 1)
+	{
+		// error 61
+		std::cout << "Error on EnableEnvelope: invalid history." << "\n";
+		return false;
+	}
+
+	DisableEnvelope();
+
+	//channels and trigger, the first values of each scan
+	EnvelopePyramid *newEnvelope = new EnvelopePyramid(SampleRate, numChannels + TRIGGER, historyLength);
+
+	//an envelope file only matches the recording from its first scan, so none is written when enabled while recording
+	_featureLock.Lock();
+	_envelope = newEnvelope;
+	_featureLock.Unlock();
+
+	_envelopeSubscriber = _dispatcher->Subscribe([newEnvelope](const BlockSpan &block)
+	{
+		newEnvelope->PushBlock(block.data, block.numScans, block.scanStride);
+	}, ENVELOPE_QUEUED_BLOCKS);
+	return true;
+}
+
+void DAQgUSBamp::DisableEnvelope()
+{
+	//no callback uses the envelope once unsubscribed
+	if (_envelopeSubscriber >= 0)
+		_dispatcher->Unsubscribe(_envelopeSubscriber);
+	_envelopeSubscriber = -1;
+
+	_featureLock.Lock();
+	EnvelopePyramid *oldEnvelope = _envelope;
+	_envelope = NULL;
+	_featureLock.Unlock();
+
+	//the envelope file ends where it was disabled
+	delete oldEnvelope;
+}
+
+int DAQgUSBamp::GetEnvelope(std::vector<int> values, long long startScan, long long numScans, int width, float *minimum, float *maximum)
+{
+	int level = -1;
+
+	_featureLock.Lock();
+	if (_envelope != NULL && !values.empty())
+		level = _envelope->GetEnvelope(&values[0], (int) values.size(), startScan, numScans, width, minimum, maximum);
+	_featureLock.Unlock();
+
+	return level;
+}
+
+long long DAQgUSBamp::EnvelopeScans()
+{
+	long long numEnvelopeScans = -1;
+
+	_featureLock.Lock();
+	if (_envelope != NULL)
+		numEnvelopeScans = _envelope->NumScans();
+	_featureLock.Unlock();
+
+	return numEnvelopeScans;
+}
+
+int DAQgUSBamp::ScheduleTrigger(int value, double seconds)
+{
+	int id = TRIGGER ? _triggerScheduler->ScheduleAtTime(value, seconds) : -1;
+	if (id < 0)
+	{
+		// error 64
+		std::cout << "Error on ScheduleTrigger: the trigger channel is disabled or acquisition is not running." << "\n";
+	}
+	return id;
+}
+
+int DAQgUSBamp::ScheduleTriggerAtScan(int value, long long scan)
+{
+	int id = TRIGGER ? _triggerScheduler->ScheduleAtScan(value, scan) : -1;
+	if (id < 0)
+	{
+		// error 64
+		std::cout << "Error on ScheduleTriggerAtScan: the trigger channel is disabled, acquisition is not running or the scan is negative." << "\n";
+	}
+	return id;
+}
+
+double DAQgUSBamp::TriggerClock()
+{
+	return TriggerScheduler::Now();
+}
+
+void DAQgUSBamp::SetTriggerLatency(double latencyMs)
+{
+	_triggerScheduler->SetOutputLatency(latencyMs / 1000);
+}
+
+int DAQgUSBamp::CancelTriggers()
+{
+	return _triggerScheduler->Cancel();
+}
+
+void DAQgUSBamp::GetTriggerEvents(std::vector<TriggerEvent> &events)
+{
+	_triggerScheduler->Events(events);
+}
+
+bool DAQgUSBamp::SetDurabilityPolicy(DurabilityPolicy policy)
+{
+	if (_isRunning || policy.mode < DURABILITY_NONE || policy.mode > DURABILITY_CHUNK || policy.syncSeconds <= 0 ||
+		policy.chunkBytes <= 0 || policy.chunkSeconds <= 0 || policy.extentBytes <= 0)
+	{
+		// error 66
+		std::cout << "Error on SetDurabilityPolicy: acquisition running, unknown mode or not positive sync time, chunk or extent." << "\n";
+		return false;
+	}
+
+	_durabilityPolicy = policy;
+	return true;
+}
+
+void DAQgUSBamp::GetRecorderStats(RecorderStats *stats)
+{
+	_recorder.GetStats(stats);
+}
+
+void DAQgUSBamp::CloseDevice()
+{
+	StopImpedanceMonitor();
+
+	std::cout << "Closing devices...\n";
+	while (!deviceHandleList.empty())
+	{
+		//closes each opened device and removes it from the call sequence (devices that failed to open are NULL)
+		if (deviceHandleList.front() != NULL)
+		{
+			_driver->Stop(deviceHandleList.front());
+			BOOL ret = _driver->CloseDevice(&deviceHandleList.front());
+		}
+		deviceHandleList.pop_front();
+	}
+
+	//the devices can be opened by another group
+	_inventoryLock.Lock();
+	for (size_t i = 0; i < deviceSerialList.size(); i++)
+		_openedSerials.erase(deviceSerialList[i]);
+	_inventoryLock.Unlock();
+
+	deviceSerialList.clear();
+	_calibrationFresh.clear();
+
+	//the next devices may need other transfer sizes
+	ReleaseQueues();
 	if (writeToFile)
-		outputFile.Close();
+		_recorder.Close();
 }
 
 // Destructor
 DAQgUSBamp::~DAQgUSBamp() {
 	std::cout << "Runnig destructor\n";
 	CloseDevice();
+	if (_bufferLocked)
+		ThreadScheduling::UnlockMemory(BufferData(), BufferBytes());
+	DisableSignalQuality();
+	DisableFeatureEngine();
+	DisableTrialClassifier();
+	DisableEOGDetector();
+	DisableEnvelope();
+	if (_engine != NULL)
+		AcquisitionEngine::ReleaseShared();
+	delete _triggerScheduler;
+	delete _dispatcher;
+	delete _driver;
 }
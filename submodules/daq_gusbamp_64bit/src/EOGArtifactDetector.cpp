@@ -0,0 +1,288 @@
+#define _USE_MATH_DEFINES
+#include <math.h>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <algorithm>
+#include "EOGArtifactDetector.h"
+
+// Constructor
+EOGArtifactDetector::EOGArtifactDetector(int sampleRate, std::vector<int> plusIndices, std::vector<int> minusIndices, int triggerIndex,
+	double thresholdUv, double slopeUvPerSec, double templateCorrelation, int marginLength, std::vector<double> blinkTemplate)
+{
+	_sampleRate = sampleRate;
+	_plusIndices = plusIndices;
+	_minusIndices = minusIndices;
+	_minusIndices.resize(_plusIndices.size(), -1);
+	_triggerIndex = triggerIndex;
+	_thresholdUv = thresholdUv;
+	_slopeUvPerSec = slopeUvPerSec;
+	_templateCorrelation = templateCorrelation;
+	_marginLength = (std::max)(marginLength, 0);
+
+	_baselineWeight = 1.0 - exp(-1000.0 / (BASELINE_MS * (double) sampleRate));
+	_slopeLength = (std::max)((int) floor(SLOPE_MS * sampleRate / 1000.0 + 0.5), 1);
+
+	//the template is compared without its mean, so only its shape matters
+	if (blinkTemplate.size() < 3)
+		blinkTemplate = BlinkTemplate(sampleRate);
+	double mean = 0;
+	for (size_t i = 0; i < blinkTemplate.size(); i++)
+		mean += blinkTemplate[i] / blinkTemplate.size();
+	_templateNorm = 0;
+	for (size_t i = 0; i < blinkTemplate.size(); i++)
+	{
+		_template.push_back(blinkTemplate[i] - mean);
+		_templateNorm += _template.back() * _template.back();
+	}
+	_templateNorm = sqrt(_templateNorm);
+	_templateHop = (std::max)((int) _template.size() / 16, 1);
+
+	_historyLength = (std::max)((int) _template.size(), _slopeLength + 1);
+	_history.assign(_plusIndices.size(), std::vector<float>(_historyLength));
+	_reference.resize(_plusIndices.size());
+	_baseline.resize(_plusIndices.size());
+
+	Reset();
+}
+
+void EOGArtifactDetector::Reset()
+{
+	std::lock_guard<std::mutex> lock(_lock);
+
+	_numScans = 0;
+	_spans.clear();
+	_trials.clear();
+	_triggerOn = false;
+	_trialStart = -1;
+	_trialPending = false;
+}
+
+bool EOGArtifactDetector::PushBlock(const float *block, int numScans, int scanStride)
+{
+	std::lock_guard<std::mutex> lock(_lock);
+
+	bool trialEnded = false;
+	const int numDerivations = (int) _plusIndices.size();
+	const int templateLength = (int) _template.size();
+	const double slopeScale = (double) _sampleRate / _slopeLength;
+
+	for (int scanIndex = 0; scanIndex < numScans; scanIndex++)
+	{
+		const float *scan = block + (size_t) scanIndex * scanStride;
+		const long long n = _numScans;
+		const int position = (int) (n % _historyLength);
+
+		for (int d = 0; d < numDerivations; d++)
+		{
+			double value = scan[_plusIndices[d]];
+			if (_minusIndices[d] >= 0)
+				value -= scan[_minusIndices[d]];
+
+			//samples are kept around the first one so a large electrode offset doesn't cost float precision
+			if (n == 0)
+			{
+				_reference[d] = value;
+				_baseline[d] = 0;
+			}
+			float sample = (float) (value - _reference[d]);
+			std::vector<float> &history = _history[d];
+			history[position] = sample;
+
+			double deviation = sample - _baseline[d];
+			_baseline[d] += _baselineWeight * deviation;
+
+			int causes = 0;
+			if (fabs(deviation) > _thresholdUv)
+				causes |= ARTIFACT_THRESHOLD;
+			if (_slopeUvPerSec > 0 && n >= _slopeLength)
+			{
+				float past = history[(position + _historyLength - _slopeLength) % _historyLength];
+				if (fabs(sample - past) * slopeScale > _slopeUvPerSec)
+					causes |= ARTIFACT_SLOPE;
+			}
+			if (causes != 0)
+				Flag(n, n + 1, fabs(deviation), causes);
+
+			//the template is matched against the last templateLength samples every _templateHop scans
+			if (_templateCorrelation > 0 && n + 1 >= templateLength && (n + 1) % _templateHop == 0)
+			{
+				double peakUv;
+				double correlation = MatchTemplate(d, &peakUv);
+				if (fabs(correlation) >= _templateCorrelation && peakUv >= _thresholdUv / 2)
+					Flag(n + 1 - templateLength, n + 1, peakUv, ARTIFACT_TEMPLATE);
+			}
+		}
+
+		//trials are cut as SessionFile::FindTrials does. A trial already running at the first scan is ignored
+		if (_triggerIndex >= 0)
+		{
+			bool triggerOn = (scan[_triggerIndex] != 0);
+			if (triggerOn && !_triggerOn && n > 0)
+				_trialStart = n - 1;
+			else if (!triggerOn && _triggerOn && _trialStart >= 0)
+			{
+				TrialArtifacts trial;
+				trial.startScan = _trialStart;
+				trial.length = (int) (n - 1 - _trialStart);
+				trial.artifactScans = CountArtifactScans(trial.startScan, trial.startScan + trial.length);
+				trial.contaminated = trial.artifactScans > 0;
+
+				_trials.push_back(trial);
+				if ((int) _trials.size() > MAX_TRIALS)
+					_trials.pop_front();
+				_trialStart = -1;
+				_trialPending = true;
+				trialEnded = true;
+			}
+			_triggerOn = triggerOn;
+		}
+
+		_numScans++;
+	}
+
+	if (trialEnded)
+		_trialEnded.notify_all();
+	return trialEnded;
+}
+
+void EOGArtifactDetector::Flag(long long startScan, long long endScan, double peakUv, int causes)
+{
+	ArtifactSpan span;
+	span.startScan = (std::max)(startScan - _marginLength, 0LL);
+	span.endScan = endScan + _marginLength;
+	span.peakUv = peakUv;
+	span.causes = causes;
+
+	//spans are disjoint and ordered: the new one can only reach back into the latest ones
+	while (!_spans.empty() && span.startScan <= _spans.back().endScan)
+	{
+		const ArtifactSpan &last = _spans.back();
+		span.startScan = (std::min)(span.startScan, last.startScan);
+		span.endScan = (std::max)(span.endScan, last.endScan);
+		span.peakUv = (std::max)(span.peakUv, last.peakUv);
+		span.causes |= last.causes;
+		_spans.pop_back();
+	}
+
+	_spans.push_back(span);
+	if ((int) _spans.size() > MAX_SPANS)
+		_spans.pop_front();
+}
+
+int EOGArtifactDetector::CountArtifactScans(long long startScan, long long endScan) const
+{
+	long long count = 0;
+	for (std::deque<ArtifactSpan>::const_reverse_iterator span = _spans.rbegin(); span != _spans.rend() && span->endScan > startScan; ++span)
+	{
+		long long overlap = (std::min)(span->endScan, endScan) - (std::max)(span->startScan, startScan);
+		if (overlap > 0)
+			count += overlap;
+	}
+	return (int) count;
+}
+
+double EOGArtifactDetector::MatchTemplate(int derivation, double *peakUv) const
+{
+	const std::vector<float> &history = _history[derivation];
+	const int templateLength = (int) _template.size();
+	const double baseline = _baseline[derivation];
+	int position = (int) ((_numScans + 1 - templateLength) % _historyLength);
+
+	//the mean of the window drops out of the dot product with the zero mean template
+	double sum = 0, sumSquares = 0, dot = 0, peak = 0;
+	for (int i = 0; i < templateLength; i++)
+	{
+		double value = history[position];
+		sum += value;
+		sumSquares += value * value;
+		dot += value * _template[i];
+		peak = (std::max)(peak, fabs(value - baseline));
+		if (++position == _historyLength)
+			position = 0;
+	}
+
+	*peakUv = peak;
+	double variance = sumSquares - sum * sum / templateLength;
+	if (variance <= 0 || _templateNorm <= 0)
+		return 0;
+	return dot / (sqrt(variance) * _templateNorm);
+}
+
+void EOGArtifactDetector::GetArtifacts(std::vector<ArtifactSpan> &spans, std::vector<TrialArtifacts> &trials)
+{
+	std::lock_guard<std::mutex> lock(_lock);
+
+	spans.assign(_spans.begin(), _spans.end());
+	trials.assign(_trials.begin(), _trials.end());
+}
+
+void EOGArtifactDetector::TakeFinishedSpans(std::vector<ArtifactSpan> &spans)
+{
+	std::lock_guard<std::mutex> lock(_lock);
+
+	//a new flag starts at most a template length and the margin before the next scan
+	long long firstOpenScan = _numScans - (long long) _template.size() - _marginLength;
+	while (!_spans.empty() && _spans.front().endScan < firstOpenScan)
+	{
+		spans.push_back(_spans.front());
+		_spans.pop_front();
+	}
+}
+
+bool EOGArtifactDetector::GetCurrentTrial(TrialArtifacts *trial)
+{
+	std::lock_guard<std::mutex> lock(_lock);
+
+	if (_trialStart < 0)
+		return false;
+
+	trial->startScan = _trialStart;
+	trial->length = (int) (_numScans - _trialStart);
+	trial->artifactScans = CountArtifactScans(_trialStart, _numScans);
+	trial->contaminated = trial->artifactScans > 0;
+	return true;
+}
+
+bool EOGArtifactDetector::WaitForTrialEnd(int timeoutMs, TrialArtifacts *trial)
+{
+	std::unique_lock<std::mutex> lock(_lock);
+
+	if (!_trialEnded.wait_for(lock, std::chrono::milliseconds(timeoutMs), [this] { return _trialPending; }))
+		return false;
+
+	_trialPending = false;
+
+	if (trial != NULL)
+		*trial = _trials.back();
+	return true;
+}
+
+std::vector<double> EOGArtifactDetector::BlinkTemplate(int sampleRate)
+{
+	int length = (std::max)((int) floor(BLINK_MS * sampleRate / 1000.0 + 0.5), 3);
+
+	std::vector<double> blink(length);
+	for (int i = 0; i < length; i++)
+		blink[i] = sin(M_PI * (i + 0.5) / length);
+	return blink;
+}
+
+void EOGArtifactDetector::FlagTrials(const std::vector<ArtifactSpan> &spans, const std::vector<long long> &trialStarts,
+	const std::vector<int> &trialLengths, std::vector<int> &artifactScans)
+{
+	artifactScans.assign(trialStarts.size(), 0);
+
+	for (size_t i = 0; i < trialStarts.size(); i++)
+	{
+		long long trialEnd = trialStarts[i] + trialLengths[i];
+		for (size_t s = 0; s < spans.size() && spans[s].startScan < trialEnd; s++)
+		{
+			long long overlap = (std::min)(spans[s].endScan, trialEnd) - (std::max)(spans[s].startScan, trialStarts[i]);
+			if (overlap > 0)
+				artifactScans[i] += (int) overlap;
+		}
+	}
+}
@@ -0,0 +1,163 @@
+#include <math.h>
+#include <vector>
+#include <algorithm>
+#include <fstream>
+#include "SessionFile.h"
+#include "EnvelopePyramid.h"
+#include "EnvelopeFile.h"
+
+// Bytes of the header (version, sample rate, values, factor, levels and first file level)
+static const int HEADER_BYTES = 6 * sizeof(int);
+
+// Constructor
+EnvelopeFile::EnvelopeFile()
+{
+	_sampleRate = 0;
+	_numValues = 0;
+	_numChunks = 0;
+}
+
+bool EnvelopeFile::Open(const char *fileName)
+{
+	Close();
+
+	_file.open(fileName, std::ios::in | std::ios::binary);
+	if (!_file.is_open())
+		return false;
+
+	int header[6];
+	if (!_file.read((char *) header, sizeof(header)) || header[0] != EnvelopePyramid::FILE_VERSION || header[2] < 1
+		|| header[3] != EnvelopePyramid::FACTOR || header[4] != EnvelopePyramid::NUM_LEVELS || header[5] != EnvelopePyramid::FILE_FIRST_LEVEL)
+	{
+		Close();
+		return false;
+	}
+	_sampleRate = header[1];
+	_numValues = header[2];
+
+	//complete chunks only, a recording cut short may end in the middle of one
+	_file.seekg(0, std::ios::end);
+	long long fileSize = (long long) _file.tellg();
+	_numChunks = (fileSize - HEADER_BYTES) / (EnvelopePyramid::ChunkFloats(_numValues) * (long long) sizeof(float));
+
+	_levelOffsets.assign(EnvelopePyramid::NUM_LEVELS, 0);
+	long long offset = 0;
+	for (int l = EnvelopePyramid::FILE_FIRST_LEVEL; l < EnvelopePyramid::NUM_LEVELS; l++)
+	{
+		_levelOffsets[l] = offset;
+		offset += 2LL * _numValues * EnvelopePyramid::ChunkBins(l);
+	}
+	return true;
+}
+
+void EnvelopeFile::Close()
+{
+	if (_file.is_open())
+		_file.close();
+	_file.clear();
+	_numChunks = 0;
+}
+
+int EnvelopeFile::GetEnvelope(const SessionFile &session, const int *values, int numValues, long long startScan, long long numScans, int width, float *minimum, float *maximum)
+{
+	if (numValues < 1 || numScans < 1 || width < 1)
+		return -1;
+	for (int i = 0; i < numValues; i++)
+		if (values[i] < 0 || values[i] >= session.NumChannels() + session.TriggerFlag() || (_file.is_open() && values[i] >= _numValues))
+			return -1;
+
+	int l = EnvelopePyramid::ChooseLevel(numScans, width);
+
+	//fine pixels (or no envelope file): from the samples, a pixel at a time
+	if (!_file.is_open() || l < EnvelopePyramid::FILE_FIRST_LEVEL)
+	{
+		std::vector<int> channels(values, values + numValues);
+		for (int p = 0; p < width; p++)
+		{
+			long long first, end;
+			EnvelopePyramid::PixelScans(startScan, numScans, width, p, &first, &end);
+			first = (std::max)(first, 0LL);
+			end = (std::min)(end, session.NumScans());
+			int pixelScans = (int) (end - first);
+
+			if (pixelScans > 0)
+			{
+				_samples.resize((size_t) pixelScans * numValues);
+				session.ReadSlice(channels, first, pixelScans, 1.0, &_samples[0]);
+			}
+			for (int i = 0; i < numValues; i++)
+			{
+				float pixelMinimum = NAN, pixelMaximum = NAN;
+				for (int s = 0; s < pixelScans; s++)
+				{
+					float value = _samples[(size_t) s * numValues + i];
+					pixelMinimum = (s == 0 || value < pixelMinimum) ? value : pixelMinimum;
+					pixelMaximum = (s == 0 || value > pixelMaximum) ? value : pixelMaximum;
+				}
+				minimum[(size_t) i * width + p] = pixelMinimum;
+				maximum[(size_t) i * width + p] = pixelMaximum;
+			}
+		}
+		return 0;
+	}
+
+	//coarse pixels: the bins of the whole range are read once per value, then reduced per pixel
+	long long firstBin, endBin, lastFirstBin;
+	EnvelopePyramid::PixelBins(startScan, numScans, width, 0, l, &firstBin, &endBin);
+	EnvelopePyramid::PixelBins(startScan, numScans, width, width - 1, l, &lastFirstBin, &endBin);
+	int numBins = (int) (endBin - firstBin);
+	_binMinimum.resize(numBins);
+	_binMaximum.resize(numBins);
+
+	for (int i = 0; i < numValues; i++)
+	{
+		ReadBins(l, values[i], firstBin, numBins, &_binMinimum[0], &_binMaximum[0]);
+
+		for (int p = 0; p < width; p++)
+		{
+			long long pixelFirstBin, pixelEndBin;
+			EnvelopePyramid::PixelBins(startScan, numScans, width, p, l, &pixelFirstBin, &pixelEndBin);
+
+			//NaN bins (out of the recording) fail every comparison and are skipped
+			float pixelMinimum = HUGE_VALF, pixelMaximum = -HUGE_VALF;
+			for (long long bin = pixelFirstBin; bin < pixelEndBin; bin++)
+			{
+				float binMinimum = _binMinimum[(size_t) (bin - firstBin)], binMaximum = _binMaximum[(size_t) (bin - firstBin)];
+				pixelMinimum = (binMinimum < pixelMinimum) ? binMinimum : pixelMinimum;
+				pixelMaximum = (binMaximum > pixelMaximum) ? binMaximum : pixelMaximum;
+			}
+			minimum[(size_t) i * width + p] = (pixelMinimum <= pixelMaximum) ? pixelMinimum : NAN;
+			maximum[(size_t) i * width + p] = (pixelMinimum <= pixelMaximum) ? pixelMaximum : NAN;
+		}
+	}
+	return l;
+}
+
+void EnvelopeFile::ReadBins(int level, int value, long long firstBin, int numBins, float *minimum, float *maximum)
+{
+	std::fill(minimum, minimum + numBins, NAN);
+	std::fill(maximum, maximum + numBins, NAN);
+
+	const int chunkBins = EnvelopePyramid::ChunkBins(level);
+	const long long chunkFloats = EnvelopePyramid::ChunkFloats(_numValues);
+	long long endBin = firstBin + numBins;
+
+	//one read of the minima and one of the maxima per chunk
+	for (long long bin = (std::max)(firstBin, 0LL); bin < endBin;)
+	{
+		long long chunk = bin / chunkBins;
+		if (chunk >= _numChunks)
+			break;
+		int offset = (int) (bin - chunk * chunkBins);
+		int run = (int) (std::min)(endBin - bin, (long long) (chunkBins - offset));
+
+		long long position = chunk * chunkFloats + _levelOffsets[level] + (long long) value * chunkBins + offset;
+		_file.clear();
+		_file.seekg(HEADER_BYTES + position * (long long) sizeof(float));
+		_file.read((char *) (minimum + (bin - firstBin)), run * sizeof(float));
+		_file.seekg(HEADER_BYTES + (position + (long long) _numValues * chunkBins) * (long long) sizeof(float));
+		_file.read((char *) (maximum + (bin - firstBin)), run * sizeof(float));
+
+		bin += run;
+	}
+}
@@ -0,0 +1,300 @@
+#include <math.h>
+#include <vector>
+#include <algorithm>
+#include <mutex>
+#include <fstream>
+#include "EnvelopePyramid.h"
+
+// Floor of a / b for a positive b
+static long long FloorDiv(long long a, long long b)
+{
+	return (a >= 0) ? a / b : -((-a + b - 1) / b);
+}
+
+// Constructor
+EnvelopePyramid::EnvelopePyramid(int sampleRate, int numValues, long long historyLength)
+{
+	_sampleRate = sampleRate;
+	_numValues = numValues;
+
+	//a whole chunk has to stay in the rings until it is written
+	historyLength = (std::max)(historyLength, BinScans(NUM_LEVELS - 1));
+
+	_levels.resize(NUM_LEVELS);
+	for (int l = 0; l < NUM_LEVELS; l++)
+	{
+		Level &level = _levels[l];
+		level.capacity = (historyLength + BinScans(l) - 1) / BinScans(l) + 1;
+		level.minimum.resize((size_t) (numValues * level.capacity));
+		if (l > 0)
+		{
+			level.maximum.resize((size_t) (numValues * level.capacity));
+			level.partialMinimum.resize(numValues);
+			level.partialMaximum.resize(numValues);
+		}
+	}
+	_chunk.resize((size_t) ChunkFloats(numValues));
+
+	Reset();
+}
+
+// Destructor
+EnvelopePyramid::~EnvelopePyramid()
+{
+	CloseFile();
+}
+
+void EnvelopePyramid::Reset()
+{
+	std::lock_guard<std::mutex> lock(_lock);
+
+	_numScans = 0;
+	for (int l = 0; l < NUM_LEVELS; l++)
+	{
+		Level &level = _levels[l];
+		level.numBins = 0;
+		level.partialCount = 0;
+		std::fill(level.partialMinimum.begin(), level.partialMinimum.end(), HUGE_VALF);
+		std::fill(level.partialMaximum.begin(), level.partialMaximum.end(), -HUGE_VALF);
+	}
+}
+
+void EnvelopePyramid::PushBlock(const float *block, int numScans, int scanStride)
+{
+	std::lock_guard<std::mutex> lock(_lock);
+
+	Level &samples = _levels[0];
+	Level &first = _levels[1];
+	const int numValues = _numValues;
+	float *partialMinimum = &first.partialMinimum[0], *partialMaximum = &first.partialMaximum[0];
+
+	for (int scanIndex = 0; scanIndex < numScans; scanIndex++)
+	{
+		const float *x = block + (size_t) scanIndex * scanStride;
+		float *sample = &samples.minimum[(size_t) (samples.numBins % samples.capacity)];
+
+		//independent per value updates of the first level over contiguous arrays
+		for (int v = 0; v < numValues; v++)
+		{
+			sample[(size_t) v * samples.capacity] = x[v];
+			partialMinimum[v] = (x[v] < partialMinimum[v]) ? x[v] : partialMinimum[v];
+			partialMaximum[v] = (x[v] > partialMaximum[v]) ? x[v] : partialMaximum[v];
+		}
+		samples.numBins++;
+		_numScans++;
+
+		if (++first.partialCount == FACTOR)
+			CompleteBin(1);
+	}
+}
+
+void EnvelopePyramid::CompleteBin(int l)
+{
+	Level &level = _levels[l];
+	size_t position = (size_t) (level.numBins % level.capacity);
+	for (int v = 0; v < _numValues; v++)
+	{
+		level.minimum[v * level.capacity + position] = level.partialMinimum[v];
+		level.maximum[v * level.capacity + position] = level.partialMaximum[v];
+	}
+	level.numBins++;
+
+	bool nextComplete = false;
+	if (l + 1 < NUM_LEVELS)
+	{
+		Level &next = _levels[l + 1];
+		for (int v = 0; v < _numValues; v++)
+		{
+			next.partialMinimum[v] = (std::min)(next.partialMinimum[v], level.partialMinimum[v]);
+			next.partialMaximum[v] = (std::max)(next.partialMaximum[v], level.partialMaximum[v]);
+		}
+		nextComplete = (++next.partialCount == FACTOR);
+	}
+
+	std::fill(level.partialMinimum.begin(), level.partialMinimum.end(), HUGE_VALF);
+	std::fill(level.partialMaximum.begin(), level.partialMaximum.end(), -HUGE_VALF);
+	level.partialCount = 0;
+
+	if (nextComplete)
+		CompleteBin(l + 1);
+	else if (l == NUM_LEVELS - 1 && _file.is_open())
+		WriteChunk(false);
+}
+
+bool EnvelopePyramid::GetBin(int l, int value, long long bin, float *minimum, float *maximum) const
+{
+	const Level &level = _levels[l];
+
+	if (bin < 0 || bin < level.numBins - level.capacity || bin > level.numBins)
+		return false;
+
+	if (bin < level.numBins)
+	{
+		size_t index = (size_t) (value * level.capacity + bin % level.capacity);
+		*minimum = level.minimum[index];
+		*maximum = (l == 0) ? level.minimum[index] : level.maximum[index];
+		return true;
+	}
+
+	//the bin being filled: its partial envelope and those of the finer bins being filled inside it
+	bool received = false;
+	*minimum = HUGE_VALF;
+	*maximum = -HUGE_VALF;
+	for (int k = l; k >= 1; k--)
+	{
+		const Level &finer = _levels[k];
+		if (finer.partialCount > 0)
+		{
+			*minimum = (std::min)(*minimum, finer.partialMinimum[value]);
+			*maximum = (std::max)(*maximum, finer.partialMaximum[value]);
+			received = true;
+		}
+	}
+	return received;
+}
+
+int EnvelopePyramid::GetEnvelope(const int *values, int numValues, long long startScan, long long numScans, int width, float *minimum, float *maximum)
+{
+	if (numValues < 1 || numScans < 1 || width < 1)
+		return -1;
+	for (int i = 0; i < numValues; i++)
+		if (values[i] < 0 || values[i] >= _numValues)
+			return -1;
+
+	std::lock_guard<std::mutex> lock(_lock);
+
+	int l = ChooseLevel(numScans, width);
+
+	for (int p = 0; p < width; p++)
+	{
+		long long firstBin, endBin;
+		PixelBins(startScan, numScans, width, p, l, &firstBin, &endBin);
+
+		for (int i = 0; i < numValues; i++)
+		{
+			float pixelMinimum = HUGE_VALF, pixelMaximum = -HUGE_VALF;
+			bool received = false;
+			for (long long bin = firstBin; bin < endBin; bin++)
+			{
+				float binMinimum, binMaximum;
+				if (GetBin(l, values[i], bin, &binMinimum, &binMaximum))
+				{
+					pixelMinimum = (std::min)(pixelMinimum, binMinimum);
+					pixelMaximum = (std::max)(pixelMaximum, binMaximum);
+					received = true;
+				}
+			}
+			minimum[(size_t) i * width + p] = received ? pixelMinimum : NAN;
+			maximum[(size_t) i * width + p] = received ? pixelMaximum : NAN;
+		}
+	}
+	return l;
+}
+
+long long EnvelopePyramid::NumScans()
+{
+	std::lock_guard<std::mutex> lock(_lock);
+
+	return _numScans;
+}
+
+bool EnvelopePyramid::OpenFile(const char *fileName)
+{
+	std::lock_guard<std::mutex> lock(_lock);
+
+	if (_file.is_open())
+		_file.close();
+	_file.clear();
+	_file.open(fileName, std::ios::out | std::ios::trunc | std::ios::binary);
+	if (!_file.is_open())
+		return false;
+
+	int header[6] = { FILE_VERSION, _sampleRate, _numValues, FACTOR, NUM_LEVELS, FILE_FIRST_LEVEL };
+	_file.write((const char *) header, sizeof(header));
+	return true;
+}
+
+void EnvelopePyramid::CloseFile()
+{
+	std::lock_guard<std::mutex> lock(_lock);
+
+	if (!_file.is_open())
+		return;
+
+	//the scans after the last complete chunk
+	if (_numScans > _levels[NUM_LEVELS - 1].numBins * BinScans(NUM_LEVELS - 1))
+		WriteChunk(true);
+	_file.close();
+}
+
+void EnvelopePyramid::WriteChunk(bool partial)
+{
+	long long chunk = _levels[NUM_LEVELS - 1].numBins - (partial ? 0 : 1);
+	float *out = &_chunk[0];
+
+	//each level: the minima of every value, then their maxima, bins missing from a partial chunk are NaN
+	for (int l = FILE_FIRST_LEVEL; l < NUM_LEVELS; l++)
+	{
+		int chunkBins = ChunkBins(l);
+		long long firstBin = chunk * chunkBins;
+		for (int v = 0; v < _numValues; v++)
+		{
+			for (int i = 0; i < chunkBins; i++)
+			{
+				float binMinimum, binMaximum;
+				bool received = GetBin(l, v, firstBin + i, &binMinimum, &binMaximum);
+				out[(size_t) v * chunkBins + i] = received ? binMinimum : NAN;
+				out[(size_t) (_numValues + v) * chunkBins + i] = received ? binMaximum : NAN;
+			}
+		}
+		out += (size_t) 2 * _numValues * chunkBins;
+	}
+
+	_file.write((const char *) &_chunk[0], _chunk.size() * sizeof(float));
+	_file.flush();
+}
+
+long long EnvelopePyramid::BinScans(int level)
+{
+	long long scans = 1;
+	for (int l = 0; l < level; l++)
+		scans *= FACTOR;
+	return scans;
+}
+
+int EnvelopePyramid::ChunkBins(int level)
+{
+	return (int) BinScans(NUM_LEVELS - 1 - level);
+}
+
+long long EnvelopePyramid::ChunkFloats(int numValues)
+{
+	long long bins = 0;
+	for (int l = FILE_FIRST_LEVEL; l < NUM_LEVELS; l++)
+		bins += ChunkBins(l);
+	return 2 * numValues * bins;
+}
+
+int EnvelopePyramid::ChooseLevel(long long numScans, int width)
+{
+	int level = 0;
+	while (level + 1 < NUM_LEVELS && BinScans(level + 1) * width <= numScans)
+		level++;
+	return level;
+}
+
+void EnvelopePyramid::PixelScans(long long startScan, long long numScans, int width, int pixel, long long *first, long long *end)
+{
+	*first = startScan + (long long) pixel * numScans / width;
+	*end = startScan + (long long) (pixel + 1) * numScans / width;
+	if (*end <= *first)
+		*end = *first + 1;
+}
+
+void EnvelopePyramid::PixelBins(long long startScan, long long numScans, int width, int pixel, int level, long long *firstBin, long long *endBin)
+{
+	long long first, end;
+	PixelScans(startScan, numScans, width, pixel, &first, &end);
+	*firstBin = FloorDiv(first, BinScans(level));
+	*endBin = FloorDiv(end - 1, BinScans(level)) + 1;
+}
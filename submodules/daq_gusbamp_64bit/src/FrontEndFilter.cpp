@@ -0,0 +1,80 @@
+#include <vector>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <iostream>
+#include "FrontEndFilter.h"
+
+// Constructor
+FrontEndFilter::FrontEndFilter(std::vector<double> num, std::vector<double> den, int numChannels)
+{
+	if (den.empty())
+		den.push_back(1.0);
+	if (num.empty())
+		num.push_back(1.0);
+
+	// both polynomials padded to the same length and normalized by den(1), as filter does
+	_order = (int) std::max(num.size(), den.size()) - 1;
+	num.resize(_order + 1, 0.0);
+	den.resize(_order + 1, 0.0);
+	for (int i = 0; i <= _order; i++)
+	{
+		_num.push_back(num[i] / den[0]);
+		_den.push_back(den[i] / den[0]);
+	}
+
+	_numChannels = numChannels;
+	Reset();
+}
+
+void FrontEndFilter::Reset()
+{
+	_state.assign(_order * _numChannels, 0.0);
+}
+
+void FrontEndFilter::Apply(float *scans, int numScans, int scanStride)
+{
+	for (int c = 0; c < _numChannels; c++)
+	{
+		double *z = _order ? &_state[c * _order] : NULL;
+		float *x = scans + c;
+
+		for (int n = 0; n < numScans; n++, x += scanStride)
+		{
+			double in = *x;
+			double out = _num[0] * in + (_order ? z[0] : 0.0);
+
+			for (int i = 1; i < _order; i++)
+				z[i - 1] = _num[i] * in + z[i] - _den[i] * out;
+			if (_order)
+				z[_order - 1] = _num[_order] * in - _den[_order] * out;
+
+			*x = (float) out;
+		}
+	}
+}
+
+bool FrontEndFilter::ReadCoefficients(const char *fileName, std::vector<double> &num, std::vector<double> &den)
+{
+	num.clear();
+	den.clear();
+
+	std::ifstream file(fileName);
+	std::string line;
+	for (int row = 0; row < 2 && std::getline(file, line); row++)
+	{
+		std::istringstream values(line);
+		double value;
+		while (values >> value)
+			(row == 0 ? num : den).push_back(value);
+	}
+
+	if (num.empty() || (!den.empty() && den[0] == 0))
+	{
+		// error 37
+		std::cout << "Error on FrontEndFilter::ReadCoefficients: no valid coefficients in " << fileName << "\n";
+		return false;
+	}
+	return true;
+}
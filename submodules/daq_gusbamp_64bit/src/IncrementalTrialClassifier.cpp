@@ -0,0 +1,290 @@
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <algorithm>
+#include <math.h>
+#include "SSVEPFeatureEngine.h"
+#include "IncrementalTrialClassifier.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Constructor
+IncrementalTrialClassifier::IncrementalTrialClassifier(int sampleRate, std::vector<int> channelIndices, int triggerIndex,
+	std::vector<double> stimFrequencies, int numHarmonics, std::vector<double> prior,
+	double threshold, int minTrialLength, double evidenceGain)
+{
+	_sampleRate = sampleRate;
+	_channelIndices = channelIndices;
+	_triggerIndex = triggerIndex;
+	_stimFrequencies = stimFrequencies;
+	_numHarmonics = numHarmonics;
+	_threshold = threshold;
+	_minTrialLength = std::max(minTrialLength, 2);
+	_evidenceGain = evidenceGain;
+
+	//uniform prior if none (or a wrong one) is given
+	if (prior.size() != stimFrequencies.size())
+		prior.assign(stimFrequencies.size(), 1.0 / stimFrequencies.size());
+
+	for (size_t classIndex = 0; classIndex < prior.size(); classIndex++)
+		_logPrior.push_back(log(std::max(prior[classIndex], 1e-300)));
+
+	//a sine and a cosine per harmonic below Nyquist, in the order of CCAReference
+	int numChannels = (int) _channelIndices.size();
+	_templateFrequencies.resize(_stimFrequencies.size());
+	_sumY.resize(_stimFrequencies.size());
+	_sumYY.resize(_stimFrequencies.size());
+	_sumXY.resize(_stimFrequencies.size());
+	for (size_t classIndex = 0; classIndex < _stimFrequencies.size(); classIndex++)
+	{
+		for (int h = 1; h <= _numHarmonics && h * _stimFrequencies[classIndex] < _sampleRate / 2.0; h++)
+		{
+			_templateFrequencies[classIndex].push_back(2 * M_PI * h * _stimFrequencies[classIndex] / _sampleRate);
+			_templateFrequencies[classIndex].push_back(2 * M_PI * h * _stimFrequencies[classIndex] / _sampleRate);
+		}
+		int numTemplates = (int) _templateFrequencies[classIndex].size();
+		_sumY[classIndex].resize(numTemplates);
+		_sumYY[classIndex].resize(numTemplates * numTemplates);
+		_sumXY[classIndex].resize(numChannels * numTemplates);
+	}
+	_origin.resize(numChannels);
+	_sumX.resize(numChannels);
+	_sumXX.resize(numChannels * numChannels);
+	_scanValues.resize(numChannels);
+	_templateValues.resize(2 * std::max(_numHarmonics, 0));
+
+	Reset();
+}
+
+void IncrementalTrialClassifier::Reset()
+{
+	std::lock_guard<std::mutex> lock(_stateLock);
+
+	ClearTrial();
+
+	_triggerOn = false;
+	_state = TRIAL_IDLE;
+	_aPosteriori.assign(_stimFrequencies.size(), 1.0 / std::max((int) _stimFrequencies.size(), 1));
+	_classIndex = -1;
+	_numTrialSamples = 0;
+	_decisionPending = false;
+}
+
+bool IncrementalTrialClassifier::PushBlock(const float *block, int numScans, int scanStride)
+{
+	bool decisionAvailable = false;
+	int numChannels = (int) _channelIndices.size();
+
+	for (int scanIndex = 0; scanIndex < numScans; scanIndex++)
+	{
+		const float *scan = block + scanIndex * scanStride;
+		bool triggerOn = (scan[_triggerIndex] != 0);
+
+		//rising edge: a new trial starts from the prior
+		if (triggerOn && !_triggerOn)
+		{
+			std::lock_guard<std::mutex> lock(_stateLock);
+			ClearTrial();
+
+			_state = TRIAL_RUNNING;
+			for (size_t classIndex = 0; classIndex < _logPrior.size(); classIndex++)
+				_aPosteriori[classIndex] = exp(_logPrior[classIndex]);
+			_classIndex = -1;
+			_numTrialSamples = 0;
+			_decisionPending = false;
+		}
+
+		//falling edge: score whatever was received and close the trial
+		if (!triggerOn && _triggerOn)
+		{
+			if (_state == TRIAL_RUNNING && _trialLength >= 2)
+				UpdatePosterior();
+
+			std::lock_guard<std::mutex> lock(_stateLock);
+			if (_state == TRIAL_RUNNING)
+				_decisionPending = true;
+			_state = TRIAL_ENDED;
+			decisionAvailable = decisionAvailable || _decisionPending;
+			_decisionReady.notify_all();
+		}
+
+		_triggerOn = triggerOn;
+
+		if (_triggerOn)
+			AccumulateScan(scan);
+	}
+
+	//update once per block while the trial is undecided
+	if (_triggerOn && _state == TRIAL_RUNNING && numChannels > 0 && _trialLength >= _minTrialLength)
+	{
+		UpdatePosterior();
+
+		std::lock_guard<std::mutex> lock(_stateLock);
+		if (_aPosteriori[_classIndex] >= _threshold)
+		{
+			_state = TRIAL_DECIDED;
+			_decisionPending = true;
+			decisionAvailable = true;
+			_decisionReady.notify_all();
+		}
+	}
+
+	return decisionAvailable;
+}
+
+void IncrementalTrialClassifier::ClearTrial()
+{
+	_trialLength = 0;
+	std::fill(_sumX.begin(), _sumX.end(), 0.0);
+	std::fill(_sumXX.begin(), _sumXX.end(), 0.0);
+	for (size_t classIndex = 0; classIndex < _sumY.size(); classIndex++)
+	{
+		std::fill(_sumY[classIndex].begin(), _sumY[classIndex].end(), 0.0);
+		std::fill(_sumYY[classIndex].begin(), _sumYY[classIndex].end(), 0.0);
+		std::fill(_sumXY[classIndex].begin(), _sumXY[classIndex].end(), 0.0);
+	}
+}
+
+void IncrementalTrialClassifier::AccumulateScan(const float *scan)
+{
+	int numChannels = (int) _channelIndices.size();
+
+	if (_trialLength == 0)
+		for (int c = 0; c < numChannels; c++)
+			_origin[c] = scan[_channelIndices[c]];
+
+	for (int c = 0; c < numChannels; c++)
+	{
+		double x = scan[_channelIndices[c]] - _origin[c];
+		_scanValues[c] = x;
+		_sumX[c] += x;
+		for (int d = 0; d <= c; d++)
+			_sumXX[c * numChannels + d] += x * _scanValues[d];
+	}
+
+	//templates at this sample of the trial
+	for (size_t classIndex = 0; classIndex < _templateFrequencies.size(); classIndex++)
+	{
+		const std::vector<double> &frequencies = _templateFrequencies[classIndex];
+		int numTemplates = (int) frequencies.size();
+		for (int t = 0; t < numTemplates; t += 2)
+		{
+			_templateValues[t] = sin(frequencies[t] * _trialLength);
+			_templateValues[t + 1] = cos(frequencies[t] * _trialLength);
+		}
+
+		double *sumY = &_sumY[classIndex][0];
+		double *sumYY = &_sumYY[classIndex][0];
+		double *sumXY = &_sumXY[classIndex][0];
+		for (int t = 0; t < numTemplates; t++)
+		{
+			sumY[t] += _templateValues[t];
+			for (int u = 0; u <= t; u++)
+				sumYY[t * numTemplates + u] += _templateValues[t] * _templateValues[u];
+		}
+		for (int c = 0; c < numChannels; c++)
+			for (int t = 0; t < numTemplates; t++)
+				sumXY[c * numTemplates + t] += _scanValues[c] * _templateValues[t];
+	}
+
+	_trialLength++;
+}
+
+void IncrementalTrialClassifier::UpdatePosterior()
+{
+	int numChannels = (int) _channelIndices.size();
+	int length = _trialLength;
+	int numClasses = (int) _stimFrequencies.size();
+
+	//channel covariance from the sums
+	std::vector<double> covXX(numChannels * numChannels);
+	for (int i = 0; i < numChannels; i++)
+		for (int j = 0; j <= i; j++)
+		{
+			covXX[i * numChannels + j] = _sumXX[i * numChannels + j] - _sumX[i] * _sumX[j] / length;
+			covXX[j * numChannels + i] = covXX[i * numChannels + j];
+		}
+
+	std::vector<double> covYY, covXY;
+
+	//log posterior up to a constant, then normalize
+	std::vector<double> logPosterior(numClasses);
+	double largest = -1e300;
+	for (int classIndex = 0; classIndex < numClasses; classIndex++)
+	{
+		//template and cross covariances from the sums
+		int numTemplates = (int) _templateFrequencies[classIndex].size();
+		const std::vector<double> &sumY = _sumY[classIndex];
+		covYY.resize(numTemplates * numTemplates);
+		covXY.resize(numChannels * numTemplates);
+		for (int t = 0; t < numTemplates; t++)
+			for (int u = 0; u <= t; u++)
+			{
+				covYY[t * numTemplates + u] = _sumYY[classIndex][t * numTemplates + u] - sumY[t] * sumY[u] / length;
+				covYY[u * numTemplates + t] = covYY[t * numTemplates + u];
+			}
+		for (int c = 0; c < numChannels; c++)
+			for (int t = 0; t < numTemplates; t++)
+				covXY[c * numTemplates + t] = _sumXY[classIndex][c * numTemplates + t] - _sumX[c] * sumY[t] / length;
+
+		double rho = (numTemplates && numChannels) ? CCAReference::CanonicalCorrelation(&covXX[0], &covXY[0], &covYY[0], numChannels, numTemplates) : 0;
+		rho = std::min(rho, 1 - 1e-9);
+
+		logPosterior[classIndex] = _logPrior[classIndex] + length * _evidenceGain * 0.5 * log((1 + rho) / (1 - rho));
+		largest = std::max(largest, logPosterior[classIndex]);
+	}
+
+	std::vector<double> aPosteriori(numClasses);
+	double total = 0;
+	int best = 0;
+	for (int classIndex = 0; classIndex < numClasses; classIndex++)
+	{
+		aPosteriori[classIndex] = exp(logPosterior[classIndex] - largest);
+		total += aPosteriori[classIndex];
+		if (aPosteriori[classIndex] > aPosteriori[best])
+			best = classIndex;
+	}
+	for (int classIndex = 0; classIndex < numClasses; classIndex++)
+		aPosteriori[classIndex] /= total;
+
+	std::lock_guard<std::mutex> lock(_stateLock);
+	_aPosteriori.swap(aPosteriori);
+	_classIndex = best;
+	_numTrialSamples = length;
+}
+
+int IncrementalTrialClassifier::GetPosterior(double *aPosteriori, int *classIndex, int *numTrialSamples)
+{
+	std::lock_guard<std::mutex> lock(_stateLock);
+
+	if (aPosteriori != NULL)
+		std::copy(_aPosteriori.begin(), _aPosteriori.end(), aPosteriori);
+	if (classIndex != NULL)
+		*classIndex = _classIndex;
+	if (numTrialSamples != NULL)
+		*numTrialSamples = _numTrialSamples;
+
+	return _state;
+}
+
+bool IncrementalTrialClassifier::WaitForDecision(int timeoutMs, double *aPosteriori, int *classIndex, int *numTrialSamples)
+{
+	std::unique_lock<std::mutex> lock(_stateLock);
+
+	if (!_decisionReady.wait_for(lock, std::chrono::milliseconds(timeoutMs), [this] { return _decisionPending; }))
+		return false;
+
+	_decisionPending = false;
+
+	if (aPosteriori != NULL)
+		std::copy(_aPosteriori.begin(), _aPosteriori.end(), aPosteriori);
+	if (classIndex != NULL)
+		*classIndex = _classIndex;
+	if (numTrialSamples != NULL)
+		*numTrialSamples = _numTrialSamples;
+
+	return true;
+}
@@ -0,0 +1,158 @@
+#include <list>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <algorithm>
+#include "ReadNotifier.h"
+
+// Constructor
+ReadNotifier::ReadNotifier()
+{
+	_numWakeups = 0;
+	_wakeBlocks = 1;
+	Reset();
+}
+
+void ReadNotifier::Reset()
+{
+	std::lock_guard<std::mutex> lock(_lock);
+	_written = 0;
+	_read = 0;
+	_numBlocks = 0;
+	_lastTrigger = 0;
+	_closed = false;
+}
+
+void ReadNotifier::SetWakeBlocks(int wakeBlocks)
+{
+	std::lock_guard<std::mutex> lock(_lock);
+	_wakeBlocks = (wakeBlocks > 1) ? wakeBlocks : 1;
+}
+
+void ReadNotifier::Close()
+{
+	std::lock_guard<std::mutex> lock(_lock);
+	_closed = true;
+	for (std::list<Waiter *>::iterator it = _waiters.begin(); it != _waiters.end(); ++it)
+		(*it)->ready.notify_one();
+}
+
+void ReadNotifier::Publish(const float *block, int numScans, int scanStride, int triggerIndex)
+{
+	std::lock_guard<std::mutex> lock(_lock);
+
+	long long firstSample = _written;
+	_written += numScans;
+	bool wake = (++_numBlocks % _wakeBlocks == 0);
+	float previousTrigger = _lastTrigger;
+	if (triggerIndex >= 0 && numScans > 0)
+		_lastTrigger = block[(numScans - 1) * scanStride + triggerIndex];
+
+	for (std::list<Waiter *>::iterator it = _waiters.begin(); it != _waiters.end(); ++it)
+	{
+		Waiter *waiter = *it;
+		if (waiter->satisfied)
+		{
+			//met on a block that didn't wake the readers
+			if (wake)
+				waiter->ready.notify_one();
+			continue;
+		}
+
+		if (waiter->numSamples >= 0)
+			waiter->satisfied = (_written - _read >= waiter->numSamples);
+		else if (triggerIndex >= 0)
+		{
+			//first scan of this block where the trigger changes to the value waited for
+			float trigger = previousTrigger;
+			for (int i = 0; i < numScans && !waiter->satisfied; i++)
+			{
+				float value = block[i * scanStride + triggerIndex];
+				bool match = (waiter->triggerValue == ANY_TRIGGER) ? (value != 0) : (value == waiter->triggerValue);
+				if (match && value != trigger)
+				{
+					waiter->satisfied = true;
+					waiter->triggerSample = firstSample + i;
+				}
+				trigger = value;
+			}
+		}
+
+		if (waiter->satisfied && wake)
+			waiter->ready.notify_one();
+	}
+}
+
+void ReadNotifier::Consume(long long numSamples)
+{
+	std::lock_guard<std::mutex> lock(_lock);
+	_read += numSamples;
+}
+
+void ReadNotifier::Discard()
+{
+	std::lock_guard<std::mutex> lock(_lock);
+	_read = _written;
+}
+
+bool ReadNotifier::WaitForSamples(long long numSamples, int timeoutMs)
+{
+	std::unique_lock<std::mutex> lock(_lock);
+	if (_written - _read >= numSamples)
+		return true;
+
+	Waiter waiter;
+	waiter.numSamples = numSamples;
+	waiter.triggerValue = 0;
+	waiter.satisfied = false;
+	waiter.triggerSample = -1;
+	return Wait(lock, waiter, timeoutMs);
+}
+
+long long ReadNotifier::WaitForTrigger(int triggerValue, int timeoutMs)
+{
+	std::unique_lock<std::mutex> lock(_lock);
+
+	Waiter waiter;
+	waiter.numSamples = -1;
+	waiter.triggerValue = triggerValue;
+	waiter.satisfied = false;
+	waiter.triggerSample = -1;
+	if (!Wait(lock, waiter, timeoutMs))
+		return -1;
+
+	return waiter.triggerSample - _read;
+}
+
+bool ReadNotifier::Wait(std::unique_lock<std::mutex> &lock, Waiter &waiter, int timeoutMs)
+{
+	if (_closed)
+		return false;
+
+	std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(std::max(timeoutMs, 0));
+
+	_waiters.push_back(&waiter);
+	while (!waiter.satisfied && !_closed)
+	{
+		if (timeoutMs < 0)
+			waiter.ready.wait(lock);
+		else if (waiter.ready.wait_until(lock, deadline) == std::cv_status::timeout)
+			break;
+		_numWakeups++;
+	}
+	_waiters.remove(&waiter);
+
+	return waiter.satisfied;
+}
+
+long long ReadNotifier::AvailableSamples()
+{
+	std::lock_guard<std::mutex> lock(_lock);
+	return _written - _read;
+}
+
+long long ReadNotifier::NumWakeups()
+{
+	std::lock_guard<std::mutex> lock(_lock);
+	return _numWakeups;
+}
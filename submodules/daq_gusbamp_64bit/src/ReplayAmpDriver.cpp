@@ -0,0 +1,159 @@
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+#include <afxwin.h>
+#include "gUSBamp.h"
+#include "SessionFile.h"
+#include "ReplayAmpDriver.h"
+
+// Channels of one amplifier
+static const int AMPLIFIER_CHANNELS = 16;
+
+// Constructor
+ReplayAmpDriver::ReplayAmpDriver(double speed, bool loop) : SimulatedAmpDriver(0, 0, 0, 0)
+{
+	_speed = speed;
+	_loop = loop;
+	_numAmplifiers = 0;
+}
+
+// Destructor
+ReplayAmpDriver::~ReplayAmpDriver()
+{
+	//the sample clocks read the recording, stop them while it is mapped
+	std::vector<HANDLE> devices;
+	{
+		std::lock_guard<std::mutex> lock(_columnsLock);
+		for (std::map<HANDLE, ReplayColumns>::iterator it = _replayColumns.begin(); it != _replayColumns.end(); ++it)
+			devices.push_back(it->first);
+	}
+	for (size_t i = 0; i < devices.size(); i++)
+		CloseDevice(&devices[i]);
+}
+
+bool ReplayAmpDriver::Open(const char *fileName)
+{
+	if (!_session.Open(fileName) || _session.NumChannels() < 1)
+		return false;
+
+	_numAmplifiers = 0;
+	for (int i = 0; i < _session.NumChannels(); i++)
+		_numAmplifiers = (std::max)(_numAmplifiers, (_session.ChannelList()[i] - 1) / AMPLIFIER_CHANNELS + 1);
+	return true;
+}
+
+HANDLE ReplayAmpDriver::OpenDevice(int usbPort)
+{
+	if (usbPort < 0 || usbPort >= _numAmplifiers)
+		return NULL;
+
+	char serial[16];
+	sprintf(serial, "UB-REPLAY.%02d", usbPort + 1);
+	return OpenDeviceEx(serial);
+}
+
+HANDLE ReplayAmpDriver::OpenDeviceEx(LPSTR serial)
+{
+	//the master (k = 1) has the highest channels
+	int k = 0;
+	if (sscanf(serial, "UB-REPLAY.%d", &k) != 1 || k < 1 || k > _numAmplifiers)
+		return NULL;
+
+	HANDLE hDevice = SimulatedAmpDriver::OpenDeviceEx(serial);
+
+	std::lock_guard<std::mutex> lock(_columnsLock);
+	_replayColumns[hDevice].amplifier = _numAmplifiers - k;
+	return hDevice;
+}
+
+BOOL ReplayAmpDriver::CloseDevice(HANDLE *hDevice)
+{
+	HANDLE device = *hDevice;
+	if (!SimulatedAmpDriver::CloseDevice(hDevice))
+		return FALSE;
+
+	std::lock_guard<std::mutex> lock(_columnsLock);
+	_replayColumns.erase(device);
+	return TRUE;
+}
+
+BOOL ReplayAmpDriver::SetChannels(HANDLE hDevice, UCHAR *channels, UCHAR numChannels)
+{
+	//the recording holds the channels of the master first, then those of the amplifiers below it, as merged
+	std::map<int, int> recordedColumns;
+	int numColumns = 0;
+	for (int a = _numAmplifiers - 1; a >= 0; a--)
+		for (int i = 0; i < _session.NumChannels(); i++)
+			if ((_session.ChannelList()[i] - 1) / AMPLIFIER_CHANNELS == a)
+				recordedColumns[_session.ChannelList()[i]] = numColumns++;
+
+	std::lock_guard<std::mutex> lock(_columnsLock);
+	ReplayColumns &replay = _replayColumns[hDevice];
+	replay.columns.clear();
+	for (int i = 0; i < numChannels; i++)
+	{
+		std::map<int, int>::iterator column = recordedColumns.find(replay.amplifier * AMPLIFIER_CHANNELS + channels[i]);
+		if (column == recordedColumns.end())
+			return FALSE;
+		replay.columns.push_back(column->second);
+	}
+	replay.columns.push_back(_session.TriggerFlag() ? _session.NumChannels() : -1);
+
+	return SimulatedAmpDriver::SetChannels(hDevice, channels, numChannels);
+}
+
+BOOL ReplayAmpDriver::SetSampleRate(HANDLE hDevice, WORD sampleRate)
+{
+	if (sampleRate != _session.SampleRate())
+		return FALSE;
+
+	return SimulatedAmpDriver::SetSampleRate(hDevice, sampleRate);
+}
+
+bool ReplayAmpDriver::ProduceScans(HANDLE hDevice, long long firstScan, int numScans, int numChannels, int trigger, float digitalOut, float *scans)
+{
+	long long recordedScans = _session.NumScans();
+	if (recordedScans < numScans || (!_loop && firstScan + numScans > recordedScans))
+		return false;
+
+	std::vector<int> columns;
+	{
+		std::lock_guard<std::mutex> lock(_columnsLock);
+		columns = _replayColumns[hDevice].columns;
+	}
+
+	//channels that were not recorded have nothing to replay
+	if ((int) columns.size() != numChannels + 1)
+		return false;
+
+	int triggerColumn = columns.back();
+	columns.pop_back();
+	if (trigger && triggerColumn >= 0)
+		columns.push_back(triggerColumn);
+
+	//a looped recording is read in two slices around its end
+	int numValues = (int) columns.size();
+	for (int scanIndex = 0; scanIndex < numScans;)
+	{
+		long long scan = (firstScan + scanIndex) % recordedScans;
+		int sliceScans = (int) (std::min)((long long) (numScans - scanIndex), recordedScans - scan);
+		if (!_session.ReadSlice(columns, scan, sliceScans, 1.0, scans + (size_t) scanIndex * numValues))
+			return false;
+		scanIndex += sliceScans;
+	}
+
+	//without a recorded trigger the digital outputs are looped back, spreading the scans from the last one
+	if (trigger && triggerColumn < 0)
+	{
+		for (int scanIndex = numScans - 1; scanIndex >= 0; scanIndex--)
+		{
+			memmove(scans + (size_t) scanIndex * (numChannels + 1), scans + (size_t) scanIndex * numChannels, numChannels * sizeof(float));
+			scans[(size_t) scanIndex * (numChannels + 1) + numChannels] = digitalOut;
+		}
+	}
+	return true;
+}
@@ -0,0 +1,378 @@
+#include <vector>
+#include <mutex>
+#include <algorithm>
+#include <math.h>
+#include "SSVEPFeatureEngine.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Constructor
+CCAReference::CCAReference(double frequency, int sampleRate, int numHarmonics, int length)
+{
+	_length = length;
+	_numTemplates = 0;
+
+	// one sine and one cosine for each harmonic below Nyquist
+	for (int h = 1; h <= numHarmonics; h++)
+	{
+		if (h * frequency >= sampleRate / 2.0)
+			break;
+
+		double w = 2 * M_PI * h * frequency / sampleRate;
+		for (int phase = 0; phase < 2; phase++)
+		{
+			double mean = 0;
+			for (int n = 0; n < _length; n++)
+			{
+				double value = phase ? cos(w * n) : sin(w * n);
+				_templates.push_back(value);
+				mean += value;
+			}
+
+			//center the template
+			mean /= _length;
+			for (int n = 0; n < _length; n++)
+				_templates[_numTemplates * _length + n] -= mean;
+
+			_numTemplates++;
+		}
+	}
+
+	//every harmonic at or above Nyquist: no template, Correlate returns 0
+	if (_numTemplates == 0)
+		return;
+
+	//template covariance
+	_covYY.assign(_numTemplates * _numTemplates, 0);
+	for (int i = 0; i < _numTemplates; i++)
+		for (int j = 0; j <= i; j++)
+		{
+			double sum = 0;
+			for (int n = 0; n < _length; n++)
+				sum += _templates[i * _length + n] * _templates[j * _length + n];
+			_covYY[i * _numTemplates + j] = sum;
+			_covYY[j * _numTemplates + i] = sum;
+		}
+}
+
+bool CCAReference::Cholesky(double *A, int n)
+{
+	for (int j = 0; j < n; j++)
+	{
+		double diag = A[j * n + j];
+		for (int k = 0; k < j; k++)
+			diag -= A[j * n + k] * A[j * n + k];
+
+		if (diag <= 0)
+			return false;
+
+		A[j * n + j] = sqrt(diag);
+
+		for (int i = j + 1; i < n; i++)
+		{
+			double sum = A[i * n + j];
+			for (int k = 0; k < j; k++)
+				sum -= A[i * n + k] * A[j * n + k];
+			A[i * n + j] = sum / A[j * n + j];
+		}
+
+		//clear upper triangle so the factor can be used as is
+		for (int i = 0; i < j; i++)
+			A[i * n + j] = 0;
+	}
+	return true;
+}
+
+double CCAReference::LargestEigenvalue(double *A, int n)
+{
+	//cyclic Jacobi sweeps until the off diagonal mass vanishes
+	for (int sweep = 0; sweep < 50; sweep++)
+	{
+		double offDiagonal = 0;
+		for (int p = 0; p < n; p++)
+			for (int q = p + 1; q < n; q++)
+				offDiagonal += A[p * n + q] * A[p * n + q];
+
+		if (offDiagonal < 1e-22)
+			break;
+
+		for (int p = 0; p < n; p++)
+			for (int q = p + 1; q < n; q++)
+			{
+				double apq = A[p * n + q];
+				if (fabs(apq) < 1e-300)
+					continue;
+
+				double theta = (A[q * n + q] - A[p * n + p]) / (2 * apq);
+				double t = (theta >= 0 ? 1.0 : -1.0) / (fabs(theta) + sqrt(theta * theta + 1));
+				double c = 1 / sqrt(t * t + 1);
+				double s = t * c;
+
+				for (int k = 0; k < n; k++)
+				{
+					double akp = A[k * n + p];
+					double akq = A[k * n + q];
+					A[k * n + p] = c * akp - s * akq;
+					A[k * n + q] = s * akp + c * akq;
+				}
+				for (int k = 0; k < n; k++)
+				{
+					double apk = A[p * n + k];
+					double aqk = A[q * n + k];
+					A[p * n + k] = c * apk - s * aqk;
+					A[q * n + k] = s * apk + c * aqk;
+				}
+			}
+	}
+
+	double largest = A[0];
+	for (int i = 1; i < n; i++)
+		largest = std::max(largest, A[i * n + i]);
+	return largest;
+}
+
+double CCAReference::Correlate(const double *window, int numChannels) const
+{
+	if (_numTemplates == 0 || numChannels == 0)
+		return 0;
+
+	//channel means (templates are already centered)
+	std::vector<double> means(numChannels, 0);
+	for (int c = 0; c < numChannels; c++)
+	{
+		for (int n = 0; n < _length; n++)
+			means[c] += window[c * _length + n];
+		means[c] /= _length;
+	}
+
+	//channel covariance
+	std::vector<double> covXX(numChannels * numChannels, 0);
+	for (int i = 0; i < numChannels; i++)
+		for (int j = 0; j <= i; j++)
+		{
+			double sum = 0;
+			for (int n = 0; n < _length; n++)
+				sum += (window[i * _length + n] - means[i]) * (window[j * _length + n] - means[j]);
+			covXX[i * numChannels + j] = sum;
+			covXX[j * numChannels + i] = sum;
+		}
+
+	//cross covariance, numChannels x numTemplates
+	std::vector<double> covXY(numChannels * _numTemplates, 0);
+	for (int i = 0; i < numChannels; i++)
+		for (int j = 0; j < _numTemplates; j++)
+		{
+			double sum = 0;
+			for (int n = 0; n < _length; n++)
+				sum += window[i * _length + n] * _templates[j * _length + n];
+			covXY[i * _numTemplates + j] = sum;
+		}
+
+	return CanonicalCorrelation(&covXX[0], &covXY[0], &_covYY[0], numChannels, _numTemplates);
+}
+
+double CCAReference::CanonicalCorrelation(const double *covXX, const double *covXY, const double *covYY, int numX, int numY)
+{
+	if (numX == 0 || numY == 0)
+		return 0;
+
+	//factor both covariances with a small ridge, so flat channels and short windows don't break the factorization
+	std::vector<double> cholXX(covXX, covXX + numX * numX);
+	std::vector<double> cholYY(covYY, covYY + numY * numY);
+	double traceXX = 0, traceYY = 0;
+	for (int i = 0; i < numX; i++)
+		traceXX += cholXX[i * numX + i];
+	for (int j = 0; j < numY; j++)
+		traceYY += cholYY[j * numY + j];
+
+	if (traceXX <= 0 || traceYY <= 0)
+		return 0;
+
+	for (int i = 0; i < numX; i++)
+		cholXX[i * numX + i] += 1e-9 * traceXX / numX;
+	for (int j = 0; j < numY; j++)
+		cholYY[j * numY + j] += 1e-9 * traceYY / numY;
+
+	if (!Cholesky(&cholXX[0], numX) || !Cholesky(&cholYY[0], numY))
+		return 0;
+
+	//whiten the channel side by forward substitution
+	std::vector<double> whitened(covXY, covXY + numX * numY);
+	for (int j = 0; j < numY; j++)
+		for (int i = 0; i < numX; i++)
+		{
+			double sum = whitened[i * numY + j];
+			for (int k = 0; k < i; k++)
+				sum -= cholXX[i * numX + k] * whitened[k * numY + j];
+			whitened[i * numY + j] = sum / cholXX[i * numX + i];
+		}
+
+	//whiten the template side, row by row
+	for (int i = 0; i < numX; i++)
+		for (int j = 0; j < numY; j++)
+		{
+			double sum = whitened[i * numY + j];
+			for (int k = 0; k < j; k++)
+				sum -= whitened[i * numY + k] * cholYY[j * numY + k];
+			whitened[i * numY + j] = sum / cholYY[j * numY + j];
+		}
+
+	//squared canonical correlations are the eigenvalues of M'M
+	std::vector<double> gram(numY * numY, 0);
+	for (int i = 0; i < numY; i++)
+		for (int j = 0; j <= i; j++)
+		{
+			double sum = 0;
+			for (int k = 0; k < numX; k++)
+				sum += whitened[k * numY + i] * whitened[k * numY + j];
+			gram[i * numY + j] = sum;
+			gram[j * numY + i] = sum;
+		}
+
+	double rho2 = LargestEigenvalue(&gram[0], numY);
+	return sqrt(std::min(std::max(rho2, 0.0), 1.0));
+}
+
+// Constructor
+SSVEPFeatureEngine::SSVEPFeatureEngine(int sampleRate, std::vector<int> channelIndices, std::vector<double> stimFrequencies,
+	int numHarmonics, int windowLength, int hopLength)
+{
+	_sampleRate = sampleRate;
+	_channelIndices = channelIndices;
+	_stimFrequencies = stimFrequencies;
+	_numHarmonics = numHarmonics;
+	_windowLength = std::max(windowLength, 2);
+	_hopLength = std::max(hopLength, 1);
+
+	_window.resize(_channelIndices.size() * _windowLength);
+	_linearWindow.resize(_channelIndices.size() * _windowLength);
+
+	_goertzelOffset.push_back(0);
+	for (size_t classIndex = 0; classIndex < _stimFrequencies.size(); classIndex++)
+	{
+		for (int h = 1; h <= _numHarmonics; h++)
+		{
+			if (h * _stimFrequencies[classIndex] >= _sampleRate / 2.0)
+				break;
+			_goertzelCoeff.push_back(2 * cos(2 * M_PI * h * _stimFrequencies[classIndex] / _sampleRate));
+		}
+		_goertzelOffset.push_back((int) _goertzelCoeff.size());
+
+		_references.push_back(CCAReference(_stimFrequencies[classIndex], _sampleRate, _numHarmonics, _windowLength));
+	}
+
+	Reset();
+}
+
+void SSVEPFeatureEngine::Reset()
+{
+	{
+		std::lock_guard<std::mutex> lock(_windowLock);
+		std::fill(_window.begin(), _window.end(), 0.0);
+		_writeIndex = 0;
+		_filledSamples = 0;
+		_samplesSinceUpdate = 0;
+	}
+
+	std::lock_guard<std::mutex> lock(_scoreLock);
+	_bandPower.assign(_stimFrequencies.size(), 0);
+	_canonicalCorrelation.assign(_stimFrequencies.size(), 0);
+	_updateCount = 0;
+}
+
+void SSVEPFeatureEngine::PushBlock(const float *block, int numScans, int scanStride)
+{
+	std::lock_guard<std::mutex> lock(_windowLock);
+
+	int numChannels = (int) _channelIndices.size();
+
+	for (int scanIndex = 0; scanIndex < numScans; scanIndex++)
+	{
+		const float *scan = block + scanIndex * scanStride;
+		for (int c = 0; c < numChannels; c++)
+			_window[c * _windowLength + _writeIndex] = scan[_channelIndices[c]];
+
+		_writeIndex = (_writeIndex + 1) % _windowLength;
+		_filledSamples = std::min(_filledSamples + 1, _windowLength);
+		_samplesSinceUpdate++;
+
+		//score as soon as a full window is available and on every hop after that
+		if (_filledSamples == _windowLength && _samplesSinceUpdate >= _hopLength)
+		{
+			ComputeScores();
+			_samplesSinceUpdate = 0;
+		}
+	}
+}
+
+void SSVEPFeatureEngine::ComputeScores()
+{
+	int numChannels = (int) _channelIndices.size();
+	int numClasses = (int) _stimFrequencies.size();
+
+	//unwrap the ring (oldest sample first) and remove the channel mean
+	for (int c = 0; c < numChannels; c++)
+	{
+		const double *ring = &_window[c * _windowLength];
+		double *linear = &_linearWindow[c * _windowLength];
+		int firstPart = _windowLength - _writeIndex;
+
+		std::copy(ring + _writeIndex, ring + _windowLength, linear);
+		std::copy(ring, ring + _writeIndex, linear + firstPart);
+
+		double mean = 0;
+		for (int n = 0; n < _windowLength; n++)
+			mean += linear[n];
+		mean /= _windowLength;
+		for (int n = 0; n < _windowLength; n++)
+			linear[n] -= mean;
+	}
+
+	std::vector<double> bandPower(numClasses, 0);
+	std::vector<double> canonicalCorrelation(numClasses, 0);
+
+	for (int classIndex = 0; classIndex < numClasses; classIndex++)
+	{
+		//power of a sinusoid with amplitude A is A^2/2 = 2|X|^2/N^2
+		for (int k = _goertzelOffset[classIndex]; k < _goertzelOffset[classIndex + 1]; k++)
+		{
+			double coeff = _goertzelCoeff[k];
+			for (int c = 0; c < numChannels; c++)
+			{
+				const double *x = &_linearWindow[c * _windowLength];
+				double s1 = 0, s2 = 0;
+				for (int n = 0; n < _windowLength; n++)
+				{
+					double s0 = x[n] + coeff * s1 - s2;
+					s2 = s1;
+					s1 = s0;
+				}
+				double magnitude2 = s1 * s1 + s2 * s2 - coeff * s1 * s2;
+				bandPower[classIndex] += 2 * magnitude2 / ((double) _windowLength * _windowLength);
+			}
+		}
+		if (numChannels > 0)
+			bandPower[classIndex] /= numChannels;
+
+		canonicalCorrelation[classIndex] = _references[classIndex].Correlate(&_linearWindow[0], numChannels);
+	}
+
+	std::lock_guard<std::mutex> lock(_scoreLock);
+	_bandPower.swap(bandPower);
+	_canonicalCorrelation.swap(canonicalCorrelation);
+	_updateCount++;
+}
+
+int SSVEPFeatureEngine::GetScores(double *bandPower, double *canonicalCorrelation)
+{
+	std::lock_guard<std::mutex> lock(_scoreLock);
+
+	if (bandPower != NULL)
+		std::copy(_bandPower.begin(), _bandPower.end(), bandPower);
+	if (canonicalCorrelation != NULL)
+		std::copy(_canonicalCorrelation.begin(), _canonicalCorrelation.end(), canonicalCorrelation);
+
+	return _updateCount;
+}
@@ -0,0 +1,224 @@
+#include <vector>
+#include <string.h>
+#include <math.h>
+#if defined(__F16C__) || defined(__AVX2__)
+#include <immintrin.h>
+#define SAMPLECODEC_F16C
+#endif
+#include "SampleCodec.h"
+
+const float SampleCodec::DEFAULT_INT16_GAIN = 0.1f;
+const float SampleCodec::HALF_MAX = 65504.0f;
+
+// Largest int16 lane of a channel (the lowest one, -32768, is left unused so the range is symmetric)
+static const float INT16_MAX_STEPS = 32767.0f;
+
+// Constructor
+SampleCodec::SampleCodec()
+{
+	_storage = STORAGE_FLOAT32;
+	_numChannels = 0;
+	_trigger = false;
+}
+
+bool SampleCodec::Configure(SampleStorage storage, int numChannels, bool trigger, std::vector<float> gains)
+{
+	if (numChannels < 0 || (!gains.empty() && (int) gains.size() != numChannels))
+		return false;
+
+	for (size_t i = 0; i < gains.size(); i++)
+		if (!(gains[i] > 0))
+			return false;
+
+	if (gains.empty())
+		gains.assign(numChannels, DEFAULT_INT16_GAIN);
+
+	_storage = storage;
+	_numChannels = numChannels;
+	_trigger = trigger;
+	_gains = gains;
+	_inverseGains.resize(numChannels);
+	for (int i = 0; i < numChannels; i++)
+		_inverseGains[i] = 1.0f / gains[i];
+
+	return true;
+}
+
+SampleStorage SampleCodec::Storage() const
+{
+	return _storage;
+}
+
+int SampleCodec::ScanStride() const
+{
+	return _numChannels + (_trigger ? 1 : 0);
+}
+
+long long SampleCodec::Encode(const float *scans, int numScans, uint16_t *lanes) const
+{
+	int stride = ScanStride();
+	size_t numValues = (size_t) numScans * stride;
+	long long numClipped = 0;
+
+	if (_storage == STORAGE_HALF)
+	{
+		//the trigger lanes are converted too and overwritten below
+		for (size_t i = 0; i < numValues; i++)
+			numClipped += (fabsf(scans[i]) > HALF_MAX) ? 1 : 0;
+		EncodeHalf(scans, numValues, lanes);
+	}
+	else if (_storage == STORAGE_INT16)
+	{
+		const float *inverseGains = _inverseGains.empty() ? NULL : &_inverseGains[0];
+		for (int scan = 0; scan < numScans; scan++)
+		{
+			const float *values = scans + (size_t) scan * stride;
+			uint16_t *scanLanes = lanes + (size_t) scan * stride;
+			for (int channel = 0; channel < _numChannels; channel++)
+			{
+				float steps = values[channel] * inverseGains[channel];
+				numClipped += (fabsf(steps) > INT16_MAX_STEPS) ? 1 : 0;
+				steps = (steps > INT16_MAX_STEPS) ? INT16_MAX_STEPS : ((steps < -INT16_MAX_STEPS) ? -INT16_MAX_STEPS : steps);
+				scanLanes[channel] = (uint16_t) (int16_t) (steps + ((steps >= 0) ? 0.5f : -0.5f));
+			}
+		}
+	}
+
+	//the trigger is a small integer, kept exactly
+	if (_trigger)
+	{
+		for (int scan = 0; scan < numScans; scan++)
+		{
+			float trigger = scans[(size_t) scan * stride + _numChannels];
+			lanes[(size_t) scan * stride + _numChannels] = (uint16_t) (int16_t) floorf(trigger + 0.5f);
+		}
+	}
+
+	return numClipped;
+}
+
+void SampleCodec::Decode(const uint16_t *lanes, int numScans, float *scans) const
+{
+	int stride = ScanStride();
+	size_t numValues = (size_t) numScans * stride;
+
+	if (_storage == STORAGE_HALF)
+		DecodeHalf(lanes, numValues, scans);
+	else if (_storage == STORAGE_INT16)
+	{
+		const float *gains = _gains.empty() ? NULL : &_gains[0];
+		for (int scan = 0; scan < numScans; scan++)
+		{
+			const uint16_t *scanLanes = lanes + (size_t) scan * stride;
+			float *values = scans + (size_t) scan * stride;
+			for (int channel = 0; channel < _numChannels; channel++)
+				values[channel] = (float) (int16_t) scanLanes[channel] * gains[channel];
+		}
+	}
+
+	if (_trigger)
+	{
+		for (int scan = 0; scan < numScans; scan++)
+			scans[(size_t) scan * stride + _numChannels] = (float) (int16_t) lanes[(size_t) scan * stride + _numChannels];
+	}
+}
+
+uint16_t SampleCodec::FloatToHalf(float value)
+{
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+
+	uint32_t sign = (bits >> 16) & 0x8000;
+	uint32_t magnitude = bits & 0x7fffffff;
+
+	//infinity and not a number
+	if (magnitude >= 0x7f800000)
+		return (uint16_t) (sign | 0x7c00 | ((magnitude > 0x7f800000) ? 0x200 : 0));
+
+	//rounds beyond the largest half
+	if (magnitude >= 0x477ff000)
+		return (uint16_t) (sign | 0x7c00);
+
+	//below the smallest normal half: subnormal, in steps of 2^-24
+	if (magnitude < 0x38800000)
+	{
+		uint32_t exponent = magnitude >> 23;
+		if (exponent < 102)
+			return (uint16_t) sign;
+
+		uint32_t mantissa = (magnitude & 0x7fffff) | 0x800000;
+		int shift = 126 - exponent;
+		uint32_t half = mantissa >> shift;
+		uint32_t remainder = mantissa & ((1u << shift) - 1);
+		uint32_t halfway = 1u << (shift - 1);
+		if (remainder > halfway || (remainder == halfway && (half & 1)))
+			half++;
+		return (uint16_t) (sign | half);
+	}
+
+	//normal: rebias the exponent from 127 to 15 and round the 13 dropped mantissa bits
+	uint32_t half = (magnitude - 0x38000000) >> 13;
+	uint32_t remainder = magnitude & 0x1fff;
+	if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1)))
+		half++;
+	return (uint16_t) (sign | half);
+}
+
+float SampleCodec::HalfToFloat(uint16_t half)
+{
+	uint32_t sign = (uint32_t) (half & 0x8000) << 16;
+	uint32_t exponent = (half >> 10) & 0x1f;
+	uint32_t mantissa = half & 0x3ff;
+
+	//subnormal: mantissa steps of 2^-24
+	if (exponent == 0)
+	{
+		float value = mantissa * (1.0f / 16777216.0f);
+		return sign ? -value : value;
+	}
+
+	uint32_t bits;
+	if (exponent == 0x1f)
+		bits = sign | 0x7f800000 | (mantissa << 13);
+	else
+		bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+
+	float value;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+void SampleCodec::EncodeHalf(const float *values, size_t numValues, uint16_t *halves)
+{
+	size_t i = 0;
+
+#ifdef SAMPLECODEC_F16C
+	const __m256 maxValue = _mm256_set1_ps(HALF_MAX);
+	const __m256 minValue = _mm256_set1_ps(-HALF_MAX);
+	for (; i + 8 <= numValues; i += 8)
+	{
+		__m256 block = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(values + i), minValue), maxValue);
+		_mm_storeu_si128((__m128i *) (halves + i), _mm256_cvtps_ph(block, _MM_FROUND_TO_NEAREST_INT));
+	}
+#endif
+
+	for (; i < numValues; i++)
+	{
+		float value = values[i];
+		value = (value > HALF_MAX) ? HALF_MAX : ((value < -HALF_MAX) ? -HALF_MAX : value);
+		halves[i] = FloatToHalf(value);
+	}
+}
+
+void SampleCodec::DecodeHalf(const uint16_t *halves, size_t numValues, float *values)
+{
+	size_t i = 0;
+
+#ifdef SAMPLECODEC_F16C
+	for (; i + 8 <= numValues; i += 8)
+		_mm256_storeu_ps(values + i, _mm256_cvtph_ps(_mm_loadu_si128((const __m128i *) (halves + i))));
+#endif
+
+	for (; i < numValues; i++)
+		values[i] = HalfToFloat(halves[i]);
+}
@@ -0,0 +1,128 @@
+#include <stddef.h>
+#include <string.h>
+#include "ScanInterleaver.h"
+
+// Merge kernel with numDevices devices of CHANNELS channels each and TRIGGER trigger values (0 or 1) on the master
+template <int NUM_DEVICES, int CHANNELS, int TRIGGER>
+static void InterleaveUniform(const ScanInterleaver &, const float *const *devices, int numScans, float *scans)
+{
+	const int scanStride = NUM_DEVICES * CHANNELS + TRIGGER;
+
+	//a single device delivers the scans as they are merged
+	if (NUM_DEVICES == 1)
+	{
+		memcpy(scans, devices[0], (size_t) numScans * scanStride * sizeof(float));
+		return;
+	}
+
+	//constant size copies become vector moves; the device blocks are held locally as the stores could alias them
+	const float *sources[NUM_DEVICES];
+	for (int device = 0; device < NUM_DEVICES; device++)
+		sources[device] = devices[device];
+
+	for (int scan = 0; scan < numScans; scan++)
+	{
+		const float *master = sources[NUM_DEVICES - 1] + (size_t) scan * (CHANNELS + TRIGGER);
+		float *destination = scans + (size_t) scan * scanStride;
+
+		memcpy(destination, master, CHANNELS * sizeof(float));
+		for (int device = NUM_DEVICES - 2; device >= 0; device--)
+			memcpy(destination + (NUM_DEVICES - 1 - device) * CHANNELS, sources[device] + (size_t) scan * CHANNELS, CHANNELS * sizeof(float));
+		if (TRIGGER)
+			destination[scanStride - 1] = master[CHANNELS];
+	}
+}
+
+typedef void (*UniformKernel)(const ScanInterleaver &, const float *const *, int, float *);
+
+#define UNIFORM_KERNELS(devices, channels) {InterleaveUniform<devices, channels, 0>, InterleaveUniform<devices, channels, 1>}
+#define UNIFORM_DEVICES(devices) {UNIFORM_KERNELS(devices, 1), UNIFORM_KERNELS(devices, 2), UNIFORM_KERNELS(devices, 3), \
+	UNIFORM_KERNELS(devices, 4), UNIFORM_KERNELS(devices, 5), UNIFORM_KERNELS(devices, 6), UNIFORM_KERNELS(devices, 7), \
+	UNIFORM_KERNELS(devices, 8), UNIFORM_KERNELS(devices, 9), UNIFORM_KERNELS(devices, 10), UNIFORM_KERNELS(devices, 11), \
+	UNIFORM_KERNELS(devices, 12), UNIFORM_KERNELS(devices, 13), UNIFORM_KERNELS(devices, 14), UNIFORM_KERNELS(devices, 15), \
+	UNIFORM_KERNELS(devices, 16)}
+
+// Specialized kernels by number of devices, channels per device and trigger (minus one for devices and channels)
+static const UniformKernel uniformKernels[ScanInterleaver::MAX_DEVICES][ScanInterleaver::MAX_CHANNELS][2] =
+{
+	UNIFORM_DEVICES(1), UNIFORM_DEVICES(2), UNIFORM_DEVICES(3), UNIFORM_DEVICES(4)
+};
+
+#undef UNIFORM_DEVICES
+#undef UNIFORM_KERNELS
+
+// Constructor
+ScanInterleaver::ScanInterleaver()
+{
+	_kernel = Generic;
+	_numDevices = 0;
+	_trigger = 0;
+	_scanStride = 0;
+}
+
+bool ScanInterleaver::Configure(int numDevices, const int *channels, bool trigger)
+{
+	if (numDevices < 1 || numDevices > MAX_DEVICES)
+		return false;
+	for (int device = 0; device < numDevices; device++)
+		if (channels[device] < 0)
+			return false;
+
+	_numDevices = numDevices;
+	_trigger = trigger ? 1 : 0;
+	_scanStride = _trigger;
+	bool uniform = true;
+	for (int device = 0; device < numDevices; device++)
+	{
+		_channels[device] = channels[device];
+		_scanStride += channels[device];
+		uniform = uniform && channels[device] == channels[0];
+	}
+
+	_kernel = (uniform && channels[0] >= 1 && channels[0] <= MAX_CHANNELS) ? uniformKernels[numDevices - 1][channels[0] - 1][_trigger] : Generic;
+	return true;
+}
+
+bool ScanInterleaver::Specialized() const
+{
+	return _kernel != Generic;
+}
+
+int ScanInterleaver::ScanStride() const
+{
+	return _scanStride;
+}
+
+void ScanInterleaver::Interleave(const float *const *devices, int numScans, float *scans) const
+{
+	_kernel(*this, devices, numScans, scans);
+}
+
+void ScanInterleaver::InterleaveGeneric(const float *const *devices, int numScans, float *scans) const
+{
+	Generic(*this, devices, numScans, scans);
+}
+
+void ScanInterleaver::Generic(const ScanInterleaver &config, const float *const *devices, int numScans, float *scans)
+{
+	int master = config._numDevices - 1;
+	float *destination = scans;
+
+	for (int scan = 0; scan < numScans; scan++)
+	{
+		//channels of each device starting from the master
+		for (int device = master; device >= 0; device--)
+		{
+			int deviceStride = config._channels[device] + ((device == master) ? config._trigger : 0);
+			memcpy(destination, devices[device] + (size_t) scan * deviceStride, config._channels[device] * sizeof(float));
+			destination += config._channels[device];
+		}
+
+		//then the trigger of the master
+		if (config._trigger)
+		{
+			*destination = devices[master][(size_t) scan * (config._channels[master] + 1) + config._channels[master]];
+			destination++;
+		}
+	}
+}
@@ -0,0 +1,263 @@
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#include <vector>
+#include <iostream>
+#include <string.h>
+#include "SessionFile.h"
+#include "SessionRecorder.h"
+
+// Size of the fixed part of the v1 header (version, sample rate, number of channels and trigger flag)
+static const int FIXED_HEADER_SIZE = 13;
+
+// Constructor
+SessionFile::SessionFile()
+{
+	_version = 0;
+	_sampleRate = 0;
+	_numChannels = 0;
+	_triggerFlag = 0;
+	_numScans = 0;
+	_scanSize = 0;
+	_mapping = NULL;
+	_scans = NULL;
+	_fileSize = 0;
+	_fileHandle = NULL;
+	_mappingHandle = NULL;
+	_fileDescriptor = -1;
+}
+
+// Destructor
+SessionFile::~SessionFile()
+{
+	Close();
+}
+
+bool SessionFile::Open(const char *fileName)
+{
+	Close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	LARGE_INTEGER size;
+	if (file != INVALID_HANDLE_VALUE && GetFileSizeEx(file, &size) && size.QuadPart > 0)
+	{
+		_fileHandle = file;
+		_fileSize = size.QuadPart;
+		_mappingHandle = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (_mappingHandle != NULL)
+			_mapping = (const unsigned char *) MapViewOfFile(_mappingHandle, FILE_MAP_READ, 0, 0, 0);
+	}
+	else if (file != INVALID_HANDLE_VALUE)
+		CloseHandle(file);
+#else
+	_fileDescriptor = open(fileName, O_RDONLY);
+	struct stat fileStat;
+	if (_fileDescriptor >= 0 && fstat(_fileDescriptor, &fileStat) == 0 && fileStat.st_size > 0)
+	{
+		_fileSize = fileStat.st_size;
+		void *mapping = mmap(NULL, (size_t) _fileSize, PROT_READ, MAP_SHARED, _fileDescriptor, 0);
+		if (mapping != MAP_FAILED)
+		{
+			_mapping = (const unsigned char *) mapping;
+			madvise(mapping, (size_t) _fileSize, MADV_SEQUENTIAL);
+		}
+	}
+#endif
+
+	if (_mapping == NULL)
+	{
+		// error 33
+		std::cout << "Error on SessionFile::Open: could not map " << fileName << "\n";
+		Close();
+		return false;
+	}
+
+	// Parse header
+	int numChannels = (_fileSize >= FIXED_HEADER_SIZE) ? _mapping[8] : 0;
+	if (_fileSize >= FIXED_HEADER_SIZE)
+	{
+		memcpy(&_version, _mapping, sizeof(int));
+		memcpy(&_sampleRate, _mapping + 4, sizeof(int));
+		memcpy(&_triggerFlag, _mapping + 9, sizeof(int));
+	}
+
+	if (_version != 1 || _sampleRate <= 0 || numChannels == 0 || (_triggerFlag != 0 && _triggerFlag != 1) || _fileSize < FIXED_HEADER_SIZE + numChannels)
+	{
+		// error 34
+		std::cout << "Error on SessionFile::Open: " << fileName << " is not a v1 daq file." << "\n";
+		Close();
+		return false;
+	}
+
+	_numChannels = numChannels;
+	_channelList.assign(_mapping + FIXED_HEADER_SIZE, _mapping + FIXED_HEADER_SIZE + numChannels);
+	_scanSize = _numChannels + _triggerFlag;
+	_scans = _mapping + FIXED_HEADER_SIZE + numChannels;
+
+	// a recording still being written, or left by a crash, only holds valid scans up to its committed length (the
+	// rest is file space reserved ahead); a partial scan at the end is ignored
+	long long dataEnd = _fileSize;
+	long long committed;
+	if (SessionRecorder::CommittedLength(fileName, &committed) && committed < dataEnd)
+		dataEnd = (committed > FIXED_HEADER_SIZE + numChannels) ? committed : FIXED_HEADER_SIZE + numChannels;
+	_numScans = (dataEnd - FIXED_HEADER_SIZE - numChannels) / (_scanSize * (long long) sizeof(float));
+
+	return true;
+}
+
+void SessionFile::Close()
+{
+#ifdef _WIN32
+	if (_mapping != NULL)
+		UnmapViewOfFile(_mapping);
+	if (_mappingHandle != NULL)
+		CloseHandle(_mappingHandle);
+	if (_fileHandle != NULL)
+		CloseHandle(_fileHandle);
+#else
+	if (_mapping != NULL)
+		munmap((void *) _mapping, (size_t) _fileSize);
+	if (_fileDescriptor >= 0)
+		close(_fileDescriptor);
+#endif
+
+	_mapping = NULL;
+	_scans = NULL;
+	_mappingHandle = NULL;
+	_fileHandle = NULL;
+	_fileDescriptor = -1;
+	_fileSize = 0;
+	_numScans = 0;
+	_numChannels = 0;
+	_channelList.clear();
+}
+
+float SessionFile::Sample(long long scan, int channel) const
+{
+	// header size is not a multiple of 4, so values are copied out instead of dereferenced
+	float value;
+	memcpy(&value, _scans + (scan * _scanSize + channel) * sizeof(float), sizeof(float));
+	return value;
+}
+
+int SessionFile::FindTrials(std::vector<long long> &trialStarts, std::vector<int> &trialLengths, double minToMaxTrial) const
+{
+	trialStarts.clear();
+	trialLengths.clear();
+
+	if (!_triggerFlag)
+	{
+		// error 35
+		std::cout << "Error on SessionFile::FindTrials: file has no trigger channel." << "\n";
+		return 0;
+	}
+
+	// edges of the logical trigger, paired as (start, end). Assumes the trigger starts at 0
+	std::vector<long long> edges;
+	bool previous = (_numScans > 0) && (Sample(0, _numChannels) != 0);
+	for (long long scan = 1; scan < _numScans; scan++)
+	{
+		bool current = (Sample(scan, _numChannels) != 0);
+		if (current != previous)
+			edges.push_back(scan - 1);
+		previous = current;
+	}
+
+	int maxLength = 0;
+	for (size_t i = 0; i + 1 < edges.size(); i += 2)
+	{
+		trialStarts.push_back(edges[i]);
+		trialLengths.push_back((int) (edges[i + 1] - edges[i]));
+		if (trialLengths.back() > maxLength)
+			maxLength = trialLengths.back();
+	}
+
+	// drop short trials
+	size_t numKept = 0;
+	for (size_t i = 0; i < trialStarts.size(); i++)
+		if (trialLengths[i] >= minToMaxTrial * maxLength)
+		{
+			trialStarts[numKept] = trialStarts[i];
+			trialLengths[numKept] = trialLengths[i];
+			numKept++;
+		}
+	trialStarts.resize(numKept);
+	trialLengths.resize(numKept);
+
+	return (int) numKept;
+}
+
+bool SessionFile::CheckRange(const std::vector<int> &channels, long long startScan, int numScans) const
+{
+	bool valid = (_scans != NULL && startScan >= 0 && numScans >= 0 && startScan + numScans <= _numScans);
+	for (size_t i = 0; i < channels.size(); i++)
+		valid = valid && channels[i] >= 0 && channels[i] < _scanSize;
+
+	if (!valid)
+	{
+		// error 36
+		std::cout << "Error on SessionFile: channels or scans " << startScan << " to " << startScan + numScans << " are out of range." << "\n";
+	}
+	return valid;
+}
+
+template <typename T> void SessionFile::CopyScans(const std::vector<int> &channels, long long startScan, int numScans, double scale, T *out) const
+{
+	int numSelected = (int) channels.size();
+	const unsigned char *scan = _scans + startScan * _scanSize * sizeof(float);
+	for (int n = 0; n < numScans; n++)
+	{
+		for (int c = 0; c < numSelected; c++)
+		{
+			float value;
+			memcpy(&value, scan + channels[c] * sizeof(float), sizeof(float));
+			out[c] = (T) (scale * value);
+		}
+		out += numSelected;
+		scan += _scanSize * sizeof(float);
+	}
+}
+
+bool SessionFile::ReadSlice(const std::vector<int> &channels, long long startScan, int numScans, double scale, float *out) const
+{
+	if (!CheckRange(channels, startScan, numScans))
+		return false;
+	CopyScans(channels, startScan, numScans, scale, out);
+	return true;
+}
+
+bool SessionFile::ReadSlice(const std::vector<int> &channels, long long startScan, int numScans, double scale, double *out) const
+{
+	if (!CheckRange(channels, startScan, numScans))
+		return false;
+	CopyScans(channels, startScan, numScans, scale, out);
+	return true;
+}
+
+bool SessionFile::ReadTrials(const std::vector<int> &channels, const std::vector<long long> &trialStarts, int trialLength, double scale, float *out) const
+{
+	for (size_t i = 0; i < trialStarts.size(); i++)
+		if (!CheckRange(channels, trialStarts[i], trialLength))
+			return false;
+
+	for (size_t i = 0; i < trialStarts.size(); i++)
+		CopyScans(channels, trialStarts[i], trialLength, scale, out + i * channels.size() * trialLength);
+	return true;
+}
+
+bool SessionFile::ReadTrials(const std::vector<int> &channels, const std::vector<long long> &trialStarts, int trialLength, double scale, double *out) const
+{
+	for (size_t i = 0; i < trialStarts.size(); i++)
+		if (!CheckRange(channels, trialStarts[i], trialLength))
+			return false;
+
+	for (size_t i = 0; i < trialStarts.size(); i++)
+		CopyScans(channels, trialStarts[i], trialLength, scale, out + i * channels.size() * trialLength);
+	return true;
+}
@@ -0,0 +1,417 @@
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include "SessionRecorder.h"
+
+const char *SessionRecorder::COMMIT_SUFFIX = ".commit";
+
+// Marks a record of the sidecar ("DAQC")
+static const unsigned int COMMIT_MAGIC = 0x43514144;
+
+// Milliseconds since a time point
+static double ElapsedMs(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Constructor
+SessionRecorder::SessionRecorder()
+{
+	_open = false;
+	_file = -1;
+	_commitFile = -1;
+	_writtenBytes = 0;
+	_reservedBytes = 0;
+	_commitSequence = 0;
+	memset(&_stats, 0, sizeof(_stats));
+	_totalWriteMs = 0;
+	_totalSyncMs = 0;
+	_failed = false;
+	_closing = false;
+}
+
+// Destructor
+SessionRecorder::~SessionRecorder()
+{
+	Close();
+}
+
+bool SessionRecorder::Open(const char *fileName, const void *header, int headerBytes, DurabilityPolicy policy, ThreadSetup setup)
+{
+	Close();
+
+	_fileName = fileName;
+	_commitName = _fileName + COMMIT_SUFFIX;
+	_policy = policy;
+	_file = OpenNative(fileName, true);
+	_commitFile = (_file != -1) ? OpenNative(_commitName.c_str(), true) : -1;
+	if (_commitFile == -1)
+	{
+		CloseNative(_file);
+		_file = -1;
+		return false;
+	}
+
+	_writtenBytes = 0;
+	_reservedBytes = 0;
+	_commitSequence = 0;
+	memset(&_stats, 0, sizeof(_stats));
+	_totalWriteMs = 0;
+	_totalSyncMs = 0;
+	_failed = false;
+	_closing = false;
+	_queued.clear();
+	_gathering.clear();
+	_gathering.reserve(_policy.chunkBytes);
+
+	//buffers for the next chunks, so appending only allocates while the writer thread lags behind
+	_spare.assign(SPARE_CHUNKS, std::vector<char>());
+	for (int i = 0; i < SPARE_CHUNKS; i++)
+		_spare[i].reserve(_policy.chunkBytes);
+	_gatherStart = std::chrono::steady_clock::now();
+
+	//the header is the first chunk, committed before any scan
+	std::vector<char> headerChunk((const char *) header, (const char *) header + headerBytes);
+	_lastSync = std::chrono::steady_clock::now();
+	if (!WriteChunk(headerChunk) || !Commit(_policy.mode != DURABILITY_NONE))
+	{
+		CloseNative(_file);
+		CloseNative(_commitFile);
+		_file = _commitFile = -1;
+		remove(_commitName.c_str());
+		return false;
+	}
+
+	_open = true;
+	_setup = setup;
+	_thread = std::thread(&SessionRecorder::WriteLoop, this);
+	return true;
+}
+
+void SessionRecorder::Append(const float *values, size_t numValues)
+{
+	std::lock_guard<std::mutex> lock(_lock);
+
+	if (!_open)
+		return;
+
+	if (_gathering.empty())
+		_gatherStart = std::chrono::steady_clock::now();
+	const char *bytes = (const char *) values;
+	_gathering.insert(_gathering.end(), bytes, bytes + numValues * sizeof(float));
+
+	if ((int) _gathering.size() >= _policy.chunkBytes || ElapsedMs(_gatherStart) >= 1000 * _policy.chunkSeconds)
+		QueueChunk();
+}
+
+bool SessionRecorder::Close()
+{
+	{
+		std::lock_guard<std::mutex> lock(_lock);
+
+		if (!_open)
+			return true;
+		if (!_gathering.empty())
+			QueueChunk();
+		_closing = true;
+	}
+	_wake.notify_all();
+	_thread.join();
+
+	//the data is complete: commit it, give back the space reserved beyond it and drop the sidecar
+	bool sync = (_policy.mode != DURABILITY_NONE);
+	bool success = !_failed && Commit(sync);
+	success = ResizeNative(_file, _writtenBytes, false) && (!sync || SyncNative(_file)) && success;
+	CloseNative(_file);
+	CloseNative(_commitFile);
+	_file = _commitFile = -1;
+	if (success)
+		remove(_commitName.c_str());
+
+	std::lock_guard<std::mutex> lock(_lock);
+	_open = false;
+	_spare.clear();
+	return success;
+}
+
+void SessionRecorder::GetStats(RecorderStats *stats)
+{
+	std::lock_guard<std::mutex> lock(_lock);
+
+	*stats = _stats;
+	stats->queuedChunks = (int) _queued.size();
+}
+
+bool SessionRecorder::CommittedLength(const char *fileName, long long *length)
+{
+	std::string commitName = std::string(fileName) + COMMIT_SUFFIX;
+	FILE *commitFile = fopen(commitName.c_str(), "rb");
+	if (commitFile == NULL)
+		return false;
+
+	CommitRecord records[2];
+	size_t numRecords = fread(records, sizeof(CommitRecord), 2, commitFile);
+	fclose(commitFile);
+
+	//the valid record written last
+	bool found = false;
+	unsigned int sequence = 0;
+	for (size_t i = 0; i < numRecords; i++)
+	{
+		if (records[i].magic != COMMIT_MAGIC || records[i].check != Check(records[i]) || (found && records[i].sequence < sequence))
+			continue;
+		found = true;
+		sequence = records[i].sequence;
+		*length = records[i].length;
+	}
+	return found;
+}
+
+long long SessionRecorder::Recover(const char *fileName)
+{
+	NativeFile file = OpenNative(fileName, false);
+	if (file == -1)
+		return -1;
+
+	long long length = SizeNative(file);
+	long long committed;
+	if (CommittedLength(fileName, &committed) && committed < length)
+	{
+		//the space reserved beyond the last commit holds nothing valid
+		if (!ResizeNative(file, committed, false) || !SyncNative(file))
+		{
+			CloseNative(file);
+			return -1;
+		}
+		length = committed;
+	}
+	CloseNative(file);
+
+	remove((std::string(fileName) + COMMIT_SUFFIX).c_str());
+	return length;
+}
+
+void SessionRecorder::WriteLoop()
+{
+	if (_setup)
+		_setup();
+
+	std::unique_lock<std::mutex> lock(_lock);
+
+	while (true)
+	{
+		if (_queued.empty())
+		{
+			if (_closing)
+				break;
+			_wake.wait(lock);
+			continue;
+		}
+
+		std::vector<char> chunk;
+		chunk.swap(_queued.front());
+		_queued.pop_front();
+		lock.unlock();
+
+		bool success = !_failed && WriteChunk(chunk);
+		if (success && _policy.mode == DURABILITY_CHUNK)
+			success = Commit(true);
+		else if (success && _policy.mode == DURABILITY_PERIODIC && ElapsedMs(_lastSync) >= 1000 * _policy.syncSeconds)
+			success = Commit(true);
+		else if (success && _policy.mode == DURABILITY_NONE)
+			success = Commit(false);
+
+		lock.lock();
+		_failed = _failed || !success;
+		chunk.clear();
+		_spare.push_back(std::vector<char>());
+		_spare.back().swap(chunk);
+	}
+}
+
+bool SessionRecorder::WriteChunk(const std::vector<char> &chunk)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	//reserve whole extents ahead of the data
+	long long end = _writtenBytes + (long long) chunk.size();
+	long long numExtents = 0;
+	if (end > _reservedBytes)
+	{
+		long long extents = (end - _reservedBytes + _policy.extentBytes - 1) / _policy.extentBytes;
+		if (!ResizeNative(_file, _reservedBytes + extents * _policy.extentBytes, true))
+			return false;
+		_reservedBytes += extents * _policy.extentBytes;
+		numExtents = extents;
+	}
+
+	if (!chunk.empty() && !WriteNative(_file, _writtenBytes, &chunk[0], chunk.size()))
+		return false;
+	_writtenBytes = end;
+
+	double writeMs = ElapsedMs(start);
+	std::lock_guard<std::mutex> lock(_lock);
+	_stats.writtenBytes = _writtenBytes;
+	_stats.numChunks++;
+	_stats.numExtents += numExtents;
+	_totalWriteMs += writeMs;
+	_stats.meanWriteMs = _totalWriteMs / _stats.numChunks;
+	_stats.maxWriteMs = (std::max)(_stats.maxWriteMs, writeMs);
+	return true;
+}
+
+bool SessionRecorder::Commit(bool sync)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	//the data must be on disk before a record says it is
+	if (sync && !SyncNative(_file))
+		return false;
+
+	CommitRecord record = {COMMIT_MAGIC, _commitSequence, _writtenBytes, 0, 0};
+	record.check = Check(record);
+	if (!WriteNative(_commitFile, (long long) (_commitSequence % 2) * sizeof(CommitRecord), &record, sizeof(record)))
+		return false;
+	if (sync && !SyncNative(_commitFile))
+		return false;
+	_commitSequence++;
+
+	double syncMs = ElapsedMs(start);
+	if (sync)
+		_lastSync = std::chrono::steady_clock::now();
+	std::lock_guard<std::mutex> lock(_lock);
+	_stats.committedBytes = _writtenBytes;
+	if (sync)
+	{
+		_stats.numSyncs++;
+		_totalSyncMs += syncMs;
+		_stats.meanSyncMs = _totalSyncMs / _stats.numSyncs;
+		_stats.maxSyncMs = (std::max)(_stats.maxSyncMs, syncMs);
+	}
+	return true;
+}
+
+void SessionRecorder::QueueChunk()
+{
+	_queued.push_back(std::vector<char>());
+	_queued.back().swap(_gathering);
+	_stats.maxQueuedChunks = (std::max)(_stats.maxQueuedChunks, (int) _queued.size());
+
+	//gather the next chunk into a buffer already allocated
+	if (!_spare.empty())
+	{
+		_gathering.swap(_spare.back());
+		_spare.pop_back();
+	}
+	_gathering.reserve(_policy.chunkBytes);
+	_wake.notify_all();
+}
+
+unsigned int SessionRecorder::Check(const CommitRecord &record)
+{
+	//FNV-1a over the fields before the checksum
+	const unsigned char *bytes = (const unsigned char *) &record;
+	unsigned int hash = 2166136261u;
+	for (size_t i = 0; i < offsetof(CommitRecord, check); i++)
+		hash = (hash ^ bytes[i]) * 16777619u;
+	return hash;
+}
+
+#ifdef _WIN32
+
+SessionRecorder::NativeFile SessionRecorder::OpenNative(const char *fileName, bool create)
+{
+	HANDLE file = CreateFileA(fileName, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, create ? CREATE_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	return (NativeFile) file;
+}
+
+long long SessionRecorder::SizeNative(NativeFile file)
+{
+	LARGE_INTEGER size;
+	return GetFileSizeEx((HANDLE) file, &size) ? size.QuadPart : -1;
+}
+
+bool SessionRecorder::WriteNative(NativeFile file, long long offset, const void *data, size_t numBytes)
+{
+	OVERLAPPED position = {0};
+	position.Offset = (DWORD) offset;
+	position.OffsetHigh = (DWORD) (offset >> 32);
+	DWORD written;
+	return WriteFile((HANDLE) file, data, (DWORD) numBytes, &written, &position) && written == numBytes;
+}
+
+bool SessionRecorder::ResizeNative(NativeFile file, long long length, bool reserve)
+{
+	//NTFS allocates the clusters of the new end of file, zeroing them lazily as they are written
+	LARGE_INTEGER position;
+	position.QuadPart = length;
+	return SetFilePointerEx((HANDLE) file, position, NULL, FILE_BEGIN) && SetEndOfFile((HANDLE) file);
+}
+
+bool SessionRecorder::SyncNative(NativeFile file)
+{
+	return FlushFileBuffers((HANDLE) file) != 0;
+}
+
+void SessionRecorder::CloseNative(NativeFile file)
+{
+	if (file != -1)
+		CloseHandle((HANDLE) file);
+}
+
+#else
+
+SessionRecorder::NativeFile SessionRecorder::OpenNative(const char *fileName, bool create)
+{
+	return open(fileName, create ? (O_RDWR | O_CREAT | O_TRUNC) : O_RDWR, 0644);
+}
+
+long long SessionRecorder::SizeNative(NativeFile file)
+{
+	struct stat fileStat;
+	return (fstat((int) file, &fileStat) == 0) ? (long long) fileStat.st_size : -1;
+}
+
+bool SessionRecorder::WriteNative(NativeFile file, long long offset, const void *data, size_t numBytes)
+{
+	const char *bytes = (const char *) data;
+	while (numBytes > 0)
+	{
+		ssize_t written = pwrite((int) file, bytes, numBytes, (off_t) offset);
+		if (written <= 0)
+			return false;
+		bytes += written;
+		offset += written;
+		numBytes -= (size_t) written;
+	}
+	return true;
+}
+
+bool SessionRecorder::ResizeNative(NativeFile file, long long length, bool reserve)
+{
+	//allocate the blocks of the extent, or at least extend the file where the file system can't
+	if (reserve && posix_fallocate((int) file, 0, (off_t) length) == 0)
+		return true;
+	return ftruncate((int) file, (off_t) length) == 0;
+}
+
+bool SessionRecorder::SyncNative(NativeFile file)
+{
+	return fdatasync((int) file) == 0;
+}
+
+void SessionRecorder::CloseNative(NativeFile file)
+{
+	if (file != -1)
+		close((int) file);
+}
+
+#endif
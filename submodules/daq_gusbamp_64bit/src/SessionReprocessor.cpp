@@ -0,0 +1,136 @@
+#include <vector>
+#include <deque>
+#include <chrono>
+#include <iostream>
+#include <algorithm>
+#include <stdio.h>
+#include <math.h>
+#include "SessionFile.h"
+#include "FrontEndFilter.h"
+#include "SessionReprocessor.h"
+
+// Version of the trial tensor file
+static const int TRIAL_TENSOR_VERSION = 1;
+
+// Constructor
+SessionReprocessor::SessionReprocessor(std::vector<int> channels, std::vector<double> filterNum, std::vector<double> filterDen, int groupDelay,
+	double trialSec, double minToMaxTrial, int chunkScans)
+{
+	_channels = channels;
+	_filterNum = filterNum;
+	_filterDen = filterDen;
+	_groupDelay = filterNum.empty() ? 0 : groupDelay;
+	_trialSec = trialSec;
+	_minToMaxTrial = minToMaxTrial;
+	_chunkScans = std::max(chunkScans, 1);
+}
+
+bool SessionReprocessor::Process(const char *inputFile, const char *outputFile, ReprocessStats *stats) const
+{
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+	SessionFile session;
+	if (!session.Open(inputFile))
+		return false;
+
+	std::vector<int> channels = _channels;
+	if (channels.empty())
+		for (int c = 0; c < session.NumChannels(); c++)
+			channels.push_back(c);
+	int numChannels = (int) channels.size();
+
+	std::vector<long long> trialStarts;
+	std::vector<int> trialLengths;
+	session.FindTrials(trialStarts, trialLengths, _minToMaxTrial);
+
+	int trialLength = (int) floor(_trialSec * session.SampleRate() + 0.5);
+	if (_trialSec <= 0)
+	{
+		trialLength = trialLengths.empty() ? 0 : *std::min_element(trialLengths.begin(), trialLengths.end());
+	}
+
+	// trials as seen in the filtered signal; those running past the end are dropped
+	std::vector<long long> filteredStarts;
+	for (size_t i = 0; i < trialStarts.size(); i++)
+		if (trialStarts[i] + _groupDelay + trialLength <= session.NumScans())
+			filteredStarts.push_back(trialStarts[i] + _groupDelay);
+
+	int numTrials = (int) filteredStarts.size();
+	if (numTrials == 0 || trialLength == 0)
+	{
+		// error 38
+		std::cout << "Error on SessionReprocessor::Process: no trials in " << inputFile << "\n";
+		return false;
+	}
+
+	FILE *output = fopen(outputFile, "wb");
+	if (output == NULL)
+	{
+		// error 39
+		std::cout << "Error on SessionReprocessor::Process: could not create " << outputFile << "\n";
+		return false;
+	}
+
+	// Write header
+	int header[5] = {TRIAL_TENSOR_VERSION, session.SampleRate(), numChannels, trialLength, numTrials};
+	fwrite(header, sizeof(int), 5, output);
+	for (int c = 0; c < numChannels; c++)
+	{
+		int channel = (channels[c] < session.NumChannels()) ? session.ChannelList()[channels[c]] : 0;
+		fwrite(&channel, sizeof(int), 1, output);
+	}
+	fwrite(&filteredStarts[0], sizeof(long long), numTrials, output);
+
+	// Stream the recording up to the end of the last trial, one chunk at a time. Trials may overlap when trialSec
+	// is longer than the gap between them, so every trial touching the chunk gets its part
+	FrontEndFilter filter(_filterNum, _filterDen, numChannels);
+	std::vector<float> chunk((size_t) numChannels * _chunkScans);
+	std::deque< std::vector<float> > openTrials;
+
+	long long endScan = filteredStarts.back() + trialLength;
+	int firstOpenTrial = 0;
+	bool success = true;
+
+	for (long long chunkStart = 0; chunkStart < endScan && success; chunkStart += _chunkScans)
+	{
+		int numScans = (int) std::min((long long) _chunkScans, endScan - chunkStart);
+		long long chunkEnd = chunkStart + numScans;
+		success = session.ReadSlice(channels, chunkStart, numScans, 1.0, &chunk[0]);
+		if (!_filterNum.empty())
+			filter.Apply(&chunk[0], numScans, numChannels);
+
+		for (int trialIndex = firstOpenTrial; trialIndex < numTrials && filteredStarts[trialIndex] < chunkEnd; trialIndex++)
+		{
+			if (trialIndex - firstOpenTrial == (int) openTrials.size())
+				openTrials.push_back(std::vector<float>((size_t) numChannels * trialLength));
+
+			long long first = std::max(filteredStarts[trialIndex], chunkStart);
+			long long last = std::min(filteredStarts[trialIndex] + trialLength, chunkEnd);
+			std::copy(chunk.begin() + (size_t) (first - chunkStart) * numChannels,
+				chunk.begin() + (size_t) (last - chunkStart) * numChannels,
+				openTrials[trialIndex - firstOpenTrial].begin() + (size_t) (first - filteredStarts[trialIndex]) * numChannels);
+		}
+
+		// trials have the same length, so they complete in order
+		while (!openTrials.empty() && filteredStarts[firstOpenTrial] + trialLength <= chunkEnd)
+		{
+			success = success && fwrite(&openTrials.front()[0], sizeof(float), openTrials.front().size(), output) == openTrials.front().size();
+			openTrials.pop_front();
+			firstOpenTrial++;
+		}
+	}
+
+	success = (fclose(output) == 0) && success && firstOpenTrial == numTrials;
+
+	if (stats != NULL)
+	{
+		stats->numTrials = numTrials;
+		stats->numScans = endScan;
+		stats->bytesRead = endScan * (session.NumChannels() + session.TriggerFlag()) * (long long) sizeof(float);
+		stats->bytesWritten = (long long) sizeof(header) + numChannels * (long long) sizeof(int) + numTrials * (long long) sizeof(long long)
+			+ (long long) firstOpenTrial * numChannels * trialLength * (long long) sizeof(float);
+		stats->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	}
+
+	return success;
+}
@@ -0,0 +1,183 @@
+#define _USE_MATH_DEFINES
+#include <math.h>
+#include <vector>
+#include <algorithm>
+#include <mutex>
+#include <fstream>
+#include "SignalQualityMonitor.h"
+
+// Constructor
+SignalQualityMonitor::SignalQualityMonitor(int sampleRate, int numChannels, int windowLength, double lineFrequency, double saturationUv, double flatlineUv)
+{
+	_sampleRate = sampleRate;
+	_numChannels = numChannels;
+	_windowLength = windowLength;
+	_saturationUv = saturationUv;
+	_flatlineUv = flatlineUv;
+	_lineCoefficient = 2.0 * cos(2.0 * M_PI * lineFrequency / sampleRate);
+
+	_offset.resize(numChannels);
+	_sum.resize(numChannels);
+	_sumSquares.resize(numChannels);
+	_min.resize(numChannels);
+	_max.resize(numChannels);
+	_numSaturated.resize(numChannels);
+	_goertzel1.resize(numChannels);
+	_goertzel2.resize(numChannels);
+	_quality.resize(numChannels);
+
+	Reset();
+}
+
+// Destructor
+SignalQualityMonitor::~SignalQualityMonitor()
+{
+	CloseLog();
+}
+
+void SignalQualityMonitor::Reset()
+{
+	std::lock_guard<std::mutex> lock(_lock);
+
+	_windowScans = 0;
+	_numWindows = 0;
+	_hasOffset = false;
+	for (int c = 0; c < _numChannels; c++)
+	{
+		_offset[c] = 0;
+		_sum[c] = 0;
+		_sumSquares[c] = 0;
+		_min[c] = HUGE_VALF;
+		_max[c] = -HUGE_VALF;
+		_numSaturated[c] = 0;
+		_goertzel1[c] = 0;
+		_goertzel2[c] = 0;
+		_quality[c] = ChannelQuality();
+	}
+}
+
+void SignalQualityMonitor::PushBlock(const float *block, int numScans, int scanStride)
+{
+	std::lock_guard<std::mutex> lock(_lock);
+
+	const int numChannels = _numChannels;
+	const double coefficient = _lineCoefficient;
+	const float saturation = (float) _saturationUv;
+	double *offset = &_offset[0], *sum = &_sum[0], *sumSquares = &_sumSquares[0];
+	double *goertzel1 = &_goertzel1[0], *goertzel2 = &_goertzel2[0];
+	float *minimum = &_min[0], *maximum = &_max[0];
+	int *numSaturated = &_numSaturated[0];
+
+	for (int scan = 0; scan < numScans; scan++)
+	{
+		const float *x = block + (size_t) scan * scanStride;
+
+		//the first window is taken around its first scan
+		if (!_hasOffset && _windowScans == 0)
+		{
+			for (int c = 0; c < numChannels; c++)
+				offset[c] = x[c];
+		}
+
+		//independent per channel updates over contiguous arrays
+		for (int c = 0; c < numChannels; c++)
+		{
+			double value = x[c] - offset[c];
+			sum[c] += value;
+			sumSquares[c] += value * value;
+			minimum[c] = (x[c] < minimum[c]) ? x[c] : minimum[c];
+			maximum[c] = (x[c] > maximum[c]) ? x[c] : maximum[c];
+			numSaturated[c] += (fabsf(x[c]) >= saturation) ? 1 : 0;
+
+			double goertzel0 = value + coefficient * goertzel1[c] - goertzel2[c];
+			goertzel2[c] = goertzel1[c];
+			goertzel1[c] = goertzel0;
+		}
+
+		if (++_windowScans == _windowLength)
+			FinishWindow();
+	}
+}
+
+void SignalQualityMonitor::FinishWindow()
+{
+	double length = _windowLength;
+	double windowSec = length / _sampleRate;
+
+	for (int c = 0; c < _numChannels; c++)
+	{
+		ChannelQuality &quality = _quality[c];
+		double centeredMean = _sum[c] / length;
+		double mean = _offset[c] + centeredMean;
+
+		//squared magnitude of the line frequency bin, scaled to the power of a sine of that amplitude (A^2 / 2)
+		double magnitude2 = _goertzel1[c] * _goertzel1[c] + _goertzel2[c] * _goertzel2[c] - _lineCoefficient * _goertzel1[c] * _goertzel2[c];
+
+		quality.driftUvPerSec = _hasOffset ? (mean - quality.meanUv) / windowSec : 0;
+		quality.meanUv = mean;
+		quality.rmsUv = sqrt((std::max)(_sumSquares[c] / length - centeredMean * centeredMean, 0.0));
+		quality.linePowerUv2 = 2.0 * magnitude2 / (length * length);
+		quality.peakToPeakUv = (double) _max[c] - _min[c];
+		quality.saturatedFraction = _numSaturated[c] / length;
+		quality.flatline = quality.peakToPeakUv < _flatlineUv;
+		quality.saturated = _numSaturated[c] > 0;
+
+		//the next window is taken around this mean
+		_offset[c] = mean;
+		_sum[c] = 0;
+		_sumSquares[c] = 0;
+		_min[c] = HUGE_VALF;
+		_max[c] = -HUGE_VALF;
+		_numSaturated[c] = 0;
+		_goertzel1[c] = 0;
+		_goertzel2[c] = 0;
+	}
+
+	_hasOffset = true;
+	_windowScans = 0;
+	_numWindows++;
+
+	if (_log.is_open())
+	{
+		for (int c = 0; c < _numChannels; c++)
+		{
+			const ChannelQuality &quality = _quality[c];
+			_log << _numWindows << "," << (long long) _numWindows * _windowLength << "," << c + 1 << "," << quality.meanUv << "," << quality.rmsUv << ","
+				<< quality.linePowerUv2 << "," << quality.peakToPeakUv << "," << quality.saturatedFraction << "," << quality.driftUvPerSec << ","
+				<< (quality.flatline ? 1 : 0) << "," << (quality.saturated ? 1 : 0) << "\n";
+		}
+		_log.flush();
+	}
+}
+
+int SignalQualityMonitor::GetQuality(ChannelQuality *quality)
+{
+	std::lock_guard<std::mutex> lock(_lock);
+
+	for (int c = 0; c < _numChannels; c++)
+		quality[c] = _quality[c];
+	return _numWindows;
+}
+
+bool SignalQualityMonitor::OpenLog(const char *fileName)
+{
+	std::lock_guard<std::mutex> lock(_lock);
+
+	if (_log.is_open())
+		_log.close();
+	_log.clear();
+	_log.open(fileName, std::ios::out | std::ios::trunc);
+	if (!_log.is_open())
+		return false;
+
+	_log << "window,endScan,channel,meanUv,rmsUv,linePowerUv2,peakToPeakUv,saturatedFraction,driftUvPerSec,flatline,saturated\n";
+	return true;
+}
+
+void SignalQualityMonitor::CloseLog()
+{
+	std::lock_guard<std::mutex> lock(_lock);
+
+	if (_log.is_open())
+		_log.close();
+}
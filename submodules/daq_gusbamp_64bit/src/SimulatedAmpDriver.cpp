@@ -0,0 +1,455 @@
+#include <string>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <math.h>
+#include <afxwin.h>
+#include "gUSBamp.h"
+#include "AmpDriver.h"
+#include "SimulatedAmpDriver.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+typedef std::chrono::steady_clock::time_point TimePoint;
+
+// Transfer queued by GetData
+struct SimulatedTransfer
+{
+	BYTE *buffer;
+	DWORD sizeBytes;
+	OVERLAPPED *ov;
+	TimePoint notifyTime;
+};
+
+// State of one simulated amplifier
+struct SimulatedDevice
+{
+	std::string serial;
+
+	// Settings
+	int numChannels;
+	int trigger;
+	int sampleRate;
+	int bufferScans;
+
+	// Sample clock
+	std::thread clock;
+	bool running;
+
+	// Transfers queued and not filled yet, and filled transfers waiting for their notification
+	std::deque<SimulatedTransfer> pending;
+	std::deque<SimulatedTransfer> filled;
+
+	// Notification time of the last filled transfer, notifications are never reordered
+	TimePoint lastNotifyTime;
+
+	// Blocks held by the device while no transfer was queued
+	int fifoBlocks;
+
+	// Scans dropped and scans produced so far
+	long long lostScans;
+	long long sampleCounter;
+
+	// No more scans to produce
+	bool finished;
+
+	// Values of the block being produced
+	std::vector<float> values;
+
+	// Digital outputs read back on the trigger channel, and the changes not acquired yet with the first scan showing them
+	float triggerValue;
+	std::deque<std::pair<long long, float>> triggerChanges;
+
+	// Start of the block being acquired by the sample clock (with pace)
+	TimePoint blockStart;
+
+	std::mt19937 random;
+	std::mutex lock;
+	std::condition_variable wake;
+};
+
+// Constructor
+SimulatedAmpDriver::SimulatedAmpDriver(int numDevices, double jitterMs, double stallProbability, double maxStallMs, double loopbackDelayMs)
+{
+	_numDevices = numDevices;
+	_jitterMs = jitterMs;
+	_stallProbability = stallProbability;
+	_maxStallMs = maxStallMs;
+	_loopbackDelayMs = loopbackDelayMs;
+	_closedLostScans = 0;
+	_speed = 1;
+}
+
+// Destructor
+SimulatedAmpDriver::~SimulatedAmpDriver()
+{
+	while (!_devices.empty())
+	{
+		HANDLE hDevice = _devices.back();
+		CloseDevice(&hDevice);
+	}
+}
+
+HANDLE SimulatedAmpDriver::OpenDevice(int usbPort)
+{
+	if (usbPort < 0 || usbPort >= _numDevices)
+		return NULL;
+
+	char serial[16];
+	sprintf(serial, "UB-SIM.00.%02d", usbPort + 1);
+	return OpenDeviceEx(serial);
+}
+
+HANDLE SimulatedAmpDriver::OpenDeviceEx(LPSTR serial)
+{
+	int number = 0;
+	if (sscanf(serial, "UB-SIM.00.%d", &number) == 1 && (number < 1 || number > _numDevices))
+		return NULL;
+
+	SimulatedDevice *device = new SimulatedDevice();
+	device->serial = serial;
+	device->numChannels = 16;
+	device->trigger = 0;
+	device->sampleRate = 256;
+	device->bufferScans = 8;
+	device->running = false;
+	device->fifoBlocks = 0;
+	device->lostScans = 0;
+	device->sampleCounter = 0;
+	device->finished = false;
+	device->triggerValue = 0;
+	device->random.seed((unsigned int) std::hash<std::string>()(device->serial));
+
+	std::lock_guard<std::mutex> lock(_devicesLock);
+	_devices.push_back(device);
+	return device;
+}
+
+BOOL SimulatedAmpDriver::CloseDevice(HANDLE *hDevice)
+{
+	SimulatedDevice *device = (SimulatedDevice *) *hDevice;
+	if (device == NULL)
+		return FALSE;
+
+	Stop(device);
+
+	std::lock_guard<std::mutex> lock(_devicesLock);
+	_devices.erase(std::remove(_devices.begin(), _devices.end(), device), _devices.end());
+	_closedLostScans += device->lostScans;
+	delete device;
+
+	*hDevice = NULL;
+	return TRUE;
+}
+
+BOOL SimulatedAmpDriver::GetSerial(HANDLE hDevice, LPSTR serial, UINT size)
+{
+	SimulatedDevice *device = (SimulatedDevice *) hDevice;
+	if (size == 0 || device->serial.size() >= size)
+		return FALSE;
+
+	strcpy(serial, device->serial.c_str());
+	return TRUE;
+}
+
+BOOL SimulatedAmpDriver::SetChannels(HANDLE hDevice, UCHAR *channels, UCHAR numChannels)
+{
+	((SimulatedDevice *) hDevice)->numChannels = numChannels;
+	return numChannels > 0;
+}
+
+BOOL SimulatedAmpDriver::SetSampleRate(HANDLE hDevice, WORD sampleRate)
+{
+	((SimulatedDevice *) hDevice)->sampleRate = sampleRate;
+	return sampleRate > 0;
+}
+
+BOOL SimulatedAmpDriver::EnableTriggerLine(HANDLE hDevice, BOOL enable)
+{
+	((SimulatedDevice *) hDevice)->trigger = enable ? 1 : 0;
+	return TRUE;
+}
+
+BOOL SimulatedAmpDriver::SetBufferSize(HANDLE hDevice, WORD numScans)
+{
+	((SimulatedDevice *) hDevice)->bufferScans = numScans;
+	return numScans > 0;
+}
+
+BOOL SimulatedAmpDriver::GetScale(HANDLE hDevice, SCALE *scaling)
+{
+	for (int i = 0; i < 16; i++)
+	{
+		scaling->factor[i] = 1;
+		scaling->offset[i] = 0;
+	}
+	return TRUE;
+}
+
+BOOL SimulatedAmpDriver::Start(HANDLE hDevice)
+{
+	SimulatedDevice *device = (SimulatedDevice *) hDevice;
+	if (device->running)
+		return FALSE;
+
+	device->running = true;
+	device->fifoBlocks = 0;
+	device->lastNotifyTime = std::chrono::steady_clock::now();
+	device->clock = std::thread(&SimulatedAmpDriver::ClockLoop, this, device);
+	return TRUE;
+}
+
+BOOL SimulatedAmpDriver::Stop(HANDLE hDevice)
+{
+	SimulatedDevice *device = (SimulatedDevice *) hDevice;
+
+	{
+		std::lock_guard<std::mutex> lock(device->lock);
+		device->running = false;
+	}
+	device->wake.notify_all();
+
+	if (device->clock.joinable())
+		device->clock.join();
+	return TRUE;
+}
+
+BOOL SimulatedAmpDriver::ResetTransfer(HANDLE hDevice)
+{
+	SimulatedDevice *device = (SimulatedDevice *) hDevice;
+
+	std::lock_guard<std::mutex> lock(device->lock);
+	device->pending.clear();
+	device->filled.clear();
+	device->fifoBlocks = 0;
+	return TRUE;
+}
+
+BOOL SimulatedAmpDriver::GetData(HANDLE hDevice, BYTE *buffer, DWORD sizeBytes, OVERLAPPED *ov)
+{
+	SimulatedDevice *device = (SimulatedDevice *) hDevice;
+
+	{
+		std::lock_guard<std::mutex> lock(device->lock);
+
+		//blocks held by the device are delivered right away
+		if (device->fifoBlocks > 0)
+		{
+			device->fifoBlocks--;
+			if (!FillTransfer(device, buffer, sizeBytes, ov))
+				device->finished = true;
+		}
+		else
+		{
+			SimulatedTransfer transfer = {buffer, sizeBytes, ov, TimePoint()};
+			device->pending.push_back(transfer);
+		}
+	}
+	device->wake.notify_all();
+
+	return TRUE;
+}
+
+BOOL SimulatedAmpDriver::GetOverlappedResult(HANDLE hDevice, OVERLAPPED *ov, DWORD *numBytes, BOOL wait)
+{
+	if (wait)
+		WaitForSingleObject(ov->hEvent, INFINITE);
+
+	*numBytes = (DWORD) ov->InternalHigh;
+	return TRUE;
+}
+
+BOOL SimulatedAmpDriver::SetDigitalOutEx(HANDLE hDevice, DigitalOUT digitalOut)
+{
+	SimulatedDevice *device = (SimulatedDevice *) hDevice;
+	float value = (float) ((digitalOut.OUT_0 ? 1 : 0) + (digitalOut.OUT_1 ? 2 : 0) + (digitalOut.OUT_2 ? 4 : 0) + (digitalOut.OUT_3 ? 8 : 0));
+	TimePoint arrival = std::chrono::steady_clock::now() + std::chrono::microseconds((long long) (_loopbackDelayMs * 1000));
+
+	std::lock_guard<std::mutex> lock(device->lock);
+
+	//scans acquired so far (delivered, held or dropped), then the first one acquired once the value arrives
+	long long scan = device->sampleCounter + (long long) device->fifoBlocks * device->bufferScans;
+	if (device->running && _speed > 0)
+	{
+		double seconds = std::chrono::duration<double>(arrival - device->blockStart).count();
+		scan += max((long long) ceil(seconds * device->sampleRate * _speed) - 1, 0LL);
+	}
+	if (!device->triggerChanges.empty())
+		scan = max(scan, device->triggerChanges.back().first);
+
+	device->triggerChanges.push_back(std::make_pair(scan, value));
+	return TRUE;
+}
+
+BOOL SimulatedAmpDriver::GetImpedance(HANDLE hDevice, UCHAR channel, double *impedance)
+{
+	SimulatedDevice *device = (SimulatedDevice *) hDevice;
+	if (device == NULL || channel < 1 || channel > 16)
+		return FALSE;
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(IMPEDANCE_MS));
+
+	//the same electrode always has about the same impedance, channel 16 is not connected
+	unsigned int hash = (unsigned int) std::hash<std::string>()(device->serial) ^ (channel * 2654435761u);
+	double kOhm = (channel == 16) ? 1000.0 : 2.0 + (hash % 2800) / 100.0;
+
+	std::lock_guard<std::mutex> lock(device->lock);
+	std::uniform_real_distribution<double> noise(-0.02, 0.02);
+	*impedance = 1000.0 * kOhm * (1.0 + noise(device->random));
+	return TRUE;
+}
+
+long long SimulatedAmpDriver::LostScans()
+{
+	std::lock_guard<std::mutex> lock(_devicesLock);
+
+	long long lostScans = _closedLostScans;
+	for (size_t i = 0; i < _devices.size(); i++)
+	{
+		std::lock_guard<std::mutex> deviceLock(_devices[i]->lock);
+		lostScans += _devices[i]->lostScans;
+	}
+	return lostScans;
+}
+
+bool SimulatedAmpDriver::Finished()
+{
+	std::lock_guard<std::mutex> lock(_devicesLock);
+
+	bool finished = false;
+	for (size_t i = 0; i < _devices.size(); i++)
+	{
+		std::lock_guard<std::mutex> deviceLock(_devices[i]->lock);
+		finished = finished || _devices[i]->finished;
+	}
+	return finished;
+}
+
+bool SimulatedAmpDriver::ProduceScans(HANDLE hDevice, long long firstScan, int numScans, int numChannels, int trigger, float digitalOut, float *scans)
+{
+	SimulatedDevice *device = (SimulatedDevice *) hDevice;
+	std::uniform_real_distribution<float> noise(-1.0f, 1.0f);
+
+	//10 uV sines at 8 Hz, 9 Hz, ... plus noise, then the trigger
+	for (int scanIndex = 0; scanIndex < numScans; scanIndex++)
+	{
+		long long sample = firstScan + scanIndex;
+		for (int channel = 0; channel < numChannels; channel++)
+			*scans++ = (float) (10.0 * sin(2 * M_PI * (8 + channel) * sample / device->sampleRate)) + noise(device->random);
+		if (trigger)
+			*scans++ = digitalOut;
+	}
+	return true;
+}
+
+bool SimulatedAmpDriver::FillTransfer(SimulatedDevice *device, BYTE *buffer, DWORD sizeBytes, OVERLAPPED *ov)
+{
+	int scanSize = device->numChannels + device->trigger;
+	DWORD blockBytes = HEADER_SIZE + device->bufferScans * scanSize * sizeof(float);
+	DWORD numBytes = min(sizeBytes, blockBytes);
+
+	device->values.resize((size_t) device->bufferScans * scanSize);
+
+	//runs of scans with the same digital outputs
+	for (int scanIndex = 0; scanIndex < device->bufferScans;)
+	{
+		long long scan = device->sampleCounter + scanIndex;
+		while (!device->triggerChanges.empty() && device->triggerChanges.front().first <= scan)
+		{
+			device->triggerValue = device->triggerChanges.front().second;
+			device->triggerChanges.pop_front();
+		}
+
+		int runScans = device->bufferScans - scanIndex;
+		if (!device->triggerChanges.empty())
+			runScans = (int) min((long long) runScans, device->triggerChanges.front().first - scan);
+
+		if (!ProduceScans(device, scan, runScans, device->numChannels, device->trigger, device->triggerValue, &device->values[(size_t) scanIndex * scanSize]))
+			return false;
+		scanIndex += runScans;
+	}
+
+	//the header leaves the values unaligned
+	memset(buffer, 0, min(numBytes, (DWORD) HEADER_SIZE));
+	if (numBytes > HEADER_SIZE)
+		memcpy(buffer + HEADER_SIZE, &device->values[0], numBytes - HEADER_SIZE);
+	device->sampleCounter += device->bufferScans;
+
+	//notification delay: small jitter, sometimes a stall
+	std::uniform_real_distribution<double> uniform(0.0, 1.0);
+	double delayMs = uniform(device->random) * _jitterMs;
+	if (uniform(device->random) < _stallProbability)
+		delayMs = uniform(device->random) * _maxStallMs;
+
+	TimePoint notifyTime = std::chrono::steady_clock::now() + std::chrono::microseconds((long long) (delayMs * 1000));
+	device->lastNotifyTime = max(notifyTime, device->lastNotifyTime);
+
+	ov->InternalHigh = numBytes;
+	SimulatedTransfer transfer = {buffer, sizeBytes, ov, device->lastNotifyTime};
+	device->filled.push_back(transfer);
+	return true;
+}
+
+void SimulatedAmpDriver::ClockLoop(SimulatedDevice *device)
+{
+	std::unique_lock<std::mutex> lock(device->lock);
+
+	//without pace (speed 0) the clock only fills the queued transfers
+	bool paced = (_speed > 0);
+	std::chrono::nanoseconds period((long long) (paced ? 1e9 * device->bufferScans / (device->sampleRate * _speed) : 0));
+	TimePoint nextBlock = std::chrono::steady_clock::now() + period;
+	device->blockStart = nextBlock - period;
+
+	while (device->running)
+	{
+		//sleep until the next block is due (a transfer is queued without pace) or the next notification
+		bool idle = device->finished || (!paced && device->pending.empty());
+		if (idle && device->filled.empty())
+			device->wake.wait(lock);
+		else if (idle || paced)
+		{
+			TimePoint wakeTime = idle ? device->filled.front().notifyTime : nextBlock;
+			if (!device->filled.empty())
+				wakeTime = min(wakeTime, device->filled.front().notifyTime);
+			device->wake.wait_until(lock, wakeTime);
+		}
+
+		TimePoint now = std::chrono::steady_clock::now();
+
+		//produce every block that is due
+		while (!device->finished && (paced ? nextBlock <= now : !device->pending.empty()))
+		{
+			if (!device->pending.empty())
+			{
+				SimulatedTransfer transfer = device->pending.front();
+				if (FillTransfer(device, transfer.buffer, transfer.sizeBytes, transfer.ov))
+					device->pending.pop_front();
+				else
+					device->finished = true;
+			}
+			else if (device->fifoBlocks < DEVICE_FIFO_BLOCKS)
+				device->fifoBlocks++;
+			else
+			{
+				device->lostScans += device->bufferScans;
+				device->sampleCounter += device->bufferScans;
+			}
+			nextBlock += period;
+			device->blockStart = nextBlock - period;
+		}
+
+		//signal the transfers whose notification is due
+		while (!device->filled.empty() && device->filled.front().notifyTime <= now)
+		{
+			SetEvent(device->filled.front().ov->hEvent);
+			device->filled.pop_front();
+		}
+	}
+}
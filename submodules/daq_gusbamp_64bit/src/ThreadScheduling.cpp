@@ -0,0 +1,222 @@
+#ifdef _WIN32
+#include <Windows.h>
+#include <psapi.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#endif
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <algorithm>
+#include "ThreadScheduling.h"
+
+#ifdef _WIN32
+// Process and thread records returned by NtQuerySystemInformation(SystemProcessInformation), as laid out by ntdll.
+// Only the fields up to the thread array and the thread context switch count are used
+struct NtThreadInformation
+{
+	LARGE_INTEGER kernelTime;
+	LARGE_INTEGER userTime;
+	LARGE_INTEGER createTime;
+	ULONG waitTime;
+	PVOID startAddress;
+	HANDLE uniqueProcess;
+	HANDLE uniqueThread;
+	LONG priority;
+	LONG basePriority;
+	ULONG contextSwitches;
+	ULONG threadState;
+	ULONG waitReason;
+};
+
+struct NtProcessInformation
+{
+	ULONG nextEntryOffset;
+	ULONG numberOfThreads;
+	LARGE_INTEGER reserved[6];
+	USHORT imageNameLength;
+	USHORT imageNameMaximumLength;
+	PWSTR imageNameBuffer;
+	LONG basePriority;
+	HANDLE uniqueProcessId;
+	HANDLE inheritedFromUniqueProcessId;
+	ULONG handleCount;
+	ULONG sessionId;
+	ULONG_PTR uniqueProcessKey;
+	SIZE_T virtualMemory[2];
+	ULONG pageFaultCount;
+	SIZE_T memoryUsage[9];
+	LARGE_INTEGER ioCounters[6];
+};
+
+typedef LONG (WINAPI *NtQuerySystemInformationFunction)(ULONG, PVOID, ULONG, PULONG);
+
+static const ULONG SYSTEM_PROCESS_INFORMATION_CLASS = 5;
+static const LONG STATUS_INFO_LENGTH_MISMATCH_CODE = (LONG) 0xC0000004;
+#endif
+
+// Size of a memory page
+static size_t PageSize()
+{
+#ifdef _WIN32
+	SYSTEM_INFO systemInfo;
+	GetSystemInfo(&systemInfo);
+	return systemInfo.dwPageSize;
+#else
+	return (size_t) sysconf(_SC_PAGESIZE);
+#endif
+}
+
+int ThreadScheduling::NumCpus()
+{
+	int numCpus = (int) std::thread::hardware_concurrency();
+	return (numCpus > 0) ? numCpus : 1;
+}
+
+bool ThreadScheduling::PinCurrentThread(int cpu)
+{
+	if (cpu < 0 || cpu >= NumCpus())
+		return false;
+
+#ifdef _WIN32
+	return SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR) 1 << cpu) != 0;
+#else
+	cpu_set_t cpuSet;
+	CPU_ZERO(&cpuSet);
+	CPU_SET(cpu, &cpuSet);
+	return pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet) == 0;
+#endif
+}
+
+bool ThreadScheduling::SetCurrentThreadRealTime(bool timeCritical)
+{
+#ifdef _WIN32
+	return SetThreadPriority(GetCurrentThread(), timeCritical ? THREAD_PRIORITY_TIME_CRITICAL : THREAD_PRIORITY_HIGHEST) != 0;
+#else
+	//leave the top levels to the kernel threads the devices depend on
+	struct sched_param parameters;
+	parameters.sched_priority = sched_get_priority_max(SCHED_FIFO) - (timeCritical ? 10 : 20);
+	return pthread_setschedparam(pthread_self(), SCHED_FIFO, &parameters) == 0;
+#endif
+}
+
+bool ThreadScheduling::LockMemory(void *address, size_t numBytes)
+{
+	if (address == NULL || numBytes == 0)
+		return false;
+
+	//write every page once so it is mapped before acquisition needs it (values are kept)
+	size_t pageSize = PageSize();
+	volatile char *bytes = (volatile char *) address;
+	for (size_t offset = 0; offset < numBytes; offset += pageSize)
+		bytes[offset] = bytes[offset];
+	bytes[numBytes - 1] = bytes[numBytes - 1];
+
+#ifdef _WIN32
+	//pages locked by a process count against its minimum working set, grow it by the locked size
+	SIZE_T minimumSize, maximumSize;
+	if (GetProcessWorkingSetSize(GetCurrentProcess(), &minimumSize, &maximumSize))
+		SetProcessWorkingSetSize(GetCurrentProcess(), minimumSize + numBytes + pageSize, maximumSize + numBytes + pageSize);
+	return VirtualLock(address, numBytes) != 0;
+#else
+	return mlock(address, numBytes) == 0;
+#endif
+}
+
+void ThreadScheduling::UnlockMemory(void *address, size_t numBytes)
+{
+	if (address == NULL || numBytes == 0)
+		return;
+
+#ifdef _WIN32
+	VirtualUnlock(address, numBytes);
+#else
+	munlock(address, numBytes);
+#endif
+}
+
+long long ThreadScheduling::CurrentThreadId()
+{
+#ifdef _WIN32
+	return (long long) GetCurrentThreadId();
+#else
+	return (long long) syscall(SYS_gettid);
+#endif
+}
+
+long long ThreadScheduling::ThreadContextSwitches(long long threadId)
+{
+#ifdef _WIN32
+	//the per thread count is only exposed by the process snapshot of ntdll
+	NtQuerySystemInformationFunction query = (NtQuerySystemInformationFunction) GetProcAddress(GetModuleHandleA("ntdll.dll"), "NtQuerySystemInformation");
+	if (query == NULL)
+		return -1;
+
+	std::vector<BYTE> snapshot(1 << 18);
+	ULONG neededSize = 0;
+	LONG status;
+	while ((status = query(SYSTEM_PROCESS_INFORMATION_CLASS, &snapshot[0], (ULONG) snapshot.size(), &neededSize)) == STATUS_INFO_LENGTH_MISMATCH_CODE)
+		snapshot.resize((std::max)((size_t) neededSize, snapshot.size()) * 2);
+	if (status < 0)
+		return -1;
+
+	DWORD processId = GetCurrentProcessId();
+	BYTE *entry = &snapshot[0];
+	while (true)
+	{
+		NtProcessInformation *process = (NtProcessInformation *) entry;
+		if ((DWORD) (ULONG_PTR) process->uniqueProcessId == processId)
+		{
+			NtThreadInformation *threads = (NtThreadInformation *) (process + 1);
+			for (ULONG i = 0; i < process->numberOfThreads; i++)
+				if ((long long) (ULONG_PTR) threads[i].uniqueThread == threadId)
+					return threads[i].contextSwitches;
+			return -1;
+		}
+
+		if (process->nextEntryOffset == 0)
+			return -1;
+		entry += process->nextEntryOffset;
+	}
+#else
+	std::ostringstream statusName;
+	statusName << "/proc/self/task/" << threadId << "/status";
+	std::ifstream statusFile(statusName.str().c_str());
+	if (!statusFile.is_open())
+		return -1;
+
+	long long contextSwitches = 0;
+	std::string line;
+	while (std::getline(statusFile, line))
+	{
+		std::istringstream fields(line);
+		std::string name;
+		long long value;
+		if ((fields >> name >> value) && (name == "voluntary_ctxt_switches:" || name == "nonvoluntary_ctxt_switches:"))
+			contextSwitches += value;
+	}
+	return contextSwitches;
+#endif
+}
+
+long long ThreadScheduling::ProcessPageFaults()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+		return -1;
+	return counters.PageFaultCount;
+#else
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return -1;
+	return usage.ru_minflt + usage.ru_majflt;
+#endif
+}
@@ -0,0 +1,53 @@
+#include <vector>
+#include <algorithm>
+#include "TransferMonitor.h"
+
+// Constructor
+TransferMonitor::TransferMonitor(double blockSeconds, int windowLength)
+{
+	_blockSeconds = blockSeconds;
+	_lateness.resize(std::max(windowLength, 1));
+	Reset();
+}
+
+void TransferMonitor::Reset()
+{
+	_numCompletions = 0;
+	_lastChange = 0;
+}
+
+void TransferMonitor::AddCompletion(long long blockIndex, double seconds)
+{
+	_lateness[_numCompletions % _lateness.size()] = seconds - blockIndex * _blockSeconds;
+	_numCompletions++;
+}
+
+double TransferMonitor::LatencyPercentile(double percent) const
+{
+	size_t numValues = (size_t) std::min((long long) _lateness.size(), _numCompletions);
+	if (numValues == 0)
+		return 0;
+
+	std::vector<double> latencies(_lateness.begin(), _lateness.begin() + numValues);
+	size_t rank = (size_t) (percent / 100.0 * (numValues - 1) + 0.5);
+	rank = std::min(rank, numValues - 1);
+	std::nth_element(latencies.begin(), latencies.begin() + rank, latencies.end());
+	double percentile = latencies[rank];
+
+	return percentile - *std::min_element(latencies.begin(), latencies.end());
+}
+
+int TransferMonitor::RecommendDepth(int currentDepth, int maxDepth)
+{
+	// wait for a quarter of the window after start and after each change
+	long long settle = std::max((long long) _lateness.size() / 4, 1LL);
+	if (currentDepth >= maxDepth || _numCompletions - _lastChange < settle)
+		return currentDepth;
+
+	double slack = (currentDepth - 1) * _blockSeconds;
+	if (LatencyPercentile(95) <= 0.5 * slack)
+		return currentDepth;
+
+	_lastChange = _numCompletions;
+	return currentDepth + 1;
+}
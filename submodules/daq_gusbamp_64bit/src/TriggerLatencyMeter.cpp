@@ -0,0 +1,117 @@
+#include <deque>
+#include <vector>
+#include <algorithm>
+#include "TriggerLatencyMeter.h"
+
+// Constructor
+TriggerLatencyMeter::TriggerLatencyMeter(int sampleRate, int scanStride, int triggerIndex)
+{
+	_sampleRate = sampleRate;
+	_scanStride = scanStride;
+	_triggerIndex = triggerIndex;
+	Reset();
+}
+
+void TriggerLatencyMeter::Reset()
+{
+	_pending.clear();
+	_matches.clear();
+	_numMissed = 0;
+	_lastValue = -1;
+	_clockOffset = 0;
+	_clockSet = false;
+}
+
+void TriggerLatencyMeter::Sent(int pattern, double seconds, long long targetScan)
+{
+	Pending pending = {pattern, seconds, targetScan};
+	_pending.push_back(pending);
+}
+
+void TriggerLatencyMeter::Received(const float *scans, int numScans, long long firstScan, double seconds)
+{
+	if (numScans < 1)
+		return;
+
+	//the block can't have returned before its last scan was acquired
+	double offset = seconds - (double) (firstScan + numScans) / _sampleRate;
+	if (!_clockSet || offset < _clockOffset)
+		_clockOffset = offset;
+	_clockSet = true;
+
+	for (int scanIndex = 0; scanIndex < numScans; scanIndex++)
+	{
+		int value = (int) (scans[(size_t) scanIndex * _scanStride + _triggerIndex] + 0.5f);
+		if (value == _lastValue)
+			continue;
+		_lastValue = value;
+
+		//the oldest pattern with this value, the ones sent before it never showed up
+		std::deque<Pending>::iterator found = _pending.begin();
+		while (found != _pending.end() && found->pattern != value)
+			++found;
+		if (found == _pending.end())
+			continue;
+
+		_numMissed += (int) (found - _pending.begin());
+		Match match = {found->sendTime, firstScan + scanIndex, seconds, found->targetScan};
+		_matches.push_back(match);
+		_pending.erase(_pending.begin(), found + 1);
+	}
+}
+
+double TriggerLatencyMeter::ScanTime(long long scan) const
+{
+	return _clockOffset + (double) (scan + 1) / _sampleRate;
+}
+
+LatencyDistribution TriggerLatencyMeter::SendToSample() const
+{
+	std::vector<double> latencies;
+	for (size_t i = 0; i < _matches.size(); i++)
+		latencies.push_back(ScanTime(_matches[i].scan) - _matches[i].sendTime);
+	return Distribution(latencies);
+}
+
+LatencyDistribution TriggerLatencyMeter::SampleToReturn() const
+{
+	std::vector<double> latencies;
+	for (size_t i = 0; i < _matches.size(); i++)
+		latencies.push_back(_matches[i].returnTime - ScanTime(_matches[i].scan));
+	return Distribution(latencies);
+}
+
+LatencyDistribution TriggerLatencyMeter::SendToReturn() const
+{
+	std::vector<double> latencies;
+	for (size_t i = 0; i < _matches.size(); i++)
+		latencies.push_back(_matches[i].returnTime - _matches[i].sendTime);
+	return Distribution(latencies);
+}
+
+LatencyDistribution TriggerLatencyMeter::TargetOffset() const
+{
+	std::vector<double> offsets;
+	for (size_t i = 0; i < _matches.size(); i++)
+		if (_matches[i].targetScan >= 0)
+			offsets.push_back((double) (_matches[i].scan - _matches[i].targetScan) / _sampleRate);
+	return Distribution(offsets);
+}
+
+LatencyDistribution TriggerLatencyMeter::Distribution(std::vector<double> &latencies)
+{
+	LatencyDistribution distribution = {(int) latencies.size(), 0, 0, 0, 0, 0, 0};
+	if (latencies.empty())
+		return distribution;
+
+	std::sort(latencies.begin(), latencies.end());
+	size_t last = latencies.size() - 1;
+	for (size_t i = 0; i < latencies.size(); i++)
+		distribution.mean += latencies[i] / latencies.size();
+	distribution.minimum = latencies.front();
+	distribution.median = latencies[(size_t) (0.50 * last + 0.5)];
+	distribution.p95 = latencies[(size_t) (0.95 * last + 0.5)];
+	distribution.p99 = latencies[(size_t) (0.99 * last + 0.5)];
+	distribution.maximum = latencies.back();
+	return distribution;
+}
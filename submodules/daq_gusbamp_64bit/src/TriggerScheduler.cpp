@@ -0,0 +1,296 @@
+#ifdef _WIN32
+#include <Windows.h>
+#endif
+#include <math.h>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <algorithm>
+#include <fstream>
+#include "ThreadScheduling.h"
+#include "TriggerScheduler.h"
+
+const double TriggerScheduler::SPIN_SECONDS = 0.002;
+
+// Constructor
+TriggerScheduler::TriggerScheduler(int sampleRate, EmitFunction emit)
+{
+	_sampleRate = sampleRate;
+	_emit = emit;
+	_outputLatency = 0;
+	_running = false;
+	Reset();
+}
+
+// Destructor
+TriggerScheduler::~TriggerScheduler()
+{
+	Stop();
+	CloseLog();
+}
+
+double TriggerScheduler::Now()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void TriggerScheduler::Reset()
+{
+	std::lock_guard<std::mutex> lock(_lock);
+
+	_events.clear();
+	_pending.clear();
+	_offsets.clear();
+	_clockOffset = 0;
+}
+
+bool TriggerScheduler::Start(int cpu)
+{
+	std::lock_guard<std::mutex> lock(_lock);
+
+	if (_running)
+		return false;
+	_running = true;
+	_thread = std::thread(&TriggerScheduler::EmitLoop, this, cpu);
+	return true;
+}
+
+void TriggerScheduler::Stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(_lock);
+		if (!_running)
+			return;
+		_running = false;
+	}
+	_wake.notify_all();
+	_thread.join();
+
+	Cancel();
+}
+
+void TriggerScheduler::SetOutputLatency(double seconds)
+{
+	{
+		std::lock_guard<std::mutex> lock(_lock);
+		_outputLatency = seconds;
+	}
+	_wake.notify_all();
+}
+
+void TriggerScheduler::AddBlock(long long numScans, double seconds)
+{
+	{
+		std::lock_guard<std::mutex> lock(_lock);
+
+		//a block can't have returned before its last scan was acquired, the earliest return bounds t0 best
+		_offsets.push_back(seconds - (double) numScans / _sampleRate);
+		if ((int) _offsets.size() > CLOCK_WINDOW)
+			_offsets.pop_front();
+		_clockOffset = *std::min_element(_offsets.begin(), _offsets.end());
+	}
+
+	//events on a scan may now be due, or due at another time
+	_wake.notify_all();
+}
+
+bool TriggerScheduler::ScanTime(long long scan, double *seconds)
+{
+	std::lock_guard<std::mutex> lock(_lock);
+
+	if (_offsets.empty())
+		return false;
+	*seconds = ScanTimeLocked(scan);
+	return true;
+}
+
+long long TriggerScheduler::ScanAt(double seconds)
+{
+	std::lock_guard<std::mutex> lock(_lock);
+
+	return _offsets.empty() ? -1 : ScanAtLocked(seconds);
+}
+
+int TriggerScheduler::ScheduleAtTime(int value, double seconds)
+{
+	int id;
+	{
+		std::lock_guard<std::mutex> lock(_lock);
+
+		if (!_running)
+			return -1;
+
+		id = (int) _events.size();
+		TriggerEvent event = {id, value, -1, seconds, NAN, -1, TRIGGER_PENDING};
+		_events.push_back(event);
+		_pending.push_back(id);
+	}
+	_wake.notify_all();
+
+	return id;
+}
+
+int TriggerScheduler::ScheduleAtScan(int value, long long scan)
+{
+	int id;
+	{
+		std::lock_guard<std::mutex> lock(_lock);
+
+		if (!_running || scan < 0)
+			return -1;
+
+		id = (int) _events.size();
+		TriggerEvent event = {id, value, scan, NAN, NAN, -1, TRIGGER_PENDING};
+		_events.push_back(event);
+		_pending.push_back(id);
+	}
+	_wake.notify_all();
+
+	return id;
+}
+
+int TriggerScheduler::Cancel()
+{
+	std::lock_guard<std::mutex> lock(_lock);
+
+	int numCancelled = (int) _pending.size();
+	for (size_t i = 0; i < _pending.size(); i++)
+		Complete(_events[_pending[i]], TRIGGER_CANCELLED);
+	_pending.clear();
+	return numCancelled;
+}
+
+void TriggerScheduler::Events(std::vector<TriggerEvent> &events)
+{
+	std::lock_guard<std::mutex> lock(_lock);
+
+	events = _events;
+}
+
+bool TriggerScheduler::OpenLog(const char *fileName)
+{
+	std::lock_guard<std::mutex> lock(_lock);
+
+	if (_log.is_open())
+		_log.close();
+	_log.clear();
+	_log.open(fileName, std::ios::out | std::ios::trunc);
+	if (!_log.is_open())
+		return false;
+
+	_log.precision(15);
+	_log << "id,value,target_scan,target_time,emit_time,emit_scan,state\n";
+	return true;
+}
+
+void TriggerScheduler::CloseLog()
+{
+	std::lock_guard<std::mutex> lock(_lock);
+
+	if (_log.is_open())
+		_log.close();
+}
+
+void TriggerScheduler::EmitLoop(int cpu)
+{
+	if (cpu >= 0)
+		ThreadScheduling::PinCurrentThread(cpu);
+	ThreadScheduling::SetCurrentThreadRealTime(true);
+#ifdef _WIN32
+	//sleeps end within a millisecond instead of the default 15.6 ms tick
+	timeBeginPeriod(1);
+#endif
+
+	std::unique_lock<std::mutex> lock(_lock);
+
+	while (_running)
+	{
+		//the next event whose time is known
+		int next = -1;
+		double due = 0;
+		for (size_t i = 0; i < _pending.size(); i++)
+		{
+			double seconds;
+			if (DueTime(_events[_pending[i]], &seconds) && (next < 0 || seconds < due))
+			{
+				next = _pending[i];
+				due = seconds;
+			}
+		}
+		if (next < 0)
+		{
+			_wake.wait(lock);
+			continue;
+		}
+
+		//sleep until shortly before it (new events and clock updates wake the thread to look again)
+		double wait = due - Now() - SPIN_SECONDS;
+		if (wait > 0)
+		{
+			_wake.wait_for(lock, std::chrono::duration<double>(wait));
+			continue;
+		}
+
+		//spin the rest of the way with the event taken out of the pending ones, so it can't be cancelled meanwhile
+		_pending.erase(std::find(_pending.begin(), _pending.end(), next));
+		int value = _events[next].value;
+		lock.unlock();
+
+		while (Now() < due)
+			std::this_thread::yield();
+		double emitTime = Now();
+		bool written = _emit(value);
+
+		lock.lock();
+		TriggerEvent &event = _events[next];
+		event.targetTime = due;
+		event.emitTime = emitTime;
+		event.emitScan = _offsets.empty() ? -1 : ScanAtLocked(emitTime);
+		Complete(event, written ? TRIGGER_EMITTED : TRIGGER_FAILED);
+	}
+
+	lock.unlock();
+#ifdef _WIN32
+	timeEndPeriod(1);
+#endif
+}
+
+bool TriggerScheduler::DueTime(const TriggerEvent &event, double *seconds) const
+{
+	if (event.targetScan < 0)
+	{
+		*seconds = event.targetTime;
+		return true;
+	}
+	if (_offsets.empty())
+		return false;
+
+	//in the middle of the sampling interval of the scan, early enough to reach the amplifier by then
+	*seconds = ScanTimeLocked(event.targetScan) - 0.5 / _sampleRate - _outputLatency;
+	return true;
+}
+
+double TriggerScheduler::ScanTimeLocked(long long scan) const
+{
+	return _clockOffset + (double) (scan + 1) / _sampleRate;
+}
+
+long long TriggerScheduler::ScanAtLocked(double seconds) const
+{
+	//the scan whose sampling interval contains the time
+	return (long long) ceil((seconds - _clockOffset) * _sampleRate) - 1;
+}
+
+void TriggerScheduler::Complete(TriggerEvent &event, TriggerEventState state)
+{
+	event.state = state;
+
+	if (_log.is_open())
+	{
+		_log << event.id << "," << event.value << "," << event.targetScan << "," << event.targetTime << ","
+			<< event.emitTime << "," << event.emitScan << "," << (int) state << "\n";
+		_log.flush();
+	}
+}
@@ -0,0 +1,169 @@
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include "WorkStealingPool.h"
+
+// Index of the worker running on the current thread, -1 outside the pool
+static thread_local int currentWorkerIndex = -1;
+
+// Pool that owns the current worker thread, NULL outside the pool
+static thread_local WorkStealingPool *currentPool = NULL;
+
+// Constructor
+WorkStealingPool::WorkStealingPool(int numThreads)
+	: _queuedTasks(0), _pendingTasks(0), _nextQueue(0), _stolenTasks(0), _stopping(false), _setupGeneration(0), _setupPending(0)
+{
+	if (numThreads <= 0)
+		numThreads = (int) std::thread::hardware_concurrency();
+	if (numThreads <= 0)
+		numThreads = 1;
+
+	for (int i = 0; i < numThreads; i++)
+		_queues.push_back(std::unique_ptr<WorkerQueue>(new WorkerQueue()));
+
+	for (int i = 0; i < numThreads; i++)
+		_workers.push_back(std::thread(&WorkStealingPool::WorkerLoop, this, i));
+}
+
+// Destructor
+WorkStealingPool::~WorkStealingPool()
+{
+	Wait();
+
+	{
+		std::lock_guard<std::mutex> lock(_stateLock);
+		_stopping = true;
+	}
+	_workAvailable.notify_all();
+
+	for (size_t i = 0; i < _workers.size(); i++)
+		_workers[i].join();
+}
+
+void WorkStealingPool::Submit(std::function<void()> task)
+{
+	//keep nested tasks local to the worker that created them
+	int queueIndex;
+	if (currentPool == this)
+		queueIndex = currentWorkerIndex;
+	else
+		queueIndex = (int) (_nextQueue++ % _queues.size());
+
+	_pendingTasks++;
+	{
+		std::lock_guard<std::mutex> lock(_queues[queueIndex]->lock);
+		_queues[queueIndex]->tasks.push_back(task);
+	}
+	_queuedTasks++;
+
+	//taking the state lock orders this against a worker that is about to sleep
+	{
+		std::lock_guard<std::mutex> lock(_stateLock);
+	}
+	_workAvailable.notify_one();
+}
+
+void WorkStealingPool::Wait()
+{
+	std::unique_lock<std::mutex> lock(_stateLock);
+	_allDone.wait(lock, [this] { return _pendingTasks == 0; });
+}
+
+void WorkStealingPool::ConfigureWorkers(std::function<void(int)> setup)
+{
+	std::unique_lock<std::mutex> lock(_stateLock);
+	_setup = setup;
+	_setupPending = (int) _workers.size();
+	_setupGeneration++;
+	_workAvailable.notify_all();
+
+	_setupDone.wait(lock, [this] { return _setupPending == 0; });
+}
+
+bool WorkStealingPool::TryGetTask(int workerIndex, std::function<void()> &task)
+{
+	//own queue, newest first (its data is most likely still in cache)
+	{
+		WorkerQueue &own = *_queues[workerIndex];
+		std::lock_guard<std::mutex> lock(own.lock);
+		if (!own.tasks.empty())
+		{
+			task = own.tasks.back();
+			own.tasks.pop_back();
+			_queuedTasks--;
+			return true;
+		}
+	}
+
+	//steal the oldest task of the other workers
+	int numQueues = (int) _queues.size();
+	for (int offset = 1; offset < numQueues; offset++)
+	{
+		WorkerQueue &victim = *_queues[(workerIndex + offset) % numQueues];
+		std::lock_guard<std::mutex> lock(victim.lock);
+		if (!victim.tasks.empty())
+		{
+			task = victim.tasks.front();
+			victim.tasks.pop_front();
+			_queuedTasks--;
+			_stolenTasks++;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void WorkStealingPool::WorkerLoop(int workerIndex)
+{
+	currentWorkerIndex = workerIndex;
+	currentPool = this;
+
+	std::function<void()> task;
+	int setupGeneration = 0;
+
+	while (true)
+	{
+		//run the setup of a ConfigureWorkers call on this thread
+		if (_setupGeneration != setupGeneration)
+		{
+			std::function<void(int)> setup;
+			{
+				std::lock_guard<std::mutex> lock(_stateLock);
+				setupGeneration = _setupGeneration;
+				setup = _setup;
+			}
+
+			setup(workerIndex);
+
+			std::lock_guard<std::mutex> lock(_stateLock);
+			if (--_setupPending == 0)
+				_setupDone.notify_all();
+			continue;
+		}
+
+		if (TryGetTask(workerIndex, task))
+		{
+			task();
+			task = std::function<void()>();
+
+			//last task done: wake up callers of Wait
+			if (--_pendingTasks == 0)
+			{
+				std::lock_guard<std::mutex> lock(_stateLock);
+				_allDone.notify_all();
+			}
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(_stateLock);
+		_workAvailable.wait(lock, [this, &setupGeneration] { return _queuedTasks > 0 || _stopping || _setupGeneration != setupGeneration; });
+		if (_stopping && _queuedTasks == 0)
+			break;
+	}
+}
@@ -0,0 +1,84 @@
+#include "BlockDispatcher.h"
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <algorithm>
+
+using namespace std;
+
+// Publishes 300 blocks, one per millisecond, to a fast subscriber and to a slow one (5 ms per block, at most 4 queued).
+// The fast one must get every block in order, off the writer thread and in the buffer the writer filled; the slow one
+// must drop blocks instead of holding the writer back, and the number of buffers must stay bounded
+int main()
+{
+	const int numBlocks = 300, numScans = 8, scanStride = 3;
+	bool success = true;
+
+	BlockDispatcher dispatcher(2);
+	std::thread::id writerThread = std::this_thread::get_id();
+
+	std::atomic<long long> nextExpected(0);
+	std::atomic<int> errors(0);
+	std::vector<const float *> filledBuffers;
+	std::vector<const float *> receivedBuffers(numBlocks);
+
+	int fastId = dispatcher.Subscribe([&](const BlockSpan &span)
+	{
+		if (span.blockIndex != nextExpected++ || std::this_thread::get_id() == writerThread)
+			errors++;
+		if (span.numScans != numScans || span.scanStride != scanStride || span.data[0] != (float) span.blockIndex)
+			errors++;
+		receivedBuffers[span.blockIndex] = span.data;
+	}, 64);
+
+	std::atomic<int> slowCalls(0);
+	int slowId = dispatcher.Subscribe([&](const BlockSpan &)
+	{
+		slowCalls++;
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	}, 4);
+
+	double maxPublishMs = 0;
+	for (int b = 0; b < numBlocks; b++)
+	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		float *block = dispatcher.AcquireBlock(numScans * scanStride);
+		for (int i = 0; i < numScans * scanStride; i++)
+			block[i] = (float) b;
+		filledBuffers.push_back(block);
+		dispatcher.Publish(numScans, scanStride);
+		maxPublishMs = std::max(maxPublishMs, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	dispatcher.Flush();
+
+	SubscriberStats fast, slow;
+	success = success && dispatcher.GetStats(fastId, &fast) && dispatcher.GetStats(slowId, &slow);
+	std::cout << "fast: " << fast.delivered << " delivered, " << fast.dropped << " dropped, lag mean " << fast.meanLagMs
+		<< " ms, max " << fast.maxLagMs << " ms\n";
+	std::cout << "slow: " << slow.delivered << " delivered, " << slow.dropped << " dropped, max queued " << slow.maxQueuedBlocks
+		<< ", callback mean " << slow.meanCallbackMs << " ms\n";
+	std::cout << "publish max " << maxPublishMs << " ms, " << dispatcher.NumBuffers() << " buffers\n";
+
+	success = success && errors == 0 && fast.delivered == numBlocks && fast.dropped == 0;
+	success = success && slow.dropped > 0 && slow.delivered + slow.dropped == numBlocks && slow.maxQueuedBlocks <= 4;
+	success = success && dispatcher.NumBuffers() <= 4 + 2 + 2;
+
+	// subscribers were given the buffers the writer filled
+	for (int b = 0; b < numBlocks; b++)
+		success = success && receivedBuffers[b] == filledBuffers[b];
+
+	// after unsubscribing, blocks are recycled right away
+	success = success && dispatcher.Unsubscribe(slowId) && !dispatcher.Unsubscribe(slowId) && dispatcher.NumSubscribers() == 1;
+	int callsBefore = slowCalls;
+	dispatcher.AcquireBlock(numScans * scanStride)[0] = (float) numBlocks;
+	dispatcher.Publish(numScans, scanStride);
+	dispatcher.Flush();
+	success = success && slowCalls == callsBefore && nextExpected == numBlocks + 1;
+
+	std::cout << (success ? "Block dispatcher test passed" : "Block dispatcher test FAILED") << "\n";
+	return success ? 0 : 1;
+}
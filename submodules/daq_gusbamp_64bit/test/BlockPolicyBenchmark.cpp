@@ -0,0 +1,109 @@
+#include "DAQgUSBamp.h"
+#include <Windows.h>
+#include <iostream>
+#include <vector>
+#include <algorithm>
+
+using namespace std;
+
+// Process CPU time (kernel and user) in seconds
+double ProcessCpuSeconds()
+{
+	FILETIME creationTime, exitTime, kernelTime, userTime;
+	GetProcessTimes(GetCurrentProcess(), &creationTime, &exitTime, &kernelTime, &userTime);
+
+	ULONGLONG kernel = ((ULONGLONG) kernelTime.dwHighDateTime << 32) | kernelTime.dwLowDateTime;
+	ULONGLONG user = ((ULONGLONG) userTime.dwHighDateTime << 32) | userTime.dwLowDateTime;
+	return (kernel + user) * 1e-7;
+}
+
+// Seconds on the performance counter
+double Now()
+{
+	LARGE_INTEGER counter, frequency;
+	QueryPerformanceCounter(&counter);
+	QueryPerformanceFrequency(&frequency);
+	return (double) counter.QuadPart / frequency.QuadPart;
+}
+
+// Acquires from a simulated amplifier with each block policy preset. The simulated amplifier writes its digital
+// outputs to the trigger channel, so the time between SendTrigger and the trigger showing up in GetData is the
+// latency a closed-loop application sees. CPU is the process load while acquiring
+int main()
+{
+	int SampleRate = 256;
+	int TRIGGER = 1;
+	int NumTrials = 100;
+	int ComR[4] = {1, 1, 1, 1};
+	int ComG[4] = {1, 1, 1, 1};
+
+	std::vector<UCHAR> ChToAcq;
+	for (int i = 1; i <= 16; i++)
+		ChToAcq.push_back(i);
+	std::vector<UCHAR> bipolarSettings(16, 0);
+
+	const char *names[] = {"default", "low latency", "high throughput"};
+	BlockPolicy policies[] = {BlockPolicy(), BlockPolicy::LowLatency(SampleRate), BlockPolicy::HighThroughput(SampleRate)};
+
+	for (int preset = 0; preset < 3; preset++)
+	{
+		DAQgUSBamp daq(ChToAcq, SampleRate, TRIGGER, 0, 0, 0, ComR, ComG, bipolarSettings, policies[preset]);
+		daq.UseSimulatedDevice(1, 1, 0, 0);
+
+		if (!daq.OpenAndInitDevice())
+			continue;
+
+		int scanSize = ChToAcq.size() + TRIGGER;
+		int blockScans = daq.BlockScans();
+		std::vector<float> data(SampleRate * scanSize);
+		std::vector<double> latencies;
+		bool state[4] = {false, false, false, false};
+
+		daq.StartAcquisition();
+		double startTime = Now();
+		double startCpu = ProcessCpuSeconds();
+
+		for (int trial = 0; trial < NumTrials; trial++)
+		{
+			//discard what has been acquired so far
+			int available = daq.AvailableSamples();
+			while (available > 0)
+			{
+				int numSamples = (std::min)(available, SampleRate);
+				daq.GetData(&data[0], numSamples);
+				available -= numSamples;
+			}
+
+			//toggle bit 0 and read blocks until it shows up on the trigger channel
+			state[0] = !state[0];
+			float expected = state[0] ? 1.0f : 0.0f;
+			daq.SendTrigger(state);
+			double sendTime = Now();
+
+			bool received = false;
+			while (!received)
+			{
+				daq.GetData(&data[0], blockScans);
+				for (int i = 0; i < blockScans && !received; i++)
+					received = data[i * scanSize + ChToAcq.size()] == expected;
+			}
+			latencies.push_back(Now() - sendTime);
+		}
+
+		double cpu = (ProcessCpuSeconds() - startCpu) / (Now() - startTime);
+		daq.StopAcquisition();
+		daq.CloseDevice();
+
+		std::sort(latencies.begin(), latencies.end());
+		double meanLatency = 0;
+		for (size_t i = 0; i < latencies.size(); i++)
+			meanLatency += latencies[i] / latencies.size();
+
+		std::cout << names[preset] << ": blocks of " << blockScans << " scans (" << 1000.0 * blockScans / SampleRate
+			<< " ms), queue " << policies[preset].queueDepth << ", wake-up every " << policies[preset].wakeBlocks
+			<< " blocks: trigger to data latency mean " << meanLatency * 1000 << " ms, p95 "
+			<< latencies[latencies.size() * 95 / 100] * 1000 << " ms, CPU " << cpu * 100 << " %\n";
+	}
+
+	return 0;
+}
@@ -0,0 +1,52 @@
+#include "CalibrationCache.h"
+#include <iostream>
+#include <stdio.h>
+
+using namespace std;
+
+// Stores the calibration of two amplifiers, saves and reloads the cache: a fresh calibration must come back exactly,
+// an old one (or one stamped in the future) must not be found, and a missing file must give an empty cache
+int main(int argc, char *argv[])
+{
+	const char *fileName = (argc > 1) ? argv[1] : "CalibrationCacheTest.txt";
+	bool success = true;
+
+	float factor[CalibrationCache::NUM_CHANNELS], offset[CalibrationCache::NUM_CHANNELS];
+	for (int i = 0; i < CalibrationCache::NUM_CHANNELS; i++)
+	{
+		factor[i] = 1.0f + 0.001f * i + 1e-7f;
+		offset[i] = -3.25f * i;
+	}
+
+	time_t now = 1800000000;
+	CalibrationCache cache;
+	cache.Store("UB-2016.05.01", now - 3600, factor, offset);
+	cache.Store("UB-2016.05.02", now - 3 * 86400, factor, offset);
+	success = success && cache.Save(fileName);
+
+	CalibrationCache loaded;
+	success = success && loaded.Load(fileName) && loaded.NumEntries() == 2;
+
+	// one hour old: found with a maximum age of a day, bit exact
+	float readFactor[CalibrationCache::NUM_CHANNELS], readOffset[CalibrationCache::NUM_CHANNELS];
+	double age = 0;
+	success = success && loaded.Find("UB-2016.05.01", now, 86400, readFactor, readOffset, &age) && age == 3600;
+	for (int i = 0; i < CalibrationCache::NUM_CHANNELS; i++)
+		success = success && readFactor[i] == factor[i] && readOffset[i] == offset[i];
+
+	// three days old, unknown serial, measured after now
+	success = success && !loaded.Find("UB-2016.05.02", now, 86400, readFactor, readOffset, NULL);
+	success = success && !loaded.Find("UB-2016.05.03", now, 86400, readFactor, readOffset, NULL);
+	success = success && !loaded.Find("UB-2016.05.01", now - 7200, 86400, readFactor, readOffset, NULL);
+
+	// recalibration replaces the entry
+	loaded.Store("UB-2016.05.02", now, factor, offset);
+	success = success && loaded.Find("UB-2016.05.02", now, 86400, readFactor, readOffset, NULL) && loaded.NumEntries() == 2;
+
+	remove(fileName);
+	CalibrationCache missing;
+	success = success && missing.Load(fileName) && missing.NumEntries() == 0;
+
+	std::cout << (success ? "Calibration cache test passed" : "Calibration cache test FAILED") << "\n";
+	return success ? 0 : 1;
+}
@@ -0,0 +1,69 @@
+#include "ChannelGather.h"
+#include <iostream>
+#include <vector>
+#include <chrono>
+
+using namespace std;
+
+// Checks a gather against the element by element transpose for subsets of 1 to 9 channels (in and out of order, with
+// the trigger) over scan counts that are not multiples of 4 or of the cache block, a destination filled by two calls
+// as after a wrap of the ring buffer, and times all 64 channels of one second at 4800 Hz
+int main()
+{
+	const int numChannels = 64, scanStride = numChannels + 1, numScans = 4800;
+	bool success = true;
+
+	std::vector<float> scans((size_t) numScans * scanStride);
+	for (size_t i = 0; i < scans.size(); i++)
+		scans[i] = (float) i;
+
+	int subset[9] = { 7, 2, 64, 0, 31, 32, 33, 63, 5 };
+	int scanCounts[4] = { 1, 3, 67, 1001 };
+	for (int numSelected = 1; numSelected <= 9; numSelected++)
+	{
+		for (int k = 0; k < 4; k++)
+		{
+			int count = scanCounts[k];
+			std::vector<float> rows((size_t) numSelected * count, -1.0f);
+			ChannelGather::Gather(&scans[0], count, scanStride, subset, numSelected, &rows[0], count);
+			for (int c = 0; c < numSelected; c++)
+				for (int s = 0; s < count; s++)
+					success = success && rows[(size_t) c * count + s] == scans[(size_t) s * scanStride + subset[c]];
+		}
+	}
+	std::cout << "subsets " << (success ? "match" : "DIFFER") << "\n";
+
+	// two parts into one destination: the first 130 scans, then the remaining 70 from elsewhere
+	std::vector<float> rows(9 * 200, -1.0f);
+	ChannelGather::Gather(&scans[0], 130, scanStride, subset, 9, &rows[0], 200);
+	ChannelGather::Gather(&scans[(size_t) 1000 * scanStride], 70, scanStride, subset, 9, &rows[130], 200);
+	for (int c = 0; c < 9; c++)
+		for (int s = 0; s < 200; s++)
+			success = success && rows[(size_t) c * 200 + s] == scans[(size_t) ((s < 130) ? s : 1000 + s - 130) * scanStride + subset[c]];
+
+	// all channels, gathered against a naive transpose
+	std::vector<int> all(numChannels);
+	for (int c = 0; c < numChannels; c++)
+		all[c] = c;
+	std::vector<float> channelMajor((size_t) numChannels * numScans);
+	const int repetitions = 50;
+
+	auto start = std::chrono::steady_clock::now();
+	for (int r = 0; r < repetitions; r++)
+		ChannelGather::Gather(&scans[0], numScans, scanStride, &all[0], numChannels, &channelMajor[0], numScans);
+	double gatherMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / repetitions;
+
+	std::vector<float> naive((size_t) numChannels * numScans);
+	start = std::chrono::steady_clock::now();
+	for (int r = 0; r < repetitions; r++)
+		for (int s = 0; s < numScans; s++)
+			for (int c = 0; c < numChannels; c++)
+				naive[(size_t) c * numScans + s] = scans[(size_t) s * scanStride + c];
+	double naiveMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / repetitions;
+
+	success = success && channelMajor == naive;
+	std::cout << numChannels << " channels x " << numScans << " scans: gather " << gatherMs << " ms, naive transpose " << naiveMs << " ms\n";
+
+	std::cout << (success ? "Channel gather test passed" : "Channel gather test FAILED") << "\n";
+	return success ? 0 : 1;
+}
@@ -0,0 +1,73 @@
+#include "ClassifierTrainer.h"
+#include <iostream>
+#include <vector>
+#include <stdlib.h>
+#include <math.h>
+
+using namespace std;
+
+// Trains on synthetic SSVEP trials with 1 thread and with all cores, and checks that both give the same results
+int main()
+{
+	int SampleRate = 256;
+	int NumChannels = 3;
+	int NumSamples = 3 * SampleRate;
+	int TrialsPerClass = 20;
+	int NumFolds = 10;
+
+	double freqArray[] = {8.0, 10.0, 12.0, 15.0};
+	std::vector<double> stimFrequencies(freqArray, freqArray + 4);
+	int NumClasses = (int) stimFrequencies.size();
+	int NumTrials = NumClasses * TrialsPerClass;
+
+	// data is numChannels x numSamples x numTrials (column-major)
+	std::vector<double> data((size_t) NumChannels * NumSamples * NumTrials);
+	std::vector<int> labels(NumTrials);
+	std::vector<int> folds(NumTrials);
+	srand(3);
+	for (int trialIndex = 0; trialIndex < NumTrials; trialIndex++)
+	{
+		labels[trialIndex] = trialIndex % NumClasses;
+		folds[trialIndex] = trialIndex % NumFolds;
+		double phase = 6.28 * rand() / RAND_MAX;
+		for (int n = 0; n < NumSamples; n++)
+			for (int c = 0; c < NumChannels; c++)
+			{
+				double noise = 40.0 * ((double) rand() / RAND_MAX - 0.5);
+				double ssvep = 3.0 * sin(2 * 3.14159265358979 * stimFrequencies[labels[trialIndex]] * n / SampleRate + phase + c);
+				data[c + NumChannels * (n + (size_t) NumSamples * trialIndex)] = ssvep + noise;
+			}
+	}
+
+	std::vector<int> trialLengths;
+	for (int i = 1; i <= 6; i++)
+		trialLengths.push_back(i * SampleRate / 2);
+
+	std::vector<double> prior(NumClasses, 1.0 / NumClasses);
+
+	ClassifierTrainer serialTrainer(SampleRate, stimFrequencies, 2, prior, 1);
+	serialTrainer.SetData(&data[0], NumChannels, NumSamples, NumTrials, &labels[0]);
+	serialTrainer.Run(trialLengths, &folds[0], NumFolds);
+
+	ClassifierTrainer parallelTrainer(SampleRate, stimFrequencies, 2, prior, 0);
+	parallelTrainer.SetData(&data[0], NumChannels, NumSamples, NumTrials, &labels[0]);
+	parallelTrainer.Run(trialLengths, &folds[0], NumFolds);
+
+	std::cout << "1 thread:   features " << serialTrainer.FeatureSeconds() << " s, folds " << serialTrainer.FoldSeconds() << " s\n";
+	std::cout << parallelTrainer.NumThreads() << " threads: features " << parallelTrainer.FeatureSeconds() << " s, folds " << parallelTrainer.FoldSeconds() << " s\n";
+
+	bool success = (serialTrainer.Posterior() == parallelTrainer.Posterior());
+	for (size_t lengthIndex = 0; lengthIndex < trialLengths.size(); lengthIndex++)
+	{
+		double accuracy = 0;
+		for (int fold = 0; fold < NumFolds; fold++)
+			accuracy += parallelTrainer.Accuracy()[lengthIndex + trialLengths.size() * fold] / NumFolds;
+		std::cout << "trial length " << (double) trialLengths[lengthIndex] / SampleRate << " s   accuracy " << accuracy << "\n";
+
+		if (lengthIndex == trialLengths.size() - 1)
+			success = success && (accuracy > 2.0 / NumClasses);
+	}
+
+	std::cout << (success ? "Classifier trainer test passed" : "Classifier trainer test FAILED") << "\n";
+	return success ? 0 : 1;
+}
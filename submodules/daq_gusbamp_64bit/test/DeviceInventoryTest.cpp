@@ -0,0 +1,79 @@
+#include "DAQgUSBamp.h"
+#include <Windows.h>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <deque>
+#include <vector>
+
+using namespace std;
+
+// Opens the devices of a group with std::cout captured. Returns what was printed
+static std::string CapturedOpen(DAQgUSBamp &daq, bool *opened)
+{
+	std::ostringstream output;
+	std::streambuf *previous = std::cout.rdbuf(output.rdbuf());
+	*opened = daq.OpenAndInitDevice();
+	std::cout.rdbuf(previous);
+	return output.str();
+}
+
+static bool Contains(const std::string &output, const char *text)
+{
+	return output.find(text) != std::string::npos;
+}
+
+// Opens a simulated amplifier without serials. The first open scans the USB ports and fills the inventory, the
+// second one opens from the inventory without a scan. For a group with a single amplifier (UB-SIM.00.01, held by
+// another group) that inventory of three is stale: the open rescans, finds no free device and keeps the new inventory,
+// which the next open uses once the amplifier is free
+int main()
+{
+	int SampleRate = 256;
+	int TRIGGER = 1;
+	int ComR[4] = {1, 1, 1, 1};
+	int ComG[4] = {1, 1, 1, 1};
+	bool success = true;
+	bool opened;
+
+	std::vector<UCHAR> ChToAcq;
+	for (int i = 1; i <= 16; i++)
+		ChToAcq.push_back(i);
+	std::vector<UCHAR> bipolarSettings(16, 0);
+
+	// choosing a driver clears the inventory, so the groups with a single amplifier choose theirs first
+	DAQgUSBamp holder(ChToAcq, SampleRate, TRIGGER, 0, 0, 0, ComR, ComG, bipolarSettings);
+	DAQgUSBamp single(ChToAcq, SampleRate, TRIGGER, 0, 0, 0, ComR, ComG, bipolarSettings);
+	DAQgUSBamp daq(ChToAcq, SampleRate, TRIGGER, 0, 0, 0, ComR, ComG, bipolarSettings);
+	holder.UseSimulatedDevice(1, 0, 0, 0);
+	single.UseSimulatedDevice(1, 0, 0, 0);
+	daq.UseSimulatedDevice(3, 0, 0, 0);
+
+	// first open scans, the second one doesn't
+	std::string output = CapturedOpen(daq, &opened);
+	success = success && opened && Contains(output, "USB ports scanned") && !Contains(output, "from inventory");
+	daq.CloseDevice();
+
+	output = CapturedOpen(daq, &opened);
+	std::cout << "second open: " << (Contains(output, "USB ports scanned") ? "scanned" : "from inventory") << "\n";
+	success = success && opened && Contains(output, "3 device(s) from inventory") && !Contains(output, "USB ports scanned");
+	daq.CloseDevice();
+
+	// UB-SIM.00.01 held by another group, the next device of the inventory (UB-SIM.00.02) is not there
+	std::deque<std::string> heldSerials;
+	heldSerials.push_back("UB-SIM.00.01");
+	success = success && holder.OpenAndInitDevice(heldSerials);
+
+	output = CapturedOpen(single, &opened);
+	std::cout << "stale inventory: " << (Contains(output, "out of date") ? "rescanned" : "not rescanned") << "\n";
+	success = success && !opened && Contains(output, "out of date") && Contains(output, "USB ports scanned");
+
+	// once released, the amplifier is opened from the new inventory of one device
+	holder.CloseDevice();
+	output = CapturedOpen(single, &opened);
+	success = success && opened && Contains(output, "1 device(s) from inventory") && !Contains(output, "USB ports scanned");
+	single.CloseDevice();
+
+	std::cout << (success ? "Device inventory test passed" : "Device inventory test FAILED") << "\n";
+	return success ? 0 : 1;
+}
@@ -0,0 +1,130 @@
+#define _USE_MATH_DEFINES
+#include "EOGArtifactDetector.h"
+#include <iostream>
+#include <vector>
+#include <math.h>
+#include <algorithm>
+
+using namespace std;
+
+// Three channels with electrode offsets, noise and a slow drift (vertical EOG = channel 2 - channel 1, horizontal EOG
+// = channel 3, as plotEOG.m) and a block trigger of four 2 s trials. Trial 2 has a blink on the vertical EOG, trial 4
+// a saccade (step) on the horizontal EOG. Checks the trial flags, that blocks of any size and spans taken while
+// streaming give the same spans, that a blink is found by the template alone and that the spans flag the same trials
+// offline (FlagTrials)
+static std::vector<float> MakeSession(int sampleRate, int numScans, int scanStride)
+{
+	std::vector<float> scans((size_t) numScans * scanStride, 0.0f);
+	unsigned int seed = 12345;
+	for (int n = 0; n < numScans; n++)
+	{
+		float *scan = &scans[(size_t) n * scanStride];
+		double t = (double) n / sampleRate;
+		for (int c = 0; c < 3; c++)
+		{
+			seed = seed * 1664525u + 1013904223u;
+			scan[c] = (float) (20000.0 * (c + 1) + 20.0 * ((seed >> 8) / 16777216.0 - 0.5) + 30.0 * sin(2 * M_PI * 0.3 * t + c));
+		}
+
+		//blink of 200 uV in 300 ms, 1 s into trial 2
+		double blinkStart = 4.0;
+		if (t >= blinkStart && t < blinkStart + 0.3)
+			scan[1] += (float) (200.0 * sin(M_PI * (t - blinkStart) / 0.3));
+
+		//saccade of 150 uV, 1 s into trial 4, back 300 ms later
+		if (t >= 10.0 && t < 10.3)
+			scan[2] += 150.0f;
+
+		//trials from 1 s, 2 s long, 3 s apart
+		double trialTime = fmod(t, 3.0);
+		scan[3] = (t >= 1.0 && trialTime >= 1.0 && t < 12.0) ? 1.0f : 0.0f;
+	}
+	return scans;
+}
+
+int main()
+{
+	const int sampleRate = 256, numScans = 13 * sampleRate, scanStride = 4;
+	bool success = true;
+
+	std::vector<float> scans = MakeSession(sampleRate, numScans, scanStride);
+	std::vector<int> plus = { 1, 2 }, minus = { 0, -1 };
+	int margin = sampleRate / 10;
+
+	EOGArtifactDetector detector(sampleRate, plus, minus, 3, 100, 3000, 0.9, margin, std::vector<double>());
+
+	int numEnded = 0;
+	for (int n = 0; n < numScans; n += 8)
+		numEnded += detector.PushBlock(&scans[(size_t) n * scanStride], 8, scanStride) ? 1 : 0;
+
+	std::vector<ArtifactSpan> spans;
+	std::vector<TrialArtifacts> trials;
+	detector.GetArtifacts(spans, trials);
+
+	success = success && numEnded == 4 && trials.size() == 4;
+	for (size_t i = 0; i < trials.size(); i++)
+	{
+		std::cout << "trial " << i + 1 << ": start " << trials[i].startScan << ", length " << trials[i].length
+			<< ", artifact scans " << trials[i].artifactScans << "\n";
+		success = success && trials[i].startScan == (long long) (1 + 3 * i) * sampleRate - 1 && trials[i].length == 2 * sampleRate;
+		success = success && trials[i].contaminated == (i == 1 || i == 3);
+	}
+	for (size_t s = 0; s < spans.size(); s++)
+		std::cout << "span " << spans[s].startScan << "-" << spans[s].endScan << ", peak " << spans[s].peakUv << " uV, causes " << spans[s].causes << "\n";
+	success = success && spans.size() == 2;
+
+	// the ended trial is consumed once
+	TrialArtifacts last;
+	success = success && detector.WaitForTrialEnd(0, &last) && last.startScan == trials.back().startScan;
+	success = success && !detector.WaitForTrialEnd(10, &last);
+	success = success && !detector.GetCurrentTrial(&last);
+
+	// one block gives the same spans
+	EOGArtifactDetector whole(sampleRate, plus, minus, 3, 100, 3000, 0.9, margin, std::vector<double>());
+	whole.PushBlock(&scans[0], numScans, scanStride);
+	std::vector<ArtifactSpan> wholeSpans;
+	std::vector<TrialArtifacts> wholeTrials;
+	whole.GetArtifacts(wholeSpans, wholeTrials);
+	success = success && wholeSpans.size() == spans.size() && wholeTrials.size() == trials.size();
+	for (size_t s = 0; s < wholeSpans.size() && s < spans.size(); s++)
+		success = success && wholeSpans[s].startScan == spans[s].startScan && wholeSpans[s].endScan == spans[s].endScan;
+
+	// spans taken while streaming, as for a long recording, add up to the same spans
+	EOGArtifactDetector taken(sampleRate, plus, minus, 3, 100, 3000, 0.9, margin, std::vector<double>());
+	std::vector<ArtifactSpan> takenSpans, openSpans;
+	for (int n = 0; n < numScans; n += 100)
+	{
+		taken.PushBlock(&scans[(size_t) n * scanStride], (std::min)(100, numScans - n), scanStride);
+		taken.TakeFinishedSpans(takenSpans);
+	}
+	taken.GetArtifacts(openSpans, wholeTrials);
+	takenSpans.insert(takenSpans.end(), openSpans.begin(), openSpans.end());
+	success = success && takenSpans.size() == spans.size();
+	for (size_t s = 0; s < takenSpans.size() && s < spans.size(); s++)
+		success = success && takenSpans[s].startScan == spans[s].startScan && takenSpans[s].endScan == spans[s].endScan;
+
+	// the template alone finds the blink (threshold above the blink, no slope)
+	EOGArtifactDetector templateOnly(sampleRate, plus, minus, 3, 300, 0, 0.9, margin, std::vector<double>());
+	templateOnly.PushBlock(&scans[0], numScans, scanStride);
+	std::vector<ArtifactSpan> templateSpans;
+	std::vector<TrialArtifacts> templateTrials;
+	templateOnly.GetArtifacts(templateSpans, templateTrials);
+	success = success && !templateSpans.empty() && templateSpans[0].causes == EOGArtifactDetector::ARTIFACT_TEMPLATE;
+	success = success && templateTrials.size() == 4 && templateTrials[1].contaminated && !templateTrials[0].contaminated;
+	std::cout << "template only: " << templateSpans.size() << " spans\n";
+
+	// offline: the spans attached to the trials found in the recording
+	std::vector<long long> trialStarts;
+	std::vector<int> trialLengths, artifactScans;
+	for (size_t i = 0; i < trials.size(); i++)
+	{
+		trialStarts.push_back(trials[i].startScan);
+		trialLengths.push_back(trials[i].length);
+	}
+	EOGArtifactDetector::FlagTrials(spans, trialStarts, trialLengths, artifactScans);
+	for (size_t i = 0; i < trials.size(); i++)
+		success = success && artifactScans[i] == trials[i].artifactScans;
+
+	std::cout << (success ? "EOG artifact detector test passed" : "EOG artifact detector test FAILED") << "\n";
+	return success ? 0 : 1;
+}
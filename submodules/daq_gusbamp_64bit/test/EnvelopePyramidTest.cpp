@@ -0,0 +1,153 @@
+#include "EnvelopePyramid.h"
+#include "EnvelopeFile.h"
+#include "SessionFile.h"
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
+
+using namespace std;
+
+// Envelope of one value over the bins [firstBin, endBin) of a level, from the samples. False if none was acquired
+static bool Expected(const std::vector<float> &scans, int scanStride, long long numScans, int value, int level,
+	long long firstBin, long long endBin, float *minimum, float *maximum)
+{
+	long long first = (std::max)(firstBin * EnvelopePyramid::BinScans(level), 0LL);
+	long long end = (std::min)(endBin * EnvelopePyramid::BinScans(level), numScans);
+	*minimum = HUGE_VALF;
+	*maximum = -HUGE_VALF;
+	for (long long s = first; s < end; s++)
+	{
+		*minimum = (std::min)(*minimum, scans[(size_t) s * scanStride + value]);
+		*maximum = (std::max)(*maximum, scans[(size_t) s * scanStride + value]);
+	}
+	return first < end;
+}
+
+// Checks every pixel of a request against the samples of the bins it covers (NaN where none was acquired)
+static bool Check(const std::vector<float> &scans, int scanStride, long long numScans, const int *values, int numValues,
+	long long startScan, long long length, int width, int level, const float *minimum, const float *maximum)
+{
+	bool match = true;
+	for (int p = 0; p < width; p++)
+	{
+		long long firstBin, endBin;
+		EnvelopePyramid::PixelBins(startScan, length, width, p, level, &firstBin, &endBin);
+		for (int i = 0; i < numValues; i++)
+		{
+			float expectedMinimum, expectedMaximum;
+			bool received = Expected(scans, scanStride, numScans, values[i], level, firstBin, endBin, &expectedMinimum, &expectedMaximum);
+			float pixelMinimum = minimum[(size_t) i * width + p], pixelMaximum = maximum[(size_t) i * width + p];
+			if (received)
+				match = match && pixelMinimum == expectedMinimum && pixelMaximum == expectedMaximum;
+			else
+				match = match && pixelMinimum != pixelMinimum && pixelMaximum != pixelMaximum;
+		}
+	}
+	return match;
+}
+
+// Streams a recording of 2 channels and a trigger through the envelope pyramid in odd sized blocks while writing the
+// recording and its envelope file. Checks the live envelope of zoomed in and zoomed out ranges (including the bins
+// being filled and ranges out of the recording) against the samples, a short history, and the same requests on the
+// recording, then times a whole session request from the envelope file against one from the samples
+int main()
+{
+	const int sampleRate = 512, numChannels = 2, scanStride = numChannels + 1;
+	const long long numScans = 3 * EnvelopePyramid::BinScans(EnvelopePyramid::NUM_LEVELS - 1) + 1001;
+	bool success = true;
+
+	std::vector<float> scans((size_t) numScans * scanStride);
+	unsigned int seed = 7;
+	for (long long n = 0; n < numScans; n++)
+	{
+		seed = seed * 1664525u + 1013904223u;
+		scans[(size_t) n * scanStride] = (float) (100 * sin(n * 0.01) + (seed >> 24));
+		scans[(size_t) n * scanStride + 1] = (float) (-50 + (seed >> 16 & 0xff) + 1e-3 * n);
+		scans[(size_t) n * scanStride + 2] = (n / 1000) % 2 ? 1.0f : 0.0f;
+	}
+
+	// the recording, as DAQgUSBamp writes it
+	const char *fileName = "EnvelopePyramidTest.bin";
+	int version = 1, triggerFlag = 1;
+	unsigned char channelCount = numChannels, channelList[] = { 3, 7 };
+	FILE *file = fopen(fileName, "wb");
+	fwrite(&version, sizeof(int), 1, file);
+	fwrite(&sampleRate, sizeof(int), 1, file);
+	fwrite(&channelCount, 1, 1, file);
+	fwrite(&triggerFlag, sizeof(int), 1, file);
+	fwrite(channelList, 1, numChannels, file);
+	fwrite(&scans[0], sizeof(float), scans.size(), file);
+	fclose(file);
+
+	EnvelopePyramid pyramid(sampleRate, scanStride, numScans);
+	EnvelopePyramid shortPyramid(sampleRate, scanStride, 2000);
+	success = success && pyramid.OpenFile("EnvelopePyramidTest.bin.envelope");
+	for (long long n = 0; n < numScans; n += 37)
+	{
+		int blockScans = (int) (std::min)(37LL, numScans - n);
+		pyramid.PushBlock(&scans[(size_t) n * scanStride], blockScans, scanStride);
+		shortPyramid.PushBlock(&scans[(size_t) n * scanStride], blockScans, scanStride);
+	}
+	pyramid.CloseFile();
+	success = success && pyramid.NumScans() == numScans;
+
+	SessionFile session;
+	EnvelopeFile envelope;
+	success = success && session.Open(fileName) && envelope.Open("EnvelopePyramidTest.bin.envelope");
+	success = success && envelope.NumValues() == scanStride && envelope.NumChunks() == 4;
+
+	// start, length and width of each request: samples, zoomed in, zoomed out, the last (partial) bins, out of range
+	long long requests[][3] = { { 100, 300, 1000 }, { 5000, 2000, 700 }, { 0, numScans, 800 }, { 1234, 40000, 333 },
+		{ numScans - 5000, 5000, 64 }, { numScans - 100000, 200000, 500 }, { -3000, 10000, 100 } };
+	int values[] = { 2, 0, 1 };
+	int width = 1000;
+	std::vector<float> minimum(3 * width), maximum(3 * width);
+	for (int r = 0; r < 7; r++)
+	{
+		long long startScan = requests[r][0], length = requests[r][1];
+		int pixels = (int) requests[r][2];
+
+		int level = pyramid.GetEnvelope(values, 3, startScan, length, pixels, &minimum[0], &maximum[0]);
+		bool live = level >= 0 && Check(scans, scanStride, numScans, values, 3, startScan, length, pixels, level, &minimum[0], &maximum[0]);
+
+		int fileLevel = envelope.GetEnvelope(session, values, 3, startScan, length, pixels, &minimum[0], &maximum[0]);
+		bool recorded = fileLevel >= 0 && Check(scans, scanStride, numScans, values, 3, startScan, length, pixels, fileLevel, &minimum[0], &maximum[0]);
+
+		std::cout << length << " scans on " << pixels << " pixels: level " << level << (live ? " matches" : " DIFFERS")
+			<< ", recording level " << fileLevel << (recorded ? " matches" : " DIFFERS") << "\n";
+		success = success && live && recorded && (fileLevel == level || (fileLevel == 0 && level < EnvelopePyramid::FILE_FIRST_LEVEL));
+	}
+
+	// a short history (raised to one chunk): the start of the session is NaN, its end is kept
+	int level = shortPyramid.GetEnvelope(values, 3, 0, numScans, 100, &minimum[0], &maximum[0]);
+	success = success && minimum[0] != minimum[0] && maximum[200] != maximum[200];
+	success = success && Check(scans, scanStride, numScans, values, 1, 99 * numScans / 100, numScans - 99 * numScans / 100, 1, level, &minimum[99], &maximum[99]);
+	success = success && shortPyramid.GetEnvelope(values, 3, 0, 10, 0, &minimum[0], &maximum[0]) == -1;
+	int badValue = scanStride;
+	success = success && shortPyramid.GetEnvelope(&badValue, 1, 0, 10, 10, &minimum[0], &maximum[0]) == -1;
+
+	// whole session on 1000 pixels, from the envelope file and from the samples
+	const int repetitions = 20;
+	auto start = std::chrono::steady_clock::now();
+	for (int r = 0; r < repetitions; r++)
+		envelope.GetEnvelope(session, values, 3, 0, numScans, width, &minimum[0], &maximum[0]);
+	double fileMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / repetitions;
+
+	EnvelopeFile samplesOnly;
+	start = std::chrono::steady_clock::now();
+	for (int r = 0; r < repetitions; r++)
+		samplesOnly.GetEnvelope(session, values, 3, 0, numScans, width, &minimum[0], &maximum[0]);
+	double samplesMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / repetitions;
+	std::cout << numScans << " scans on " << width << " pixels: envelope file " << fileMs << " ms, samples " << samplesMs << " ms\n";
+
+	envelope.Close();
+	session.Close();
+	remove(fileName);
+	remove("EnvelopePyramidTest.bin.envelope");
+
+	std::cout << (success ? "Envelope pyramid test passed" : "Envelope pyramid test FAILED") << "\n";
+	return success ? 0 : 1;
+}
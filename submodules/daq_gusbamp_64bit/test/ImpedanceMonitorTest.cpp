@@ -0,0 +1,93 @@
+#include "DAQgUSBamp.h"
+#include "SimulatedAmpDriver.h"
+#include <Windows.h>
+#include <iostream>
+#include <string>
+#include <deque>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <cmath>
+
+using namespace std;
+
+// Impedance the simulated driver gives a channel (1 to 16) of a device, within its 2% measurement noise
+static double SimulatedKOhm(const std::string &serial, int channel)
+{
+	unsigned int hash = (unsigned int) std::hash<std::string>()(serial) ^ (channel * 2654435761u);
+	return (channel == 16) ? 1000.0 : 2.0 + (hash % 2800) / 100.0;
+}
+
+// Measures the impedances of three simulated amplifiers (48 channels). Every entry of the table must be the
+// impedance of its channel, the channels of the first serial coming first and the unconnected channel 16 of each
+// device reading 1000 kOhm, and the one shot measurement must take about one device's time (16 channels) rather than
+// all devices' in series. The monitor must keep completing sweeps until StartAcquisition stops it
+int main()
+{
+	int SampleRate = 256;
+	int TRIGGER = 1;
+	int ComR[4] = {1, 1, 1, 1};
+	int ComG[4] = {1, 1, 1, 1};
+	bool success = true;
+
+	std::vector<UCHAR> ChToAcq;
+	for (int i = 1; i <= 48; i++)
+		ChToAcq.push_back(i);
+	std::vector<UCHAR> bipolarSettings(48, 0);
+
+	std::deque<std::string> serials;
+	serials.push_back("UB-SIM.00.01");
+	serials.push_back("UB-SIM.00.02");
+	serials.push_back("UB-SIM.00.03");
+
+	DAQgUSBamp daq(ChToAcq, SampleRate, TRIGGER, 0, 0, 0, ComR, ComG, bipolarSettings);
+	daq.UseSimulatedDevice(3, 0, 0, 0);
+
+	std::vector<double> impedances(ChToAcq.size());
+
+	// nothing can be measured before the devices are open
+	success = success && !daq.MeasureImpedance(&impedances[0]) && daq.GetImpedances(&impedances[0]) == -1;
+
+	if (!daq.OpenAndInitDevice(serials))
+	{
+		std::cout << "Impedance monitor test FAILED" << "\n";
+		return 1;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	success = success && daq.MeasureImpedance(&impedances[0]);
+	double measureMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	double serialMs = (double) ChToAcq.size() * SimulatedAmpDriver::IMPEDANCE_MS;
+	std::cout << "one shot measurement of " << ChToAcq.size() << " channels in " << measureMs << " ms, " << serialMs << " ms in series\n";
+	success = success && measureMs < serialMs / 2;
+
+	for (size_t i = 0; i < ChToAcq.size(); i++)
+	{
+		double expected = SimulatedKOhm(serials[i / 16], (int) (i % 16) + 1);
+		if (fabs(impedances[i] - expected) > 0.021 * expected)
+		{
+			std::cout << "channel " << i << ": " << impedances[i] << " kOhm instead of " << expected << " kOhm\n";
+			success = false;
+		}
+	}
+
+	// a second monitor cannot start while one is running
+	success = success && daq.StartImpedanceMonitor() && !daq.StartImpedanceMonitor();
+	std::this_thread::sleep_for(std::chrono::milliseconds(500));
+	int firstSweeps = daq.GetImpedances(&impedances[0]);
+	std::this_thread::sleep_for(std::chrono::milliseconds(500));
+	int secondSweeps = daq.GetImpedances(&impedances[0]);
+	std::cout << "monitor sweeps " << firstSweeps << " then " << secondSweeps << "\n";
+	success = success && firstSweeps >= 1 && secondSweeps > firstSweeps;
+
+	// acquisition stops the monitor, no sweep is completed afterwards and impedances cannot be measured
+	daq.StartAcquisition();
+	int acquiringSweeps = daq.GetImpedances(&impedances[0]);
+	std::this_thread::sleep_for(std::chrono::milliseconds(500));
+	success = success && daq.GetImpedances(&impedances[0]) == acquiringSweeps && !daq.MeasureImpedance(&impedances[0]);
+	daq.StopAcquisition();
+	daq.CloseDevice();
+
+	std::cout << (success ? "Impedance monitor test passed" : "Impedance monitor test FAILED") << "\n";
+	return success ? 0 : 1;
+}
@@ -0,0 +1,91 @@
+#include "IncrementalTrialClassifier.h"
+#include "SSVEPFeatureEngine.h"
+#include <iostream>
+#include <vector>
+#include <stdlib.h>
+#include <math.h>
+
+using namespace std;
+
+// Streams a 4 second block trial with a 12 Hz SSVEP and checks that it is decided early and correctly, with the
+// posteriors the canonical correlations of the whole trial so far give
+int main()
+{
+	int SampleRate = 256;
+	int NumChannels = 3;
+	int ScanStride = NumChannels + 1;
+	int NumScans = SampleRate / 32;
+	int TrialLength = 4 * SampleRate;
+	double TargetFrequency = 12.0;
+
+	double freqArray[] = {8.0, 10.0, 12.0, 15.0};
+	std::vector<double> stimFrequencies(freqArray, freqArray + 4);
+	std::vector<double> prior(4, 0.25);
+	std::vector<int> channelIndices;
+	for (int c = 0; c < NumChannels; c++)
+		channelIndices.push_back(c);
+
+	IncrementalTrialClassifier classifier(SampleRate, channelIndices, NumChannels, stimFrequencies, 2, prior, 0.99, SampleRate / 2, 0.05);
+
+	std::vector<float> block(NumScans * ScanStride);
+	std::vector< std::vector<double> > trialData(NumChannels);
+	srand(2);
+	long sampleIndex = 0;
+	for (int blockIndex = 0; blockIndex < (TrialLength + SampleRate) / NumScans; blockIndex++)
+	{
+		for (int scanIndex = 0; scanIndex < NumScans; scanIndex++, sampleIndex++)
+		{
+			// half a second of rest, then the trial
+			bool inTrial = (sampleIndex >= SampleRate / 2) && (sampleIndex < SampleRate / 2 + TrialLength);
+			for (int c = 0; c < NumChannels; c++)
+			{
+				double noise = 40.0 * ((double) rand() / RAND_MAX - 0.5);
+				double ssvep = inTrial ? 4.0 * sin(2 * 3.14159265358979 * TargetFrequency * sampleIndex / SampleRate + c) : 0;
+				block[scanIndex * ScanStride + c] = (float) (ssvep + noise);
+			}
+			block[scanIndex * ScanStride + NumChannels] = inTrial ? 1.0f : 0.0f;
+
+			// kept to score the trial in one go
+			if (inTrial)
+				for (int c = 0; c < NumChannels; c++)
+					trialData[c].push_back(block[scanIndex * ScanStride + c]);
+		}
+
+		classifier.PushBlock(&block[0], NumScans, ScanStride);
+	}
+
+	std::vector<double> aPosteriori(classifier.NumClasses());
+	int classIndex = -1;
+	int numTrialSamples = 0;
+	bool decided = classifier.WaitForDecision(0, &aPosteriori[0], &classIndex, &numTrialSamples);
+
+	std::cout << "decided after " << numTrialSamples << " of " << TrialLength << " samples\n";
+	for (int i = 0; i < classifier.NumClasses(); i++)
+		std::cout << stimFrequencies[i] << " Hz   p: " << aPosteriori[i] << "\n";
+
+	bool success = decided && classIndex >= 0 && stimFrequencies[classIndex] == TargetFrequency && numTrialSamples < TrialLength;
+
+	// the same posteriors from the first numTrialSamples samples, centered and correlated at once
+	std::vector<double> window(NumChannels * numTrialSamples);
+	for (int c = 0; c < NumChannels && numTrialSamples > 0; c++)
+	{
+		double mean = 0;
+		for (int n = 0; n < numTrialSamples; n++)
+			mean += trialData[c][n] / numTrialSamples;
+		for (int n = 0; n < numTrialSamples; n++)
+			window[c * numTrialSamples + n] = trialData[c][n] - mean;
+	}
+	std::vector<double> expected(classifier.NumClasses());
+	double total = 0;
+	for (int i = 0; i < classifier.NumClasses() && numTrialSamples > 0; i++)
+	{
+		CCAReference reference(stimFrequencies[i], SampleRate, 2, numTrialSamples);
+		double rho = reference.Correlate(&window[0], NumChannels);
+		expected[i] = prior[i] * exp(numTrialSamples * 0.05 * 0.5 * log((1 + rho) / (1 - rho)));
+		total += expected[i];
+	}
+	for (int i = 0; i < classifier.NumClasses(); i++)
+		success = success && fabs(expected[i] / total - aPosteriori[i]) < 1e-6;
+	std::cout << (success ? "Incremental classifier test passed" : "Incremental classifier test FAILED") << "\n";
+	return success ? 0 : 1;
+}
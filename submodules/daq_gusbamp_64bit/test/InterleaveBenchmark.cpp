@@ -0,0 +1,76 @@
+#include "ScanInterleaver.h"
+#include <iostream>
+#include <vector>
+#include <chrono>
+
+using namespace std;
+
+// Times the merge of the device blocks with the specialized kernel and the generic one, for 1 to 4 amplifiers of 8
+// and 16 channels with the trigger and a mixed 16 + 8 channel configuration (generic only), on blocks of 4 scans
+// (low latency preset at 512 Hz), 8 scans (low latency at 1200 Hz) and 512 scans (high throughput)
+int main()
+{
+	struct Configuration
+	{
+		const char *name;
+		int numDevices;
+		int channels[ScanInterleaver::MAX_DEVICES];
+	};
+	Configuration configurations[] = {
+		{ "1 x 8", 1, { 8 } },
+		{ "1 x 16", 1, { 16 } },
+		{ "2 x 16", 2, { 16, 16 } },
+		{ "4 x 8", 4, { 8, 8, 8, 8 } },
+		{ "4 x 16", 4, { 16, 16, 16, 16 } },
+		{ "16 + 8", 2, { 16, 8 } }
+	};
+	int blockSizes[3] = { 4, 8, 512 };
+	const long long scansPerRun = 4000000;
+
+	std::cout << "config     block   generic ns/scan   kernel ns/scan   speedup\n";
+	for (size_t c = 0; c < sizeof(configurations) / sizeof(configurations[0]); c++)
+	{
+		const Configuration &configuration = configurations[c];
+		ScanInterleaver interleaver;
+		interleaver.Configure(configuration.numDevices, configuration.channels, true);
+
+		for (int b = 0; b < 3; b++)
+		{
+			int blockScans = blockSizes[b];
+			std::vector<std::vector<float> > blocks(configuration.numDevices);
+			std::vector<const float *> devices(configuration.numDevices);
+			for (int device = 0; device < configuration.numDevices; device++)
+			{
+				blocks[device].assign((size_t) blockScans * (configuration.channels[device] + 1), (float) device);
+				devices[device] = &blocks[device][0];
+			}
+			std::vector<float> scans((size_t) blockScans * interleaver.ScanStride());
+			long long numBlocks = scansPerRun / blockScans;
+
+			double times[2];
+			for (int generic = 1; generic >= 0; generic--)
+			{
+				auto start = std::chrono::steady_clock::now();
+				for (long long block = 0; block < numBlocks; block++)
+				{
+					if (generic)
+						interleaver.InterleaveGeneric(&devices[0], blockScans, &scans[0]);
+					else
+						interleaver.Interleave(&devices[0], blockScans, &scans[0]);
+
+					//keep the compiler from dropping the merges
+					blocks[0][0] = scans[(size_t) (block % blockScans) * interleaver.ScanStride()];
+				}
+				times[generic] = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / (numBlocks * blockScans);
+			}
+
+			std::cout << configuration.name << "\t   " << blockScans << "\t   " << times[1] << "\t     ";
+			if (interleaver.Specialized())
+				std::cout << times[0] << "\t      " << times[1] / times[0] << "x\n";
+			else
+				std::cout << "(generic)\n";
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,94 @@
+#include "DAQgUSBamp.h"
+#include <Windows.h>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <deque>
+#include <vector>
+#include <cmath>
+
+using namespace std;
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Starts acquisition with std::cout captured, reads one second and stops. Returns what the start printed and sets
+// valid if the first channel holds the 10 uV sine at 8 Hz of the simulated driver
+static std::string CapturedCycle(DAQgUSBamp &daq, int sampleRate, int numColumns, bool *valid)
+{
+	std::ostringstream output;
+	std::streambuf *previous = std::cout.rdbuf(output.rdbuf());
+	daq.StartAcquisition();
+	std::cout.rdbuf(previous);
+
+	std::vector<float> data((size_t) sampleRate * numColumns);
+	daq.GetData(&data[0], sampleRate);
+	daq.StopAcquisition();
+
+	double sinSum = 0, cosSum = 0;
+	for (int i = 0; i < sampleRate; i++)
+	{
+		sinSum += data[i * numColumns] * sin(2 * M_PI * 8 * i / sampleRate);
+		cosSum += data[i * numColumns] * cos(2 * M_PI * 8 * i / sampleRate);
+	}
+	*valid = fabs(2 * sqrt(sinSum * sinSum + cosSum * cosSum) / sampleRate - 10) < 1;
+	return output.str();
+}
+
+static bool Contains(const std::string &output, const char *text)
+{
+	return output.find(text) != std::string::npos;
+}
+
+// Starts and stops two simulated amplifiers twice: the first start allocates the transfer queues and the application
+// buffer, the second one reuses them. A storage change while open allocates the application buffer again, as does
+// reopening with another block size, and the next start reuses it. Every run must acquire the sines of the simulated
+// driver
+int main()
+{
+	int SampleRate = 256;
+	int TRIGGER = 1;
+	int ComR[4] = {1, 1, 1, 1};
+	int ComG[4] = {1, 1, 1, 1};
+	bool success = true;
+	bool valid;
+
+	std::vector<UCHAR> ChToAcq;
+	for (int i = 1; i <= 32; i++)
+		ChToAcq.push_back(i);
+	std::vector<UCHAR> bipolarSettings(32, 0);
+	int numColumns = (int) ChToAcq.size() + TRIGGER;
+
+	std::deque<std::string> serials;
+	serials.push_back("UB-SIM.00.01");
+	serials.push_back("UB-SIM.00.02");
+
+	DAQgUSBamp daq(ChToAcq, SampleRate, TRIGGER, 0, 0, 0, ComR, ComG, bipolarSettings);
+	daq.UseSimulatedDevice(2, 0.5, 0, 0);
+
+	int blockScans[2] = {8, 32};
+	SampleStorage storages[2] = {STORAGE_HALF, STORAGE_FLOAT32};
+	for (int run = 0; run < 2; run++)
+	{
+		success = success && daq.SetBlockPolicy(BlockPolicy(blockScans[run], 4, 1)) && daq.OpenAndInitDevice(serials);
+
+		std::string output = CapturedCycle(daq, SampleRate, numColumns, &valid);
+		success = success && valid && Contains(output, "(buffers allocated)");
+
+		output = CapturedCycle(daq, SampleRate, numColumns, &valid);
+		std::cout << "blocks of " << blockScans[run] << " scans, second start: " << (Contains(output, "(buffers reused)") ? "reused" : "allocated") << "\n";
+		success = success && valid && Contains(output, "(buffers reused)");
+
+		success = success && daq.SetSampleStorage(storages[run], std::vector<float>());
+		output = CapturedCycle(daq, SampleRate, numColumns, &valid);
+		success = success && valid && Contains(output, "(buffers allocated)");
+		output = CapturedCycle(daq, SampleRate, numColumns, &valid);
+		success = success && valid && Contains(output, "(buffers reused)");
+
+		daq.CloseDevice();
+	}
+
+	std::cout << (success ? "Queue reuse test passed" : "Queue reuse test FAILED") << "\n";
+	return success ? 0 : 1;
+}
@@ -0,0 +1,104 @@
+#include "ReadNotifier.h"
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <chrono>
+
+using namespace std;
+
+// A writer publishes blocks of 4 scans (2 channels and trigger) every millisecond, the trigger turning to 3 at scan
+// 1000. A reader waiting for 64 samples at a time must be woken about once per wait rather than once per block, must
+// find the trigger onset at the right position, and waits must fail on timeout and when the notifier is closed. With
+// a wake-up every 8 blocks, a reader waiting for every block is woken every 8 blocks and still finds the trigger onset
+int main()
+{
+	const int numScans = 4, scanStride = 3, triggerIndex = 2, numBlocks = 500;
+	bool success = true;
+
+	ReadNotifier notifier;
+
+	// nothing is written: a short wait times out
+	success = success && !notifier.WaitForSamples(1, 5) && notifier.WaitForTrigger(ReadNotifier::ANY_TRIGGER, 5) == -1;
+
+	std::thread writer([&]()
+	{
+		std::vector<float> block(numScans * scanStride);
+		for (int b = 0; b < numBlocks; b++)
+		{
+			for (int i = 0; i < numScans; i++)
+			{
+				block[i * scanStride] = (float) (b * numScans + i);
+				block[i * scanStride + 1] = 0;
+				block[i * scanStride + triggerIndex] = (b * numScans + i >= 1000) ? 3.0f : 0.0f;
+			}
+			notifier.Publish(&block[0], numScans, scanStride, triggerIndex);
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	});
+
+	// read 64 samples at a time up to the trigger wait
+	long long startWakeups = notifier.NumWakeups();
+	int numWaits = 0;
+	for (int k = 0; k < 10; k++)
+	{
+		success = success && notifier.WaitForSamples(64, 5000);
+		numWaits++;
+		notifier.Consume(64);
+	}
+	long long wakeups = notifier.NumWakeups() - startWakeups;
+	std::cout << numWaits << " waits over " << 640 / numScans << " blocks: " << wakeups << " wake-ups\n";
+	success = success && wakeups <= numWaits + 2;
+
+	// trigger onset at scan 1000, 640 samples have been read
+	long long position = notifier.WaitForTrigger(3, 5000);
+	std::cout << "trigger found " << position << " samples after the read position\n";
+	success = success && position == 1000 - 640;
+
+	writer.join();
+	success = success && notifier.AvailableSamples() == numBlocks * numScans - 640;
+
+	// a reader waiting for more than will ever be written is released by Close
+	std::thread closer([&]()
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		notifier.Close();
+	});
+	success = success && !notifier.WaitForSamples(100000, -1);
+	closer.join();
+
+	// after Reset everything starts from zero
+	notifier.Reset();
+	success = success && notifier.AvailableSamples() == 0;
+
+	// a wake-up every 8 blocks: a reader waiting for one block at a time takes 8 at each wake-up
+	const int wakeBlocks = 8, pacedBlocks = 160;
+	notifier.SetWakeBlocks(wakeBlocks);
+	std::thread pacedWriter([&]()
+	{
+		std::vector<float> block(numScans * scanStride, 0.0f);
+		for (int b = 0; b < pacedBlocks; b++)
+		{
+			for (int i = 0; i < numScans; i++)
+				block[i * scanStride + triggerIndex] = (b * numScans + i >= 300) ? 5.0f : 0.0f;
+			notifier.Publish(&block[0], numScans, scanStride, triggerIndex);
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	});
+
+	int pacedWaits = 0;
+	long long numRead = 0;
+	while (numRead < 256 && notifier.WaitForSamples(numScans, 5000))
+	{
+		long long available = notifier.AvailableSamples();
+		notifier.Consume(available);
+		numRead += available;
+		pacedWaits++;
+	}
+	std::cout << pacedWaits << " waits for " << numRead / numScans << " blocks with a wake-up every " << wakeBlocks << " blocks\n";
+	success = success && pacedWaits <= 256 / (wakeBlocks * numScans) + 1;
+	success = success && notifier.WaitForTrigger(5, 5000) == 300 - numRead;
+	pacedWriter.join();
+
+	std::cout << (success ? "Read notifier test passed" : "Read notifier test FAILED") << "\n";
+	return success ? 0 : 1;
+}
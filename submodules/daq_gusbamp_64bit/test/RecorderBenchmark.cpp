@@ -0,0 +1,108 @@
+#include "SessionRecorder.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace std;
+
+// Seconds since a time point
+static double Elapsed(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Records numMB MB of 64 channels and the trigger in blocks of 8 scans (low latency preset at 1200 Hz) as fast as
+// possible, written one block per unbuffered call (as recordings were written before the recorder) and with the
+// recorder under each durability policy, then 5 s paced as an acquisition at 4800 Hz with each policy. Reports the
+// throughput, the time the acquisition thread spends appending a block and the cost of the writes and syncs on the
+// writer thread. Usage: RecorderBenchmark [directory] [MB]
+int main(int argc, char *argv[])
+{
+	std::string directory = (argc > 1) ? std::string(argv[1]) + "/" : "";
+	int numMB = (argc > 2) ? atoi(argv[2]) : 64;
+	const int scanStride = 65, blockScans = 8;
+	std::string fileName = directory + "RecorderBenchmark.bin";
+
+	std::vector<float> block(blockScans * scanStride, 1.0f);
+	size_t blockBytes = block.size() * sizeof(float);
+	long long numBlocks = ((long long) numMB << 20) / blockBytes;
+	char header[16] = {0};
+
+	// per block writes
+	FILE *file = fopen(fileName.c_str(), "wb");
+	if (file == NULL)
+	{
+		std::cout << "Can't create " << fileName << "\n";
+		return 1;
+	}
+	setvbuf(file, NULL, _IONBF, 0);
+	fwrite(header, 1, sizeof(header), file);
+	double maxAppend = 0;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (long long b = 0; b < numBlocks; b++)
+	{
+		std::chrono::steady_clock::time_point appendStart = std::chrono::steady_clock::now();
+		fwrite(&block[0], 1, blockBytes, file);
+		maxAppend = (std::max)(maxAppend, Elapsed(appendStart));
+	}
+	fclose(file);
+	double seconds = Elapsed(start);
+	std::cout << "per block writes: " << numMB / seconds << " MB/s, append mean " << seconds / numBlocks * 1e6
+		<< " us, max " << maxAppend * 1e6 << " us\n";
+	remove(fileName.c_str());
+
+	// as fast as possible, then paced as an acquisition at 4800 Hz for 5 s
+	DurabilityMode modes[3] = { DURABILITY_NONE, DURABILITY_PERIODIC, DURABILITY_CHUNK };
+	const char *modeNames[3] = { "no sync", "sync every second", "sync every chunk" };
+	long long pacedBlocks = 5 * 4800 / blockScans;
+	for (int paced = 0; paced <= 1; paced++)
+	{
+		for (int m = 0; m < 3; m++)
+		{
+			SessionRecorder recorder;
+			if (!recorder.Open(fileName.c_str(), header, sizeof(header), DurabilityPolicy(modes[m], 1)))
+			{
+				std::cout << "Can't create " << fileName << "\n";
+				return 1;
+			}
+
+			long long runBlocks = paced ? pacedBlocks : numBlocks;
+			maxAppend = 0;
+			double totalAppend = 0;
+			start = std::chrono::steady_clock::now();
+			for (long long b = 0; b < runBlocks; b++)
+			{
+				if (paced)
+					std::this_thread::sleep_until(start + std::chrono::microseconds(b * blockScans * 1000000LL / 4800));
+
+				std::chrono::steady_clock::time_point appendStart = std::chrono::steady_clock::now();
+				recorder.Append(&block[0], block.size());
+				double append = Elapsed(appendStart);
+				totalAppend += append;
+				maxAppend = (std::max)(maxAppend, append);
+			}
+			bool closed = recorder.Close();
+			seconds = Elapsed(start);
+
+			RecorderStats stats;
+			recorder.GetStats(&stats);
+			std::cout << "recorder, " << modeNames[m];
+			if (paced)
+				std::cout << ", paced at 4800 Hz: ";
+			else
+				std::cout << ": " << numMB / seconds << " MB/s, ";
+			std::cout << "append mean " << totalAppend / runBlocks * 1e6 << " us, max " << maxAppend * 1e6 << " us; "
+				<< stats.numChunks << " chunks (write mean " << stats.meanWriteMs << " ms, max " << stats.maxWriteMs << " ms), "
+				<< stats.numExtents << " extents, " << stats.numSyncs << " syncs (mean " << stats.meanSyncMs << " ms, max "
+				<< stats.maxSyncMs << " ms), up to " << stats.maxQueuedChunks << " chunks queued" << (closed ? "" : ", FAILED") << "\n";
+			remove(fileName.c_str());
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,99 @@
+#include "DAQgUSBamp.h"
+#include "SessionFile.h"
+#include <Windows.h>
+#include <iostream>
+#include <vector>
+#include <algorithm>
+
+using namespace std;
+
+// Seconds on the performance counter
+double Now()
+{
+	LARGE_INTEGER counter, frequency;
+	QueryPerformanceCounter(&counter);
+	QueryPerformanceFrequency(&frequency);
+	return (double) counter.QuadPart / frequency.QuadPart;
+}
+
+// Replays a recording (loadSessionDataTestFile.bin by default, or the first argument) through DAQgUSBamp in real
+// time, 4x and as fast as possible with the low latency block policy. For each block trial of the recording, the time
+// from the moment its last sample would have been acquired to the moment GetData returns it is the latency GetTrial
+// sees with that EEG. The same data is replayed on every run, so the numbers can be compared between builds
+int main(int argc, char *argv[])
+{
+	const char *fileName = (argc > 1) ? argv[1] : "loadSessionDataTestFile.bin";
+	int ComR[4] = {1, 1, 1, 1};
+	int ComG[4] = {1, 1, 1, 1};
+
+	SessionFile session;
+	if (!session.Open(fileName))
+	{
+		std::cout << "Could not open " << fileName << "\n";
+		return 1;
+	}
+
+	std::vector<UCHAR> ChToAcq(session.ChannelList().begin(), session.ChannelList().end());
+	std::vector<UCHAR> bipolarSettings(*std::max_element(ChToAcq.begin(), ChToAcq.end()), 0);
+	int SampleRate = session.SampleRate();
+	int TRIGGER = session.TriggerFlag();
+	int scanSize = ChToAcq.size() + TRIGGER;
+
+	std::vector<long long> trialStarts;
+	std::vector<int> trialLengths;
+	int numTrials = TRIGGER ? session.FindTrials(trialStarts, trialLengths, 0) : 0;
+	session.Close();
+
+	const char *names[] = {"real time", "4x", "as fast as possible"};
+	double speeds[] = {1, 4, 0};
+
+	for (int run = 0; run < 3; run++)
+	{
+		DAQgUSBamp daq(ChToAcq, SampleRate, TRIGGER, 0, 0, 0, ComR, ComG, bipolarSettings, BlockPolicy::LowLatency(SampleRate));
+		if (!daq.UseReplayDevice(fileName, speeds[run], false) || !daq.OpenAndInitDevice())
+			continue;
+
+		int blockScans = daq.BlockScans();
+		std::vector<float> data(blockScans * scanSize);
+		std::vector<double> latencies;
+		long long readScans = 0;
+		int trial = 0;
+
+		daq.StartAcquisition();
+		double startTime = Now();
+
+		//read block by block until the replay ends, timing each trial end
+		while (daq.WaitForSamples(blockScans, 2000))
+		{
+			daq.GetData(&data[0], blockScans);
+			readScans += blockScans;
+			double readTime = Now();
+
+			for (; trial < numTrials && trialStarts[trial] + trialLengths[trial] <= readScans; trial++)
+			{
+				long long endScan = trialStarts[trial] + trialLengths[trial];
+				if (speeds[run] > 0)
+					latencies.push_back(readTime - startTime - endScan / (SampleRate * speeds[run]));
+			}
+		}
+		double duration = Now() - startTime;
+
+		daq.StopAcquisition();
+		daq.CloseDevice();
+
+		std::cout << names[run] << ": " << readScans << " scans in " << duration << " s (" << readScans / (SampleRate * duration)
+			<< "x real time)";
+		if (!latencies.empty())
+		{
+			std::sort(latencies.begin(), latencies.end());
+			double meanLatency = 0;
+			for (size_t i = 0; i < latencies.size(); i++)
+				meanLatency += latencies[i] / latencies.size();
+			std::cout << ", " << latencies.size() << " trials: trial end to data latency mean " << meanLatency * 1000
+				<< " ms, max " << latencies.back() * 1000 << " ms";
+		}
+		std::cout << "\n";
+	}
+
+	return 0;
+}
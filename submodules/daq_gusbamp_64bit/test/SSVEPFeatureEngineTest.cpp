@@ -0,0 +1,66 @@
+#include "SSVEPFeatureEngine.h"
+#include <iostream>
+#include <vector>
+#include <stdlib.h>
+#include <math.h>
+
+using namespace std;
+
+// Feeds a synthetic 10 Hz SSVEP (3 channels + trigger) in 8 scan blocks and prints the scores for 4 classes. A class at
+// Nyquist has no template and scores 0
+int main()
+{
+	int SampleRate = 256;
+	int NumChannels = 3;
+	int ScanStride = NumChannels + 1;
+	int NumScans = 8;
+	double TargetFrequency = 10.0;
+
+	double freqArray[] = {8.0, 10.0, 12.0, 15.0};
+	std::vector<double> stimFrequencies(freqArray, freqArray + 4);
+	std::vector<int> channelIndices;
+	for (int c = 0; c < NumChannels; c++)
+		channelIndices.push_back(c);
+
+	SSVEPFeatureEngine engine(SampleRate, channelIndices, stimFrequencies, 2, 2 * SampleRate, SampleRate / 4);
+
+	std::vector<float> block(NumScans * ScanStride);
+	srand(1);
+	long sampleIndex = 0;
+	for (int blockIndex = 0; blockIndex < 3 * SampleRate / NumScans; blockIndex++)
+	{
+		for (int scanIndex = 0; scanIndex < NumScans; scanIndex++, sampleIndex++)
+		{
+			for (int c = 0; c < NumChannels; c++)
+			{
+				double noise = 20.0 * ((double) rand() / RAND_MAX - 0.5);
+				block[scanIndex * ScanStride + c] = (float) (5.0 * (c + 1) * sin(2 * 3.14159265358979 * TargetFrequency * sampleIndex / SampleRate + c) + noise);
+			}
+			block[scanIndex * ScanStride + NumChannels] = 1.0f;
+		}
+		engine.PushBlock(&block[0], NumScans, ScanStride);
+	}
+
+	std::vector<double> bandPower(engine.NumClasses());
+	std::vector<double> cca(engine.NumClasses());
+	int updateCount = engine.GetScores(&bandPower[0], &cca[0]);
+
+	int best = 0;
+	std::cout << "updates: " << updateCount << "\n";
+	for (int classIndex = 0; classIndex < engine.NumClasses(); classIndex++)
+	{
+		std::cout << stimFrequencies[classIndex] << " Hz   power: " << bandPower[classIndex] << "   cca: " << cca[classIndex] << "\n";
+		if (cca[classIndex] > cca[best])
+			best = classIndex;
+	}
+
+	bool success = (stimFrequencies[best] == TargetFrequency) && (updateCount == 5);
+
+	// no harmonic below Nyquist
+	std::vector<double> window(NumChannels * SampleRate, 1.0);
+	CCAReference nyquist(SampleRate / 2.0, SampleRate, 2, SampleRate);
+	success = success && nyquist.Correlate(&window[0], NumChannels) == 0;
+
+	std::cout << (success ? "Feature engine test passed" : "Feature engine test FAILED") << "\n";
+	return success ? 0 : 1;
+}
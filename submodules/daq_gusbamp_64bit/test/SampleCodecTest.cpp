@@ -0,0 +1,89 @@
+#include "SampleCodec.h"
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <math.h>
+
+using namespace std;
+
+// Scans of 16 channels (sines of +-200 uV with a drift) and a trigger are stored as half precision and as int16. The
+// trigger must come back exactly, channels within half a step, clipped values must be counted, and the half precision
+// conversion must round to nearest even like the hardware one, subnormals and infinities included
+int main()
+{
+	const int numChannels = 16, numScans = 1000, stride = numChannels + 1;
+	bool success = true;
+
+	std::vector<float> scans(numScans * stride);
+	for (int i = 0; i < numScans; i++)
+	{
+		for (int c = 0; c < numChannels; c++)
+			scans[i * stride + c] = 200.0f * (float) sin(0.01 * i * (c + 1)) + 10.0f * c;
+		scans[i * stride + numChannels] = (float) ((i / 100) % 8);
+	}
+
+	std::vector<uint16_t> lanes(numScans * stride);
+	std::vector<float> decoded(numScans * stride);
+
+	// half precision: relative error below 2^-11
+	SampleCodec codec;
+	success = success && codec.Configure(STORAGE_HALF, numChannels, true, std::vector<float>());
+	success = success && codec.ScanStride() == stride && codec.Encode(&scans[0], numScans, &lanes[0]) == 0;
+	codec.Decode(&lanes[0], numScans, &decoded[0]);
+	double maxHalfError = 0;
+	for (int i = 0; i < numScans; i++)
+	{
+		for (int c = 0; c < numChannels; c++)
+		{
+			float value = scans[i * stride + c];
+			maxHalfError = (std::max)(maxHalfError, (double) fabsf(decoded[i * stride + c] - value) / (std::max)(fabsf(value), 1.0f));
+		}
+		success = success && decoded[i * stride + numChannels] == scans[i * stride + numChannels];
+	}
+	std::cout << "half: max relative error " << maxHalfError << "\n";
+	success = success && maxHalfError <= 1.0 / 2048;
+
+	// int16 with 0.05 uV steps: error below half a step
+	std::vector<float> gains(numChannels, 0.05f);
+	success = success && codec.Configure(STORAGE_INT16, numChannels, true, gains);
+	success = success && codec.Encode(&scans[0], numScans, &lanes[0]) == 0;
+	codec.Decode(&lanes[0], numScans, &decoded[0]);
+	double maxInt16Error = 0;
+	for (int i = 0; i < numScans; i++)
+	{
+		for (int c = 0; c < numChannels; c++)
+			maxInt16Error = (std::max)(maxInt16Error, (double) fabsf(decoded[i * stride + c] - scans[i * stride + c]));
+		success = success && decoded[i * stride + numChannels] == scans[i * stride + numChannels];
+	}
+	std::cout << "int16: max error " << maxInt16Error << " uV\n";
+	success = success && maxInt16Error <= 0.0251;
+
+	// out of range values are clipped and counted: 0.01 uV steps reach 327.67 uV only
+	gains.assign(numChannels, 0.01f);
+	success = success && codec.Configure(STORAGE_INT16, numChannels, true, gains);
+	long long numClipped = codec.Encode(&scans[0], numScans, &lanes[0]);
+	codec.Decode(&lanes[0], numScans, &decoded[0]);
+	long long expectedClipped = 0;
+	for (int i = 0; i < numScans; i++)
+		for (int c = 0; c < numChannels; c++)
+			expectedClipped += (fabsf(scans[i * stride + c]) > 327.67f + 0.001f) ? 1 : 0;
+	std::cout << "int16: " << numClipped << " clipped values\n";
+	success = success && numClipped >= expectedClipped && numClipped > 0 && fabsf(decoded[0 * stride + 15]) <= 327.671f;
+
+	// gains must match the channels and be positive
+	success = success && !codec.Configure(STORAGE_INT16, numChannels, true, std::vector<float>(3, 1.0f));
+	success = success && !codec.Configure(STORAGE_INT16, 2, true, std::vector<float>(2, 0.0f));
+
+	// conversions of single values against known half precision patterns
+	success = success && SampleCodec::FloatToHalf(1.0f) == 0x3c00 && SampleCodec::FloatToHalf(-2.0f) == 0xc000;
+	success = success && SampleCodec::FloatToHalf(65504.0f) == 0x7bff && SampleCodec::FloatToHalf(65520.0f) == 0x7c00;
+	success = success && SampleCodec::FloatToHalf(1.0f + 1.0f / 2048) == 0x3c00;
+	success = success && SampleCodec::FloatToHalf(1.0f + 3.0f / 2048) == 0x3c02;
+	success = success && SampleCodec::FloatToHalf(5.9604645e-8f) == 0x0001 && SampleCodec::FloatToHalf(1e-9f) == 0;
+	success = success && SampleCodec::HalfToFloat(0x0001) == 5.9604645e-8f && SampleCodec::HalfToFloat(0xc000) == -2.0f;
+	for (unsigned int half = 0; half < 0x7c00; half++)
+		success = success && SampleCodec::FloatToHalf(SampleCodec::HalfToFloat((uint16_t) half)) == half;
+
+	std::cout << (success ? "Sample codec test passed" : "Sample codec test FAILED") << "\n";
+	return success ? 0 : 1;
+}
@@ -0,0 +1,96 @@
+#include "ScanInterleaver.h"
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+// Fills the block of each device with values telling the device, scan and value apart, merges it and checks every
+// merged value came from the right place. Returns false on any mismatch
+static bool Check(const ScanInterleaver &interleaver, int numDevices, const int *channels, int trigger, int numScans, bool generic)
+{
+	std::vector<std::vector<float> > blocks(numDevices);
+	std::vector<const float *> devices(numDevices);
+	for (int device = 0; device < numDevices; device++)
+	{
+		int deviceStride = channels[device] + ((device == numDevices - 1) ? trigger : 0);
+		blocks[device].resize((size_t) numScans * deviceStride + 1);
+		for (int scan = 0; scan < numScans; scan++)
+			for (int value = 0; value < deviceStride; value++)
+				blocks[device][(size_t) scan * deviceStride + value] = (float) (device * 100000 + scan * 100 + value);
+		devices[device] = &blocks[device][0];
+	}
+
+	int scanStride = interleaver.ScanStride();
+	std::vector<float> scans((size_t) numScans * scanStride + 1, -1.0f);
+	if (generic)
+		interleaver.InterleaveGeneric(&devices[0], numScans, &scans[0]);
+	else
+		interleaver.Interleave(&devices[0], numScans, &scans[0]);
+
+	bool success = (scans.back() == -1.0f);
+	for (int scan = 0; scan < numScans; scan++)
+	{
+		const float *merged = &scans[(size_t) scan * scanStride];
+		int position = 0;
+		for (int device = numDevices - 1; device >= 0; device--)
+			for (int channel = 0; channel < channels[device]; channel++)
+				success = success && merged[position++] == (float) (device * 100000 + scan * 100 + channel);
+		if (trigger)
+			success = success && merged[position++] == (float) ((numDevices - 1) * 100000 + scan * 100 + channels[numDevices - 1]);
+		success = success && position == scanStride;
+	}
+	return success;
+}
+
+// Checks the specialized kernel of every configuration with the same channels on each device, and the generic one,
+// against the expected merge for blocks of 1, 8 and 67 scans; then configurations the generic kernel handles (devices
+// with different channels, more channels than specialized, none) and invalid ones
+int main()
+{
+	bool success = true;
+	int scanCounts[3] = { 1, 8, 67 };
+	int numSpecialized = 0;
+
+	for (int numDevices = 1; numDevices <= ScanInterleaver::MAX_DEVICES; numDevices++)
+	{
+		for (int numChannels = 1; numChannels <= ScanInterleaver::MAX_CHANNELS; numChannels++)
+		{
+			for (int trigger = 0; trigger <= 1; trigger++)
+			{
+				int channels[ScanInterleaver::MAX_DEVICES];
+				for (int device = 0; device < numDevices; device++)
+					channels[device] = numChannels;
+
+				ScanInterleaver interleaver;
+				success = success && interleaver.Configure(numDevices, channels, trigger != 0);
+				success = success && interleaver.ScanStride() == numDevices * numChannels + trigger;
+				numSpecialized += interleaver.Specialized() ? 1 : 0;
+				for (int k = 0; k < 3; k++)
+				{
+					success = success && Check(interleaver, numDevices, channels, trigger, scanCounts[k], false);
+					success = success && Check(interleaver, numDevices, channels, trigger, scanCounts[k], true);
+				}
+			}
+		}
+	}
+	success = success && numSpecialized == ScanInterleaver::MAX_DEVICES * ScanInterleaver::MAX_CHANNELS * 2;
+	std::cout << numSpecialized << " specialized kernels " << (success ? "match" : "DIFFER") << "\n";
+
+	// generic configurations
+	int mixed[3] = { 16, 8, 3 };
+	int wide[2] = { 20, 20 };
+	ScanInterleaver interleaver;
+	success = success && interleaver.Configure(3, mixed, true) && !interleaver.Specialized() && interleaver.ScanStride() == 28;
+	success = success && Check(interleaver, 3, mixed, 1, 67, false);
+	success = success && interleaver.Configure(2, wide, false) && !interleaver.Specialized();
+	success = success && Check(interleaver, 2, wide, 0, 8, false);
+
+	// a device without channels, and invalid configurations
+	int empty[2] = { 8, 0 };
+	int negative[2] = { 8, -1 };
+	success = success && interleaver.Configure(2, empty, true) && !interleaver.Specialized() && Check(interleaver, 2, empty, 1, 8, false);
+	success = success && !interleaver.Configure(0, mixed, true) && !interleaver.Configure(5, mixed, true) && !interleaver.Configure(2, negative, true);
+
+	std::cout << (success ? "Scan interleaver test passed" : "Scan interleaver test FAILED") << "\n";
+	return success ? 0 : 1;
+}
@@ -0,0 +1,79 @@
+#include "SessionFile.h"
+#include <iostream>
+#include <vector>
+#include <stdio.h>
+
+using namespace std;
+
+// Writes a small v1 file with known values and block trials, then loads a channel subset of its trials.
+// If a recording is passed as argument, its header and trials are printed as well
+int main(int argc, char *argv[])
+{
+	int version = 1;
+	int SampleRate = 256;
+	unsigned char NumChannels = 4;
+	int TriggerFlag = 1;
+	unsigned char channelList[] = {1, 2, 5, 9};
+	int NumScans = 2000;
+
+	// trials are [200, 600) and [1000, 1500), the second one longer
+	const char *fileName = "SessionFileTest.bin";
+	FILE *file = fopen(fileName, "wb");
+	fwrite(&version, sizeof(int), 1, file);
+	fwrite(&SampleRate, sizeof(int), 1, file);
+	fwrite(&NumChannels, 1, 1, file);
+	fwrite(&TriggerFlag, sizeof(int), 1, file);
+	fwrite(channelList, 1, NumChannels, file);
+	for (int n = 0; n < NumScans; n++)
+	{
+		for (int c = 0; c < NumChannels; c++)
+		{
+			float value = (float) (1000 * c + n);
+			fwrite(&value, sizeof(float), 1, file);
+		}
+		float trigger = ((n >= 200 && n < 600) || (n >= 1000 && n < 1500)) ? 1.0f : 0.0f;
+		fwrite(&trigger, sizeof(float), 1, file);
+	}
+	// half written scan, as left by a killed acquisition
+	fwrite(&version, sizeof(int), 1, file);
+	fclose(file);
+
+	SessionFile session;
+	bool success = session.Open(fileName);
+	success = success && session.SampleRate() == SampleRate && session.NumChannels() == NumChannels && session.NumScans() == NumScans;
+	success = success && session.ChannelList()[2] == 5;
+
+	std::vector<long long> trialStarts;
+	std::vector<int> trialLengths;
+	session.FindTrials(trialStarts, trialLengths, 0);
+	success = success && trialStarts.size() == 2 && trialStarts[0] == 199 && trialLengths[0] == 400 && trialLengths[1] == 500;
+
+	// channels 3 and 1, shortest trial length
+	std::vector<int> channels;
+	channels.push_back(3);
+	channels.push_back(1);
+	std::vector<double> trials(channels.size() * 400 * trialStarts.size());
+	success = success && session.ReadTrials(channels, trialStarts, 400, 1.0, &trials[0]);
+	success = success && trials[0] == 3199 && trials[1] == 1199 && trials[2 * 400 + 1] == 1999 && trials.back() == 1000 + 999 + 399;
+
+	// the longer trial no longer passes at 90% of the longest
+	success = success && session.FindTrials(trialStarts, trialLengths, 0.9) == 1 && trialStarts[0] == 999;
+
+	// reads past the end are refused
+	std::vector<float> slice(channels.size() * 10);
+	success = success && !session.ReadSlice(channels, NumScans - 5, 10, 1.0, &slice[0]);
+
+	session.Close();
+	remove(fileName);
+
+	if (argc > 1 && session.Open(argv[1]))
+	{
+		session.FindTrials(trialStarts, trialLengths, 0);
+		std::cout << argv[1] << ": " << session.SampleRate() << " Hz, " << session.NumChannels() << " channels, "
+			<< session.NumScans() << " scans, " << trialStarts.size() << " trials\n";
+		success = success && session.NumScans() > 0;
+	}
+
+	std::cout << (success ? "Session file test passed" : "Session file test FAILED") << "\n";
+	return success ? 0 : 1;
+}
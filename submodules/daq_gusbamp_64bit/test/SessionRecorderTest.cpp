@@ -0,0 +1,155 @@
+#include "SessionRecorder.h"
+#include "SessionFile.h"
+#include <iostream>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+
+using namespace std;
+
+// Copies a file byte for byte, as a crash would leave it
+static void CopyFile(const std::string &from, const std::string &to)
+{
+	std::ifstream in(from.c_str(), std::ios::binary);
+	std::ofstream out(to.c_str(), std::ios::binary | std::ios::trunc);
+	out << in.rdbuf();
+}
+
+// Size of a file, -1 if missing
+static long long FileSize(const std::string &fileName)
+{
+	std::ifstream file(fileName.c_str(), std::ios::binary | std::ios::ate);
+	return file.is_open() ? (long long) file.tellg() : -1;
+}
+
+// Checks the scans of a recording are the first numScans ones appended (scan s, value v is s * 100 + v)
+static bool CheckScans(const std::string &fileName, long long numScans, int scanStride)
+{
+	SessionFile session;
+	if (!session.Open(fileName.c_str()) || session.NumScans() != numScans)
+		return false;
+	bool success = true;
+	for (long long s = 0; s < numScans; s += 7)
+		for (int v = 0; v < scanStride; v++)
+			success = success && session.Sample(s, v) == (float) (s * 100 + v);
+	return success;
+}
+
+// Records 3000 scans of 4 channels and the trigger with each durability policy, in small chunks and extents. Halfway
+// through, the file and its sidecar are copied as a crash would leave them: read directly, the copy holds only the
+// committed scans, and recovered, it is truncated to them. Checks the closed file, the sidecar records (one of them
+// torn), that the thread setup ran on the writer thread and the cost counted for each policy
+int main()
+{
+	const int numChannels = 4, scanStride = numChannels + 1, blockScans = 8, numBlocks = 375;
+	const std::string fileName = "SessionRecorderTest.bin", crashName = "SessionRecorderTest.crash.bin";
+	bool success = true;
+
+	// v1 header: version, rate, channels, trigger flag and channel list
+	std::vector<char> header(13 + numChannels);
+	int version = 1, sampleRate = 512, trigger = 1;
+	memcpy(&header[0], &version, 4);
+	memcpy(&header[4], &sampleRate, 4);
+	header[8] = (char) numChannels;
+	memcpy(&header[9], &trigger, 4);
+	for (int c = 0; c < numChannels; c++)
+		header[13 + c] = (char) (c + 1);
+	long long scanBytes = scanStride * (long long) sizeof(float);
+
+	DurabilityMode modes[3] = { DURABILITY_NONE, DURABILITY_PERIODIC, DURABILITY_CHUNK };
+	const char *modeNames[3] = { "none", "periodic", "chunk" };
+	for (int m = 0; m < 3; m++)
+	{
+		DurabilityPolicy policy(modes[m], 0.01);
+		policy.chunkBytes = 4096;
+		policy.chunkSeconds = 0.005;
+		policy.extentBytes = 16384;
+
+		// the setup runs on the writer thread
+		SessionRecorder recorder;
+		std::thread::id writerId;
+		success = success && recorder.Open(fileName.c_str(), &header[0], (int) header.size(), policy, [&writerId]()
+		{
+			writerId = std::this_thread::get_id();
+		});
+
+		std::vector<float> block(blockScans * scanStride);
+		for (int b = 0; b < numBlocks; b++)
+		{
+			for (int s = 0; s < blockScans; s++)
+				for (int v = 0; v < scanStride; v++)
+					block[s * scanStride + v] = (float) ((b * blockScans + s) * 100 + v);
+			recorder.Append(&block[0], block.size());
+			std::this_thread::sleep_for(std::chrono::microseconds(200));
+
+			// crash halfway: the sidecar first, so it can't be ahead of the copied data
+			if (b == numBlocks / 2)
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(30));
+				CopyFile(fileName + SessionRecorder::COMMIT_SUFFIX, crashName + SessionRecorder::COMMIT_SUFFIX);
+				CopyFile(fileName, crashName);
+			}
+		}
+
+		success = success && recorder.Close();
+		success = success && writerId != std::thread::id() && writerId != std::this_thread::get_id();
+		RecorderStats stats;
+		recorder.GetStats(&stats);
+
+		// closed: every scan, no space reserved beyond them, no sidecar
+		long long dataBytes = (long long) numBlocks * blockScans * scanBytes;
+		success = success && FileSize(fileName) == (long long) header.size() + dataBytes;
+		success = success && FileSize(fileName + SessionRecorder::COMMIT_SUFFIX) == -1;
+		success = success && CheckScans(fileName, (long long) numBlocks * blockScans, scanStride);
+		success = success && SessionRecorder::Recover(fileName.c_str()) == (long long) header.size() + dataBytes;
+
+		// crashed: reserved space beyond the committed scans, which are read and recovered
+		long long committed;
+		success = success && SessionRecorder::CommittedLength(crashName.c_str(), &committed);
+		long long committedScans = (committed - (long long) header.size()) / scanBytes;
+		success = success && committedScans > 0 && committedScans * scanBytes + (long long) header.size() == committed;
+		success = success && FileSize(crashName) % policy.extentBytes == 0 && FileSize(crashName) > committed;
+		success = success && CheckScans(crashName, committedScans, scanStride);
+
+		// a torn last record: the other one is used
+		std::fstream sidecar((crashName + SessionRecorder::COMMIT_SUFFIX).c_str(), std::ios::in | std::ios::out | std::ios::binary);
+		std::vector<char> records((std::istreambuf_iterator<char>(sidecar)), std::istreambuf_iterator<char>());
+		unsigned int sequences[2] = { 0, 0 };
+		for (size_t r = 0; r < records.size() / 24 && r < 2; r++)
+			memcpy(&sequences[r], &records[r * 24 + 4], 4);
+		int last = (sequences[1] > sequences[0]) ? 1 : 0;
+		sidecar.seekp(last * 24 + 10);
+		sidecar.put('\x7f');
+		sidecar.close();
+		long long previous;
+		success = success && SessionRecorder::CommittedLength(crashName.c_str(), &previous) && previous <= committed;
+
+		success = success && SessionRecorder::Recover(crashName.c_str()) == previous;
+		success = success && FileSize(crashName) == previous && FileSize(crashName + SessionRecorder::COMMIT_SUFFIX) == -1;
+		success = success && CheckScans(crashName, (previous - (long long) header.size()) / scanBytes, scanStride);
+
+		// what each policy costs
+		success = success && stats.numExtents >= dataBytes / policy.extentBytes && stats.writtenBytes == (long long) header.size() + dataBytes;
+		success = success && stats.committedBytes == stats.writtenBytes && stats.queuedChunks == 0;
+		success = success && (modes[m] == DURABILITY_NONE ? stats.numSyncs == 0 : stats.numSyncs > 1);
+		success = success && (modes[m] != DURABILITY_CHUNK || stats.numSyncs >= stats.numChunks);
+
+		std::cout << modeNames[m] << ": " << stats.numChunks << " chunks (mean " << stats.meanWriteMs << " ms, max "
+			<< stats.maxWriteMs << " ms), " << stats.numExtents << " extents, " << stats.numSyncs << " syncs (mean "
+			<< stats.meanSyncMs << " ms, max " << stats.maxSyncMs << " ms), " << committedScans << " scans committed at the crash\n";
+
+		remove(fileName.c_str());
+		remove(crashName.c_str());
+	}
+
+	// nothing to recover
+	success = success && SessionRecorder::Recover("SessionRecorderTest.missing.bin") == -1;
+
+	std::cout << (success ? "Session recorder test passed" : "Session recorder test FAILED") << "\n";
+	return success ? 0 : 1;
+}
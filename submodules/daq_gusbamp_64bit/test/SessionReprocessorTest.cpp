@@ -0,0 +1,78 @@
+#include "SessionReprocessor.h"
+#include "FrontEndFilter.h"
+#include <iostream>
+#include <vector>
+#include <stdio.h>
+#include <math.h>
+
+using namespace std;
+
+// Reprocesses a small v1 file with a short FIR filter and small chunks, and checks the trial tensor against the
+// filter applied to the whole recording at once
+int main()
+{
+	int version = 1;
+	int SampleRate = 256;
+	unsigned char NumChannels = 3;
+	int TriggerFlag = 1;
+	unsigned char channelList[] = {2, 4, 6};
+	int NumScans = 3000;
+
+	std::vector<float> scans;
+	for (int n = 0; n < NumScans; n++)
+	{
+		for (int c = 0; c < NumChannels; c++)
+			scans.push_back((float) sin(0.01 * n * (c + 1)) + (float) c);
+		bool trigger = (n >= 300 && n < 800) || (n >= 1200 && n < 1700) || (n >= 2100 && n < 2650);
+		scans.push_back(trigger ? 1.0f : 0.0f);
+	}
+
+	const char *inputFile = "SessionReprocessorTest.bin";
+	const char *outputFile = "SessionReprocessorTest.trials";
+	FILE *file = fopen(inputFile, "wb");
+	fwrite(&version, sizeof(int), 1, file);
+	fwrite(&SampleRate, sizeof(int), 1, file);
+	fwrite(&NumChannels, 1, 1, file);
+	fwrite(&TriggerFlag, sizeof(int), 1, file);
+	fwrite(channelList, 1, NumChannels, file);
+	fwrite(&scans[0], sizeof(float), scans.size(), file);
+	fclose(file);
+
+	// channel 3 only, 5 tap moving average (group delay 2), chunks not aligned with trials
+	std::vector<double> num(5, 0.2);
+	std::vector<int> channels(1, 2);
+	SessionReprocessor reprocessor(channels, num, std::vector<double>(), FrontEndFilter::LinearPhaseDelay(num), 0, 0, 77);
+
+	ReprocessStats stats;
+	bool success = reprocessor.Process(inputFile, outputFile, &stats);
+	success = success && stats.numTrials == 3;
+
+	// reference: whole recording filtered at once
+	std::vector<float> reference;
+	for (int n = 0; n < NumScans; n++)
+		reference.push_back(scans[n * (NumChannels + 1) + 2]);
+	FrontEndFilter filter(num, std::vector<double>(), 1);
+	filter.Apply(&reference[0], NumScans, 1);
+
+	int header[5];
+	int channel;
+	long long trialStarts[3];
+	file = fopen(outputFile, "rb");
+	success = success && fread(header, sizeof(int), 5, file) == 5 && fread(&channel, sizeof(int), 1, file) == 1 && fread(trialStarts, sizeof(long long), 3, file) == 3;
+	success = success && header[2] == 1 && header[3] == 500 && header[4] == 3 && channel == 6 && trialStarts[0] == 299 + 2;
+
+	std::vector<float> trials(500 * 3);
+	success = success && fread(&trials[0], sizeof(float), trials.size(), file) == trials.size();
+	fclose(file);
+
+	for (int t = 0; t < 3 && success; t++)
+		for (int n = 0; n < 500; n++)
+			success = success && fabs(trials[t * 500 + n] - reference[trialStarts[t] + n]) < 1e-6;
+
+	remove(inputFile);
+	remove(outputFile);
+
+	std::cout << stats.numTrials << " trials, " << stats.bytesWritten << " bytes written in " << stats.seconds * 1000 << " ms\n";
+	std::cout << (success ? "Session reprocessor test passed" : "Session reprocessor test FAILED") << "\n";
+	return success ? 0 : 1;
+}
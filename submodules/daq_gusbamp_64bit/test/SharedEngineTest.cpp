@@ -0,0 +1,115 @@
+#include "DAQgUSBamp.h"
+#include <Windows.h>
+#include <iostream>
+#include <string>
+#include <deque>
+#include <vector>
+#include <cmath>
+
+using namespace std;
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Amplitude of the sine at frequency over numSamples samples of column channel of data (numColumns per scan)
+static double SineAmplitude(const float *data, int numSamples, int numColumns, int channel, double frequency, int sampleRate)
+{
+	double sinSum = 0, cosSum = 0;
+	for (int i = 0; i < numSamples; i++)
+	{
+		sinSum += data[i * numColumns + channel] * sin(2 * M_PI * frequency * i / sampleRate);
+		cosSum += data[i * numColumns + channel] * cos(2 * M_PI * frequency * i / sampleRate);
+	}
+	return 2 * sqrt(sinSum * sinSum + cosSum * cosSum) / numSamples;
+}
+
+// Reads one second of a group and checks that every channel holds the 10 uV sine the simulated driver gives it
+// (8 Hz plus its channel on the device) at the sample rate of the group
+static bool CheckSecond(DAQgUSBamp &daq, int numChannels, int sampleRate, std::vector<float> &data)
+{
+	data.resize((size_t) sampleRate * (numChannels + 1));
+	daq.GetData(&data[0], sampleRate);
+
+	bool success = true;
+	for (int channel = 0; channel < numChannels; channel++)
+	{
+		double amplitude = SineAmplitude(&data[0], sampleRate, numChannels + 1, channel, 8 + channel % 16, sampleRate);
+		success = success && fabs(amplitude - 10) < 1;
+	}
+	return success;
+}
+
+// Acquires two groups on one I/O thread of the shared engine: group A with two simulated amplifiers (32 channels at
+// 256 Hz) and group B with one (16 channels at 512 Hz), both in blocks of 8 scans. Each group must get its own
+// channels at its own rate and count its own blocks and devices; once A stops, B must keep acquiring on the engine
+int main()
+{
+	int TRIGGER = 1;
+	int ComR[4] = {1, 1, 1, 1};
+	int ComG[4] = {1, 1, 1, 1};
+	int rateA = 256, rateB = 512, channelsA = 32, channelsB = 16;
+	bool success = true;
+
+	std::vector<UCHAR> ChToAcqA, ChToAcqB;
+	for (int i = 1; i <= channelsA; i++)
+		ChToAcqA.push_back(i);
+	for (int i = 1; i <= channelsB; i++)
+		ChToAcqB.push_back(i);
+
+	std::deque<std::string> serialsA, serialsB;
+	serialsA.push_back("UB-SIM.00.01");
+	serialsA.push_back("UB-SIM.00.02");
+	serialsB.push_back("UB-SIM.00.03");
+
+	DAQgUSBamp daqA(ChToAcqA, rateA, TRIGGER, 0, 0, 0, ComR, ComG, std::vector<UCHAR>(channelsA, 0), BlockPolicy(8, 16, 1));
+	DAQgUSBamp daqB(ChToAcqB, rateB, TRIGGER, 0, 0, 0, ComR, ComG, std::vector<UCHAR>(channelsB, 0), BlockPolicy(8, 16, 1));
+	daqA.UseSimulatedDevice(3, 0.5, 0, 0);
+	daqB.UseSimulatedDevice(3, 0.5, 0, 0);
+
+	if (!daqA.OpenAndInitDevice(serialsA) || !daqB.OpenAndInitDevice(serialsB))
+	{
+		std::cout << "Shared engine test FAILED" << "\n";
+		return 1;
+	}
+
+	success = success && daqA.UseSharedEngine(1) && daqB.UseSharedEngine(1);
+	daqA.StartAcquisition();
+	daqB.StartAcquisition();
+	success = success && daqA.EngineThread() == 0 && daqB.EngineThread() == 0;
+
+	std::vector<float> dataA, dataB;
+	for (int s = 0; s < 3; s++)
+		success = success && CheckSecond(daqA, channelsA, rateA, dataA) && CheckSecond(daqB, channelsB, rateB, dataB);
+
+	// the same time in blocks of 8 scans: B completes twice the blocks of A, on its single device
+	int queueDepth[2];
+	double latencyMs[6];
+	long long blocksA, blocksB;
+	success = success && daqA.GetTransferStats(queueDepth, latencyMs, &blocksA) == 0;
+	success = success && daqB.GetTransferStats(queueDepth, latencyMs, &blocksB) == 0;
+	std::cout << "after 3 s: group A " << blocksA << " blocks, group B " << blocksB << " blocks\n";
+	success = success && blocksA >= 3 * rateA / 8 && blocksB > 1.5 * blocksA && blocksB < 2.5 * blocksA;
+
+	// stopping A leaves B acquiring on the engine
+	daqA.StopAcquisition();
+	success = success && daqA.EngineThread() == -1 && daqB.EngineThread() == 0;
+	daqA.GetTransferStats(queueDepth, latencyMs, &blocksA);
+
+	// B loses nothing while A takes back its transfers, its next 2 s are whole
+	for (int s = 0; s < 2; s++)
+		success = success && CheckSecond(daqB, channelsB, rateB, dataB);
+
+	long long laterBlocksA, laterBlocksB;
+	daqA.GetTransferStats(queueDepth, latencyMs, &laterBlocksA);
+	long long lostScansB = daqB.GetTransferStats(queueDepth, latencyMs, &laterBlocksB);
+	std::cout << "2 s after stopping A: group A " << laterBlocksA << " blocks, group B " << laterBlocksB << " blocks, " << lostScansB << " scans lost\n";
+	success = success && laterBlocksA == blocksA && laterBlocksB >= 5 * rateB / 8 && lostScansB == 0;
+
+	daqB.StopAcquisition();
+	daqA.CloseDevice();
+	daqB.CloseDevice();
+
+	std::cout << (success ? "Shared engine test passed" : "Shared engine test FAILED") << "\n";
+	return success ? 0 : 1;
+}
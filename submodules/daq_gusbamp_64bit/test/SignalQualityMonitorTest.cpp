@@ -0,0 +1,70 @@
+#include "SignalQualityMonitor.h"
+#include <iostream>
+#include <vector>
+#include <stdio.h>
+#include <math.h>
+
+using namespace std;
+
+// 4 channels and a trigger at 256 Hz pushed in blocks of 8 scans, windows of 1 s: a 10 Hz sine of 20 uV with 5 uV of
+// 50 Hz line noise, a flat channel at a 1 mV offset, a channel saturating in 16 scans per window and a channel with a
+// 10 uV/s drift. Each must show the expected RMS, line power, flatline, saturation and drift, and each window must be
+// logged
+int main()
+{
+	const int sampleRate = 256, numChannels = 4, scanStride = numChannels + 1, blockScans = 8, numWindows = 5;
+	const double pi = 3.14159265358979;
+	bool success = true;
+
+	SignalQualityMonitor monitor(sampleRate, numChannels, sampleRate, 50.0, 250000.0, 1.0);
+	const char *logName = "SignalQualityMonitorTest.csv";
+	success = success && monitor.OpenLog(logName);
+
+	std::vector<float> block(blockScans * scanStride);
+	for (int scan = 0; scan < numWindows * sampleRate; scan += blockScans)
+	{
+		for (int i = 0; i < blockScans; i++)
+		{
+			double t = (double) (scan + i) / sampleRate;
+			float *x = &block[i * scanStride];
+			x[0] = (float) (20 * sin(2 * pi * 10 * t) + 5 * sin(2 * pi * 50 * t));
+			x[1] = 1000.0f;
+			x[2] = ((scan + i) % sampleRate < 16) ? 300000.0f : (float) (10 * sin(2 * pi * 7 * t));
+			x[3] = (float) (-500 + 10 * t + 3 * sin(2 * pi * 11 * t));
+			x[4] = 0;
+		}
+		monitor.PushBlock(&block[0], blockScans, scanStride);
+	}
+	monitor.CloseLog();
+
+	ChannelQuality quality[numChannels];
+	int windows = monitor.GetQuality(quality);
+	for (int c = 0; c < numChannels; c++)
+		std::cout << "channel " << c + 1 << ": mean " << quality[c].meanUv << " uV, rms " << quality[c].rmsUv << " uV, line " << quality[c].linePowerUv2
+			<< " uV^2, p2p " << quality[c].peakToPeakUv << " uV, saturated " << quality[c].saturatedFraction << ", drift " << quality[c].driftUvPerSec
+			<< " uV/s, flatline " << quality[c].flatline << "\n";
+
+	success = success && windows == numWindows;
+	success = success && fabs(quality[0].rmsUv - sqrt(200.0 + 12.5)) < 0.1 && fabs(quality[0].linePowerUv2 - 12.5) < 0.1 && !quality[0].flatline && !quality[0].saturated;
+	success = success && quality[1].flatline && fabs(quality[1].meanUv - 1000) < 1e-3 && quality[1].rmsUv < 1e-3 && quality[1].linePowerUv2 < 1e-6;
+	success = success && quality[2].saturated && fabs(quality[2].saturatedFraction - 16.0 / sampleRate) < 1e-9;
+	success = success && fabs(quality[3].driftUvPerSec - 10) < 0.01 && !quality[3].flatline && quality[3].linePowerUv2 < 0.01 * quality[0].linePowerUv2;
+
+	// header and one row per channel and window
+	FILE *log = fopen(logName, "r");
+	int numLines = 0;
+	char line[512];
+	while (log != NULL && fgets(line, sizeof(line), log) != NULL)
+		numLines++;
+	if (log != NULL)
+		fclose(log);
+	remove(logName);
+	success = success && numLines == 1 + numWindows * numChannels;
+
+	// after Reset nothing is reported
+	monitor.Reset();
+	success = success && monitor.GetQuality(quality) == 0 && quality[0].rmsUv == 0;
+
+	std::cout << (success ? "Signal quality monitor test passed" : "Signal quality monitor test FAILED") << "\n";
+	return success ? 0 : 1;
+}
@@ -0,0 +1,65 @@
+#include "DAQgUSBamp.h"
+#include <Windows.h>
+#include <iostream>
+#include <string>
+#include <deque>
+#include <vector>
+
+using namespace std;
+
+// Acquires from two simulated amplifiers whose completions are delayed by up to 5 ms and, for 2% of the blocks,
+// stalled by up to 250 ms. Compares the lost sample rate of the fixed queue of 4 transfers with the adaptive queue
+int main()
+{
+	int SampleRate = 256;
+	int TRIGGER = 1;
+	int NumSec = 60;
+	int ComR[4] = {1, 1, 1, 1};
+	int ComG[4] = {1, 1, 1, 1};
+
+	std::vector<UCHAR> ChToAcq;
+	for (int i = 1; i <= 32; i++)
+		ChToAcq.push_back(i);
+	std::vector<UCHAR> bipolarSettings(32, 0);
+
+	std::deque<std::string> serials;
+	serials.push_back("UB-SIM.00.01");
+	serials.push_back("UB-SIM.00.02");
+
+	int NumSamples = SampleRate;
+	float *data = new float[NumSamples * (ChToAcq.size() + TRIGGER)];
+
+	const char *names[] = {"fixed depth 4", "adaptive 4 to 16"};
+	bool adaptive[] = {false, true};
+
+	for (int run = 0; run < 2; run++)
+	{
+		DAQgUSBamp daq(ChToAcq, SampleRate, TRIGGER, 0, 0, 0, ComR, ComG, bipolarSettings);
+		daq.UseSimulatedDevice(2, 5, 0.02, 250);
+		daq.SetQueueDepth(4, 16, adaptive[run]);
+
+		if (!daq.OpenAndInitDevice(serials))
+			continue;
+
+		daq.StartAcquisition();
+		for (int s = 0; s < NumSec; s++)
+			daq.GetData(data, NumSamples);
+
+		int queueDepth[2];
+		double latencyMs[6];
+		long long numBlocks;
+		long long lostScans = daq.GetTransferStats(queueDepth, latencyMs, &numBlocks);
+
+		daq.StopAcquisition();
+		daq.CloseDevice();
+
+		// lost scans are counted on both devices
+		double lostRate = (double) lostScans / (lostScans + 2 * numBlocks * SampleRate / 32);
+		std::cout << names[run] << ": " << numBlocks << " blocks, lost samples " << lostRate * 100 << " %, queue depth "
+			<< queueDepth[0] << "/" << queueDepth[1] << ", latency p50/p95/p99 " << latencyMs[0] << "/" << latencyMs[1]
+			<< "/" << latencyMs[2] << " ms\n";
+	}
+
+	delete[] data;
+	return 0;
+}
@@ -0,0 +1,77 @@
+#include "ThreadScheduling.h"
+#include "WorkStealingPool.h"
+#include <iostream>
+#include <vector>
+#include <set>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <stdlib.h>
+
+using namespace std;
+
+// Pins a thread, locks a buffer and reads the counters: sleeping must add context switches, touching new memory must
+// add page faults and locking must not lose the buffer contents. ConfigureWorkers must run once on every pool worker.
+// Real-time priority needs a privilege, so its result is only printed
+int main()
+{
+	bool success = true;
+
+	// context switches of this thread grow when it sleeps
+	long long threadId = ThreadScheduling::CurrentThreadId();
+	long long switchesBefore = ThreadScheduling::ThreadContextSwitches(threadId);
+	for (int i = 0; i < 5; i++)
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	long long switchesAfter = ThreadScheduling::ThreadContextSwitches(threadId);
+	std::cout << "context switches: " << switchesBefore << " -> " << switchesAfter << "\n";
+	success = success && switchesBefore >= 0 && switchesAfter >= switchesBefore + 5;
+
+	// touching fresh pages faults, locking keeps the values
+	const size_t numBytes = 1 << 20;
+	long long faultsBefore = ThreadScheduling::ProcessPageFaults();
+	char *buffer = (char *) malloc(numBytes * 8);
+	for (size_t i = 0; i < numBytes * 8; i += 4096)
+		buffer[i] = (char) i;
+	long long faultsAfter = ThreadScheduling::ProcessPageFaults();
+	std::cout << "page faults: " << faultsBefore << " -> " << faultsAfter << "\n";
+	success = success && faultsAfter > faultsBefore;
+
+	buffer[12345] = 42;
+	bool locked = ThreadScheduling::LockMemory(buffer, numBytes);
+	std::cout << "lock 1 MB: " << (locked ? "yes" : "no (limit)") << "\n";
+	success = success && buffer[12345] == 42;
+	if (locked)
+		ThreadScheduling::UnlockMemory(buffer, numBytes);
+	free(buffer);
+
+	// pinning to an existing core works, to a missing one does not
+	std::thread pinned([&success]()
+	{
+		success = success && ThreadScheduling::PinCurrentThread(ThreadScheduling::NumCpus() - 1);
+		success = success && !ThreadScheduling::PinCurrentThread(ThreadScheduling::NumCpus());
+		std::cout << "real-time priority: " << (ThreadScheduling::SetCurrentThreadRealTime(false) ? "yes" : "no (privilege)") << "\n";
+	});
+	pinned.join();
+
+	// every worker runs the setup once, on its own thread
+	WorkStealingPool pool(3);
+	std::mutex lock;
+	std::set<int> workers;
+	std::set<long long> threads;
+	pool.ConfigureWorkers([&](int workerIndex)
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		workers.insert(workerIndex);
+		threads.insert(ThreadScheduling::CurrentThreadId());
+	});
+	success = success && workers.size() == 3 && threads.size() == 3 && threads.count(threadId) == 0;
+
+	// the pool still runs tasks afterwards
+	int counter = 0;
+	pool.Submit([&]() { std::lock_guard<std::mutex> guard(lock); counter++; });
+	pool.Wait();
+	success = success && counter == 1;
+
+	std::cout << (success ? "Thread scheduling test passed" : "Thread scheduling test FAILED") << "\n";
+	return success ? 0 : 1;
+}
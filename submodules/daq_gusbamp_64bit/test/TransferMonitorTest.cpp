@@ -0,0 +1,54 @@
+#include "TransferMonitor.h"
+#include <iostream>
+#include <math.h>
+
+using namespace std;
+
+// Feeds completion times of a device producing a block every 31.25 ms: on time completions must keep the queue depth,
+// completions regularly 80 ms late must deepen it until half of the slack covers them, and never beyond the maximum
+int main()
+{
+	double blockSeconds = 0.03125;
+	bool success = true;
+
+	// on time, with a constant offset and a little jitter
+	TransferMonitor onTime(blockSeconds, 64);
+	int depth = 4;
+	for (int k = 0; k < 1000; k++)
+	{
+		onTime.AddCompletion(k, 12.5 + (k + 1) * blockSeconds + 0.001 * (k % 3));
+		depth = onTime.RecommendDepth(depth, 16);
+	}
+	success = success && depth == 4 && fabs(onTime.LatencyPercentile(99) - 0.002) < 1e-9 && onTime.NumCompletions() == 1000;
+	std::cout << "on time: depth " << depth << ", p99 " << onTime.LatencyPercentile(99) * 1000 << " ms\n";
+
+	// every 10th completion 80 ms late: slack 0.5 * (depth - 1) * 31.25 ms must reach 80 ms, so depth 7
+	TransferMonitor late(blockSeconds, 64);
+	depth = 4;
+	for (int k = 0; k < 1000; k++)
+	{
+		late.AddCompletion(k, (k + 1) * blockSeconds + ((k % 10 == 0) ? 0.08 : 0));
+		depth = late.RecommendDepth(depth, 16);
+	}
+	success = success && depth == 7 && fabs(late.LatencyPercentile(95) - 0.08) < 1e-9;
+	std::cout << "late: depth " << depth << ", p95 " << late.LatencyPercentile(95) * 1000 << " ms\n";
+
+	// same with a maximum of 5
+	late.Reset();
+	depth = 4;
+	for (int k = 0; k < 1000; k++)
+	{
+		late.AddCompletion(k, (k + 1) * blockSeconds + ((k % 10 == 0) ? 0.08 : 0));
+		depth = late.RecommendDepth(depth, 5);
+	}
+	success = success && depth == 5;
+
+	// a dropped block shifts every later completion by one block, latencies recover once it leaves the window
+	TransferMonitor shifted(blockSeconds, 64);
+	for (int k = 0; k < 500; k++)
+		shifted.AddCompletion(k, (k + 1 + (k >= 100 ? 1 : 0)) * blockSeconds);
+	success = success && shifted.LatencyPercentile(99) < 1e-9;
+
+	std::cout << (success ? "Transfer monitor test passed" : "Transfer monitor test FAILED") << "\n";
+	return success ? 0 : 1;
+}
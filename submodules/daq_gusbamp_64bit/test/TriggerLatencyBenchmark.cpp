@@ -0,0 +1,156 @@
+#include "DAQgUSBamp.h"
+#include "TriggerLatencyMeter.h"
+#include "TriggerScheduler.h"
+#include <Windows.h>
+#include <iostream>
+#include <deque>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+using namespace std;
+
+// Seconds on the clock of the trigger scheduler
+double Now()
+{
+	return TriggerScheduler::Now();
+}
+
+// Reads count scans into the meter, returning the scans read so far
+long long Read(DAQgUSBamp &daq, TriggerLatencyMeter &meter, std::vector<float> &data, int count, long long readScans)
+{
+	daq.GetData(&data[0], count);
+	meter.Received(&data[0], count, readScans, Now());
+	return readScans + count;
+}
+
+// Prints one latency distribution in ms
+void Print(const char *name, const LatencyDistribution &latency)
+{
+	std::cout << "  " << name << ": mean " << latency.mean * 1000 << ", min " << latency.minimum * 1000 << ", median "
+		<< latency.median * 1000 << ", p95 " << latency.p95 * 1000 << ", p99 " << latency.p99 * 1000 << ", max "
+		<< latency.maximum * 1000 << " ms\n";
+}
+
+// Sends NumPatterns trigger patterns (1 to 15 in turn) at random moments and reads block by block until each shows up
+// on the trigger channel, then reports the distributions of send to sample, sample to GetData return and send to
+// return latency (see TriggerLatencyMeter). Each setup is then run again with the patterns scheduled 100 ms ahead on a
+// scan (ScheduleTriggerAtScan), the trigger latency set to the median send to sample latency just measured (less half
+// a scan, the average wait for the next scan), which reports how far from their scan the patterns show up and how late
+// the scheduler wrote them. Without arguments it runs on a simulated amplifier looping its digital outputs back after
+// 0 and 5 ms; with "hw" (and optionally the serial of the amplifier) it runs on a real one, whose digital outputs must
+// be wired to its trigger input as for DAQgUSBAmp.USBTriggerTest
+int main(int argc, char *argv[])
+{
+	int SampleRate = 512;
+	int TRIGGER = 1;
+	int NumPatterns = 200;
+	int ComR[4] = {1, 1, 1, 1};
+	int ComG[4] = {1, 1, 1, 1};
+	bool hardware = (argc > 1 && std::string(argv[1]) == "hw");
+
+	std::vector<UCHAR> ChToAcq;
+	for (int i = 1; i <= 16; i++)
+		ChToAcq.push_back(i);
+	std::vector<UCHAR> bipolarSettings(16, 0);
+	int scanSize = ChToAcq.size() + TRIGGER;
+
+	double loopbackDelays[] = {0, 5};
+	int numRuns = hardware ? 2 : 4;
+	double triggerLatency = 0;
+	srand(3);
+
+	for (int run = 0; run < numRuns; run++)
+	{
+		bool scheduled = (run % 2 == 1);
+		DAQgUSBamp daq(ChToAcq, SampleRate, TRIGGER, 0, 0, 0, ComR, ComG, bipolarSettings, BlockPolicy::LowLatency(SampleRate));
+
+		bool opened;
+		if (hardware)
+		{
+			std::deque<std::string> serials;
+			if (argc > 2)
+				serials.push_back(argv[2]);
+			opened = serials.empty() ? daq.OpenAndInitDevice() : daq.OpenAndInitDevice(serials);
+		}
+		else
+			opened = daq.UseSimulatedDevice(1, 1, 0, 0, loopbackDelays[run / 2]) && daq.OpenAndInitDevice();
+		if (!opened)
+			continue;
+
+		int blockScans = daq.BlockScans();
+		std::vector<float> data(SampleRate * scanSize);
+		TriggerLatencyMeter meter(SampleRate, scanSize, ChToAcq.size());
+		long long readScans = 0;
+		bool state[4] = {false, false, false, false};
+
+		daq.SetTriggerLatency(triggerLatency * 1000);
+		daq.StartAcquisition();
+		daq.SendTrigger(state);
+
+		for (int pattern = 0; pattern < NumPatterns; pattern++)
+		{
+			//let some scans go by so patterns are sent at any point of a block, then catch up
+			Sleep(20 + rand() % 51);
+			for (int available = daq.AvailableSamples(); available > 0; available = daq.AvailableSamples())
+				readScans = Read(daq, meter, data, (std::min)(available, SampleRate), readScans);
+
+			int value = pattern % 15 + 1;
+			double sendTime = Now();
+			if (scheduled)
+			{
+				long long targetScan = readScans + SampleRate / 10;
+				meter.Sent(value, sendTime, targetScan);
+				daq.ScheduleTriggerAtScan(value, targetScan);
+			}
+			else
+			{
+				for (int bit = 0; bit < 4; bit++)
+					state[bit] = ((value >> bit) & 1) != 0;
+				meter.Sent(value, sendTime);
+				daq.SendTrigger(state);
+			}
+
+			//read as blocks arrive until the pattern shows up (or half a second went by)
+			while (meter.NumPending() > 0 && Now() - sendTime < 0.6)
+				readScans = Read(daq, meter, data, blockScans, readScans);
+		}
+
+		for (int bit = 0; bit < 4; bit++)
+			state[bit] = false;
+		daq.SendTrigger(state);
+		daq.StopAcquisition();
+		daq.CloseDevice();
+
+		if (hardware)
+			std::cout << "Hardware loopback";
+		else
+			std::cout << "Simulated loopback of " << loopbackDelays[run / 2] << " ms";
+		std::cout << (scheduled ? ", scheduled" : ", immediate") << ", blocks of " << blockScans << " scans at " << SampleRate
+			<< " Hz: " << meter.NumMatched() << " patterns received, " << meter.NumMissed() + meter.NumPending() << " missed\n";
+
+		if (scheduled)
+		{
+			std::vector<TriggerEvent> events;
+			daq.GetTriggerEvents(events);
+			double meanLateness = 0, maxLateness = 0;
+			for (size_t i = 0; i < events.size(); i++)
+			{
+				meanLateness += (events[i].emitTime - events[i].targetTime) / events.size();
+				maxLateness = (std::max)(maxLateness, events[i].emitTime - events[i].targetTime);
+			}
+			std::cout << "  trigger latency " << triggerLatency * 1000 << " ms, written late by mean " << meanLateness * 1e6
+				<< " us, max " << maxLateness * 1e6 << " us\n";
+			Print("scan shown minus target scan", meter.TargetOffset());
+		}
+		else
+		{
+			Print("send to sample", meter.SendToSample());
+			Print("sample to GetData return", meter.SampleToReturn());
+			Print("send to GetData return", meter.SendToReturn());
+			triggerLatency = (std::max)(meter.SendToSample().median - 0.5 / SampleRate, 0.0);
+		}
+	}
+
+	return 0;
+}
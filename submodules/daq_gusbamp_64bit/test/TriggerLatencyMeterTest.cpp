@@ -0,0 +1,97 @@
+#include "TriggerLatencyMeter.h"
+#include <iostream>
+#include <vector>
+#include <math.h>
+
+using namespace std;
+
+// Loops patterns back with a 5 ms delay into a simulated stream of 2 channels and a trigger, returned in blocks of 8
+// scans up to 3 ms late (the first block on time). One pattern is lost on the way. Checks the matches, the split of
+// each latency at the sample the pattern shows up on, and the distributions against the latencies computed directly,
+// and how far from their target scan the scheduled ones show up
+int main()
+{
+	const int sampleRate = 256, scanStride = 3, blockScans = 8, numPatterns = 40, lostPattern = 17;
+	const double t0 = 12.5, loopbackDelay = 0.005;
+	bool success = true;
+
+	// send times and the scan each pattern shows up on
+	std::vector<double> sendTimes;
+	std::vector<long long> patternScans;
+	for (int i = 0; i < numPatterns; i++)
+	{
+		double sendTime = t0 + 0.05 + i * 0.1 + 0.0053 * (i % 7);
+		sendTimes.push_back(sendTime);
+		patternScans.push_back((long long) ceil((sendTime + loopbackDelay - t0) * sampleRate) - 1);
+	}
+	long long numScans = patternScans.back() + 100;
+
+	std::vector<float> scans((size_t) numScans * scanStride, 0.0f);
+	int pattern = 0;
+	for (long long n = 0, i = 0; n < numScans; n++)
+	{
+		for (; i < numPatterns && patternScans[(size_t) i] <= n; i++)
+			pattern = (i == lostPattern) ? pattern : (int) (i % 15) + 1;
+		scans[(size_t) n * scanStride] = (float) n;
+		scans[(size_t) n * scanStride + 1] = -1.0f;
+		scans[(size_t) n * scanStride + 2] = (float) pattern;
+	}
+
+	// patterns are sent as the stream is read, blocks return late by a deterministic jitter
+	TriggerLatencyMeter meter(sampleRate, scanStride, 2);
+	std::vector<double> sendToSample, sampleToReturn;
+	int sent = 0;
+	for (long long first = 0; first + blockScans <= numScans; first += blockScans)
+	{
+		double returnTime = t0 + (double) (first + blockScans) / sampleRate + 0.003 * ((first / blockScans * 5) % 11) / 10.0;
+		while (sent < numPatterns && sendTimes[sent] <= returnTime)
+		{
+			meter.Sent(sent % 15 + 1, sendTimes[sent], (sent % 2) ? patternScans[sent] - sent % 3 : -1);
+			sent++;
+		}
+		meter.Received(&scans[(size_t) first * scanStride], blockScans, first, returnTime);
+
+		for (int i = 0; i < numPatterns; i++)
+			if (i != lostPattern && patternScans[i] >= first && patternScans[i] < first + blockScans)
+			{
+				double scanTime = t0 + (double) (patternScans[i] + 1) / sampleRate;
+				sendToSample.push_back(scanTime - sendTimes[i]);
+				sampleToReturn.push_back(returnTime - scanTime);
+			}
+	}
+
+	success = success && meter.NumMatched() == numPatterns - 1 && meter.NumMissed() == 1 && meter.NumPending() == 0;
+
+	LatencyDistribution output = meter.SendToSample();
+	LatencyDistribution input = meter.SampleToReturn();
+	LatencyDistribution total = meter.SendToReturn();
+
+	double outputMean = 0, inputMean = 0;
+	for (size_t i = 0; i < sendToSample.size(); i++)
+	{
+		outputMean += sendToSample[i] / sendToSample.size();
+		inputMean += sampleToReturn[i] / sampleToReturn.size();
+	}
+	success = success && output.count == numPatterns - 1 && fabs(output.mean - outputMean) < 1e-9 && fabs(input.mean - inputMean) < 1e-9;
+	success = success && fabs(total.mean - output.mean - input.mean) < 1e-9;
+
+	// the pattern shows up on the first scan acquired after it reached the amplifier
+	success = success && output.minimum >= loopbackDelay - 1e-9 && output.maximum < loopbackDelay + 1.0 / sampleRate + 1e-9;
+	success = success && input.minimum >= -1e-9 && input.maximum <= (double) blockScans / sampleRate + 0.003 + 1e-9;
+	success = success && output.minimum <= output.median && output.median <= output.p95 && output.p95 <= output.p99 && output.p99 <= output.maximum;
+
+	std::cout << output.count << " patterns, " << meter.NumMissed() << " missed: send to sample mean " << output.mean * 1000
+		<< " ms (max " << output.maximum * 1000 << "), sample to return mean " << input.mean * 1000 << " ms (max "
+		<< input.maximum * 1000 << "), send to return p95 " << total.p95 * 1000 << " ms\n";
+
+	// scheduled patterns (odd ones) showed up 0 to 2 scans after their target
+	LatencyDistribution offset = meter.TargetOffset();
+	success = success && offset.count == numPatterns / 2 - 1 && offset.minimum == 0 && offset.maximum == 2.0 / sampleRate;
+
+	// an empty meter reports nothing
+	meter.Reset();
+	success = success && meter.SendToReturn().count == 0 && meter.NumMatched() == 0 && meter.NumMissed() == 0;
+
+	std::cout << (success ? "Trigger latency meter test passed" : "Trigger latency meter test FAILED") << "\n";
+	return success ? 0 : 1;
+}
@@ -0,0 +1,135 @@
+#include "TriggerScheduler.h"
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
+
+using namespace std;
+
+// Patterns written by the scheduler and when
+static std::mutex writesLock;
+static std::vector<int> writtenValues;
+static std::vector<double> writeTimes;
+
+// Digital outputs of the test: pattern 13 fails to be written
+static bool Write(int value)
+{
+	std::lock_guard<std::mutex> lock(writesLock);
+	writtenValues.push_back(value);
+	writeTimes.push_back(TriggerScheduler::Now());
+	return value != 13;
+}
+
+// Schedules patterns at host times and on the scans of a simulated amplifier (blocks of 8 scans at 512 Hz returned on
+// time), with one pattern failing and some cancelled. Checks that they are written in time order close to their
+// target, that the patterns on a scan are written within its sampling interval, and the event index and its log
+int main()
+{
+	const int sampleRate = 512, blockScans = 8;
+	bool success = true;
+
+	TriggerScheduler scheduler(sampleRate, Write);
+	success = success && scheduler.ScheduleAtTime(1, TriggerScheduler::Now()) == -1;
+	success = success && scheduler.Start(-1) && !scheduler.Start(-1);
+	success = success && scheduler.OpenLog("TriggerSchedulerTest.csv");
+
+	// events on a scan wait for the clock
+	double start = TriggerScheduler::Now();
+	double scanTime;
+	success = success && !scheduler.ScanTime(0, &scanTime) && scheduler.ScanAt(start) == -1;
+
+	// the amplifier: a block every 8 scans from start
+	std::atomic<bool> acquiring(true);
+	std::thread amplifier([&]() {
+		for (long long numScans = blockScans; acquiring; numScans += blockScans)
+		{
+			double returnTime = start + (double) numScans / sampleRate;
+			std::this_thread::sleep_until(std::chrono::steady_clock::time_point(std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(returnTime))));
+			scheduler.AddBlock(numScans, returnTime);
+		}
+	});
+
+	// host time patterns, scheduled out of order, and scan patterns every 30 scans (one of them failing)
+	const int numTimed = 20, numScanned = 20;
+	std::vector<double> targetTimes;
+	for (int i = 0; i < numTimed; i++)
+	{
+		double target = start + 0.1 + 0.0237 * ((i * 7) % numTimed);
+		targetTimes.push_back(target);
+		success = success && scheduler.ScheduleAtTime(i % 12 + 1, target) == i;
+	}
+	for (int i = 0; i < numScanned; i++)
+		success = success && scheduler.ScheduleAtScan(i == 5 ? 13 : 14, 100 + 30 * i) == numTimed + i;
+
+	// far away ones are cancelled
+	int farId = scheduler.ScheduleAtTime(15, start + 100);
+	int farScanId = scheduler.ScheduleAtScan(15, 1000000);
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(1400));
+	success = success && scheduler.Cancel() == 2;
+	scheduler.Stop();
+	success = success && scheduler.ScheduleAtScan(1, 0) == -1;
+	acquiring = false;
+	amplifier.join();
+	scheduler.CloseLog();
+
+	std::vector<TriggerEvent> events;
+	scheduler.Events(events);
+	success = success && (int) events.size() == numTimed + numScanned + 2;
+	success = success && events[farId].state == TRIGGER_CANCELLED && events[farScanId].state == TRIGGER_CANCELLED;
+
+	// written in the order of their targets, each when it was recorded
+	std::vector<double> lateness;
+	int onScan = 0;
+	double previousTarget = 0;
+	for (int i = 0; i < numTimed + numScanned; i++)
+	{
+		const TriggerEvent &event = events[i];
+		bool failed = (i == numTimed + 5);
+		success = success && event.state == (failed ? TRIGGER_FAILED : TRIGGER_EMITTED);
+		success = success && event.emitTime >= event.targetTime && (i >= numTimed || event.targetTime == targetTimes[i]);
+		lateness.push_back(event.emitTime - event.targetTime);
+
+		if (event.targetScan >= 0)
+		{
+			onScan += (event.emitScan == event.targetScan) ? 1 : 0;
+			success = success && scheduler.ScanTime(event.targetScan, &scanTime) && fabs(event.targetTime - (scanTime - 0.5 / sampleRate)) < 1e-9;
+		}
+	}
+	std::sort(events.begin(), events.begin() + numTimed + numScanned, [](const TriggerEvent &a, const TriggerEvent &b) { return a.emitTime < b.emitTime; });
+	for (int i = 0; i < numTimed + numScanned; i++)
+	{
+		success = success && events[i].value == writtenValues[i] && events[i].emitTime <= writeTimes[i];
+		success = success && events[i].targetTime >= previousTarget;
+		previousTarget = events[i].targetTime;
+	}
+	success = success && (int) writtenValues.size() == numTimed + numScanned;
+
+	// scheduling noise of a loaded machine aside, patterns are written on time and on their scan
+	std::sort(lateness.begin(), lateness.end());
+	double medianLateness = lateness[lateness.size() / 2];
+	success = success && medianLateness < 0.001 && onScan >= numScanned * 3 / 4;
+
+	std::cout << numTimed + numScanned << " patterns: lateness median " << medianLateness * 1e6 << " us, max "
+		<< lateness.back() * 1e6 << " us, " << onScan << " of " << numScanned << " written on their scan\n";
+
+	// one row per completed event
+	std::ifstream log("TriggerSchedulerTest.csv");
+	std::string line;
+	int numRows = 0;
+	while (std::getline(log, line))
+		numRows++;
+	log.close();
+	success = success && numRows == 1 + numTimed + numScanned + 2;
+	remove("TriggerSchedulerTest.csv");
+
+	std::cout << (success ? "Trigger scheduler test passed" : "Trigger scheduler test FAILED") << "\n";
+	return success ? 0 : 1;
+}
@@ -0,0 +1,176 @@
+// Reprocesses a directory of daq files (.bin) in parallel: each recording is filtered with the front end filter, cut
+// into block trials and written to a trial tensor file (.trials, see SessionReprocessor.h and loadTrialTensor.m).
+// One recording is processed per worker and streamed in chunks, so memory stays bounded however long the sessions are.
+// Builds on Windows and Linux.
+//
+// Usage:
+//      BatchReprocess <inputDir> <outputDir> [options]
+//
+//      --filter <file>        filter coefficients (numerator line, optional denominator line), see exportFrontEndFilter.m
+//      --group-delay <n>      samples the trigger is delayed by, default round(order / 2) for FIR filters
+//      --channels <c1,c2,..>  positions of the channels to export (1 based), default all
+//      --trial-sec <t>        trial length in seconds, default the shortest trial of each session
+//      --min-to-max <r>       drop trials shorter than r times the longest one, default 0
+//      --threads <n>          worker threads, default one per core
+//      --chunk <n>            scans read at a time, default 4096
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <dirent.h>
+#endif
+#include <iostream>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <chrono>
+#include <algorithm>
+#include <stdlib.h>
+#include <string.h>
+#include "FrontEndFilter.h"
+#include "SessionReprocessor.h"
+#include "WorkStealingPool.h"
+
+using namespace std;
+
+// Lists the .bin files of a directory, sorted by name
+static std::vector<std::string> ListSessions(const std::string &directory)
+{
+	std::vector<std::string> names;
+
+#ifdef _WIN32
+	WIN32_FIND_DATAA findData;
+	HANDLE find = FindFirstFileA((directory + "\\*.bin").c_str(), &findData);
+	if (find != INVALID_HANDLE_VALUE)
+	{
+		do
+			names.push_back(findData.cFileName);
+		while (FindNextFileA(find, &findData));
+		FindClose(find);
+	}
+#else
+	DIR *dir = opendir(directory.c_str());
+	if (dir != NULL)
+	{
+		struct dirent *entry;
+		while ((entry = readdir(dir)) != NULL)
+		{
+			std::string name = entry->d_name;
+			if (name.size() > 4 && name.compare(name.size() - 4, 4, ".bin") == 0)
+				names.push_back(name);
+		}
+		closedir(dir);
+	}
+#endif
+
+	std::sort(names.begin(), names.end());
+	return names;
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc < 3)
+	{
+		std::cout << "Usage: BatchReprocess <inputDir> <outputDir> [--filter file] [--group-delay n] [--channels c1,c2,..]\n"
+			<< "                      [--trial-sec t] [--min-to-max r] [--threads n] [--chunk n]\n";
+		return 1;
+	}
+
+	std::string inputDir = argv[1];
+	std::string outputDir = argv[2];
+	std::vector<double> num, den;
+	std::vector<int> channels;
+	int groupDelay = -1;
+	double trialSec = 0;
+	double minToMaxTrial = 0;
+	int numThreads = 0;
+	int chunkScans = 4096;
+
+	for (int i = 3; i + 1 < argc; i += 2)
+	{
+		std::string option = argv[i];
+		if (option == "--filter")
+		{
+			if (!FrontEndFilter::ReadCoefficients(argv[i + 1], num, den))
+				return 1;
+		}
+		else if (option == "--group-delay")
+			groupDelay = atoi(argv[i + 1]);
+		else if (option == "--channels")
+		{
+			for (char *token = strtok(argv[i + 1], ","); token != NULL; token = strtok(NULL, ","))
+				channels.push_back(atoi(token) - 1);
+		}
+		else if (option == "--trial-sec")
+			trialSec = atof(argv[i + 1]);
+		else if (option == "--min-to-max")
+			minToMaxTrial = atof(argv[i + 1]);
+		else if (option == "--threads")
+			numThreads = atoi(argv[i + 1]);
+		else if (option == "--chunk")
+			chunkScans = atoi(argv[i + 1]);
+		else
+		{
+			std::cout << "Unknown option " << option << "\n";
+			return 1;
+		}
+	}
+
+	if (groupDelay < 0)
+		groupDelay = (den.size() > 1) ? 0 : FrontEndFilter::LinearPhaseDelay(num);
+
+	std::vector<std::string> sessions = ListSessions(inputDir);
+	if (sessions.empty())
+	{
+		std::cout << "No .bin files in " << inputDir << "\n";
+		return 1;
+	}
+
+	SessionReprocessor reprocessor(channels, num, den, groupDelay, trialSec, minToMaxTrial, chunkScans);
+	WorkStealingPool pool(numThreads);
+
+	std::cout << sessions.size() << " sessions, " << pool.NumThreads() << " threads, filter order "
+		<< (num.empty() ? 0 : (int) std::max(num.size(), den.size()) - 1) << ", group delay " << groupDelay << "\n";
+
+	std::mutex progressLock;
+	int numDone = 0;
+	int numFailed = 0;
+	long long totalRead = 0;
+	long long totalWritten = 0;
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+	for (size_t i = 0; i < sessions.size(); i++)
+	{
+		pool.Submit([&, i]() {
+			std::string inputFile = inputDir + "/" + sessions[i];
+			std::string outputFile = outputDir + "/" + sessions[i].substr(0, sessions[i].size() - 4) + ".trials";
+
+			ReprocessStats stats;
+			bool success = reprocessor.Process(inputFile.c_str(), outputFile.c_str(), &stats);
+
+			std::lock_guard<std::mutex> lock(progressLock);
+			numDone++;
+			std::cout << "[" << numDone << "/" << sessions.size() << "] " << sessions[i];
+			if (success)
+			{
+				totalRead += stats.bytesRead;
+				totalWritten += stats.bytesWritten;
+				std::cout << ": " << stats.numTrials << " trials, " << stats.bytesRead / 1048576.0 << " MB in " << stats.seconds << " s ("
+					<< stats.bytesRead / 1048576.0 / std::max(stats.seconds, 1e-9) << " MB/s)\n";
+			}
+			else
+			{
+				numFailed++;
+				std::cout << ": FAILED\n";
+			}
+		});
+	}
+	pool.Wait();
+
+	double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	std::cout << sessions.size() - numFailed << " sessions done, " << numFailed << " failed. Read " << totalRead / 1048576.0 << " MB, wrote "
+		<< totalWritten / 1048576.0 << " MB in " << elapsed << " s (" << totalRead / 1048576.0 / std::max(elapsed, 1e-9) << " MB/s)\n";
+
+	return numFailed ? 1 : 0;
+}
@@ -0,0 +1,36 @@
+// Recovers daq files (.bin) left by a crash or a power loss while recording. The file space reserved beyond the
+// samples is cut at the length committed in <file.bin>.commit, and the sidecar is removed. Files closed normally are
+// left as they are. Builds on Windows and Linux.
+//
+// Usage:
+//      RecoverSession <file.bin> [file.bin ...]
+
+#include <iostream>
+#include "SessionRecorder.h"
+
+using namespace std;
+
+int main(int argc, char *argv[])
+{
+	if (argc < 2)
+	{
+		std::cout << "Usage: RecoverSession <file.bin> [file.bin ...]\n";
+		return 1;
+	}
+
+	int numFailed = 0;
+	for (int i = 1; i < argc; i++)
+	{
+		long long committed;
+		bool crashed = SessionRecorder::CommittedLength(argv[i], &committed);
+		long long fileBytes = SessionRecorder::Recover(argv[i]);
+		if (fileBytes < 0)
+		{
+			std::cout << argv[i] << ": could not be opened or truncated\n";
+			numFailed++;
+		}
+		else
+			std::cout << argv[i] << ": " << (crashed ? "recovered, " : "closed normally, ") << fileBytes << " bytes\n";
+	}
+	return numFailed ? 1 : 0;
+}
@@ -0,0 +1,64 @@
+// Standalone loader for daq files (.bin). Prints the header and block trials of a recording and loads the trials of
+// the requested channels, reporting how long it took. Builds on Windows and Linux.
+//
+// Usage:
+//      SessionLoader <file.bin> [channel ...]
+//
+// Channels are positions in the file (1 based); all channels are loaded if none is given.
+
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <stdlib.h>
+#include "SessionFile.h"
+
+using namespace std;
+
+int main(int argc, char *argv[])
+{
+	if (argc < 2)
+	{
+		std::cout << "Usage: SessionLoader <file.bin> [channel ...]\n";
+		return 1;
+	}
+
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+	SessionFile session;
+	if (!session.Open(argv[1]))
+		return 1;
+
+	std::cout << "version " << session.Version() << ", " << session.SampleRate() << " Hz, " << session.NumScans() << " scans ("
+		<< (double) session.NumScans() / session.SampleRate() << " s)\n";
+	std::cout << "channels:";
+	for (int c = 0; c < session.NumChannels(); c++)
+		std::cout << " " << session.ChannelList()[c];
+	std::cout << (session.TriggerFlag() ? " + trigger\n" : "\n");
+
+	std::vector<int> channels;
+	for (int i = 2; i < argc; i++)
+		channels.push_back(atoi(argv[i]) - 1);
+	if (channels.empty())
+		for (int c = 0; c < session.NumChannels(); c++)
+			channels.push_back(c);
+
+	std::vector<long long> trialStarts;
+	std::vector<int> trialLengths;
+	int numTrials = session.TriggerFlag() ? session.FindTrials(trialStarts, trialLengths, 0) : 0;
+
+	int trialLength = numTrials ? trialLengths[0] : 0;
+	for (int i = 0; i < numTrials; i++)
+	{
+		std::cout << "trial " << i + 1 << ": start " << trialStarts[i] + 1 << ", " << trialLengths[i] << " samples\n";
+		trialLength = (trialLengths[i] < trialLength) ? trialLengths[i] : trialLength;
+	}
+
+	std::vector<float> trials(channels.size() * trialLength * numTrials);
+	if (numTrials && !session.ReadTrials(channels, trialStarts, trialLength, 1.0, &trials[0]))
+		return 1;
+
+	double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	std::cout << numTrials << " trials of " << trialLength << " samples in " << channels.size() << " channels loaded in " << elapsed * 1000 << " ms\n";
+
+	return 0;
+}